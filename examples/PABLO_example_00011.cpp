@@ -0,0 +1,175 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2019 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <chrono>
+
+#if BITPIT_ENABLE_MPI==1
+#include <mpi.h>
+#endif
+
+#include "bitpit_PABLO.hpp"
+
+using namespace std;
+using namespace bitpit;
+
+// =================================================================================== //
+/*!
+	\example PABLO_example_00011.cpp
+
+	\brief Octant layouts of PABLO
+
+	This example compares the two layouts that can be used to access the
+	octants of a 3D octree: the default array-of-structures layout, where
+	the index based getters read the octant objects, and the
+	structure-of-arrays layout, where coordinates, levels, markers and
+	flags are mirrored in separate contiguous arrays.
+
+	For both layouts the total memory used per local octant and the
+	throughput of a traversal that evaluates centers, sizes and markers of
+	all the octants are printed. The structure-of-arrays layout keeps the
+	octant objects and adds the mirrored arrays, hence it uses more memory
+	per octant than the array-of-structures layout.
+
+	<b>To run</b>: ./PABLO_example_00011 \n
+
+	<b>To see the result visit</b>: <a href="http://optimad.github.io/PABLO/">PABLO website</a> \n
+
+*/
+// =================================================================================== //
+
+/**
+ * Traverse all the octants of the tree evaluating centers, sizes and markers.
+ *
+ * \param tree is the tree
+ * \param nRepetitions is the number of times the traversal is repeated
+ * \result The throughput of the traversal, expressed in millions of octants
+ * per second.
+ */
+double traverse(const ParaTree &tree, int nRepetitions)
+{
+	uint32_t nOctants = tree.getNumOctants();
+
+	double checksum = 0.;
+	std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+	for (int n = 0; n < nRepetitions; ++n) {
+		for (uint32_t idx = 0; idx < nOctants; ++idx) {
+			darray3 center = tree.getCenter(idx);
+			checksum += center[0] + center[1] + center[2];
+			checksum += tree.getSize(idx);
+			checksum += tree.getMarker(idx);
+		}
+	}
+	std::chrono::time_point<std::chrono::steady_clock> end = std::chrono::steady_clock::now();
+
+	double elapsed = std::chrono::duration<double>(end - start).count();
+	log::cout() << "   Checksum : " << checksum << endl;
+
+	return (double(nRepetitions) * nOctants / elapsed) / 1.e6;
+}
+
+/**
+ * Run the example.
+ */
+void run()
+{
+	const int N_REPETITIONS = 10;
+
+	/**<Instantation of a 3D para_tree object.*/
+	ParaTree pablo11(3);
+
+	/**<Refine globally six levels and refine one more level a half of the domain.*/
+	for (int iter=0; iter<6; iter++){
+		pablo11.adaptGlobalRefine();
+	}
+
+	uint32_t nOctants = pablo11.getNumOctants();
+	for (uint32_t idx=0; idx<nOctants; idx++){
+		if (pablo11.getCenter(idx)[0] < 0.5){
+			pablo11.setMarker(idx, 1);
+		}
+	}
+	pablo11.adapt();
+	nOctants = pablo11.getNumOctants();
+
+	log::cout() << " Number of octants : " << nOctants << endl;
+
+	/**<Both layouts store the octant objects along with their cached Morton numbers.*/
+	size_t octantBytes = sizeof(Octant) + sizeof(uint64_t);
+
+	/**<Array-of-structures layout.*/
+	pablo11.setOctantLayout(ParaTree::OCTANT_LAYOUT_AOS);
+
+	size_t aosBytes = octantBytes;
+	double aosThroughput = traverse(pablo11, N_REPETITIONS);
+
+	/**<Structure-of-arrays layout, the octants are still stored as objects and the mirrored arrays are added.*/
+	pablo11.setOctantLayout(ParaTree::OCTANT_LAYOUT_SOA);
+
+	size_t mirrorBytes = 3 * sizeof(uint32_t) + sizeof(uint8_t) + sizeof(int8_t) + sizeof(uint16_t);
+	size_t soaBytes = octantBytes + mirrorBytes;
+	double soaThroughput = traverse(pablo11, N_REPETITIONS);
+
+	log::cout() << " AoS layout : " << aosBytes << " bytes per octant, " << aosThroughput << " Mocts/s" << endl;
+	log::cout() << " SoA layout : " << soaBytes << " bytes per octant (" << octantBytes << " for the octant and " << mirrorBytes << " for the mirrored arrays), " << soaThroughput << " Mocts/s" << endl;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+#if BITPIT_ENABLE_MPI==1
+	MPI_Init(&argc,&argv);
+#else
+	BITPIT_UNUSED(argc);
+	BITPIT_UNUSED(argv);
+#endif
+
+	int nProcs;
+	int rank;
+#if BITPIT_ENABLE_MPI==1
+	MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+#else
+	nProcs = 1;
+	rank   = 0;
+#endif
+
+	// Initialize the logger
+	log::manager().initialize(log::SEPARATE, false, nProcs, rank);
+	log::cout() << fileVerbosity(log::NORMAL);
+	log::cout() << consoleVerbosity(log::NORMAL);
+
+	// Run the example
+	try {
+		run();
+	} catch (const std::exception &exception) {
+		log::cout() << exception.what();
+		exit(1);
+	}
+
+#if BITPIT_ENABLE_MPI==1
+	MPI_Finalize();
+#endif
+}
@@ -0,0 +1,191 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2019 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+#include <chrono>
+
+#if BITPIT_ENABLE_MPI==1
+#include <mpi.h>
+#endif
+
+#include "bitpit_PABLO.hpp"
+
+using namespace std;
+using namespace bitpit;
+
+// =================================================================================== //
+/*!
+	\example PABLO_example_00012.cpp
+
+	\brief Neighbour search on PABLO
+
+	This example measures the cost of the searches that locate octants by
+	their Morton number: the face, edge and node neighbours of all the
+	octants of a non-uniform 3D octree are evaluated and all the octants
+	are found again from their pointers.
+
+	The searches read the Morton numbers of the octants from the cache kept
+	by the tree alongside the octants, rather than interleaving the bits of
+	the coordinates for each comparison.
+
+	<b>To run</b>: ./PABLO_example_00012 \n
+
+	<b>To see the result visit</b>: <a href="http://optimad.github.io/PABLO/">PABLO website</a> \n
+
+*/
+// =================================================================================== //
+
+/**
+ * Find the face, edge and node neighbours of all the octants of the tree.
+ *
+ * \param tree is the tree
+ * \result The throughput of the search, expressed in millions of octants
+ * per second.
+ */
+double searchNeighbours(const ParaTree &tree)
+{
+	uint32_t nOctants = tree.getNumOctants();
+
+	std::size_t nNeighbours = 0;
+	u32vector neighbours;
+	bvector isGhost;
+
+	std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+	for (uint32_t idx = 0; idx < nOctants; ++idx) {
+		for (uint8_t face = 0; face < tree.getNfaces(); ++face) {
+			tree.findNeighbours(idx, face, 1, neighbours, isGhost);
+			nNeighbours += neighbours.size();
+		}
+		for (uint8_t edge = 0; edge < tree.getNedges(); ++edge) {
+			tree.findNeighbours(idx, edge, 2, neighbours, isGhost);
+			nNeighbours += neighbours.size();
+		}
+		for (uint8_t node = 0; node < tree.getNnodes(); ++node) {
+			tree.findNeighbours(idx, node, 3, neighbours, isGhost);
+			nNeighbours += neighbours.size();
+		}
+	}
+	std::chrono::time_point<std::chrono::steady_clock> end = std::chrono::steady_clock::now();
+
+	double elapsed = std::chrono::duration<double>(end - start).count();
+	log::cout() << "   Neighbours found : " << nNeighbours << endl;
+
+	return (nOctants / elapsed) / 1.e6;
+}
+
+/**
+ * Find all the octants of the tree from their pointers.
+ *
+ * \param tree is the tree
+ * \result The throughput of the search, expressed in millions of octants
+ * per second.
+ */
+double searchOctants(ParaTree &tree)
+{
+	uint32_t nOctants = tree.getNumOctants();
+
+	uint64_t checksum = 0;
+	std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+	for (uint32_t idx = 0; idx < nOctants; ++idx) {
+		checksum += tree.getIdx(tree.getOctant(idx));
+	}
+	std::chrono::time_point<std::chrono::steady_clock> end = std::chrono::steady_clock::now();
+
+	double elapsed = std::chrono::duration<double>(end - start).count();
+	log::cout() << "   Checksum : " << checksum << endl;
+
+	return (nOctants / elapsed) / 1.e6;
+}
+
+/**
+ * Run the example.
+ */
+void run()
+{
+	/**<Instantation of a 3D para_tree object.*/
+	ParaTree pablo12(3);
+
+	/**<Refine globally five levels and refine two more levels inside a sphere.*/
+	for (int iter=0; iter<5; iter++){
+		pablo12.adaptGlobalRefine();
+	}
+
+	for (int iter=0; iter<2; iter++){
+		uint32_t nOctants = pablo12.getNumOctants();
+		for (uint32_t idx=0; idx<nOctants; idx++){
+			darray3 center = pablo12.getCenter(idx);
+			double distance = norm2(center - darray3{{0.5, 0.5, 0.5}});
+			if (distance < 0.3){
+				pablo12.setMarker(idx, 1);
+			}
+		}
+		pablo12.adapt();
+	}
+
+	log::cout() << " Number of octants : " << pablo12.getNumOctants() << endl;
+
+	double neighboursThroughput = searchNeighbours(pablo12);
+	double octantsThroughput    = searchOctants(pablo12);
+
+	log::cout() << " Neighbour search : " << neighboursThroughput << " Mocts/s" << endl;
+	log::cout() << " Octant search    : " << octantsThroughput << " Mocts/s" << endl;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+#if BITPIT_ENABLE_MPI==1
+	MPI_Init(&argc,&argv);
+#else
+	BITPIT_UNUSED(argc);
+	BITPIT_UNUSED(argv);
+#endif
+
+	int nProcs;
+	int rank;
+#if BITPIT_ENABLE_MPI==1
+	MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+#else
+	nProcs = 1;
+	rank   = 0;
+#endif
+
+	// Initialize the logger
+	log::manager().initialize(log::SEPARATE, false, nProcs, rank);
+	log::cout() << fileVerbosity(log::NORMAL);
+	log::cout() << consoleVerbosity(log::NORMAL);
+
+	// Run the example
+	try {
+		run();
+	} catch (const std::exception &exception) {
+		log::cout() << exception.what();
+		exit(1);
+	}
+
+#if BITPIT_ENABLE_MPI==1
+	MPI_Finalize();
+#endif
+}
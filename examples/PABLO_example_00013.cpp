@@ -0,0 +1,219 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2019 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+#include <chrono>
+#include <random>
+
+#if BITPIT_ENABLE_MPI==1
+#include <mpi.h>
+#endif
+
+#include "bitpit_PABLO.hpp"
+
+using namespace std;
+using namespace bitpit;
+
+// =================================================================================== //
+/*!
+	\example PABLO_example_00013.cpp
+
+	\brief Batch Morton kernels of PABLO
+
+	This example compares the batch Morton encode/decode functions of PABLO
+	with a loop that calls the scalar functions on each set of coordinates.
+	Every kernel supported by the processor is timed on the same random
+	coordinates and its results are checked against the scalar ones.
+
+	The batch functions are used by the tree to rebuild the cache of the
+	Morton numbers of the octants.
+
+	<b>To run</b>: ./PABLO_example_00013 \n
+
+	<b>To see the result visit</b>: <a href="http://optimad.github.io/PABLO/">PABLO website</a> \n
+
+*/
+// =================================================================================== //
+
+/**
+ * Get the name of the specified kernel.
+ *
+ * \param kernel is the kernel
+ * \result The name of the kernel.
+ */
+std::string getKernelName(PABLO::MortonKernel kernel)
+{
+	switch (kernel) {
+
+	case PABLO::MORTON_KERNEL_SCALAR:
+		return "scalar";
+
+	case PABLO::MORTON_KERNEL_AVX2:
+		return "AVX2";
+
+	case PABLO::MORTON_KERNEL_BMI2:
+		return "BMI2";
+
+	default:
+		return "unknown";
+
+	}
+}
+
+/**
+ * Evaluate the throughput of the specified function.
+ *
+ * \param nItems is the number of items processed by each call
+ * \param nRepetitions is the number of calls
+ * \param function is the function
+ * \result The throughput of the function, expressed in millions of items
+ * per second.
+ */
+template<typename Function>
+double evalThroughput(std::size_t nItems, int nRepetitions, Function function)
+{
+	std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
+	for (int k = 0; k < nRepetitions; ++k) {
+		function();
+	}
+	std::chrono::time_point<std::chrono::steady_clock> end = std::chrono::steady_clock::now();
+
+	double elapsed = std::chrono::duration<double>(end - start).count();
+
+	return (nItems * nRepetitions / elapsed) / 1.e6;
+}
+
+/**
+ * Run the example.
+ */
+void run()
+{
+	const std::size_t N_ITEMS = 1 << 20;
+	const int N_REPETITIONS = 20;
+
+	/**<Generate random integer coordinates on the 21 bits used by the 3D Morton numbers.*/
+	std::mt19937 generator(1);
+	std::uniform_int_distribution<uint32_t> distribution(0, (1 << 21) - 1);
+
+	std::vector<uint32_t> x(N_ITEMS);
+	std::vector<uint32_t> y(N_ITEMS);
+	std::vector<uint32_t> z(N_ITEMS);
+	for (std::size_t i = 0; i < N_ITEMS; ++i) {
+		x[i] = distribution(generator);
+		y[i] = distribution(generator);
+		z[i] = distribution(generator);
+	}
+
+	/**<Reference results evaluated with the scalar functions.*/
+	std::vector<uint64_t> expectedMortons(N_ITEMS);
+	double encodeReference = evalThroughput(N_ITEMS, N_REPETITIONS, [&]() {
+		for (std::size_t i = 0; i < N_ITEMS; ++i) {
+			expectedMortons[i] = PABLO::computeMorton(x[i], y[i], z[i]);
+		}
+	});
+
+	std::vector<uint32_t> xDecoded(N_ITEMS);
+	std::vector<uint32_t> yDecoded(N_ITEMS);
+	std::vector<uint32_t> zDecoded(N_ITEMS);
+	double decodeReference = evalThroughput(N_ITEMS, N_REPETITIONS, [&]() {
+		for (std::size_t i = 0; i < N_ITEMS; ++i) {
+			PABLO::decodeMorton(expectedMortons[i], &xDecoded[i], &yDecoded[i], &zDecoded[i]);
+		}
+	});
+
+	log::cout() << " Default kernel : " << getKernelName(PABLO::getMortonKernel()) << endl;
+	log::cout() << " Scalar loop encode : " << encodeReference << " Mitems/s" << endl;
+	log::cout() << " Scalar loop decode : " << decodeReference << " Mitems/s" << endl;
+
+	/**<Time all the supported kernels.*/
+	PABLO::MortonKernel defaultKernel = PABLO::getMortonKernel();
+
+	std::vector<uint64_t> mortons(N_ITEMS);
+	for (PABLO::MortonKernel kernel : {PABLO::MORTON_KERNEL_SCALAR, PABLO::MORTON_KERNEL_AVX2, PABLO::MORTON_KERNEL_BMI2}) {
+		if (!PABLO::isMortonKernelSupported(kernel)) {
+			log::cout() << " Kernel " << getKernelName(kernel) << " : not supported" << endl;
+			continue;
+		}
+
+		PABLO::setMortonKernel(kernel);
+
+		double encodeThroughput = evalThroughput(N_ITEMS, N_REPETITIONS, [&]() {
+			PABLO::computeMortons(N_ITEMS, x.data(), y.data(), z.data(), mortons.data());
+		});
+
+		double decodeThroughput = evalThroughput(N_ITEMS, N_REPETITIONS, [&]() {
+			PABLO::decodeMortons(N_ITEMS, mortons.data(), xDecoded.data(), yDecoded.data(), zDecoded.data());
+		});
+
+		bool isValid = (mortons == expectedMortons) && (xDecoded == x) && (yDecoded == y) && (zDecoded == z);
+
+		log::cout() << " Kernel " << getKernelName(kernel) << " encode : " << encodeThroughput << " Mitems/s";
+		log::cout() << " (speedup " << (encodeThroughput / encodeReference) << ")" << endl;
+		log::cout() << " Kernel " << getKernelName(kernel) << " decode : " << decodeThroughput << " Mitems/s";
+		log::cout() << " (speedup " << (decodeThroughput / decodeReference) << ")" << endl;
+		if (!isValid) {
+			throw std::runtime_error("Kernel " + getKernelName(kernel) + " gives results different from the scalar functions.");
+		}
+	}
+
+	PABLO::setMortonKernel(defaultKernel);
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+#if BITPIT_ENABLE_MPI==1
+	MPI_Init(&argc,&argv);
+#else
+	BITPIT_UNUSED(argc);
+	BITPIT_UNUSED(argv);
+#endif
+
+	int nProcs;
+	int rank;
+#if BITPIT_ENABLE_MPI==1
+	MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+#else
+	nProcs = 1;
+	rank   = 0;
+#endif
+
+	// Initialize the logger
+	log::manager().initialize(log::SEPARATE, false, nProcs, rank);
+	log::cout() << fileVerbosity(log::NORMAL);
+	log::cout() << consoleVerbosity(log::NORMAL);
+
+	// Run the example
+	try {
+		run();
+	} catch (const std::exception &exception) {
+		log::cout() << exception.what();
+		exit(1);
+	}
+
+#if BITPIT_ENABLE_MPI==1
+	MPI_Finalize();
+#endif
+}
@@ -0,0 +1,184 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2019 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+/*!
+	\example containers_example_00001.cpp
+
+	\brief Throughput of the position maps of the pierced kernel
+
+	This example measures insertion, lookup and deletion throughput of a
+	pierced vector using the different maps available to link the ids of
+	the elements to their positions (node-based hash map, flat hash map
+	and dense map).
+
+	<b>To run</b>: ./containers_example_00001 [number of elements] \n
+*/
+
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#if BITPIT_ENABLE_MPI==1
+#include <mpi.h>
+#endif
+
+#include "bitpit_containers.hpp"
+
+using namespace bitpit;
+
+/**
+ * Get the name of the specified position map type.
+ *
+ * \param type is the type of the position map
+ * \result The name of the specified position map type.
+ */
+std::string getMapTypeName(PiercedKernel<long>::PositionMapType type)
+{
+	switch (type) {
+
+	case PiercedPositionMap<long>::MAP_TYPE_FLAT:
+		return "flat ";
+
+	case PiercedPositionMap<long>::MAP_TYPE_DENSE:
+		return "dense";
+
+	default:
+		return "hash ";
+
+	}
+}
+
+/**
+ * Evaluate the throughput of the specified operation.
+ *
+ * \param nOperations is the number of operations performed
+ * \param begin is the time when the operations started
+ * \param end is the time when the operations ended
+ * \result The throughput expressed in millions of operations per second.
+ */
+double evalThroughput(long nOperations, const std::chrono::steady_clock::time_point &begin,
+                      const std::chrono::steady_clock::time_point &end)
+{
+	double elapsed = std::chrono::duration<double>(end - begin).count();
+
+	return 1e-6 * nOperations / std::max(elapsed, 1e-12);
+}
+
+/**
+ * Run the example.
+ *
+ * \param nElements is the number of elements
+ */
+void run(long nElements)
+{
+	std::array<PiercedKernel<long>::PositionMapType, 3> mapTypes = {{
+		PiercedPositionMap<long>::MAP_TYPE_HASH,
+		PiercedPositionMap<long>::MAP_TYPE_FLAT,
+		PiercedPositionMap<long>::MAP_TYPE_DENSE
+	}};
+
+	// Random lookup sequence
+	std::vector<long> lookupIds(nElements);
+	for (long n = 0; n < nElements; ++n) {
+		lookupIds[n] = std::rand() % nElements;
+	}
+
+	std::cout << std::endl;
+	std::cout << "  Number of elements: " << nElements << std::endl;
+	std::cout << std::endl;
+	std::cout << "  Throughput (millions of operations per second)" << std::endl;
+	std::cout << std::endl;
+	std::cout << "    map     insert    lookup    erase     refill" << std::endl;
+
+	for (PiercedKernel<long>::PositionMapType type : mapTypes) {
+		PiercedVector<double> container;
+		container.setPositionMapType(type);
+		container.reserve(nElements);
+
+		// Insertion
+		auto insertBegin = std::chrono::steady_clock::now();
+		for (long id = 0; id < nElements; ++id) {
+			container.emplaceBack(id, (double) id);
+		}
+		auto insertEnd = std::chrono::steady_clock::now();
+
+		// Random lookup
+		double sum = 0.;
+		auto lookupBegin = std::chrono::steady_clock::now();
+		for (long id : lookupIds) {
+			sum += container.at(id);
+		}
+		auto lookupEnd = std::chrono::steady_clock::now();
+
+		// Deletion of every other element
+		auto eraseBegin = std::chrono::steady_clock::now();
+		for (long id = 0; id < nElements; id += 2) {
+			container.erase(id);
+		}
+		auto eraseEnd = std::chrono::steady_clock::now();
+
+		// Refill of the holes
+		auto refillBegin = std::chrono::steady_clock::now();
+		for (long id = 0; id < nElements; id += 2) {
+			container.emplace(id, (double) id);
+		}
+		auto refillEnd = std::chrono::steady_clock::now();
+
+		long nHalf = (nElements + 1) / 2;
+
+		std::cout << "    " << getMapTypeName(type);
+		std::cout << "   " << evalThroughput(nElements, insertBegin, insertEnd);
+		std::cout << "   " << evalThroughput(nElements, lookupBegin, lookupEnd);
+		std::cout << "   " << evalThroughput(nHalf, eraseBegin, eraseEnd);
+		std::cout << "   " << evalThroughput(nHalf, refillBegin, refillEnd);
+		std::cout << "   (checksum " << sum << ")" << std::endl;
+	}
+}
+
+/**
+ * Main program.
+ */
+int main(int argc, char *argv[])
+{
+#if BITPIT_ENABLE_MPI==1
+	MPI_Init(&argc,&argv);
+#endif
+
+	long nElements = 1000000;
+	if (argc > 1) {
+		nElements = std::atol(argv[1]);
+	}
+
+	// Run the example
+	try {
+		run(nElements);
+	} catch (const std::exception &exception) {
+		std::cout << exception.what();
+		exit(1);
+	}
+
+#if BITPIT_ENABLE_MPI==1
+	MPI_Finalize();
+#endif
+}
@@ -0,0 +1,257 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2019 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+/*!
+	\example surfunstructured_example_00001.cpp
+
+	\brief Performance of the batch closest cell search
+
+	This example measures the time needed to find the closest cells of the
+	centroids of a Cartesian grid that contains a triangulated sphere, using
+	a query for each point and using a single batch query. Points are sorted
+	following the Morton order of the grid cells. Searches are
+	performed both with no maximum distance and with a maximum distance
+	equal to the size of the grid cells, as done when evaluating a narrow
+	band.
+
+	<b>To run</b>: ./surfunstructured_example_00001 [number of grid cells along each direction] [number of sphere subdivisions] \n
+*/
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+#if BITPIT_ENABLE_MPI==1
+#include <mpi.h>
+#endif
+
+#include "bitpit_surfunstructured.hpp"
+
+using namespace bitpit;
+
+/**
+ * Fill the patch with a triangulation of the unit sphere.
+ *
+ * \param nDivisions is the number of subdivisions along the parallels, the
+ * number of subdivisions along the meridians is half of this value
+ * \param patch is the patch that will be filled
+ */
+void fillPatch(int nDivisions, SurfUnstructured *patch)
+{
+	int nParallels = nDivisions / 2;
+	int nMeridians = nDivisions;
+
+	// Vertices
+	long northId = patch->addVertex({{0., 0., 1.}})->getId();
+	long southId = patch->addVertex({{0., 0., -1.}})->getId();
+
+	std::vector<long> vertexIds;
+	for (int j = 1; j < nParallels; ++j) {
+		double theta = BITPIT_PI * j / nParallels;
+		for (int i = 0; i < nMeridians; ++i) {
+			double phi = 2. * BITPIT_PI * i / nMeridians;
+			std::array<double, 3> coords = {{std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi), std::cos(theta)}};
+			vertexIds.push_back(patch->addVertex(coords)->getId());
+		}
+	}
+
+	auto getVertexId = [&vertexIds, nMeridians](int i, int j) -> long {
+		return vertexIds[(i % nMeridians) + nMeridians * (j - 1)];
+	};
+
+	// Cells
+	for (int i = 0; i < nMeridians; ++i) {
+		patch->addCell(ElementType::TRIANGLE, std::vector<long>({{northId, getVertexId(i, 1), getVertexId(i + 1, 1)}}));
+		patch->addCell(ElementType::TRIANGLE, std::vector<long>({{southId, getVertexId(i + 1, nParallels - 1), getVertexId(i, nParallels - 1)}}));
+	}
+
+	for (int j = 1; j < nParallels - 1; ++j) {
+		for (int i = 0; i < nMeridians; ++i) {
+			long v0 = getVertexId(i,     j);
+			long v1 = getVertexId(i,     j + 1);
+			long v2 = getVertexId(i + 1, j + 1);
+			long v3 = getVertexId(i + 1, j);
+
+			patch->addCell(ElementType::TRIANGLE, std::vector<long>({{v0, v1, v2}}));
+			patch->addCell(ElementType::TRIANGLE, std::vector<long>({{v0, v2, v3}}));
+		}
+	}
+}
+
+/**
+ * Run the search and print the timings.
+ *
+ * \param tree is the search tree
+ * \param points are the points
+ * \param maxDistances are the maximum distances of the points, if a null
+ * pointer is passed no maximum distance will be considered
+ */
+void search(const SurfaceSkdTree &tree, const std::vector<std::array<double, 3>> &points, const double *maxDistances)
+{
+	std::size_t nPoints = points.size();
+
+	// Query for each point
+	std::vector<long> pointIds(nPoints);
+	std::vector<double> pointDistances(nPoints);
+
+	long nPointEvaluations = 0;
+	auto pointBegin = std::chrono::steady_clock::now();
+	for (std::size_t n = 0; n < nPoints; ++n) {
+		double maxDistance = std::numeric_limits<double>::max();
+		if (maxDistances) {
+			maxDistance = maxDistances[n];
+		}
+
+		nPointEvaluations += tree.findPointClosestCell(points[n], maxDistance, pointIds.data() + n, pointDistances.data() + n);
+	}
+	auto pointEnd = std::chrono::steady_clock::now();
+
+	// Batch query
+	std::vector<long> batchIds(nPoints);
+	std::vector<double> batchDistances(nPoints);
+
+	auto batchBegin = std::chrono::steady_clock::now();
+	long nBatchEvaluations = tree.findPointClosestCells(nPoints, points.data(), maxDistances, batchIds.data(), batchDistances.data());
+	auto batchEnd = std::chrono::steady_clock::now();
+
+	// Compare the results
+	std::size_t nMismatches = 0;
+	for (std::size_t n = 0; n < nPoints; ++n) {
+		if (pointIds[n] != batchIds[n] || pointDistances[n] != batchDistances[n]) {
+			++nMismatches;
+		}
+	}
+
+	double pointElapsed = std::chrono::duration<double>(pointEnd - pointBegin).count();
+	double batchElapsed = std::chrono::duration<double>(batchEnd - batchBegin).count();
+
+	std::cout << "    per-point    " << pointElapsed << "    " << nPointEvaluations << std::endl;
+	std::cout << "    batch        " << batchElapsed << "    " << nBatchEvaluations << std::endl;
+	std::cout << "    speedup      " << (pointElapsed / batchElapsed) << std::endl;
+	std::cout << "    mismatches   " << nMismatches << std::endl;
+}
+
+/**
+ * Run the example.
+ *
+ * \param nCells is the number of grid cells along each direction
+ * \param nDivisions is the number of sphere subdivisions
+ */
+void run(int nCells, int nDivisions)
+{
+	SurfUnstructured *patch = new SurfUnstructured(0, 2, 3);
+	fillPatch(nDivisions, patch);
+
+	SurfaceSkdTree tree(patch);
+	tree.build();
+
+	// Centroids of the grid cells
+	//
+	// Centroids are sorted following the Morton order of the cells, as
+	// happens for the cells of an octree.
+	double length = 3.;
+	double h = length / nCells;
+
+	std::vector<std::pair<uint64_t, std::array<int, 3>>> cells;
+	cells.reserve(nCells * nCells * nCells);
+	for (int k = 0; k < nCells; ++k) {
+		for (int j = 0; j < nCells; ++j) {
+			for (int i = 0; i < nCells; ++i) {
+				std::array<int, 3> ijk = {{i, j, k}};
+
+				uint64_t key = 0;
+				for (int b = 0; b < 21; ++b) {
+					for (int d = 0; d < 3; ++d) {
+						key |= ((static_cast<uint64_t>(ijk[d]) >> b) & uint64_t(1)) << (3 * b + d);
+					}
+				}
+
+				cells.emplace_back(key, ijk);
+			}
+		}
+	}
+
+	std::sort(cells.begin(), cells.end());
+
+	std::vector<std::array<double, 3>> points;
+	points.reserve(cells.size());
+	for (const auto &cell : cells) {
+		const std::array<int, 3> &ijk = cell.second;
+		points.push_back({{- 0.5 * length + (ijk[0] + 0.5) * h, - 0.5 * length + (ijk[1] + 0.5) * h, - 0.5 * length + (ijk[2] + 0.5) * h}});
+	}
+
+	std::vector<double> maxDistances(points.size(), h);
+
+	std::cout << std::endl;
+	std::cout << "  Number of triangles: " << patch->getCellCount() << std::endl;
+	std::cout << "  Number of points: " << points.size() << std::endl;
+
+	std::cout << std::endl;
+	std::cout << "  Search with no maximum distance" << std::endl;
+	std::cout << "    query        time (s)    distance evaluations" << std::endl;
+	search(tree, points, nullptr);
+
+	std::cout << std::endl;
+	std::cout << "  Search with maximum distance equal to the grid size" << std::endl;
+	std::cout << "    query        time (s)    distance evaluations" << std::endl;
+	search(tree, points, maxDistances.data());
+
+	delete patch;
+}
+
+/**
+ * Main program.
+ */
+int main(int argc, char *argv[])
+{
+#if BITPIT_ENABLE_MPI==1
+	MPI_Init(&argc,&argv);
+#endif
+
+	int nCells = 64;
+	if (argc > 1) {
+		nCells = std::atoi(argv[1]);
+	}
+
+	int nDivisions = 256;
+	if (argc > 2) {
+		nDivisions = std::atoi(argv[2]);
+	}
+
+	// Run the example
+	try {
+		run(nCells, nDivisions);
+	} catch (const std::exception &exception) {
+		std::cout << exception.what();
+		exit(1);
+	}
+
+#if BITPIT_ENABLE_MPI==1
+	MPI_Finalize();
+#endif
+}
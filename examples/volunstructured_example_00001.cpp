@@ -0,0 +1,171 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2019 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+/*!
+	\example volunstructured_example_00001.cpp
+
+	\brief Performance of the adjacencies build strategies
+
+	This example measures the time needed to build the adjacencies of a
+	three-dimensional unstructured patch made of hexahedra using the
+	hash-based strategy and the sort-based strategy.
+
+	<b>To run</b>: ./volunstructured_example_00001 [number of cells along each direction] \n
+*/
+
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#if BITPIT_ENABLE_MPI==1
+#include <mpi.h>
+#endif
+
+#include "bitpit_volunstructured.hpp"
+
+using namespace bitpit;
+
+/**
+ * Get the name of the specified adjacencies build strategy.
+ *
+ * \param strategy is the adjacencies build strategy
+ * \result The name of the specified adjacencies build strategy.
+ */
+std::string getStrategyName(PatchKernel::AdjacenciesBuildStrategy strategy)
+{
+	switch (strategy) {
+
+	case PatchKernel::ADJACENCIES_SORTED:
+		return "sorted ";
+
+	default:
+		return "hashed ";
+
+	}
+}
+
+/**
+ * Fill the patch with a structured grid of hexahedra.
+ *
+ * \param nCells is the number of cells along each direction
+ * \param patch is the patch that will be filled
+ */
+void fillPatch(int nCells, VolUnstructured *patch)
+{
+	int nVertices = nCells + 1;
+
+	auto getVertexId = [nVertices](int i, int j, int k) -> long {
+		return (i + nVertices * (j + nVertices * k));
+	};
+
+	patch->reserveVertices(nVertices * nVertices * nVertices);
+	for (int k = 0; k < nVertices; ++k) {
+		for (int j = 0; j < nVertices; ++j) {
+			for (int i = 0; i < nVertices; ++i) {
+				patch->addVertex({{(double) i, (double) j, (double) k}}, getVertexId(i, j, k));
+			}
+		}
+	}
+
+	patch->reserveCells(nCells * nCells * nCells);
+	for (int k = 0; k < nCells; ++k) {
+		for (int j = 0; j < nCells; ++j) {
+			for (int i = 0; i < nCells; ++i) {
+				std::vector<long> connect = {{
+					getVertexId(i,     j,     k    ), getVertexId(i + 1, j,     k    ),
+					getVertexId(i + 1, j + 1, k    ), getVertexId(i,     j + 1, k    ),
+					getVertexId(i,     j,     k + 1), getVertexId(i + 1, j,     k + 1),
+					getVertexId(i + 1, j + 1, k + 1), getVertexId(i,     j + 1, k + 1)
+				}};
+
+				patch->addCell(ElementType::HEXAHEDRON, connect);
+			}
+		}
+	}
+}
+
+/**
+ * Run the example.
+ *
+ * \param nCells is the number of cells along each direction
+ */
+void run(int nCells)
+{
+	std::array<PatchKernel::AdjacenciesBuildStrategy, 2> strategies = {{
+		PatchKernel::ADJACENCIES_AUTOMATIC,
+		PatchKernel::ADJACENCIES_SORTED
+	}};
+
+	VolUnstructured *patch = new VolUnstructured(0, 3);
+	fillPatch(nCells, patch);
+
+	std::cout << std::endl;
+	std::cout << "  Number of cells: " << patch->getCellCount() << std::endl;
+	std::cout << std::endl;
+	std::cout << "    strategy   build (s)   adjacencies" << std::endl;
+
+	for (PatchKernel::AdjacenciesBuildStrategy strategy : strategies) {
+		auto buildBegin = std::chrono::steady_clock::now();
+		patch->buildAdjacencies(strategy);
+		auto buildEnd = std::chrono::steady_clock::now();
+
+		long nAdjacencies = 0;
+		for (const Cell &cell : patch->getCells()) {
+			nAdjacencies += cell.getAdjacencyCount();
+		}
+
+		std::cout << "    " << getStrategyName(strategy);
+		std::cout << "    " << std::chrono::duration<double>(buildEnd - buildBegin).count();
+		std::cout << "    " << nAdjacencies << std::endl;
+	}
+
+	delete patch;
+}
+
+/**
+ * Main program.
+ */
+int main(int argc, char *argv[])
+{
+#if BITPIT_ENABLE_MPI==1
+	MPI_Init(&argc,&argv);
+#endif
+
+	int nCells = 64;
+	if (argc > 1) {
+		nCells = std::atoi(argv[1]);
+	}
+
+	// Run the example
+	try {
+		run(nCells);
+	} catch (const std::exception &exception) {
+		std::cout << exception.what();
+		exit(1);
+	}
+
+#if BITPIT_ENABLE_MPI==1
+	MPI_Finalize();
+#endif
+}
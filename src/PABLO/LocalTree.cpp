@@ -28,9 +28,15 @@
 #include "bitpit_common.hpp"
 
 #include "LocalTree.hpp"
+#include <algorithm>
 #include <map>
+#include <numeric>
 #include <unordered_map>
 
+#if BITPIT_ENABLE_OPENMP==1
+#include <omp.h>
+#endif
+
 namespace bitpit {
 
     // =================================================================================== //
@@ -48,7 +54,10 @@ namespace bitpit {
 
     /*!Defaut constructor.
      */
-    LocalTree::LocalTree() {
+    LocalTree::LocalTree()
+        : m_isOctantsSoAEnabled(false), m_isOctantsSoAValid(false),
+          m_areOctantsMortonsValid(false), m_areGhostsMortonsValid(false)
+    {
         initialize();
         reset(false);
     };
@@ -56,7 +65,10 @@ namespace bitpit {
     /*!Dimensional and default constructor.
      * \param[in] dim Space dimension of octree.
      */
-    LocalTree::LocalTree(uint8_t dim){
+    LocalTree::LocalTree(uint8_t dim)
+        : m_isOctantsSoAEnabled(false), m_isOctantsSoAValid(false),
+          m_areOctantsMortonsValid(false), m_areGhostsMortonsValid(false)
+    {
         initialize(dim);
         reset(true);
     };
@@ -115,6 +127,10 @@ namespace bitpit {
      */
     int8_t
     LocalTree::getMarker(int32_t idx) const {
+        if (m_isOctantsSoAValid) {
+            return m_octantsMarker[idx];
+        }
+
         return m_octants[idx].getMarker();
     };
 
@@ -124,6 +140,10 @@ namespace bitpit {
      */
     uint8_t
     LocalTree::getLevel(int32_t idx) const {
+        if (m_isOctantsSoAValid) {
+            return m_octantsLevel[idx];
+        }
+
         return m_octants[idx].getLevel();
     };
 
@@ -133,6 +153,10 @@ namespace bitpit {
      */
     uint64_t
     LocalTree::computeMorton(int32_t idx) const {
+        if (m_areOctantsMortonsValid) {
+            return m_octantsMortons[idx];
+        }
+
         return m_octants[idx].computeMorton();
     };
 
@@ -162,6 +186,10 @@ namespace bitpit {
      */
     uint64_t
     LocalTree::computeGhostMorton(int32_t idx) const {
+        if (m_areGhostsMortonsValid) {
+            return m_ghostsMortons[idx];
+        }
+
         return m_ghosts[idx].computeMorton();
     };
 
@@ -182,9 +210,143 @@ namespace bitpit {
      */
     bool
     LocalTree::getBalance(int32_t idx) const{
+        if (m_isOctantsSoAValid) {
+            return ((m_octantsInfo[idx] >> Octant::INFO_BALANCED) & 1);
+        }
+
         return m_octants[idx].getBalance();
     };
 
+    /** Get if the idx-th octant is new after a refinement.
+     * \param[in] idx Local index of the target octant.
+     * \return True if the octant is new after a refinement.
+     */
+    bool
+    LocalTree::getIsNewR(int32_t idx) const{
+        if (m_isOctantsSoAValid) {
+            return ((m_octantsInfo[idx] >> Octant::INFO_NEW4REFINEMENT) & 1);
+        }
+
+        return m_octants[idx].getIsNewR();
+    };
+
+    /** Get if the idx-th octant is new after a coarsening.
+     * \param[in] idx Local index of the target octant.
+     * \return True if the octant is new after a coarsening.
+     */
+    bool
+    LocalTree::getIsNewC(int32_t idx) const{
+        if (m_isOctantsSoAValid) {
+            return ((m_octantsInfo[idx] >> Octant::INFO_NEW4COARSENING) & 1);
+        }
+
+        return m_octants[idx].getIsNewC();
+    };
+
+    /** Get the logical x coordinate of the node 0 of the idx-th octant.
+     * \param[in] idx Local index of the target octant.
+     * \return Logical x coordinate of the octant.
+     */
+    uint32_t
+    LocalTree::getX(int32_t idx) const{
+        if (m_isOctantsSoAValid) {
+            return m_octantsX[idx];
+        }
+
+        return m_octants[idx].getX();
+    };
+
+    /** Get the logical y coordinate of the node 0 of the idx-th octant.
+     * \param[in] idx Local index of the target octant.
+     * \return Logical y coordinate of the octant.
+     */
+    uint32_t
+    LocalTree::getY(int32_t idx) const{
+        if (m_isOctantsSoAValid) {
+            return m_octantsY[idx];
+        }
+
+        return m_octants[idx].getY();
+    };
+
+    /** Get the logical z coordinate of the node 0 of the idx-th octant.
+     * \param[in] idx Local index of the target octant.
+     * \return Logical z coordinate of the octant.
+     */
+    uint32_t
+    LocalTree::getZ(int32_t idx) const{
+        if (m_isOctantsSoAValid) {
+            return (m_dim == 3) ? m_octantsZ[idx] : 0;
+        }
+
+        return m_octants[idx].getZ();
+    };
+
+    /** Get the logical coordinates of the node 0 of the idx-th octant.
+     * \param[in] idx Local index of the target octant.
+     * \return Logical coordinates of the octant.
+     */
+    u32array3
+    LocalTree::getCoordinates(int32_t idx) const{
+        if (m_isOctantsSoAValid) {
+            u32array3 coords;
+            coords[0] = m_octantsX[idx];
+            coords[1] = m_octantsY[idx];
+            coords[2] = (m_dim == 3) ? m_octantsZ[idx] : 0;
+
+            return coords;
+        }
+
+        return m_octants[idx].getCoordinates();
+    };
+
+    /** Get the logical size of the idx-th octant.
+     * \param[in] idx Local index of the target octant.
+     * \return Logical size of the octant.
+     */
+    uint32_t
+    LocalTree::getSize(int32_t idx) const{
+        return m_treeConstants->lengths[getLevel(idx)];
+    };
+
+    /** Get the logical area of the idx-th octant.
+     * \param[in] idx Local index of the target octant.
+     * \return Logical area of the octant.
+     */
+    uint64_t
+    LocalTree::getArea(int32_t idx) const{
+        return m_treeConstants->areas[getLevel(idx)];
+    };
+
+    /** Get the logical volume of the idx-th octant.
+     * \param[in] idx Local index of the target octant.
+     * \return Logical volume of the octant.
+     */
+    uint64_t
+    LocalTree::getVolume(int32_t idx) const{
+        return m_treeConstants->volumes[getLevel(idx)];
+    };
+
+    /** Get the logical coordinates of the center of the idx-th octant.
+     * \param[in] idx Local index of the target octant.
+     * \return Logical coordinates of the center of the octant.
+     */
+    darray3
+    LocalTree::getCenter(int32_t idx) const{
+        if (m_isOctantsSoAValid) {
+            double dh = 0.5 * double(m_treeConstants->lengths[m_octantsLevel[idx]]);
+
+            darray3 center;
+            center[0] = double(m_octantsX[idx]) + dh;
+            center[1] = double(m_octantsY[idx]) + dh;
+            center[2] = (m_dim == 3) ? double(m_octantsZ[idx]) + dh : 0.;
+
+            return center;
+        }
+
+        return m_octants[idx].getCenter();
+    };
+
     /*! Get the codimension for 2:1 balancing
      * \return Maximum codimension of the entity through which the 2:1 balance is performed.
      */
@@ -200,6 +362,10 @@ namespace bitpit {
     void
     LocalTree::setMarker(int32_t idx, int8_t marker){
         m_octants[idx].setMarker(marker);
+        if (m_isOctantsSoAValid) {
+            m_octantsMarker[idx] = marker;
+            m_octantsInfo[idx]   = static_cast<uint16_t>(m_octants[idx].m_info.to_ulong());
+        }
     };
 
     /** Set if balancing-blocked idx-th octant
@@ -209,6 +375,9 @@ namespace bitpit {
     void
     LocalTree::setBalance(int32_t idx, bool balance){
         m_octants[idx].setBalance(balance);
+        if (m_isOctantsSoAValid) {
+            m_octantsInfo[idx] = static_cast<uint16_t>(m_octants[idx].m_info.to_ulong());
+        }
     };
 
     /*! Set the codimension for 2:1 balancing
@@ -290,6 +459,9 @@ namespace bitpit {
      */
     void
     LocalTree::reset(bool createRoot){
+        invalidateOctantsMortons();
+        invalidateGhostsMortons();
+
         m_octants.clear();
         m_ghosts.clear();
         m_globalIdxGhosts.clear();
@@ -320,6 +492,10 @@ namespace bitpit {
 
         m_sizeGhosts  = m_ghosts.size();
         m_sizeOctants = m_octants.size();
+
+        updateOctantsSoA();
+        updateOctantsMortons();
+        updateGhostsMortons();
     };
 
     /*!Extract an octant of the octree.
@@ -367,6 +543,10 @@ namespace bitpit {
     bool
     LocalTree::refine(u32vector & mapidx){
 
+        if (isAdaptThreaded()){
+            return refineThreaded(mapidx);
+        }
+
         u32vector		last_child_index;
         octvector 		children(0,Octant(m_dim));
         uint32_t 		idx, ilastch;
@@ -393,6 +573,11 @@ namespace bitpit {
             if(mapsize > 0){
                 mapidx.resize(m_sizeOctants+offset);
             }
+            // The cached Morton numbers are shifted along with the octants
+            bool updateMortons = m_areOctantsMortonsValid;
+            if (updateMortons){
+                m_octantsMortons.resize(m_sizeOctants+offset);
+            }
             m_octants.resize(m_sizeOctants+offset, Octant(m_dim));
             m_sizeOctants = m_octants.size();
             blockidx = last_child_index[0]-nchm1;
@@ -407,6 +592,7 @@ namespace bitpit {
                     for (ich=0; ich<m_treeConstants->nChildren; ich++){
                         m_octants[idx-ich] = (children[nchm1-ich]);
                         if(mapsize>0) mapidx[idx-ich]  = mapidx[idx-offset];
+                        if(updateMortons) m_octantsMortons[idx-ich] = children[nchm1-ich].computeMorton();
                     }
                     offset -= nchm1;
                     idx -= nchm1;
@@ -425,6 +611,7 @@ namespace bitpit {
                 else {
                     m_octants[idx] = m_octants[idx-offset];
                     if(mapsize>0) mapidx[idx]  = mapidx[idx-offset];
+                    if(updateMortons) m_octantsMortons[idx] = m_octantsMortons[idx-offset];
                 }
             }
         }
@@ -432,6 +619,130 @@ namespace bitpit {
         octvector(m_octants).swap(m_octants);
         m_sizeOctants = m_octants.size();
 
+        if (!m_areOctantsMortonsValid){
+            updateOctantsMortons();
+        }
+
+        return dorefine;
+
+    };
+
+    /*! Check if the local adaption will use multiple threads.
+     * Threads are used only if OpenMP is enabled, more than one thread is
+     * available and the local tree is large enough.
+     * \return true if the local adaption will use multiple threads.
+     */
+    bool
+    LocalTree::isAdaptThreaded() const{
+#if BITPIT_ENABLE_OPENMP==1
+        return (omp_get_max_threads() > 1 && m_octants.size() >= THREADED_ADAPT_MIN_OCTANTS);
+#else
+        return false;
+#endif
+    };
+
+    /*! Refine local tree using multiple threads: refine one time octants with marker >0.
+     * The number of octants generated by each octant is counted, the positions
+     * of the octants in the refined tree are evaluated with a prefix sum and
+     * the octants are then scattered in the refined tree. The result is the
+     * same of the serial refinement.
+     * \param[out] mapidx mpaidx[i] = index in old octants vector of the new i-th octant (index of father if octant is new after refinement)
+     * \return	true if another refinement is needed
+     */
+    bool
+    LocalTree::refineThreaded(u32vector & mapidx){
+
+        uint32_t nOctants  = m_octants.size();
+        uint8_t  nChildren = m_treeConstants->nChildren;
+        bool     hasMapping = (mapidx.size() > 0);
+
+        // Count the octants generated by each octant
+        u32vector offsets(nOctants + 1);
+        offsets[0] = 0;
+
+#if BITPIT_ENABLE_OPENMP==1
+        #pragma omp parallel for schedule(static)
+#endif
+        for (uint32_t idx = 0; idx < nOctants; ++idx){
+            Octant &octant = m_octants[idx];
+            if (octant.getMarker() > 0 && octant.getLevel() < TreeConstants::MAX_LEVEL){
+                offsets[idx + 1] = nChildren;
+            }
+            else{
+                if (octant.m_marker > 0){
+                    octant.m_marker = 0;
+                    octant.m_info[Octant::INFO_AUX] = false;
+                }
+                offsets[idx + 1] = 1;
+            }
+        }
+
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+        uint32_t nRefinedOctants = offsets[nOctants];
+        if (nRefinedOctants == nOctants){
+            m_sizeOctants = nOctants;
+            if (!m_areOctantsMortonsValid){
+                updateOctantsMortons();
+            }
+
+            return false;
+        }
+
+        // Scatter the octants in the refined tree
+        bool updateMortons = m_areOctantsMortonsValid;
+
+        octvector refinedOctants(nRefinedOctants);
+        u32vector refinedMapidx(hasMapping ? nRefinedOctants : 0);
+        u64vector refinedMortons(updateMortons ? nRefinedOctants : 0);
+
+        uint8_t localMaxDepth = m_localMaxDepth;
+        bool    dorefine      = false;
+
+#if BITPIT_ENABLE_OPENMP==1
+        #pragma omp parallel for schedule(static) reduction(max:localMaxDepth) reduction(||:dorefine)
+#endif
+        for (uint32_t idx = 0; idx < nOctants; ++idx){
+            uint32_t position = offsets[idx];
+            Octant &octant = m_octants[idx];
+            if (offsets[idx + 1] - position == 1){
+                refinedOctants[position] = octant;
+                if (hasMapping) refinedMapidx[position] = mapidx[idx];
+                if (updateMortons) refinedMortons[position] = m_octantsMortons[idx];
+                continue;
+            }
+
+            octant.m_info[Octant::INFO_AUX] = false;
+            octvector children = octant.buildChildren();
+            for (uint8_t ich = 0; ich < nChildren; ++ich){
+                refinedOctants[position + ich] = children[ich];
+                if (hasMapping) refinedMapidx[position + ich] = mapidx[idx];
+                if (updateMortons) refinedMortons[position + ich] = children[ich].computeMorton();
+            }
+
+            //Update local max depth
+            localMaxDepth = std::max(localMaxDepth, children[0].getLevel());
+            if (children[0].getMarker()){
+                //More Refinement to do
+                dorefine = true;
+            }
+        }
+
+        m_octants.swap(refinedOctants);
+        m_sizeOctants = m_octants.size();
+        m_localMaxDepth = localMaxDepth;
+
+        if (hasMapping){
+            mapidx.swap(refinedMapidx);
+        }
+
+        if (updateMortons){
+            m_octantsMortons.swap(refinedMortons);
+        }
+        else{
+            updateOctantsMortons();
+        }
+
         return dorefine;
 
     };
@@ -467,6 +778,9 @@ namespace bitpit {
 
         if (m_sizeOctants == 0) return false;
 
+        // The cached Morton numbers are out of sync until the end of the coarsening
+        invalidateOctantsMortons();
+
         nbro = nend = nstart = 0;
         nidx = offset = 0;
 
@@ -497,79 +811,85 @@ namespace bitpit {
         }
 
         // Check and coarse internal octants
-        for (idx=0; idx<m_sizeOctants; idx++){
-            if(m_octants[idx].getMarker() < 0 && m_octants[idx].getLevel() > 0){
-                nbro = 0;
-                father = m_octants[idx].buildFather();
-                // Check if family is to be refined
-                for (idx2=idx; idx2<idx+m_treeConstants->nChildren; idx2++){
-                    if (idx2<m_sizeOctants){
-                        if(m_octants[idx2].getMarker() < 0 && m_octants[idx2].buildFather() == father){
-                            nbro++;
+        if (isAdaptThreaded()){
+            coarseInternalFamiliesThreaded(mapidx, &father, &nbro);
+            m_sizeOctants = m_octants.size();
+        }
+        else{
+            for (idx=0; idx<m_sizeOctants; idx++){
+                if(m_octants[idx].getMarker() < 0 && m_octants[idx].getLevel() > 0){
+                    nbro = 0;
+                    father = m_octants[idx].buildFather();
+                    // Check if family is to be refined
+                    for (idx2=idx; idx2<idx+m_treeConstants->nChildren; idx2++){
+                        if (idx2<m_sizeOctants){
+                            if(m_octants[idx2].getMarker() < 0 && m_octants[idx2].buildFather() == father){
+                                nbro++;
+                            }
                         }
                     }
-                }
-                if (nbro == m_treeConstants->nChildren){
-                    nidx++;
-                    first_child_index.push_back(idx);
-                    idx = idx2-1;
+                    if (nbro == m_treeConstants->nChildren){
+                        nidx++;
+                        first_child_index.push_back(idx);
+                        idx = idx2-1;
+                    }
                 }
             }
-        }
-        uint32_t nblock = m_sizeOctants;
-        uint32_t nfchild = first_child_index.size();
-        if (nidx!=0){
-            nblock = m_sizeOctants - nidx*nchm1;
-            nidx = 0;
-            for (idx=0; idx<nblock; idx++){
-                if (idx+offset < m_sizeOctants){
-                    if (nidx < nfchild){
-                        if (idx+offset == first_child_index[nidx]){
-                            markerfather = -TreeConstants::MAX_LEVEL;
-                            father = m_octants[idx+offset].buildFather();
-                            for (uint32_t iii=0; iii<Octant::INFO_ITEM_COUNT; iii++){
-                                father.m_info[iii] = false;
-                            }
-                            father.setGhostLayer(-1);
-                            for(idx2=0; idx2<m_treeConstants->nChildren; idx2++){
-                                if (idx2 < m_sizeOctants){
-                                    if (markerfather < m_octants[idx+offset+idx2].getMarker()+1){
-                                        markerfather = m_octants[idx+offset+idx2].getMarker()+1;
-                                    }
-                                    for (uint32_t iii=0; iii<Octant::INFO_ITEM_COUNT; iii++){
-                                        father.m_info[iii] = father.m_info[iii] || m_octants[idx+offset+idx2].m_info[iii];
+            uint32_t nblock = m_sizeOctants;
+            uint32_t nfchild = first_child_index.size();
+            if (nidx!=0){
+                nblock = m_sizeOctants - nidx*nchm1;
+                nidx = 0;
+                for (idx=0; idx<nblock; idx++){
+                    if (idx+offset < m_sizeOctants){
+                        if (nidx < nfchild){
+                            if (idx+offset == first_child_index[nidx]){
+                                markerfather = -TreeConstants::MAX_LEVEL;
+                                father = m_octants[idx+offset].buildFather();
+                                for (uint32_t iii=0; iii<Octant::INFO_ITEM_COUNT; iii++){
+                                    father.m_info[iii] = false;
+                                }
+                                father.setGhostLayer(-1);
+                                for(idx2=0; idx2<m_treeConstants->nChildren; idx2++){
+                                    if (idx2 < m_sizeOctants){
+                                        if (markerfather < m_octants[idx+offset+idx2].getMarker()+1){
+                                            markerfather = m_octants[idx+offset+idx2].getMarker()+1;
+                                        }
+                                        for (uint32_t iii=0; iii<Octant::INFO_ITEM_COUNT; iii++){
+                                            father.m_info[iii] = father.m_info[iii] || m_octants[idx+offset+idx2].m_info[iii];
+                                        }
                                     }
                                 }
+                                father.m_info[Octant::INFO_NEW4COARSENING] = true;
+                                father.m_info[Octant::INFO_AUX] = false;
+                                father.setMarker(markerfather);
+                                //Impossible in this version
+    //                            if (markerfather < 0 && mapsize == 0){
+    //                                docoarse = true;
+    //                            }
+                                m_octants[idx] = father;
+                                if(mapsize > 0) mapidx[idx] = mapidx[idx+offset];
+                                offset += nchm1;
+                                nidx++;
+                            }
+                            else{
+                                m_octants[idx] = m_octants[idx+offset];
+                                if(mapsize > 0) mapidx[idx] = mapidx[idx+offset];
                             }
-                            father.m_info[Octant::INFO_NEW4COARSENING] = true;
-                            father.m_info[Octant::INFO_AUX] = false;
-                            father.setMarker(markerfather);
-                            //Impossible in this version
-//                            if (markerfather < 0 && mapsize == 0){
-//                                docoarse = true;
-//                            }
-                            m_octants[idx] = father;
-                            if(mapsize > 0) mapidx[idx] = mapidx[idx+offset];
-                            offset += nchm1;
-                            nidx++;
                         }
                         else{
                             m_octants[idx] = m_octants[idx+offset];
                             if(mapsize > 0) mapidx[idx] = mapidx[idx+offset];
                         }
                     }
-                    else{
-                        m_octants[idx] = m_octants[idx+offset];
-                        if(mapsize > 0) mapidx[idx] = mapidx[idx+offset];
-                    }
                 }
             }
-        }
-        m_octants.resize(nblock, Octant(m_dim));
-        octvector(m_octants).swap(m_octants);
-        m_sizeOctants = m_octants.size();
-        if(mapsize > 0){
-            mapidx.resize(m_sizeOctants);
+            m_octants.resize(nblock, Octant(m_dim));
+            octvector(m_octants).swap(m_octants);
+            m_sizeOctants = m_octants.size();
+            if(mapsize > 0){
+                mapidx.resize(m_sizeOctants);
+            }
         }
 
         //Check ghosts
@@ -750,12 +1070,158 @@ namespace bitpit {
         setFirstDescMorton();
         setLastDescMorton();
 
+        updateOctantsMortons();
+
         return docoarse;
 
     };
 
     // =================================================================================== //
 
+    /*! Coarse the families of internal octants using multiple threads.
+     * The first child of the families to be coarsened is identified for each
+     * octant independently, the positions of the octants in the coarsened tree
+     * are evaluated with a prefix sum and the octants are then scattered in
+     * the coarsened tree. The result is the same of the serial coarsening.
+     * The checks on the families shared with the ghosts start from the last
+     * family checked on the internal octants, the father and the number of
+     * brothers of that family are therefore returned.
+     * \param[out] mapidx mpaidx[i] = index in old octants vector of the new i-th octant (index of first child if octant is new after coarsening)
+     * \param[in,out] lastFather On output is the father of the last family checked,
+     * it is not modified if no family is checked
+     * \param[in,out] lastNBrothers On output is the number of brothers with negative marker
+     * of the last family checked, it is not modified if no family is checked
+     */
+    void
+    LocalTree::coarseInternalFamiliesThreaded(u32vector & mapidx, Octant *lastFather, uint8_t *lastNBrothers){
+
+        uint32_t nOctants  = m_octants.size();
+        uint8_t  nChildren = m_treeConstants->nChildren;
+        bool     hasMapping = (mapidx.size() > 0);
+
+        // Count the brothers of each octant that are to be coarsened. A
+        // family can be coarsened if all its children are contiguous and
+        // have a negative marker.
+        u8vector nBrothers(nOctants, 0);
+
+#if BITPIT_ENABLE_OPENMP==1
+        #pragma omp parallel for schedule(static)
+#endif
+        for (uint32_t idx = 0; idx < nOctants; ++idx){
+            const Octant &octant = m_octants[idx];
+            if (octant.getMarker() >= 0 || octant.getLevel() == 0){
+                continue;
+            }
+
+            Octant father = octant.buildFather();
+            uint32_t familyEnd = std::min(idx + nChildren, nOctants);
+            uint8_t nbro = 0;
+            for (uint32_t idx2 = idx; idx2 < familyEnd; ++idx2){
+                if (m_octants[idx2].getMarker() < 0 && m_octants[idx2].buildFather() == father){
+                    nbro++;
+                }
+            }
+            nBrothers[idx] = nbro;
+        }
+
+        // Count the octants generated by each octant: the first child of a
+        // family generates the father, the other children of the family are
+        // removed.
+        u32vector offsets(nOctants + 1);
+        offsets[0] = 0;
+
+#if BITPIT_ENABLE_OPENMP==1
+        #pragma omp parallel for schedule(static)
+#endif
+        for (uint32_t idx = 0; idx < nOctants; ++idx){
+            uint32_t familyBegin = (idx >= nChildren) ? (idx - nChildren + 1) : 0;
+            bool isRemoved = false;
+            for (uint32_t idx2 = familyBegin; idx2 < idx; ++idx2){
+                if (nBrothers[idx2] == nChildren){
+                    isRemoved = true;
+                    break;
+                }
+            }
+            offsets[idx + 1] = isRemoved ? 0 : 1;
+        }
+
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+        // Father and brothers of the last family checked
+        bool hasFamilies = false;
+        for (uint32_t idx = nOctants; idx > 0; --idx){
+            bool isRemoved = (offsets[idx] == offsets[idx - 1]);
+            if (nBrothers[idx - 1] > 0 && !isRemoved){
+                *lastNBrothers = nBrothers[idx - 1];
+                *lastFather    = m_octants[idx - 1].buildFather();
+                break;
+            }
+        }
+
+        for (uint32_t idx = nOctants; idx > 0; --idx){
+            if (nBrothers[idx - 1] == nChildren){
+                *lastFather = m_octants[idx - 1].buildFather();
+                hasFamilies = true;
+                break;
+            }
+        }
+
+        if (!hasFamilies){
+            return;
+        }
+
+        // Scatter the octants in the coarsened tree
+        uint32_t nCoarsenedOctants = offsets[nOctants];
+
+        octvector coarsenedOctants(nCoarsenedOctants);
+        u32vector coarsenedMapidx(hasMapping ? nCoarsenedOctants : 0);
+
+#if BITPIT_ENABLE_OPENMP==1
+        #pragma omp parallel for schedule(static)
+#endif
+        for (uint32_t idx = 0; idx < nOctants; ++idx){
+            uint32_t position = offsets[idx];
+            if (offsets[idx + 1] == position){
+                continue;
+            }
+
+            if (hasMapping) coarsenedMapidx[position] = mapidx[idx];
+            if (nBrothers[idx] != nChildren){
+                coarsenedOctants[position] = m_octants[idx];
+                continue;
+            }
+
+            int8_t markerfather = -TreeConstants::MAX_LEVEL;
+            Octant father = m_octants[idx].buildFather();
+            for (uint32_t iii=0; iii<Octant::INFO_ITEM_COUNT; iii++){
+                father.m_info[iii] = false;
+            }
+            father.setGhostLayer(-1);
+            for (uint8_t ich = 0; ich < nChildren; ++ich){
+                const Octant &child = m_octants[idx + ich];
+                if (markerfather < child.getMarker()+1){
+                    markerfather = child.getMarker()+1;
+                }
+                for (uint32_t iii=0; iii<Octant::INFO_ITEM_COUNT; iii++){
+                    father.m_info[iii] = father.m_info[iii] || child.m_info[iii];
+                }
+            }
+            father.m_info[Octant::INFO_NEW4COARSENING] = true;
+            father.m_info[Octant::INFO_AUX] = false;
+            father.setMarker(markerfather);
+
+            coarsenedOctants[position] = father;
+        }
+
+        m_octants.swap(coarsenedOctants);
+        if (hasMapping){
+            mapidx.swap(coarsenedMapidx);
+        }
+
+    };
+
+    // =================================================================================== //
+
     /*! Refine local tree: refine one time all the octants
      * \param[out] mapidx mpaidx[i] = index in old octants vector of the new i-th octant (index of father if octant is new after refinement)
      * \return	true if refinement done
@@ -844,6 +1310,10 @@ namespace bitpit {
                 }
                 m_sizeOctants = m_octants.size();
                 setFirstDescMorton();
+
+                if (m_areOctantsMortonsValid){
+                    m_octantsMortons.erase(m_octantsMortons.begin(), m_octantsMortons.begin() + std::min<std::size_t>(toDelete, m_octantsMortons.size()));
+                }
             }
 
         }
@@ -937,7 +1407,7 @@ namespace bitpit {
                 idxtry = noctants-1;
         }
         while(abs(jump) > 0){
-            Mortontry = m_octants[idxtry].computeMorton();
+            Mortontry = computeMorton(idxtry);
             jump = ((Mortontry<Morton)-(Mortontry>Morton))*abs(jump)/2;
             idxtry += jump;
             if (idxtry > noctants-1){
@@ -951,7 +1421,7 @@ namespace bitpit {
                 }
             }
         }
-        Mortontry = m_octants[idxtry].computeMorton();
+        Mortontry = computeMorton(idxtry);
         if(Mortontry == Morton && m_octants[idxtry].m_level == oct->m_level){
             //Found neighbour of same size
             isghost.push_back(false);
@@ -963,11 +1433,11 @@ namespace bitpit {
             {
                 while(idxtry < (noctants - 1) && Mortontry < Morton){
                     idxtry++;
-                    Mortontry = m_octants[idxtry].computeMorton();
+                    Mortontry = computeMorton(idxtry);
                 }
                 while(idxtry > 0 && Mortontry > Morton){
                     idxtry--;
-                    Mortontry = m_octants[idxtry].computeMorton();
+                    Mortontry = computeMorton(idxtry);
                 }
             }
             if(Mortontry == Morton && m_octants[idxtry].m_level == oct->m_level){
@@ -1015,7 +1485,7 @@ namespace bitpit {
                 if(idxtry>noctants-1){
                     break;
                 }
-                Mortontry = m_octants[idxtry].computeMorton();
+                Mortontry = computeMorton(idxtry);
                 coordtry = m_octants[idxtry].getCoord();
             }
 
@@ -1064,7 +1534,7 @@ namespace bitpit {
             idxtry = uint32_t(idxghost +((Mortontry<Morton)-(Mortontry>Morton))*jump);
             if (idxtry > m_ghosts.size()-1) idxtry = m_ghosts.size()-1;
             while(abs(jump) > 0){
-                Mortontry = m_ghosts[idxtry].computeMorton();
+                Mortontry = computeGhostMorton(idxtry);
                 jump = ((Mortontry<Morton)-(Mortontry>Morton))*abs(jump)/2;
                 idxtry += jump;
                 if (idxtry > m_ghosts.size()-1){
@@ -1078,7 +1548,7 @@ namespace bitpit {
                     }
                 }
             }
-            Mortontry = m_ghosts[idxtry].computeMorton();
+            Mortontry = computeGhostMorton(idxtry);
             if(Mortontry == Morton && m_ghosts[idxtry].m_level == oct->m_level){
                 //Found neighbour of same size
                 isghost.push_back(true);
@@ -1090,15 +1560,15 @@ namespace bitpit {
                 {
                     while(idxtry < (m_ghosts.size() - 1) && Mortontry < Morton){
                         idxtry++;
-                        Mortontry = m_ghosts[idxtry].computeMorton();
+                        Mortontry = computeGhostMorton(idxtry);
                     }
                     while(idxtry > 0 && Mortontry > Morton){
                         idxtry--;
-                        Mortontry = m_ghosts[idxtry].computeMorton();
+                        Mortontry = computeGhostMorton(idxtry);
                     }
                 }
                 if(idxtry < m_sizeGhosts){
-                    if(m_ghosts[idxtry].computeMorton() == Morton && m_ghosts[idxtry].m_level == oct->m_level){
+                    if(computeGhostMorton(idxtry) == Morton && m_ghosts[idxtry].m_level == oct->m_level){
                         //Found neighbour of same size
                         isghost.push_back(true);
                         neighbours.push_back(idxtry);
@@ -1143,7 +1613,7 @@ namespace bitpit {
                         if(idxtry>m_sizeGhosts-1){
                             break;
                         }
-                        Mortontry = m_ghosts[idxtry].computeMorton();
+                        Mortontry = computeGhostMorton(idxtry);
                         coordtry = m_ghosts[idxtry].getCoord();
                     }
                 }
@@ -1213,7 +1683,7 @@ namespace bitpit {
                 int32_t jump = int32_t(idxghost/2+1);
                 idxtry = uint32_t(idxghost +((Mortontry<Morton)-(Mortontry>Morton))*jump);
                 while(abs(jump) > 0){
-                    Mortontry = m_ghosts[idxtry].computeMorton();
+                    Mortontry = computeGhostMorton(idxtry);
                     jump = ((Mortontry<Morton)-(Mortontry>Morton))*abs(jump)/2;
                     idxtry += jump;
                     if (idxtry > m_ghosts.size()-1){
@@ -1227,7 +1697,7 @@ namespace bitpit {
                         }
                     }
                 }
-                if(m_ghosts[idxtry].computeMorton() == Morton && m_ghosts[idxtry].m_level == oct->m_level){
+                if(computeGhostMorton(idxtry) == Morton && m_ghosts[idxtry].m_level == oct->m_level){
                     //Found neighbour of same size
                     isghost.push_back(true);
                     neighbours.push_back(idxtry);
@@ -1236,15 +1706,15 @@ namespace bitpit {
                 else{
                     // Step until the mortontry lower than morton (one idx of distance)
                     {
-                        while(idxtry < (m_ghosts.size() - 1) && m_ghosts[idxtry].computeMorton() < Morton){
+                        while(idxtry < (m_ghosts.size() - 1) && computeGhostMorton(idxtry) < Morton){
                             idxtry++;
                         }
-                        while(idxtry > 0 && m_ghosts[idxtry].computeMorton() > Morton){
+                        while(idxtry > 0 && computeGhostMorton(idxtry) > Morton){
                             idxtry--;
                         }
                     }
                     if(idxtry < m_sizeGhosts){
-                        if(m_ghosts[idxtry].computeMorton() == Morton && m_ghosts[idxtry].m_level == oct->m_level){
+                        if(computeGhostMorton(idxtry) == Morton && m_ghosts[idxtry].m_level == oct->m_level){
                             //Found neighbour of same size
                             isghost.push_back(true);
                             neighbours.push_back(idxtry);
@@ -1253,7 +1723,7 @@ namespace bitpit {
                         // Compute Last discendent of virtual octant of same size
                         Octant last_desc = samesizeoct.buildLastDesc();
                         uint64_t Mortonlast = last_desc.computeMorton();
-                        Mortontry = m_ghosts[idxtry].computeMorton();
+                        Mortontry = computeGhostMorton(idxtry);
                         while(Mortontry <= Mortonlast && idxtry < m_ghosts.size()){
                             Dx = int32_t(abs(cx))*(-int32_t(oct->m_x) + int32_t(m_ghosts[idxtry].m_x));
                             Dy = int32_t(abs(cy))*(-int32_t(oct->m_y) + int32_t(m_ghosts[idxtry].m_y));
@@ -1296,7 +1766,7 @@ namespace bitpit {
                             if(idxtry>m_sizeGhosts-1){
                                 break;
                             }
-                            Mortontry = m_ghosts[idxtry].computeMorton();
+                            Mortontry = computeGhostMorton(idxtry);
                         }
                     }
                 }
@@ -1323,7 +1793,7 @@ namespace bitpit {
             }
 
             while(abs(jump) > 0){
-                Mortontry = m_octants[idxtry].computeMorton();
+                Mortontry = computeMorton(idxtry);
                 jump = ((Mortontry<Morton)-(Mortontry>Morton))*abs(jump)/2;
                 idxtry += jump;
                 if (idxtry > m_octants.size()-1){
@@ -1337,7 +1807,7 @@ namespace bitpit {
                     }
                 }
             }
-            if(m_octants[idxtry].computeMorton() == Morton && m_octants[idxtry].m_level == oct->m_level){
+            if(computeMorton(idxtry) == Morton && m_octants[idxtry].m_level == oct->m_level){
                 //Found neighbour of same size
                 isghost.push_back(false);
                 neighbours.push_back(idxtry);
@@ -1346,15 +1816,15 @@ namespace bitpit {
             else{
                 // Step until the mortontry lower than morton (one idx of distance)
                 {
-                    while(idxtry < (noctants - 1) && m_octants[idxtry].computeMorton() < Morton){
+                    while(idxtry < (noctants - 1) && computeMorton(idxtry) < Morton){
                         idxtry++;
                     }
-                    while(idxtry > 0 && m_octants[idxtry].computeMorton() > Morton){
+                    while(idxtry > 0 && computeMorton(idxtry) > Morton){
                         idxtry--;
                     }
                 }
                 if (idxtry < noctants){
-                    if(m_octants[idxtry].computeMorton() == Morton && m_octants[idxtry].m_level == oct->m_level){
+                    if(computeMorton(idxtry) == Morton && m_octants[idxtry].m_level == oct->m_level){
                         //Found neighbour of same size
                         isghost.push_back(false);
                         neighbours.push_back(idxtry);
@@ -1363,7 +1833,7 @@ namespace bitpit {
                     // Compute Last discendent of virtual octant of same size
                     Octant last_desc = samesizeoct.buildLastDesc();
                     uint64_t Mortonlast = last_desc.computeMorton();
-                    Mortontry = m_octants[idxtry].computeMorton();
+                    Mortontry = computeMorton(idxtry);
                     while(Mortontry <= Mortonlast && idxtry <= noctants-1){
                         Dx = int32_t(abs(cx))*(-int32_t(oct->m_x) + int32_t(m_octants[idxtry].m_x));
                         Dy = int32_t(abs(cy))*(-int32_t(oct->m_y) + int32_t(m_octants[idxtry].m_y));
@@ -1406,7 +1876,7 @@ namespace bitpit {
                         if(idxtry>noctants-1){
                             break;
                         }
-                        Mortontry = m_octants[idxtry].computeMorton();
+                        Mortontry = computeMorton(idxtry);
                     }
                 }
             }
@@ -1483,7 +1953,7 @@ namespace bitpit {
                 if (idxtry > m_sizeGhosts-1)
                     idxtry = m_sizeGhosts-1;
                 while(abs(jump) > 0){
-                    Mortontry = m_ghosts[idxtry].computeMorton();
+                    Mortontry = computeGhostMorton(idxtry);
                     jump = ((Mortontry<Morton)-(Mortontry>Morton))*abs(jump)/2;
                     idxtry += jump;
                     if (idxtry > m_ghosts.size()-1){
@@ -1497,7 +1967,7 @@ namespace bitpit {
                         }
                     }
                 }
-                if(m_ghosts[idxtry].computeMorton() == Morton && m_ghosts[idxtry].m_level == oct->m_level){
+                if(computeGhostMorton(idxtry) == Morton && m_ghosts[idxtry].m_level == oct->m_level){
                     //Found neighbour of same size
                     isghost.push_back(true);
                     neighbours.push_back(idxtry);
@@ -1506,15 +1976,15 @@ namespace bitpit {
                 else{
                     // Step until the mortontry lower than morton (one idx of distance)
                     {
-                        while(idxtry < (m_ghosts.size() - 1) && m_ghosts[idxtry].computeMorton() < Morton){
+                        while(idxtry < (m_ghosts.size() - 1) && computeGhostMorton(idxtry) < Morton){
                             idxtry++;
                         }
-                        while(idxtry > 0 && m_ghosts[idxtry].computeMorton() > Morton){
+                        while(idxtry > 0 && computeGhostMorton(idxtry) > Morton){
                             idxtry--;
                         }
                     }
                     if(idxtry < m_sizeGhosts){
-                        if(m_ghosts[idxtry].computeMorton() == Morton && m_ghosts[idxtry].m_level == oct->m_level){
+                        if(computeGhostMorton(idxtry) == Morton && m_ghosts[idxtry].m_level == oct->m_level){
                             //Found neighbour of same size
                             isghost.push_back(true);
                             neighbours.push_back(idxtry);
@@ -1523,7 +1993,7 @@ namespace bitpit {
                         // Compute Last discendent of virtual octant of same size
                         Octant last_desc = samesizeoct.buildLastDesc();
                         uint64_t Mortonlast = last_desc.computeMorton();
-                        Mortontry = m_ghosts[idxtry].computeMorton();
+                        Mortontry = computeGhostMorton(idxtry);
                         int32_t Dx[3] = {0,0,0};
                         int32_t Dxstar[3] = {0,0,0};
                         u32array3 coord = oct->getCoord();
@@ -1546,7 +2016,7 @@ namespace bitpit {
                             if(idxtry>m_sizeGhosts-1){
                                 break;
                             }
-                            Mortontry = m_ghosts[idxtry].computeMorton();
+                            Mortontry = computeGhostMorton(idxtry);
                             coordtry = m_ghosts[idxtry].getCoord();
                         }
                     }
@@ -1574,7 +2044,7 @@ namespace bitpit {
                     idxtry = noctants-1;
             }
             while(abs(jump) > 0){
-                Mortontry = m_octants[idxtry].computeMorton();
+                Mortontry = computeMorton(idxtry);
                 jump = ((Mortontry<Morton)-(Mortontry>Morton))*abs(jump)/2;
                 idxtry += jump;
                 if (idxtry > m_octants.size()-1){
@@ -1588,7 +2058,7 @@ namespace bitpit {
                     }
                 }
             }
-            if(m_octants[idxtry].computeMorton() == Morton && m_octants[idxtry].m_level == oct->m_level){
+            if(computeMorton(idxtry) == Morton && m_octants[idxtry].m_level == oct->m_level){
                 //Found neighbour of same size
                 isghost.push_back(false);
                 neighbours.push_back(idxtry);
@@ -1597,15 +2067,15 @@ namespace bitpit {
             else{
                 // Step until the mortontry lower than morton (one idx of distance)
                 {
-                    while(idxtry < (noctants - 1) && m_octants[idxtry].computeMorton() < Morton){
+                    while(idxtry < (noctants - 1) && computeMorton(idxtry) < Morton){
                         idxtry++;
                     }
-                    while(idxtry > 0 && m_octants[idxtry].computeMorton() > Morton){
+                    while(idxtry > 0 && computeMorton(idxtry) > Morton){
                         idxtry--;
                     }
                 }
                 if (idxtry < noctants){
-                    if(m_octants[idxtry].computeMorton() == Morton && m_octants[idxtry].m_level == oct->m_level){
+                    if(computeMorton(idxtry) == Morton && m_octants[idxtry].m_level == oct->m_level){
                         //Found neighbour of same size
                         isghost.push_back(false);
                         neighbours.push_back(idxtry);
@@ -1614,7 +2084,7 @@ namespace bitpit {
                     // Compute Last discendent of virtual octant of same size
                     Octant last_desc = samesizeoct.buildLastDesc();
                     uint64_t Mortonlast = last_desc.computeMorton();
-                    Mortontry = m_octants[idxtry].computeMorton();
+                    Mortontry = computeMorton(idxtry);
                     int32_t Dx[3] = {0,0,0};
                     int32_t Dxstar[3] = {0,0,0};
                     u32array3 coord = oct->getCoord();
@@ -1637,7 +2107,7 @@ namespace bitpit {
                         if(idxtry>noctants-1){
                             break;
                         }
-                        Mortontry = m_octants[idxtry].computeMorton();
+                        Mortontry = computeMorton(idxtry);
                         coordtry = m_octants[idxtry].getCoord();
                     }
                 }
@@ -1962,9 +2432,9 @@ namespace bitpit {
             // ---> can i search only before or after idx in octants
             int32_t jump = int32_t((noctants)/2+1);
             idxtry = uint32_t(jump);
-            Mortontry = m_octants[idxtry].computeMorton();
+            Mortontry = computeMorton(idxtry);
             while(abs(jump) > 0){
-                Mortontry = m_octants[idxtry].computeMorton();
+                Mortontry = computeMorton(idxtry);
                 jump = ((Mortontry<Morton)-(Mortontry>Morton))*abs(jump)/2;
                 idxtry += jump;
                 if (idxtry > noctants-1){
@@ -1978,7 +2448,7 @@ namespace bitpit {
                     }
                 }
             }
-            Mortontry = m_octants[idxtry].computeMorton();
+            Mortontry = computeMorton(idxtry);
             if(Mortontry == Morton && m_octants[idxtry].m_level == oct->m_level){
                 //Found neighbour of same size
                 isghost.push_back(false);
@@ -1990,11 +2460,11 @@ namespace bitpit {
                 {
                     while(idxtry < (noctants - 1) && Mortontry < Morton){
                         idxtry++;
-                        Mortontry = m_octants[idxtry].computeMorton();
+                        Mortontry = computeMorton(idxtry);
                     }
                     while(idxtry > 0 && Mortontry > Morton){
                         idxtry--;
-                        Mortontry = m_octants[idxtry].computeMorton();
+                        Mortontry = computeMorton(idxtry);
                     }
                 }
 
@@ -2007,7 +2477,7 @@ namespace bitpit {
                 // Compute Last discendent of virtual octant of same size
                 Octant last_desc = samesizeoct.buildLastDesc();
                 uint64_t Mortonlast = last_desc.computeMorton();
-                Mortontry = m_octants[idxtry].computeMorton();
+                Mortontry = computeMorton(idxtry);
                 int64_t Dx[3] = {0,0,0};
                 int64_t Dxstar[3] = {0,0,0};
                 array<int64_t,3> coord = oct->getPeriodicCoord(iface);
@@ -2045,7 +2515,7 @@ namespace bitpit {
                     if(idxtry>noctants-1){
                         break;
                     }
-                    Mortontry = m_octants[idxtry].computeMorton();
+                    Mortontry = computeMorton(idxtry);
                     coordtry = m_octants[idxtry].getCoord();
                 }
                 return;
@@ -2071,7 +2541,7 @@ namespace bitpit {
 				idxtry = uint32_t(idxghost +((Mortontry<Morton)-(Mortontry>Morton))*jump);
 				if (idxtry > m_ghosts.size()-1) idxtry = m_ghosts.size()-1;
 				while(abs(jump) > 0){
-					Mortontry = m_ghosts[idxtry].computeMorton();
+					Mortontry = computeGhostMorton(idxtry);
 					jump = ((Mortontry<Morton)-(Mortontry>Morton))*abs(jump)/2;
 					idxtry += jump;
 					if (idxtry > m_ghosts.size()-1){
@@ -2085,7 +2555,7 @@ namespace bitpit {
 						}
 					}
 				}
-				Mortontry = m_ghosts[idxtry].computeMorton();
+				Mortontry = computeGhostMorton(idxtry);
 				if(Mortontry == Morton && m_ghosts[idxtry].m_level == oct->m_level){
 					//Found neighbour of same size
 					isghost.push_back(true);
@@ -2097,15 +2567,15 @@ namespace bitpit {
 					{
 						while(idxtry < (m_ghosts.size() - 1) && Mortontry < Morton){
 							idxtry++;
-							Mortontry = m_ghosts[idxtry].computeMorton();
+							Mortontry = computeGhostMorton(idxtry);
 						}
 						while(idxtry > 0 && Mortontry > Morton){
 							idxtry--;
-							Mortontry = m_ghosts[idxtry].computeMorton();
+							Mortontry = computeGhostMorton(idxtry);
 						}
 					}
 					if(idxtry < m_sizeGhosts){
-						if(m_ghosts[idxtry].computeMorton() == Morton && m_ghosts[idxtry].m_level == oct->m_level){
+						if(computeGhostMorton(idxtry) == Morton && m_ghosts[idxtry].m_level == oct->m_level){
 							//Found neighbour of same size
 							isghost.push_back(true);
 							neighbours.push_back(idxtry);
@@ -2114,7 +2584,7 @@ namespace bitpit {
 						// Compute Last discendent of virtual octant of same size
 						Octant last_desc = samesizeoct.buildLastDesc();
 						uint64_t Mortonlast = last_desc.computeMorton();
-						Mortontry = m_ghosts[idxtry].computeMorton();
+						Mortontry = computeGhostMorton(idxtry);
 						int32_t Dx[3] = {0,0,0};
 						int32_t Dxstar[3] = {0,0,0};
 						array<int64_t,3> coord = oct->getPeriodicCoord(iface);
@@ -2151,7 +2621,7 @@ namespace bitpit {
 							if(idxtry>m_sizeGhosts-1){
 								break;
 							}
-							Mortontry = m_ghosts[idxtry].computeMorton();
+							Mortontry = computeGhostMorton(idxtry);
 							coordtry = m_ghosts[idxtry].getCoord();
 						}
 					}
@@ -2174,7 +2644,7 @@ namespace bitpit {
                     int32_t jump = (int32_t((noctants)/2+1));
                     idxtry = uint32_t(jump);
                     while(abs(jump) > 0){
-                        Mortontry = m_octants[idxtry].computeMorton();
+                        Mortontry = computeMorton(idxtry);
                         jump = ((Mortontry<Morton)-(Mortontry>Morton))*abs(jump)/2;
                         idxtry += jump;
                         if (idxtry > noctants-1){
@@ -2188,7 +2658,7 @@ namespace bitpit {
                             }
                         }
                     }
-                    Mortontry = m_octants[idxtry].computeMorton();
+                    Mortontry = computeMorton(idxtry);
                     if(Mortontry == Morton && m_octants[idxtry].m_level == oct->m_level){
                         //Found neighbour of same size
                         isghost.push_back(false);
@@ -2200,11 +2670,11 @@ namespace bitpit {
                         {
                             while(idxtry < (noctants - 1) && Mortontry < Morton){
                                 idxtry++;
-                                Mortontry = m_octants[idxtry].computeMorton();
+                                Mortontry = computeMorton(idxtry);
                             }
                             while(idxtry > 0 && Mortontry > Morton){
                                 idxtry--;
-                                Mortontry = m_octants[idxtry].computeMorton();
+                                Mortontry = computeMorton(idxtry);
                             }
                         }
                         if(Mortontry == Morton && m_octants[idxtry].m_level == oct->m_level){
@@ -2216,7 +2686,7 @@ namespace bitpit {
                         // Compute Last discendent of virtual octant of same size
                         Octant last_desc = samesizeoct.buildLastDesc();
                         uint64_t Mortonlast = last_desc.computeMorton();
-                        Mortontry = m_octants[idxtry].computeMorton();
+                        Mortontry = computeMorton(idxtry);
                         int32_t Dx[3] = {0,0,0};
                         int32_t Dxstar[3] = {0,0,0};
                         array<int64_t,3> coord = oct->getPeriodicCoord(iface);
@@ -2253,7 +2723,7 @@ namespace bitpit {
                             if(idxtry>noctants-1){
                                 break;
                             }
-                            Mortontry = m_octants[idxtry].computeMorton();
+                            Mortontry = computeMorton(idxtry);
                             coordtry = m_octants[idxtry].getCoord();
                         }
                         return;
@@ -2303,10 +2773,10 @@ namespace bitpit {
             // ---> can i search only before or after idx in octants
             int32_t jump = getNumOctants()/2;
             idxtry = uint32_t(getNumOctants()/2);
-            Mortontry = m_octants[idxtry].computeMorton();
+            Mortontry = computeMorton(idxtry);
             while(abs(jump) > 0){
 
-                Mortontry = m_octants[idxtry].computeMorton();
+                Mortontry = computeMorton(idxtry);
                 jump = ((Mortontry<Morton)-(Mortontry>Morton))*abs(jump)/2;
                 idxtry += jump;
                 if (idxtry > noctants-1){
@@ -2320,7 +2790,7 @@ namespace bitpit {
                     }
                 }
             }
-            Mortontry = m_octants[idxtry].computeMorton();
+            Mortontry = computeMorton(idxtry);
             if(Mortontry == Morton && m_octants[idxtry].m_level == oct->m_level){
                 //Found neighbour of same size
                 neighbours.push_back(idxtry);
@@ -2331,11 +2801,11 @@ namespace bitpit {
                 {
                     while(idxtry < (noctants - 1) && Mortontry < Morton){
                         idxtry++;
-                        Mortontry = m_octants[idxtry].computeMorton();
+                        Mortontry = computeMorton(idxtry);
                     }
                     while(idxtry > 0 && Mortontry > Morton){
                         idxtry--;
-                        Mortontry = m_octants[idxtry].computeMorton();
+                        Mortontry = computeMorton(idxtry);
                     }
                 }
                 if(Mortontry == Morton && m_octants[idxtry].m_level == oct->m_level){
@@ -2346,7 +2816,7 @@ namespace bitpit {
                 // Compute Last discendent of virtual octant of same size
                 Octant last_desc = samesizeoct.buildLastDesc();
                 uint64_t Mortonlast = last_desc.computeMorton();
-                Mortontry = m_octants[idxtry].computeMorton();
+                Mortontry = computeMorton(idxtry);
                 int32_t Dx[3] = {0,0,0};
                 int32_t Dxstar[3] = {0,0,0};
                 array<int64_t,3> coord = oct->getPeriodicCoord(iface);
@@ -2381,7 +2851,7 @@ namespace bitpit {
                     if(idxtry>noctants-1){
                         break;
                     }
-                    Mortontry = m_octants[idxtry].computeMorton();
+                    Mortontry = computeMorton(idxtry);
                     coordtry = m_octants[idxtry].getCoord();
                 }
                 return;
@@ -2426,13 +2896,13 @@ namespace bitpit {
         bool checkend = true;
         bool checkstart = true;
         if (m_ghosts.size()){
-            while(m_ghosts[idx2_gh].computeMorton() <= m_lastDescMorton){
+            while(computeGhostMorton(idx2_gh) <= m_lastDescMorton){
                 idx2_gh++;
                 if (idx2_gh > m_sizeGhosts-1) break;
             }
             if (idx2_gh > m_sizeGhosts-1) checkend = false;
 
-            while(m_ghosts[idx1_gh].computeMorton() <= m_octants[0].computeMorton()){
+            while(computeGhostMorton(idx1_gh) <= computeMorton(0)){
                 idx1_gh++;
                 if (idx1_gh > m_sizeGhosts-1) break;
             }
@@ -2537,7 +3007,7 @@ namespace bitpit {
                 for (idx=0; idx<m_treeConstants->nChildren; idx++){
                     if (idx<nocts){
                         // Check if family is complete or to be checked in the internal loop (some brother refined)
-                        if (m_octants[idx].computeMorton() <= mortonld){
+                        if (computeMorton(idx) <= mortonld){
                             nbro++;
                         }
                     }
@@ -2609,13 +3079,13 @@ namespace bitpit {
         bool checkend = true;
         bool checkstart = true;
         if (m_ghosts.size()){
-            while(m_ghosts[idx2_gh].computeMorton() <= m_lastDescMorton){
+            while(computeGhostMorton(idx2_gh) <= m_lastDescMorton){
                 idx2_gh++;
                 if (idx2_gh > m_sizeGhosts-1) break;
             }
             if (idx2_gh > m_sizeGhosts-1) checkend = false;
 
-            while(m_ghosts[idx1_gh].computeMorton() <= m_octants[0].computeMorton()){
+            while(computeGhostMorton(idx1_gh) <= computeMorton(0)){
                 idx1_gh++;
                 if (idx1_gh > m_sizeGhosts-1) break;
             }
@@ -2721,7 +3191,7 @@ namespace bitpit {
         for (idx=0; idx<m_treeConstants->nChildren; idx++){
             // Check if family is complete or to be checked in the internal loop (some brother refined)
             if (idx<nocts){
-                if (m_octants[idx].computeMorton() <= mortonld){
+                if (computeMorton(idx) <= mortonld){
                     nbro++;
                 }
             }
@@ -2763,10 +3233,15 @@ namespace bitpit {
      * requested, also on new octants.
      * \param[in] doNew Set to true the balance is enforced also on new octants.
      * \param[in] doInterior Set to false if the interior octants are already balanced.
+     * \param[in] ghosts If not null and the interior octants are already balanced,
+     * only the listed ghost octants are examined instead of all the ghosts with the
+     * AUX bit set.
+     * \param[out] nVisited If not null, on output will contain the number of octants
+     * (local and ghost) whose neighbourhood has been examined.
      * \return True if balanced done with some markers modification.
      */
     bool
-    LocalTree::localBalance(bool doNew, bool doInterior){
+    LocalTree::localBalance(bool doNew, bool doInterior, const u32vector *ghosts, uint32_t *nVisited){
 
         uint32_t			sizeneigh, modsize;
         u32vector		 	neigh;
@@ -2776,6 +3251,7 @@ namespace bitpit {
         int8_t				targetmarker;
         vector<bool> 		isghost;
         bool				Bdone = false;
+        uint32_t			nVisits = 0;
         bool				Bedge = ((m_balanceCodim>1) && (m_dim==3));
         bool				Bnode = (m_balanceCodim==m_dim);
 
@@ -2799,6 +3275,7 @@ namespace bitpit {
                 }
 
                 if (balanceOctant){
+                    ++nVisits;
                     targetmarker = min(TreeConstants::MAX_LEVEL, int8_t(m_octants[idx].getLevel() + m_octants[idx].getMarker()));
 
                     //Balance through faces
@@ -2924,6 +3401,7 @@ namespace bitpit {
                 }
 
                 if (balanceOctant){
+                    ++nVisits;
                     targetmarker = min(TreeConstants::MAX_LEVEL, int8_t(it->getLevel()+it->getMarker()));
 
                     //Balance through faces
@@ -2993,6 +3471,7 @@ namespace bitpit {
                 for (iit=ibegin; iit!=iend; ++iit){
                     idx = *iit;
                     if (m_octants[idx].getBalance()){
+                        ++nVisits;
                         targetmarker = min(TreeConstants::MAX_LEVEL, int8_t(m_octants[idx].getLevel()+m_octants[idx].getMarker()));
 
                         //Balance through faces
@@ -3089,10 +3568,12 @@ namespace bitpit {
         else{
 
             // Loop on ghost octants (influence over interior borders)
-            obegin = m_ghosts.begin();
-            oend = m_ghosts.end();
-            idx = 0;
-            for (it=obegin; it!=oend; ++it){
+            //
+            // When a frontier is given, only the ghosts it lists are examined.
+            std::size_t nCandidates = (ghosts ? ghosts->size() : m_ghosts.size());
+            for (std::size_t n = 0; n < nCandidates; ++n){
+                idx = (ghosts ? (*ghosts)[n] : n);
+                it = m_ghosts.begin() + idx;
                 bool balanceOctant = it->getBalance();
                 if (balanceOctant) {
                     if (doNew) {
@@ -3103,6 +3584,7 @@ namespace bitpit {
                 }
 
                 if (balanceOctant){
+                    ++nVisits;
                     targetmarker = min(TreeConstants::MAX_LEVEL, int8_t(it->getLevel()+it->getMarker()));
 
                     //Balance through faces
@@ -3160,7 +3642,6 @@ namespace bitpit {
                     }
 
                 }
-                idx++;
             }
 
             // While loop for iterative balancing
@@ -3172,6 +3653,7 @@ namespace bitpit {
                 for (iit=ibegin; iit!=iend; ++iit){
                     idx = *iit;
                     if (m_octants[idx].getBalance()){
+                        ++nVisits;
                         targetmarker = min(TreeConstants::MAX_LEVEL, int8_t(m_octants[idx].getLevel()+m_octants[idx].getMarker()));
 
                         //Balance through faces
@@ -3266,6 +3748,10 @@ namespace bitpit {
             obegin = oend = m_octants.end();
             ibegin = iend = modified.end();
         }
+        if (nVisited) {
+            *nVisited = nVisits;
+        }
+
         return Bdone;
         // Pay attention : info[15] may be true after local balance for some octants
     };
@@ -3504,6 +3990,10 @@ namespace bitpit {
      */
     uint32_t
     LocalTree::findMorton(uint64_t Morton) const {
+        if (m_areOctantsMortonsValid) {
+            return _findMorton(Morton, m_octantsMortons);
+        }
+
         return _findMorton(Morton, m_octants);
     };
 
@@ -3514,6 +4004,10 @@ namespace bitpit {
      */
     uint32_t
     LocalTree::findGhostMorton(uint64_t Morton) const {
+        if (m_areGhostsMortonsValid) {
+            return _findMorton(Morton, m_ghostsMortons);
+        }
+
         return _findMorton(Morton, m_ghosts);
     };
 
@@ -3546,25 +4040,59 @@ namespace bitpit {
         return nocts;
     };
 
+    // =================================================================================== //
+    /*! Find the index of the specified Morton in the given sorted list of
+     *  Morton numbers.
+     * \param[in] Morton Morton index to be found.
+     * \param[in] mortons sorted list of Morton numbers
+     * \return Position of the target Morton (=size of the list if target Morton not found).
+     */
+    uint32_t
+    LocalTree::_findMorton(uint64_t Morton, const u64vector &mortons) const {
+
+        uint32_t nocts = mortons.size();
+
+        u64vector::const_iterator itr = std::lower_bound(mortons.begin(), mortons.end(), Morton);
+        if (itr == mortons.end() || *itr != Morton) {
+            return nocts;
+        }
+
+        return static_cast<uint32_t>(itr - mortons.begin());
+    };
+
     // =================================================================================== //
 
     /** Compute the connectivity of octants and store the coordinates of nodes.
+     *
+     * Nodes are deduplicated sorting the keys of the nodes of all the octants:
+     * for each node of each octant an entry containing the key of the node and
+     * the position of the node in the connectivity is generated, the entries
+     * are then sorted by key with a stable radix sort. Entries with the same
+     * key refer to the same node.
+     *
+     * In flat mode, the connectivity is stored in a single array with a fixed
+     * stride (the nodes of the i-th octant are stored in the range
+     * [i * nNodes, (i + 1) * nNodes)), otherwise the connectivity of each octant
+     * is stored in a separate vector.
+     *
+     * \param[in] flat if set to true the connectivity will be computed in flat
+     * mode
      */
     void
-    LocalTree::computeConnectivity(){
-        vector<uint64_t>                             mortonList;
-        unordered_map<uint64_t, array<uint32_t, 3> > nodeCoords;
-        unordered_map<uint64_t, vector<uint64_t> >   nodeOctants;
+    LocalTree::computeConnectivity(bool flat){
         uint32_t                                     noctants = getNumOctants();
         uint32_t                                     nghosts  = m_sizeGhosts;
-
-
+        uint8_t                                      nNodes   = m_treeConstants->nNodes;
 
         // Gather node information
-        mortonList.reserve(noctants);
-        nodeCoords.reserve(noctants);
-        nodeOctants.reserve(noctants);
+        //
+        // Each entry contains the key of the node and the position of the
+        // node in the connectivity. Ghosts connectivity follows the octants
+        // connectivity.
+        uint64_t nOctantEntries = uint64_t(noctants) * nNodes;
+        uint64_t nEntries       = uint64_t(noctants + nghosts) * nNodes;
 
+        vector<pair<uint64_t, uint64_t>> entries(nEntries);
         for (uint64_t n = 0; n < (noctants + nghosts); n++){
             const Octant *octant;
             if (n < noctants) {
@@ -3575,46 +4103,129 @@ namespace bitpit {
                 octant = &(m_ghosts[octantId]);
             }
 
-            for (uint8_t i = 0; i < m_treeConstants->nNodes; ++i){
+            for (uint8_t i = 0; i < nNodes; ++i){
                 u32array3 node;
                 octant->getNode(node, i);
 
-                uint64_t morton = octant->computeNodeMorton(node);
-                if (nodeCoords.count(morton) == 0) {
-                    mortonList.push_back(morton);
-                    nodeCoords.insert({{morton, std::move(node)}});
-                    nodeOctants[morton].reserve(m_treeConstants->nNodes);
+                uint64_t position = n * nNodes + i;
+                entries[position] = make_pair(octant->computeNodeMorton(node), position);
+            }
+        }
+
+        // Sort the entries by key
+        //
+        // A least significant digit radix sort is used. The sort is stable,
+        // hence entries with the same key are kept in the order of the
+        // octants. The histograms of all the digits are evaluated in a single
+        // pass, digits for which all the entries fall in the same bucket are
+        // skipped.
+        const int RADIX_BITS    = 8;
+        const int RADIX_BUCKETS = 1 << RADIX_BITS;
+        const int RADIX_DIGITS  = 64 / RADIX_BITS;
+
+        vector<array<uint64_t, RADIX_BUCKETS>> histograms(RADIX_DIGITS);
+        for (array<uint64_t, RADIX_BUCKETS> &histogram : histograms) {
+            histogram.fill(0);
+        }
+
+        for (const pair<uint64_t, uint64_t> &entry : entries) {
+            for (int digit = 0; digit < RADIX_DIGITS; ++digit) {
+                ++histograms[digit][(entry.first >> (digit * RADIX_BITS)) & (RADIX_BUCKETS - 1)];
+            }
+        }
+
+        vector<pair<uint64_t, uint64_t>> sortedEntries;
+        for (int digit = 0; digit < RADIX_DIGITS; ++digit) {
+            array<uint64_t, RADIX_BUCKETS> &histogram = histograms[digit];
+
+            uint64_t offset = 0;
+            bool isTrivial = false;
+            for (int bucket = 0; bucket < RADIX_BUCKETS; ++bucket) {
+                uint64_t bucketSize = histogram[bucket];
+                if (bucketSize == nEntries) {
+                    isTrivial = true;
+                    break;
                 }
 
-                nodeOctants[morton].push_back(n);
+                histogram[bucket] = offset;
+                offset += bucketSize;
+            }
+
+            if (isTrivial) {
+                continue;
             }
+
+            sortedEntries.resize(nEntries);
+            for (const pair<uint64_t, uint64_t> &entry : entries) {
+                uint64_t &bucketOffset = histogram[(entry.first >> (digit * RADIX_BITS)) & (RADIX_BUCKETS - 1)];
+                sortedEntries[bucketOffset++] = entry;
+            }
+            entries.swap(sortedEntries);
         }
-        std::sort(mortonList.begin(), mortonList.end());
+
+        vector<pair<uint64_t, uint64_t>>().swap(sortedEntries);
 
         // Build node list and connectivity
-        m_nodes.reserve(mortonList.size());
-        m_connectivity.resize(noctants);
-        m_ghostsConnectivity.resize(nghosts);
+        uint64_t nUniqueNodes = 0;
+        for (uint64_t k = 0; k < nEntries; ++k) {
+            if (k == 0 || entries[k].first != entries[k - 1].first) {
+                ++nUniqueNodes;
+            }
+        }
+
+        m_nodes.reserve(nUniqueNodes);
+        m_flatConnectivity.resize(nOctantEntries);
+        m_flatGhostsConnectivity.resize(nEntries - nOctantEntries);
 
         uint32_t nodeId = 0;
-        for (uint64_t morton : mortonList) {
-            m_nodes.emplace_back(std::move(nodeCoords.at(morton)));
-            for (uint64_t n : nodeOctants.at(morton)) {
-                std::vector<uint32_t> *octantConnect;
+        for (uint64_t k = 0; k < nEntries; ++k) {
+            uint64_t position = entries[k].second;
+            if (k == 0 || entries[k].first != entries[k - 1].first) {
+                if (k > 0) {
+                    nodeId++;
+                }
+
+                uint64_t n = position / nNodes;
+                uint8_t  i = position % nNodes;
+
+                const Octant *octant;
                 if (n < noctants) {
-                    uint32_t octantId = n;
-                    octantConnect = &(m_connectivity[octantId]);
+                    octant = &(m_octants[n]);
                 } else {
-                    uint32_t octantId = n - noctants;
-                    octantConnect = &(m_ghostsConnectivity[octantId]);
+                    octant = &(m_ghosts[n - noctants]);
                 }
 
-                if (octantConnect->size() == 0) {
-                    octantConnect->reserve(m_treeConstants->nNodes);
-                }
-                octantConnect->push_back(nodeId);
+                u32array3 node;
+                octant->getNode(node, i);
+                m_nodes.emplace_back(std::move(node));
+            }
+
+            if (position < nOctantEntries) {
+                m_flatConnectivity[position] = nodeId;
+            } else {
+                m_flatGhostsConnectivity[position - nOctantEntries] = nodeId;
             }
-            nodeId++;
+        }
+
+        vector<pair<uint64_t, uint64_t>>().swap(entries);
+
+        // Store the connectivity of each octant in a separate vector
+        m_isConnectivityFlat = flat;
+        if (!m_isConnectivityFlat) {
+            m_connectivity.resize(noctants);
+            for (uint32_t n = 0; n < noctants; ++n) {
+                const uint32_t *octantConnect = m_flatConnectivity.data() + uint64_t(n) * nNodes;
+                m_connectivity[n].assign(octantConnect, octantConnect + nNodes);
+            }
+
+            m_ghostsConnectivity.resize(nghosts);
+            for (uint32_t n = 0; n < nghosts; ++n) {
+                const uint32_t *ghostConnect = m_flatGhostsConnectivity.data() + uint64_t(n) * nNodes;
+                m_ghostsConnectivity[n].assign(ghostConnect, ghostConnect + nNodes);
+            }
+
+            u32vector().swap(m_flatConnectivity);
+            u32vector().swap(m_flatGhostsConnectivity);
         }
     };
 
@@ -3625,14 +4236,194 @@ namespace bitpit {
         u32arr3vector().swap(m_nodes);
         u32vector2D().swap(m_connectivity);
         u32vector2D().swap(m_ghostsConnectivity);
+        u32vector().swap(m_flatConnectivity);
+        u32vector().swap(m_flatGhostsConnectivity);
+        m_isConnectivityFlat = false;
     };
 
     /*! Updates nodes vector and connectivity of octants of local tree
      */
     void
     LocalTree::updateConnectivity(){
+        bool flat = m_isConnectivityFlat;
         clearConnectivity();
-        computeConnectivity();
+        computeConnectivity(flat);
+    };
+
+    /*! Check if the hot fields of the local octants are mirrored in
+     * structure-of-arrays form.
+     * \return True if the structure-of-arrays storage is enabled.
+     */
+    bool
+    LocalTree::isOctantsSoAEnabled() const{
+        return m_isOctantsSoAEnabled;
+    };
+
+    /*! Enable or disable the structure-of-arrays storage of the local octants.
+     *
+     * When enabled, coordinates, levels, markers and info flags of the local
+     * octants are also stored in separate contiguous arrays (the dimension is
+     * stored once for the whole tree). The octant vector remains the reference
+     * storage: the arrays are rebuilt at the end of every operation that changes
+     * the structure of the tree and are used to serve the index based getters.
+     * Since the arrays are an additional copy, enabling them increases the
+     * memory used per local octant.
+     * \param[in] enabled True to enable the structure-of-arrays storage.
+     */
+    void
+    LocalTree::setOctantsSoAEnabled(bool enabled){
+        m_isOctantsSoAEnabled = enabled;
+        updateOctantsSoA();
+    };
+
+    /*! Mark the structure-of-arrays storage as out of sync with the local
+     * octants. Until the storage is updated, the getters will read the data
+     * from the octant vector.
+     */
+    void
+    LocalTree::invalidateOctantsSoA(){
+        m_isOctantsSoAValid = false;
+    };
+
+    /*! Rebuild the structure-of-arrays storage from the local octants.
+     *
+     * If the storage is disabled, the arrays are released.
+     */
+    void
+    LocalTree::updateOctantsSoA(){
+        if (!m_isOctantsSoAEnabled) {
+            u32vector().swap(m_octantsX);
+            u32vector().swap(m_octantsY);
+            u32vector().swap(m_octantsZ);
+            u8vector().swap(m_octantsLevel);
+            i8vector().swap(m_octantsMarker);
+            u16vector().swap(m_octantsInfo);
+
+            m_isOctantsSoAValid = false;
+
+            return;
+        }
+
+        std::size_t nOctants = m_octants.size();
+
+        m_octantsX.resize(nOctants);
+        m_octantsY.resize(nOctants);
+        m_octantsZ.resize((m_dim == 3) ? nOctants : 0);
+        m_octantsLevel.resize(nOctants);
+        m_octantsMarker.resize(nOctants);
+        m_octantsInfo.resize(nOctants);
+
+        for (std::size_t i = 0; i < nOctants; ++i) {
+            const Octant &octant = m_octants[i];
+
+            m_octantsX[i]      = octant.m_x;
+            m_octantsY[i]      = octant.m_y;
+            m_octantsLevel[i]  = octant.m_level;
+            m_octantsMarker[i] = octant.m_marker;
+            m_octantsInfo[i]   = static_cast<uint16_t>(octant.m_info.to_ulong());
+        }
+
+        if (m_dim == 3) {
+            for (std::size_t i = 0; i < nOctants; ++i) {
+                m_octantsZ[i] = m_octants[i].m_z;
+            }
+        }
+
+        m_isOctantsSoAValid = true;
+    };
+
+    /*! Update the structure-of-arrays storage of the specified octant.
+     *
+     * Only the marker and the info flags are updated, ghost octants and
+     * octants not belonging to the tree are ignored.
+     * \param[in] octant Pointer to the octant.
+     */
+    void
+    LocalTree::updateOctantSoA(const Octant *octant){
+        if (!m_isOctantsSoAValid || m_octants.empty()) {
+            return;
+        }
+
+        const Octant *begin = m_octants.data();
+        if (octant < begin || octant >= begin + m_octants.size()) {
+            return;
+        }
+
+        std::size_t idx = octant - begin;
+        m_octantsMarker[idx] = octant->m_marker;
+        m_octantsInfo[idx]   = static_cast<uint16_t>(octant->m_info.to_ulong());
+    };
+
+    /*! Mark the cached Morton numbers of the local octants as out of sync with
+     * the octants. Until the cache is updated, the Morton numbers will be
+     * computed from the coordinates of the octants.
+     */
+    void
+    LocalTree::invalidateOctantsMortons(){
+        m_areOctantsMortonsValid = false;
+    };
+
+    /*! Mark the cached Morton numbers of the ghost octants as out of sync with
+     * the ghosts. Until the cache is updated, the Morton numbers will be
+     * computed from the coordinates of the ghosts.
+     */
+    void
+    LocalTree::invalidateGhostsMortons(){
+        m_areGhostsMortonsValid = false;
+    };
+
+    /*! Rebuild the cached Morton numbers of the local octants.
+     */
+    void
+    LocalTree::updateOctantsMortons(){
+        computeMortons(m_octants, &m_octantsMortons);
+
+        m_areOctantsMortonsValid = true;
+    };
+
+    /*! Rebuild the cached Morton numbers of the ghost octants.
+     */
+    void
+    LocalTree::updateGhostsMortons(){
+        computeMortons(m_ghosts, &m_ghostsMortons);
+
+        m_areGhostsMortonsValid = true;
+    };
+
+    /*! Compute the Morton numbers of the specified octants using the batch
+     * Morton kernels. Coordinates are gathered in small blocks, so that the
+     * kernels can work on contiguous arrays without allocating a full copy
+     * of the coordinates. Large sets of octants are processed using multiple
+     * threads.
+     * \param[in] octants Octants whose Morton numbers will be computed.
+     * \param[out] mortons On output will contain the Morton numbers of the
+     * octants.
+     */
+    void
+    LocalTree::computeMortons(const octvector &octants, u64vector *mortons){
+        const std::size_t BLOCK_SIZE = 256;
+
+        std::size_t nOctants = octants.size();
+        mortons->resize(nOctants);
+
+#if BITPIT_ENABLE_OPENMP==1
+        #pragma omp parallel for schedule(static) if(nOctants >= THREADED_ADAPT_MIN_OCTANTS)
+#endif
+        for (std::size_t begin = 0; begin < nOctants; begin += BLOCK_SIZE) {
+            uint32_t x[BLOCK_SIZE];
+            uint32_t y[BLOCK_SIZE];
+            uint32_t z[BLOCK_SIZE];
+
+            std::size_t blockSize = std::min(BLOCK_SIZE, nOctants - begin);
+            for (std::size_t k = 0; k < blockSize; ++k) {
+                const Octant &octant = octants[begin + k];
+                x[k] = octant.m_x;
+                y[k] = octant.m_y;
+                z[k] = octant.m_z;
+            }
+
+            PABLO::computeMortons(blockSize, x, y, z, mortons->data() + begin);
+        }
     };
 
     // =================================================================================== //
@@ -97,6 +97,14 @@ public:
 	 */
 	typedef std::vector<uint8_t>				u8vector;
 
+	/*!Vector of int (8-bit).
+	 */
+	typedef std::vector<int8_t>					i8vector;
+
+	/*!Vector of unsigned int (16-bit).
+	 */
+	typedef std::vector<uint16_t>				u16vector;
+
 	/*!Vector of usigned int (32-bit).
 	 */
 	typedef std::vector<uint32_t>				u32vector;
@@ -114,6 +122,8 @@ public:
 	// =================================================================================== //
 
 private:
+	static const uint32_t	THREADED_ADAPT_MIN_OCTANTS = 4096;	/**< Minimum number of octants needed for adapting the local tree using multiple threads */
+
 	octvector				m_octants;				/**< Local vector of octants ordered with Morton Number */
 	octvector				m_ghosts;				/**< Local vector of ghost octants ordered with Morton Number */
 	intervector				m_intersections;		/**< Local vector of intersections */
@@ -132,8 +142,27 @@ private:
 	 	 	 	 	 	 	 	 	 	 	 	 	 	 The nodes are stored as index of vector nodes*/
 	u32vector2D				m_ghostsConnectivity;	/**<Local vector of ghosts connectivity (node1, node2, ...) ordered with Morton-order.
 	 	 	 	 	 	 	 	 	 	 	 	 	 	 The nodes are stored as index of vector nodes*/
+	u32vector				m_flatConnectivity;		/**<Local flat connectivity, the nodes of the i-th octant are stored in the range [i * nNodes, (i + 1) * nNodes).
+	 	 	 	 	 	 	 	 	 	 	 	 	 	 Used only when the connectivity is computed in flat mode*/
+	u32vector				m_flatGhostsConnectivity;	/**<Local flat connectivity of the ghosts, the nodes of the i-th ghost are stored in the range [i * nNodes, (i + 1) * nNodes).
+	 	 	 	 	 	 	 	 	 	 	 	 	 	 Used only when the connectivity is computed in flat mode*/
+	bool					m_isConnectivityFlat;	/**<True if the connectivity is computed in flat mode*/
 	u32arr3vector			m_nodes;				/**<Local vector of nodes (x,y,z) ordered with Morton Number*/
 
+	bool					m_isOctantsSoAEnabled;	/**<True if the hot fields of the local octants are mirrored in structure-of-arrays form*/
+	bool					m_isOctantsSoAValid;	/**<True if the structure-of-arrays storage is in sync with the local octants*/
+	u32vector				m_octantsX;				/**<Logical x coordinate of the local octants (structure-of-arrays storage)*/
+	u32vector				m_octantsY;				/**<Logical y coordinate of the local octants (structure-of-arrays storage)*/
+	u32vector				m_octantsZ;				/**<Logical z coordinate of the local octants (structure-of-arrays storage, empty in 2D)*/
+	u8vector				m_octantsLevel;			/**<Level of the local octants (structure-of-arrays storage)*/
+	i8vector				m_octantsMarker;		/**<Refinement marker of the local octants (structure-of-arrays storage)*/
+	u16vector				m_octantsInfo;			/**<Info flags of the local octants (structure-of-arrays storage)*/
+
+	bool					m_areOctantsMortonsValid;	/**<True if the cached Morton numbers are in sync with the local octants*/
+	bool					m_areGhostsMortonsValid;	/**<True if the cached Morton numbers are in sync with the ghost octants*/
+	u64vector				m_octantsMortons;		/**<Cached Morton numbers of the local octants*/
+	u64vector				m_ghostsMortons;		/**<Cached Morton numbers of the ghost octants*/
+
 	uint8_t					m_dim;					/**<Space dimension. Only 2D or 3D space accepted*/
 	const TreeConstants	   *m_treeConstants;		/**<Tree constants*/
 	bvector 				m_periodic;				/**<Boolvector: i-th element is true if the i-th boundary face is a periodic interface.*/
@@ -166,6 +195,16 @@ private:
 	uint64_t 		computeGhostMorton(int32_t idx) const;
 	uint64_t 		computeGhostNodeMorton(int32_t idx, uint8_t inode) const;
 	bool 			getBalance(int32_t idx) const;
+	bool 			getIsNewR(int32_t idx) const;
+	bool 			getIsNewC(int32_t idx) const;
+	uint32_t 		getX(int32_t idx) const;
+	uint32_t 		getY(int32_t idx) const;
+	uint32_t 		getZ(int32_t idx) const;
+	u32array3 		getCoordinates(int32_t idx) const;
+	uint32_t 		getSize(int32_t idx) const;
+	uint64_t 		getArea(int32_t idx) const;
+	uint64_t 		getVolume(int32_t idx) const;
+	darray3 		getCenter(int32_t idx) const;
 	uint8_t 		getBalanceCodim() const;
 	void 			setMarker(int32_t idx, int8_t marker);
 	void 			setBalance(int32_t idx, bool balance);
@@ -192,8 +231,11 @@ private:
 	const Octant&	extractGhostOctant(uint32_t idx) const;
 
 
+	bool 		isAdaptThreaded() const;
 	bool 		refine(u32vector & mapidx);
+	bool 		refineThreaded(u32vector & mapidx);
 	bool 		coarse(u32vector & mapidx);
+	void 		coarseInternalFamiliesThreaded(u32vector & mapidx, Octant *lastFather, uint8_t *lastNBrothers);
 	bool 		globalRefine(u32vector & mapidx);
 	bool 		globalCoarse(u32vector & mapidx);
 	void 		checkCoarse(uint64_t partLastDesc, u32vector & mapidx);
@@ -231,18 +273,31 @@ private:
 
 	void 		preBalance21(bool internal);
 	void 		preBalance21(u32vector& newmodified);
-	bool 		localBalance(bool doNew, bool doInterior);
+	bool 		localBalance(bool doNew, bool doInterior, const u32vector *ghosts = nullptr, uint32_t *nVisited = nullptr);
 
 	void 		computeIntersections();
 
 	uint32_t 	findMorton(uint64_t Morton) const;
 	uint32_t 	findGhostMorton(uint64_t Morton) const;
 	uint32_t 	_findMorton(uint64_t Morton, const octvector &octants) const;
+	uint32_t 	_findMorton(uint64_t Morton, const u64vector &mortons) const;
 
-	void 		computeConnectivity();
+	void 		computeConnectivity(bool flat = false);
 	void 		clearConnectivity();
 	void 		updateConnectivity();
 
+	bool 		isOctantsSoAEnabled() const;
+	void 		setOctantsSoAEnabled(bool enabled);
+	void 		invalidateOctantsSoA();
+	void 		updateOctantsSoA();
+	void 		updateOctantSoA(const Octant *octant);
+
+	void 		invalidateOctantsMortons();
+	void 		invalidateGhostsMortons();
+	void 		updateOctantsMortons();
+	void 		updateGhostsMortons();
+	static void	computeMortons(const octvector &octants, u64vector *mortons);
+
 	// =================================================================================== //
 
 };
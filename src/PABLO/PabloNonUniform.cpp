@@ -198,6 +198,45 @@ namespace bitpit {
         setL(L);
     }
 
+    /*! Write the header of the checkpoint files.
+    *
+    *  \param stream is the stream to write to
+    */
+    void
+    PabloNonUniform::dumpCheckpointHeader(std::ostream &stream)
+    {
+        ParaTree::dumpCheckpointHeader(stream);
+
+        utils::binary::write(stream, m_origin[0]);
+        utils::binary::write(stream, m_origin[1]);
+        utils::binary::write(stream, m_origin[2]);
+        utils::binary::write(stream, m_L[0]);
+        utils::binary::write(stream, m_L[1]);
+        utils::binary::write(stream, m_L[2]);
+    }
+
+    /*! Restore the header of the checkpoint files.
+    *
+    *  \param stream is the stream to read from
+    */
+    void
+    PabloNonUniform::restoreCheckpointHeader(std::istream &stream)
+    {
+        ParaTree::restoreCheckpointHeader(stream);
+
+        darray3 origin;
+        utils::binary::read(stream, origin[0]);
+        utils::binary::read(stream, origin[1]);
+        utils::binary::read(stream, origin[2]);
+        setOrigin(origin);
+
+        darray3 L;
+        utils::binary::read(stream, L[0]);
+        utils::binary::read(stream, L[1]);
+        utils::binary::read(stream, L[2]);
+        setL(L);
+    }
+
     // =================================================================================== //
     // BASIC GET/SET METHODS								   //
     // =================================================================================== //
@@ -935,7 +974,7 @@ namespace bitpit {
     void
     PabloNonUniform::write(string filename) {
 
-        if (getConnectivity().size() == 0) {
+        if (getConnectivity().size() == 0 && getFlatConnectivity().size() == 0) {
             computeConnectivity();
         }
 
@@ -956,7 +995,7 @@ namespace bitpit {
         out << "<?xml version=\"1.0\"?>" << endl
             << "<VTKFile type=\"UnstructuredGrid\" version=\"0.1\" byte_order=\"BigEndian\">" << endl
             << "  <UnstructuredGrid>" << endl
-            << "    <Piece NumberOfCells=\"" << getConnectivity().size() + getGhostConnectivity().size() << "\" NumberOfPoints=\"" << getNumNodes() << "\">" << endl;
+            << "    <Piece NumberOfCells=\"" << nofAll << "\" NumberOfPoints=\"" << getNumNodes() << "\">" << endl;
         out << "      <Points>" << endl
             << "        <DataArray type=\"Float64\" Name=\"Coordinates\" NumberOfComponents=\""<< 3 <<"\" format=\"ascii\">" << endl
             << "          " << std::fixed;
@@ -990,7 +1029,7 @@ namespace bitpit {
                                 jj = 2;
                             }
                         }
-                        out << getConnectivity()[i][jj] << " ";
+                        out << getConnectivityView(i)[jj] << " ";
                     }
                 if((i+1)%3==0 && i!=nofOctants-1)
                     out << endl << "          ";
@@ -1011,7 +1050,7 @@ namespace bitpit {
                                 jj = 2;
                             }
                         }
-                        out << getGhostConnectivity()[i][jj] << " ";
+                        out << getGhostConnectivityView(i)[jj] << " ";
                     }
                 if((i+1)%3==0 && i!=nofGhosts-1)
                     out << endl << "          ";
@@ -1089,7 +1128,7 @@ namespace bitpit {
     void
     PabloNonUniform::writeTest(string filename, vector<double> data) {
 
-        if (getConnectivity().size() == 0) {
+        if (getConnectivity().size() == 0 && getFlatConnectivity().size() == 0) {
             computeConnectivity();
         }
 
@@ -1157,7 +1196,7 @@ namespace bitpit {
                                 jj = 2;
                             }
                         }
-                        out << getConnectivity()[i][jj] << " ";
+                        out << getConnectivityView(i)[jj] << " ";
                     }
                 if((i+1)%3==0 && i!=nofOctants-1)
                     out << endl << "          ";
@@ -118,6 +118,11 @@ namespace bitpit {
         void	dump(std::ostream &stream, bool full = true) override;
         void	restore(std::istream &stream) override;
 
+    protected:
+        void	dumpCheckpointHeader(std::ostream &stream) override;
+        void	restoreCheckpointHeader(std::istream &stream) override;
+
+    public:
         // =================================================================================== //
         // BASIC GET/SET METHODS	                                                       //
         // =================================================================================== //
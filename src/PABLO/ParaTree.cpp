@@ -32,6 +32,7 @@
 
 #include "ParaTree.hpp"
 #include <climits>
+#include <cstring>
 #include <sstream>
 #include <iomanip>
 #include <fstream>
@@ -48,6 +49,39 @@ namespace bitpit {
     // AUXILIARY IMPLEMENTATIONS                                                           //
     // =================================================================================== //
 
+#if BITPIT_ENABLE_MPI==1
+    namespace {
+
+    /*!
+        \class NoLBData
+        \ingroup PABLO
+
+        Load balance interface for trees without user data, it allows the
+        load balance of the octants alone to use the streaming migration.
+    */
+    class NoLBData : public DataLBInterface<NoLBData> {
+
+    public:
+        size_t fixedSize() const { return 0; }
+        size_t size(const uint32_t e) const { BITPIT_UNUSED(e); return 0; }
+        void move(const uint32_t from, const uint32_t to) { BITPIT_UNUSED(from); BITPIT_UNUSED(to); }
+
+        template<class Buffer>
+        void gather(Buffer & buff, const uint32_t e) { BITPIT_UNUSED(buff); BITPIT_UNUSED(e); }
+
+        template<class Buffer>
+        void scatter(Buffer & buff, const uint32_t e) { BITPIT_UNUSED(buff); BITPIT_UNUSED(e); }
+
+        void assign(uint32_t stride, uint32_t length) { BITPIT_UNUSED(stride); BITPIT_UNUSED(length); }
+        void resize(uint32_t newSize) { BITPIT_UNUSED(newSize); }
+        void resizeGhost(uint32_t newSize) { BITPIT_UNUSED(newSize); }
+        void shrink() {}
+
+    };
+
+    }
+#endif
+
     /*!
         \typedef ParaTree::ExchangeRanges
         \ingroup PABLO
@@ -117,11 +151,46 @@ namespace bitpit {
         recvRanges.clear();
     }
 
+    /*!
+        \struct ParaTree::NeighbourCache
+        \ingroup PABLO
+
+        Stores, in compressed sparse row format, the neighbours of the local
+        octants through their faces, edges and nodes.
+
+        The rows of an octant are contiguous: first the rows of its faces,
+        then those of its edges (3D only) and then those of its nodes, up to
+        the maximum codimension the cache was enabled for.
+    */
+
+    /*! Default constructor, the cache is disabled.
+    */
+    ParaTree::NeighbourCache::NeighbourCache()
+        : maxCodim(0), valid(false), status(0), nEntities(0)
+    {
+        firstEntity.fill(0);
+    }
+
+    /*! Clear the cached neighbours, the maximum codimension is not changed.
+     */
+    void ParaTree::NeighbourCache::clear()
+    {
+        valid = false;
+        status = 0;
+        nEntities = 0;
+        firstEntity.fill(0);
+
+        std::vector<std::size_t>().swap(offsets);
+        u32vector().swap(neighbours);
+        std::vector<uint8_t>().swap(ghostFlags);
+    }
+
     // =================================================================================== //
     // CLASS IMPLEMENTATION                                                                //
     // =================================================================================== //
 
     const std::string	ParaTree::DEFAULT_LOG_FILE   = "PABLO";
+    const std::size_t	ParaTree::CHECKPOINT_OCTANT_SIZE = 3 * sizeof(uint32_t) + sizeof(uint8_t) + sizeof(int8_t) + sizeof(uint16_t);
 
     // =================================================================================== //
     // CONSTRUCTORS AND OPERATORS														   //
@@ -234,6 +303,10 @@ namespace bitpit {
           m_errorFlag(other.m_errorFlag),
           m_serial(other.m_serial),
           m_tol(other.m_tol),
+          m_balanceStrategy(other.m_balanceStrategy),
+          m_balanceVisits(other.m_balanceVisits),
+          m_loadBalanceMemoryBudget(other.m_loadBalanceMemoryBudget),
+          m_neighbourCache(other.m_neighbourCache),
           m_trans(other.m_trans),
           m_dim(other.m_dim),
           m_periodic(other.m_periodic),
@@ -416,6 +489,11 @@ namespace bitpit {
     ParaTree::reset(bool createRoot){
         m_tol       = 1.0e-14;
         m_serial    = true;
+
+        m_balanceStrategy = BALANCE_STRATEGY_FRONTIER;
+        m_balanceVisits.clear();
+        m_loadBalanceMemoryBudget = 0;
+        m_neighbourCache.clear();
         m_errorFlag = 0;
 
         m_maxDepth  = 0;
@@ -434,6 +512,8 @@ namespace bitpit {
         std::fill(m_periodic.begin(), m_periodic.end(), false);
 
         _initializePartitions();
+
+        updateNeighbourCache();
     }
 
     // =============================================================================== //
@@ -573,7 +653,7 @@ namespace bitpit {
         utils::binary::read(stream, m_maxDepth);
         utils::binary::read(stream, m_status);
 
-        bool balanceCodimension;
+        uint8_t balanceCodimension;
         utils::binary::read(stream, balanceCodimension);
         setBalanceCodimension(balanceCodimension);
 
@@ -586,6 +666,10 @@ namespace bitpit {
         }
 
         // Restore octants
+        m_octree.invalidateOctantsSoA();
+        m_octree.invalidateOctantsMortons();
+        invalidateNeighbourCache();
+
         uint32_t nOctants;
         utils::binary::read(stream, nOctants);
         m_octree.m_sizeOctants = nOctants;
@@ -703,10 +787,387 @@ namespace bitpit {
         else {
             m_lastOp = OP_INIT;
         }
+
+        m_octree.updateOctantsSoA();
+        m_octree.updateOctantsMortons();
+        updateNeighbourCache();
+    }
+
+    // =============================================================================== //
+
+    /*! Write the octree to a single checkpoint file shared by all the
+     *  processes.
+     *
+     *  The file contains a header, written by the first process, followed
+     *  by the octants sorted along the Morton curve. Octants are stored as
+     *  fixed-size records, hence each process writes its block of octants
+     *  at the offset given by the global index of its first octant. When
+     *  MPI is available, the file is written using collective MPI-IO.
+     *
+     *  Unlike the stream dump, the checkpoint can be restored on any number
+     *  of processes. Only the tree is saved, the mapping of the last
+     *  operation is not.
+     *
+     *  \param filename is the name of the checkpoint file
+     */
+    void ParaTree::dumpCheckpoint(const std::string &filename)
+    {
+        // Header
+        std::ostringstream headerStream;
+        dumpCheckpointHeader(headerStream);
+
+        std::string header = headerStream.str();
+        uint64_t headerSize = header.size();
+
+        // Octants
+        //
+        // If the tree is serial, all processes contain all the octants and
+        // only the first process will write them.
+        uint32_t nOctants = getNumOctants();
+        uint64_t globalOffset = 0;
+        if (m_serial) {
+            if (m_rank != 0) {
+                nOctants = 0;
+            }
+        } else if (m_rank > 0) {
+            globalOffset = m_partitionRangeGlobalIdx[m_rank - 1] + 1;
+        }
+
+        std::vector<char> octantsBuffer(nOctants * CHECKPOINT_OCTANT_SIZE);
+        char *record = octantsBuffer.data();
+        for (uint32_t i = 0; i < nOctants; ++i) {
+            const Octant &octant = m_octree.m_octants[i];
+
+            uint16_t info = static_cast<uint16_t>(octant.m_info.to_ulong());
+
+            std::memcpy(record, &octant.m_x, sizeof(uint32_t)); record += sizeof(uint32_t);
+            std::memcpy(record, &octant.m_y, sizeof(uint32_t)); record += sizeof(uint32_t);
+            std::memcpy(record, &octant.m_z, sizeof(uint32_t)); record += sizeof(uint32_t);
+            std::memcpy(record, &octant.m_level, sizeof(uint8_t)); record += sizeof(uint8_t);
+            std::memcpy(record, &octant.m_marker, sizeof(int8_t)); record += sizeof(int8_t);
+            std::memcpy(record, &info, sizeof(uint16_t)); record += sizeof(uint16_t);
+        }
+
+        uint64_t octantsOffset = sizeof(headerSize) + headerSize + globalOffset * CHECKPOINT_OCTANT_SIZE;
+
+#if BITPIT_ENABLE_MPI==1
+        if (isCommSet()) {
+            MPI_File file;
+            int openError = MPI_File_open(m_comm, filename.c_str(), MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &file);
+            if (openError != MPI_SUCCESS) {
+                throw std::runtime_error("Unable to open the checkpoint file \"" + filename + "\".");
+            }
+
+            m_errorFlag = MPI_File_set_size(file, 0);
+            if (m_errorFlag != MPI_SUCCESS) {
+                MPI_File_close(&file);
+                throw std::runtime_error("Unable to truncate the checkpoint file \"" + filename + "\".");
+            }
+
+            // The header is written only by the first process, the outcome
+            // is shared so that all processes agree on whether to proceed.
+            int headerError = MPI_SUCCESS;
+            if (m_rank == 0) {
+                headerError = MPI_File_write_at(file, 0, &headerSize, 1, MPI_UINT64_T, MPI_STATUS_IGNORE);
+                if (headerError == MPI_SUCCESS) {
+                    headerError = MPI_File_write_at(file, sizeof(headerSize), header.data(), headerSize, MPI_CHAR, MPI_STATUS_IGNORE);
+                }
+            }
+
+            m_errorFlag = MPI_Bcast(&headerError, 1, MPI_INT, 0, m_comm);
+            if (m_errorFlag != MPI_SUCCESS || headerError != MPI_SUCCESS) {
+                MPI_File_close(&file);
+                throw std::runtime_error("Unable to write the header of the checkpoint file \"" + filename + "\".");
+            }
+
+            MPI_Datatype octantType;
+            MPI_Type_contiguous(CHECKPOINT_OCTANT_SIZE, MPI_BYTE, &octantType);
+            MPI_Type_commit(&octantType);
+
+            m_errorFlag = MPI_File_write_at_all(file, octantsOffset, octantsBuffer.data(), nOctants, octantType, MPI_STATUS_IGNORE);
+
+            MPI_Type_free(&octantType);
+            if (m_errorFlag != MPI_SUCCESS) {
+                MPI_File_close(&file);
+                throw std::runtime_error("Unable to write the octants of the checkpoint file \"" + filename + "\".");
+            }
+
+            m_errorFlag = MPI_File_close(&file);
+            if (m_errorFlag != MPI_SUCCESS) {
+                throw std::runtime_error("Unable to close the checkpoint file \"" + filename + "\".");
+            }
+
+            return;
+        }
+#endif
+
+        std::ofstream stream(filename, std::ios::binary);
+        if (!stream.good()) {
+            throw std::runtime_error("Unable to open the checkpoint file \"" + filename + "\".");
+        }
+
+        utils::binary::write(stream, headerSize);
+        stream.write(header.data(), headerSize);
+        stream.seekp(octantsOffset);
+        stream.write(octantsBuffer.data(), octantsBuffer.size());
+        if (!stream.good()) {
+            throw std::runtime_error("Unable to write the checkpoint file \"" + filename + "\".");
+        }
     }
 
     // =============================================================================== //
 
+    /*! Restore the octree from a checkpoint file written by dumpCheckpoint.
+     *
+     *  The checkpoint can be restored on a number of processes different
+     *  from the one used to write it. If the saved tree was serial, every
+     *  process reads all the octants. Otherwise the octants are split along
+     *  the Morton curve in contiguous blocks of the same size, each process
+     *  reads its block and the ghost halo is rebuilt. When MPI is available,
+     *  the file is read using collective MPI-IO.
+     *
+     *  \param filename is the name of the checkpoint file
+     */
+    void ParaTree::restoreCheckpoint(const std::string &filename)
+    {
+        bool isCollective = false;
+#if BITPIT_ENABLE_MPI==1
+        isCollective = isCommSet();
+#endif
+
+        // Open the file
+#if BITPIT_ENABLE_MPI==1
+        MPI_File file;
+#endif
+        std::ifstream stream;
+        if (isCollective) {
+#if BITPIT_ENABLE_MPI==1
+            int openError = MPI_File_open(m_comm, filename.c_str(), MPI_MODE_RDONLY, MPI_INFO_NULL, &file);
+            if (openError != MPI_SUCCESS) {
+                throw std::runtime_error("Unable to open the checkpoint file \"" + filename + "\".");
+            }
+#endif
+        } else {
+            stream.open(filename, std::ios::binary);
+            if (!stream.good()) {
+                throw std::runtime_error("Unable to open the checkpoint file \"" + filename + "\".");
+            }
+        }
+
+        // Header
+        uint64_t headerSize;
+        std::string header;
+        if (isCollective) {
+#if BITPIT_ENABLE_MPI==1
+            m_errorFlag = MPI_File_read_at_all(file, 0, &headerSize, 1, MPI_UINT64_T, MPI_STATUS_IGNORE);
+            if (m_errorFlag == MPI_SUCCESS) {
+                header.resize(headerSize);
+                m_errorFlag = MPI_File_read_at_all(file, sizeof(headerSize), &header[0], headerSize, MPI_CHAR, MPI_STATUS_IGNORE);
+            }
+
+            if (m_errorFlag != MPI_SUCCESS) {
+                MPI_File_close(&file);
+                throw std::runtime_error("Unable to read the header of the checkpoint file \"" + filename + "\".");
+            }
+#endif
+        } else {
+            utils::binary::read(stream, headerSize);
+            if (stream.good()) {
+                header.resize(headerSize);
+                stream.read(&header[0], headerSize);
+            }
+
+            if (!stream.good()) {
+                throw std::runtime_error("Unable to read the header of the checkpoint file \"" + filename + "\".");
+            }
+        }
+
+        std::istringstream headerStream(header);
+        restoreCheckpointHeader(headerStream);
+
+        // Octants
+        //
+        // Without a communicator the tree can only be serial. A distributed
+        // tree is split among the processes in contiguous blocks of octants.
+        if (!isCollective) {
+            m_serial = true;
+        }
+
+        uint64_t nGlobalOctants = m_globalNumOctants;
+        uint64_t globalOffset   = 0;
+        uint64_t nOctants       = nGlobalOctants;
+        if (!m_serial) {
+            uint64_t nBlockOctants = nGlobalOctants / m_nproc;
+            uint64_t nRemainders   = nGlobalOctants % m_nproc;
+
+            globalOffset = m_rank * nBlockOctants + std::min<uint64_t>(m_rank, nRemainders);
+            nOctants     = nBlockOctants + (static_cast<uint64_t>(m_rank) < nRemainders ? 1 : 0);
+        }
+
+        std::vector<char> octantsBuffer(nOctants * CHECKPOINT_OCTANT_SIZE);
+        uint64_t octantsOffset = sizeof(headerSize) + headerSize + globalOffset * CHECKPOINT_OCTANT_SIZE;
+        if (isCollective) {
+#if BITPIT_ENABLE_MPI==1
+            MPI_Datatype octantType;
+            MPI_Type_contiguous(CHECKPOINT_OCTANT_SIZE, MPI_BYTE, &octantType);
+            MPI_Type_commit(&octantType);
+
+            m_errorFlag = MPI_File_read_at_all(file, octantsOffset, octantsBuffer.data(), nOctants, octantType, MPI_STATUS_IGNORE);
+
+            MPI_Type_free(&octantType);
+            if (m_errorFlag != MPI_SUCCESS) {
+                MPI_File_close(&file);
+                throw std::runtime_error("Unable to read the octants of the checkpoint file \"" + filename + "\".");
+            }
+
+            m_errorFlag = MPI_File_close(&file);
+            if (m_errorFlag != MPI_SUCCESS) {
+                throw std::runtime_error("Unable to close the checkpoint file \"" + filename + "\".");
+            }
+#endif
+        } else {
+            stream.seekg(octantsOffset);
+            stream.read(octantsBuffer.data(), octantsBuffer.size());
+            if (!stream.good()) {
+                throw std::runtime_error("The checkpoint file \"" + filename + "\" is truncated.");
+            }
+        }
+
+        m_octree.invalidateOctantsSoA();
+        m_octree.invalidateOctantsMortons();
+        invalidateNeighbourCache();
+
+        m_octree.m_octants.clear();
+        m_octree.m_octants.reserve(nOctants);
+        const char *record = octantsBuffer.data();
+        for (uint64_t i = 0; i < nOctants; ++i) {
+            uint32_t x;
+            uint32_t y;
+            uint32_t z;
+            uint8_t level;
+            int8_t marker;
+            uint16_t info;
+
+            std::memcpy(&x, record, sizeof(uint32_t)); record += sizeof(uint32_t);
+            std::memcpy(&y, record, sizeof(uint32_t)); record += sizeof(uint32_t);
+            std::memcpy(&z, record, sizeof(uint32_t)); record += sizeof(uint32_t);
+            std::memcpy(&level, record, sizeof(uint8_t)); record += sizeof(uint8_t);
+            std::memcpy(&marker, record, sizeof(int8_t)); record += sizeof(int8_t);
+            std::memcpy(&info, record, sizeof(uint16_t)); record += sizeof(uint16_t);
+
+            Octant octant(false, m_dim, level, x, y, z);
+            octant.m_info = std::bitset<Octant::INFO_ITEM_COUNT>(info);
+            octant.setMarker(marker);
+
+            m_octree.m_octants.push_back(std::move(octant));
+        }
+        m_octree.m_sizeOctants = m_octree.m_octants.size();
+        m_octree.updateOctantsSoA();
+
+        // Partitions
+        m_lastOp = OP_INIT;
+        m_mapIdx.clear();
+
+#if BITPIT_ENABLE_MPI==1
+        if (!m_serial) {
+            updateLoadBalance();
+            computeGhostHalo();
+            updateNeighbourCache();
+
+            return;
+        }
+#endif
+
+        m_octree.updateLocalMaxDepth();
+        m_octree.updateOctantsMortons();
+        if (nOctants > 0) {
+            m_octree.setFirstDescMorton();
+            m_octree.setLastDescMorton();
+        }
+
+        _initializePartitions();
+
+        updateNeighbourCache();
+    }
+
+    // =============================================================================== //
+
+    /*! Write the header of the checkpoint files.
+     *
+     *  Derived classes can extend the header with their own information.
+     *
+     *  \param stream is the stream to write to
+     */
+    void ParaTree::dumpCheckpointHeader(std::ostream &stream)
+    {
+        // Version
+        utils::binary::write(stream, getDumpVersion());
+
+        // Tree data
+        utils::binary::write(stream, getDim());
+
+        utils::binary::write(stream, getSerial());
+        utils::binary::write(stream, getNofGhostLayers());
+        utils::binary::write(stream, getMaxDepth());
+        utils::binary::write(stream, getStatus());
+        utils::binary::write(stream, getBalanceCodimension());
+
+        for (int i = 0; i < m_treeConstants->nFaces; i++) {
+            utils::binary::write(stream, getPeriodic(i));
+        }
+
+        // Number of octants
+        utils::binary::write(stream, getGlobalNumOctants());
+    }
+
+    // =============================================================================== //
+
+    /*! Restore the header of the checkpoint files and initialize the tree
+     *  accordingly.
+     *
+     *  \param stream is the stream to read from
+     */
+    void ParaTree::restoreCheckpointHeader(std::istream &stream)
+    {
+        // Version
+        int version;
+        utils::binary::read(stream, version);
+        if (version != getDumpVersion()) {
+            throw std::runtime_error ("The version of the file does not match the required version");
+        }
+
+        // Initialize the tree
+        uint8_t dimension;
+        utils::binary::read(stream, dimension);
+
+        m_octree.initialize(dimension);
+        m_trans.initialize(dimension);
+        reinitialize(dimension, m_log->getName());
+        reset(false);
+
+        // Set tree properties
+        utils::binary::read(stream, m_serial);
+        utils::binary::read(stream, m_nofGhostLayers);
+        utils::binary::read(stream, m_maxDepth);
+        utils::binary::read(stream, m_status);
+
+        uint8_t balanceCodimension;
+        utils::binary::read(stream, balanceCodimension);
+        setBalanceCodimension(balanceCodimension);
+
+        for (int i = 0; i < m_treeConstants->nFaces; i++) {
+            bool periodicBorder;
+            utils::binary::read(stream, periodicBorder);
+            if (periodicBorder){
+                setPeriodic(i);
+            }
+        }
+
+        // Number of octants
+        utils::binary::read(stream, m_globalNumOctants);
+    }
+
+
     /*! Print the initial PABLO header.
      */
     void
@@ -1230,6 +1691,9 @@ namespace bitpit {
         m_periodic[i] = true;
         m_periodic[m_treeConstants->oppositeFace[i]] = true;
         m_octree.setPeriodic(m_periodic);
+
+        invalidateNeighbourCache();
+        updateNeighbourCache();
     };
 
     /*!Set the tolerance used in geometric operations.
@@ -1240,6 +1704,96 @@ namespace bitpit {
         m_tol = tol;
     };
 
+    /*!Get the layout used to serve the index based getters of the local octants.
+     * \return Layout of the local octants.
+     */
+    ParaTree::OctantLayout
+    ParaTree::getOctantLayout() const {
+        if (m_octree.isOctantsSoAEnabled()) {
+            return OCTANT_LAYOUT_SOA;
+        }
+
+        return OCTANT_LAYOUT_AOS;
+    };
+
+    /*!Set the layout used to serve the index based getters of the local octants.
+     *
+     * With the structure-of-arrays layout, coordinates, levels, markers and flags
+     * of the local octants are mirrored in separate contiguous arrays, which are
+     * kept in sync with the octants by the operations that modify the tree.
+     * Traversals that only access these fields (e.g., centers, sizes and markers)
+     * touch less memory. The arrays are a copy kept in addition to the octant
+     * objects, hence this layout increases the memory used by the tree by 16
+     * bytes per local octant in 3D and by 12 bytes per local octant in 2D.
+     * \param[in] layout Desired layout.
+     */
+    void
+    ParaTree::setOctantLayout(OctantLayout layout){
+        m_octree.setOctantsSoAEnabled(layout == OCTANT_LAYOUT_SOA);
+    };
+
+    /*!Get the strategy used to iterate the 2:1 balance of distributed trees.
+     * \return Balance strategy.
+     */
+    ParaTree::BalanceStrategy
+    ParaTree::getBalanceStrategy() const {
+        return m_balanceStrategy;
+    };
+
+    /*!Set the strategy used to iterate the 2:1 balance of distributed trees.
+     *
+     * With the sweep strategy, every iteration exchanges the markers of all the
+     * border octants and re-examines all the ghosts whose marker has ever been
+     * modified. With the frontier strategy, after the first iteration, only the
+     * markers modified by the previous iteration are exchanged and only the
+     * ghosts they refer to are re-examined. Both strategies produce the same
+     * markers. On serial trees the strategy has no effect.
+     * \param[in] strategy Desired strategy.
+     */
+    void
+    ParaTree::setBalanceStrategy(BalanceStrategy strategy){
+        m_balanceStrategy = strategy;
+    };
+
+    /*!Get the memory budget of the streaming load balance.
+     * \return Memory, in bytes, available to the communication buffers of
+     * the load balance; zero means that streaming is disabled.
+     */
+    std::size_t
+    ParaTree::getLoadBalanceMemoryBudget() const {
+        return m_loadBalanceMemoryBudget;
+    };
+
+    /*!Set the memory budget of the streaming load balance.
+     *
+     * When the budget is zero (the default), the octants (and their user
+     * data) moved by a load balance of a distributed tree are exchanged
+     * using buffers sized to the whole transfer. With a positive budget,
+     * the octants are exchanged in chunks whose communication buffers, on
+     * each process, do not exceed the budget, and the received octants are
+     * inserted directly in the tree. The budget has no effect on the first
+     * load balance of a serial tree, that requires no communication.
+     * \param[in] budget Memory, in bytes, available to the communication
+     * buffers of the load balance.
+     */
+    void
+    ParaTree::setLoadBalanceMemoryBudget(std::size_t budget){
+        m_loadBalanceMemoryBudget = budget;
+    };
+
+    /*!Get the number of octants visited by each iteration of the last 2:1
+     * balance.
+     *
+     * An octant is visited when its neighbourhood is examined to enforce the
+     * balance; an octant may be visited more than once in the same iteration.
+     * The size of the returned vector is the number of iterations performed.
+     * \return Number of local and ghost octants visited by each iteration.
+     */
+    u32vector
+    ParaTree::getBalanceVisits() const {
+        return m_balanceVisits;
+    };
+
     // =================================================================================== //
     // INDEX BASED METHODS
     // =================================================================================== //
@@ -1250,7 +1804,7 @@ namespace bitpit {
      */
     darray3
     ParaTree::getCoordinates(uint32_t idx) const {
-        return m_trans.mapCoordinates(m_octree.m_octants[idx].getCoordinates());
+        return m_trans.mapCoordinates(m_octree.getCoordinates(idx));
     }
 
     /*! Get the coordinates of an octant, i.e. the coordinates of its node 0.
@@ -1259,7 +1813,7 @@ namespace bitpit {
      */
     double
     ParaTree::getX(uint32_t idx) const {
-        return m_trans.mapX(m_octree.m_octants[idx].getX());
+        return m_trans.mapX(m_octree.getX(idx));
     }
 
     /*! Get the coordinates of an octant, i.e. the coordinates of its node 0.
@@ -1268,7 +1822,7 @@ namespace bitpit {
      */
     double
     ParaTree::getY(uint32_t idx) const {
-        return m_trans.mapY(m_octree.m_octants[idx].getY());
+        return m_trans.mapY(m_octree.getY(idx));
     }
 
     /*! Get the coordinates of an octant, i.e. the coordinates of its node 0.
@@ -1277,7 +1831,7 @@ namespace bitpit {
      */
     double
     ParaTree::getZ(uint32_t idx) const {
-        return m_trans.mapZ(m_octree.m_octants[idx].getZ());
+        return m_trans.mapZ(m_octree.getZ(idx));
     }
 
     /*! Get the size of an octant, i.e. the side length.
@@ -1286,7 +1840,7 @@ namespace bitpit {
      */
     double
     ParaTree::getSize(uint32_t idx) const {
-        return m_trans.mapSize(m_octree.m_octants[idx].getSize());
+        return m_trans.mapSize(m_octree.getSize(idx));
     }
 
     /*! Get the area of an octant (for 2D case the same value of getSize).
@@ -1295,7 +1849,7 @@ namespace bitpit {
      */
     double
     ParaTree::getArea(uint32_t idx) const {
-        return m_trans.mapArea(m_octree.m_octants[idx].getArea());
+        return m_trans.mapArea(m_octree.getArea(idx));
     }
 
     /*! Get the volume of an octant.
@@ -1304,7 +1858,7 @@ namespace bitpit {
      */
     double
     ParaTree::getVolume(uint32_t idx) const {
-        return m_trans.mapVolume(m_octree.m_octants[idx].getVolume());
+        return m_trans.mapVolume(m_octree.getVolume(idx));
     }
 
     /*! Get the coordinates of the center of an octant.
@@ -1313,7 +1867,7 @@ namespace bitpit {
      */
     void
     ParaTree::getCenter(uint32_t idx, darray3& center) const {
-        darray3 center_ = m_octree.m_octants[idx].getCenter();
+        darray3 center_ = m_octree.getCenter(idx);
         m_trans.mapCenter(center_, center);
     }
 
@@ -1324,7 +1878,7 @@ namespace bitpit {
     darray3
     ParaTree::getCenter(uint32_t idx) const {
         darray3 center;
-        darray3 center_ = m_octree.m_octants[idx].getCenter();
+        darray3 center_ = m_octree.getCenter(idx);
         m_trans.mapCenter(center_, center);
         return center;
     }
@@ -1532,7 +2086,7 @@ namespace bitpit {
      */
     bool
     ParaTree::getIsNewR(uint32_t idx) const {
-        return m_octree.m_octants[idx].getIsNewR();
+        return m_octree.getIsNewR(idx);
     };
 
     /*! Get if the octant is new after coarsening.
@@ -1541,7 +2095,7 @@ namespace bitpit {
      */
     bool
     ParaTree::getIsNewC(uint32_t idx) const {
-        return m_octree.m_octants[idx].getIsNewC();
+        return m_octree.getIsNewC(idx);
     };
 
     /*! Get the global index of an octant.
@@ -1631,6 +2185,15 @@ namespace bitpit {
         return uint64_t(m_octree.m_sizeGhosts);
     };
 
+    /** Compute the Morton index of a ghost octant (without level).
+     * \param[in] idx Local index of target ghost octant.
+     * \return Morton index of the ghost octant.
+     */
+    uint64_t
+    ParaTree::getGhostMorton(uint32_t idx) const {
+        return m_octree.computeGhostMorton(idx);
+    };
+
     /*! Returns true if the specified global index belongs to the current
      *  process
      * \param[in] gidx Global index of target octant.
@@ -2051,6 +2614,7 @@ namespace bitpit {
         }
 
         oct->setMarker(marker);
+        m_octree.updateOctantSoA(oct);
     };
 
     /*! Set the balancing condition of an octant.
@@ -2064,6 +2628,7 @@ namespace bitpit {
         }
 
         oct->setBalance(balance);
+        m_octree.updateOctantSoA(oct);
     };
 
     // =================================================================================== //
@@ -2609,10 +3174,20 @@ namespace bitpit {
      * \param[in] iface Index of face/edge/node passed through for neighbours finding
      * \param[in] codim Codimension of the iface-th entity 1=edge, 2=node
      * \param[out] neighbours Vector of neighbours indices in octants/ghosts structure
-     * \param[out] isghost Vector with boolean flag; true if the respective octant in neighbours is a ghost octant. Can be ignored in serial runs. */
+     * \param[out] isghost Vector with boolean flag; true if the respective octant in neighbours is a ghost octant. Can be ignored in serial runs.
+     * \n NOTE: if the neighbour cache is valid and contains the requested
+     * codimension, the neighbours are read from the cache (see enableNeighbourCache). */
     void
     ParaTree::findNeighbours(uint32_t idx, uint8_t iface, uint8_t codim, u32vector & neighbours, bvector & isghost) const {
 
+        if (isNeighbourCached(iface, codim)) {
+            ConstProxyVector<uint8_t> cachedGhostFlags;
+            ConstProxyVector<uint32_t> cachedNeighbours = getNeighboursView(idx, iface, codim, &cachedGhostFlags);
+            neighbours.assign(cachedNeighbours.cbegin(), cachedNeighbours.cend());
+            isghost.assign(cachedGhostFlags.cbegin(), cachedGhostFlags.cend());
+            return;
+        }
+
         const Octant* oct = &m_octree.m_octants[idx];
 
         findNeighbours(oct, true, idx, iface, codim, neighbours, isghost, false);
@@ -2761,6 +3336,194 @@ namespace bitpit {
         findAllNodeNeighbours(oct, inode, neighbours, isghost);
     };
 
+    /** Enable the cache of the neighbours of the local octants.
+     * The neighbours of all the local octants through their faces (and,
+     * depending on the maximum codimension, through their edges and nodes)
+     * are evaluated in a single pass and stored in compressed sparse row
+     * format. The cache is rebuilt at the end of every operation that modifies
+     * the tree (adapt, global refinement/coarsening, load balance, restore)
+     * and, while valid, neighbour queries on local octants are answered
+     * reading the cached rows instead of searching the tree.
+     * \param[in] maxCodim Maximum codimension of the entities whose neighbours
+     * will be cached: 1 caches face neighbours, 2 adds edge neighbours in 3D
+     * (node neighbours in 2D), 3 adds node neighbours in 3D.
+     */
+    void
+    ParaTree::enableNeighbourCache(uint8_t maxCodim){
+        if (maxCodim < 1 || maxCodim > m_dim) {
+            throw std::runtime_error("Invalid codimension for the neighbour cache.");
+        }
+
+        m_neighbourCache.clear();
+        m_neighbourCache.maxCodim = maxCodim;
+        updateNeighbourCache();
+    }
+
+    /** Disable the cache of the neighbours of the local octants and release
+     * its memory.
+     */
+    void
+    ParaTree::disableNeighbourCache(){
+        m_neighbourCache.clear();
+        m_neighbourCache.maxCodim = 0;
+    }
+
+    /** Get the maximum codimension of the entities whose neighbours are cached.
+     * \return Maximum codimension of the cached entities, zero if the cache is
+     * disabled.
+     */
+    uint8_t
+    ParaTree::getNeighbourCacheCodimension() const {
+        return m_neighbourCache.maxCodim;
+    }
+
+    /** Check if the cache of the neighbours is up-to-date with the tree.
+     * The cache is valid if it has been built after the last operation that
+     * modified the tree, i.e., if neither the status of the tree nor the
+     * local/ghost octants have changed since then.
+     * \return True if the cache is enabled and valid, false otherwise.
+     */
+    bool
+    ParaTree::isNeighbourCacheValid() const {
+        return (m_neighbourCache.maxCodim > 0 && m_neighbourCache.valid && m_neighbourCache.status == m_status);
+    }
+
+    /** Rebuild the cache of the neighbours if it is enabled and not valid.
+     */
+    void
+    ParaTree::updateNeighbourCache(){
+        if (m_neighbourCache.maxCodim == 0 || isNeighbourCacheValid()) {
+            return;
+        }
+
+        NeighbourCache &cache = m_neighbourCache;
+        uint8_t maxCodim = std::min(cache.maxCodim, m_dim);
+
+        // Layout of the rows of an octant
+        cache.nEntities = 0;
+        cache.firstEntity.fill(0);
+        for (uint8_t codim = 1; codim <= maxCodim; ++codim) {
+            cache.firstEntity[codim] = cache.nEntities;
+            cache.nEntities += getNofCodimensionEntities(codim);
+        }
+
+        // Neighbours
+        uint32_t nOctants = getNumOctants();
+        std::size_t nRows = std::size_t(nOctants) * cache.nEntities;
+
+        std::size_t nEstimatedNeighbours = cache.neighbours.size();
+        cache.offsets.resize(nRows + 1);
+        cache.neighbours.clear();
+        cache.neighbours.reserve(std::max(nEstimatedNeighbours, nRows));
+        cache.ghostFlags.clear();
+        cache.ghostFlags.reserve(cache.neighbours.capacity());
+
+        u32vector neighbours;
+        bvector isghost;
+        std::size_t row = 0;
+        cache.offsets[0] = 0;
+        for (uint32_t idx = 0; idx < nOctants; ++idx) {
+            const Octant *octant = &m_octree.m_octants[idx];
+            for (uint8_t codim = 1; codim <= maxCodim; ++codim) {
+                uint8_t nCodimEntities = getNofCodimensionEntities(codim);
+                for (uint8_t i = 0; i < nCodimEntities; ++i) {
+                    findNeighbours(octant, true, idx, i, codim, neighbours, isghost, false);
+
+                    std::size_t nNeighbours = neighbours.size();
+                    for (std::size_t n = 0; n < nNeighbours; ++n) {
+                        cache.neighbours.push_back(neighbours[n]);
+                        cache.ghostFlags.push_back(isghost[n]);
+                    }
+                    cache.offsets[++row] = cache.neighbours.size();
+                }
+            }
+        }
+
+        cache.status = m_status;
+        cache.valid  = true;
+    }
+
+    /** Get a view of the neighbours of a local octant through iface
+     * face/edge/node.
+     * If the cache of the neighbours is valid and contains the requested
+     * codimension, the view points directly to the cached neighbours and no
+     * search is performed; otherwise the neighbours are evaluated and the view
+     * owns them.
+     * \param[in] idx Index of current octant
+     * \param[in] iface Index of face/edge/node passed through for neighbours finding
+     * \param[in] codim Codimension of the iface-th entity 1=edge, 2=node
+     * \param[out] isghost If a valid pointer is provided, it will receive a
+     * view of the ghost flags of the neighbours: the i-th flag is non-zero if
+     * the i-th neighbour is a ghost octant.
+     * \return View of the indices of the neighbours in octants/ghosts structure.
+     */
+    ConstProxyVector<uint32_t>
+    ParaTree::getNeighboursView(uint32_t idx, uint8_t iface, uint8_t codim, ConstProxyVector<uint8_t> *isghost) const {
+        if (isNeighbourCached(iface, codim)) {
+            const NeighbourCache &cache = m_neighbourCache;
+            std::size_t row = std::size_t(idx) * cache.nEntities + cache.firstEntity[codim] + iface;
+            std::size_t begin = cache.offsets[row];
+            std::size_t size = cache.offsets[row + 1] - begin;
+            if (isghost) {
+                *isghost = ConstProxyVector<uint8_t>(cache.ghostFlags.data() + begin, size);
+            }
+
+            return ConstProxyVector<uint32_t>(cache.neighbours.data() + begin, size);
+        }
+
+        u32vector neighbours;
+        bvector neighbourGhostFlags;
+        findNeighbours(&m_octree.m_octants[idx], true, idx, iface, codim, neighbours, neighbourGhostFlags, false);
+        if (isghost) {
+            *isghost = ConstProxyVector<uint8_t>(std::vector<uint8_t>(neighbourGhostFlags.begin(), neighbourGhostFlags.end()));
+        }
+
+        return ConstProxyVector<uint32_t>(std::move(neighbours));
+    }
+
+    /** Get the number of entities of the specified codimension of an octant.
+     * \param[in] codim Codimension of the entities 1=face, 2=edge (node in 2D), 3=node
+     * \return Number of entities of the specified codimension.
+     */
+    uint8_t
+    ParaTree::getNofCodimensionEntities(uint8_t codim) const {
+        if (codim == 1) {
+            return m_treeConstants->nFaces;
+        } else if (codim == m_dim) {
+            return m_treeConstants->nNodes;
+        } else if (codim == 2 && m_dim == 3) {
+            return m_treeConstants->nEdges;
+        }
+
+        return 0;
+    }
+
+    /** Invalidate the cache of the neighbours.
+     * The cached neighbours are kept until the cache is rebuilt, so the
+     * memory can be reused.
+     */
+    void
+    ParaTree::invalidateNeighbourCache(){
+        m_neighbourCache.valid = false;
+    }
+
+    /** Check if the neighbours through the specified entity are available in
+     * the cache.
+     * \param[in] iface Index of face/edge/node
+     * \param[in] codim Codimension of the iface-th entity
+     * \return True if the neighbours are cached, false otherwise.
+     */
+    bool
+    ParaTree::isNeighbourCached(uint8_t iface, uint8_t codim) const {
+        if (!isNeighbourCacheValid()) {
+            return false;
+        } else if (codim < 1 || codim > m_neighbourCache.maxCodim) {
+            return false;
+        }
+
+        return (iface < getNofCodimensionEntities(codim));
+    }
+
     /** Compute neighbours adjacencies for every internal octant, storing them in a structure provided by the user
      * \param[in] idx Index of the octant
      * \param[out] globalNeighs Vector of global neighbours indices
@@ -2992,24 +3755,12 @@ namespace bitpit {
         if(noctants==0)
             return numeric_limits<uint32_t>::max();
         uint32_t idxtry = noctants/2;
-        uint32_t x, y, z;
         uint64_t morton, mortontry;
         int powner = 0;
-        //ParaTree works in [0,1] domain
-        if (point[0] > 1+m_tol || point[1] > 1+m_tol || point[2] > 1+m_tol
-            || point[0] < -m_tol || point[1] < -m_tol || point[2] < -m_tol){
+        if (!evalPointMorton(point, &morton)){
             return numeric_limits<uint32_t>::max();
         }
 
-        x = m_trans.mapX(std::min(std::max(point[0], 0.0), 1.0));
-        y = m_trans.mapY(std::min(std::max(point[1], 0.0), 1.0));
-        z = m_trans.mapZ(std::min(std::max(point[2], 0.0), 1.0));
-
-        if (x == TreeConstants::MAX_LENGTH) x = x - 1;
-        if (y == TreeConstants::MAX_LENGTH) y = y - 1;
-        if (z == TreeConstants::MAX_LENGTH) z = z - 1;
-        morton = PABLO::computeMorton(x,y,z);
-
 
         powner = 0;
         if(!m_serial) powner = findOwner(morton);
@@ -3020,7 +3771,7 @@ namespace bitpit {
         int32_t jump = idxtry;
         while(abs(jump) > 0){
 
-            mortontry = m_octree.m_octants[idxtry].computeMorton();
+            mortontry = m_octree.computeMorton(idxtry);
             jump = ((mortontry<morton)-(mortontry>morton))*abs(jump)/2;
             idxtry += jump;
             if (idxtry > noctants-1){
@@ -3034,20 +3785,20 @@ namespace bitpit {
                 }
             }
         }
-        if(m_octree.m_octants[idxtry].computeMorton() == morton){
+        if(m_octree.computeMorton(idxtry) == morton){
             return idxtry;
         }
         else{
             // Step until the mortontry lower than morton (one idx of distance)
             {
-                while(m_octree.m_octants[idxtry].computeMorton() < morton){
+                while(m_octree.computeMorton(idxtry) < morton){
                     idxtry++;
                     if(idxtry > noctants-1){
                         idxtry = noctants-1;
                         break;
                     }
                 }
-                while(m_octree.m_octants[idxtry].computeMorton() > morton){
+                while(m_octree.computeMorton(idxtry) > morton){
                     idxtry--;
                     if(idxtry > noctants-1){
                         idxtry = 0;
@@ -3070,25 +3821,13 @@ namespace bitpit {
         if(noctants==0)
             return numeric_limits<uint32_t>::max();
         uint32_t idxtry = noctants/2;
-        uint32_t x, y, z;
         uint64_t morton, mortontry;
         int powner = 0;
         isghost = false;
-        //ParaTree works in [0,1] domain
-        if (point[0] > 1+m_tol || point[1] > 1+m_tol || point[2] > 1+m_tol
-            || point[0] < -m_tol || point[1] < -m_tol || point[2] < -m_tol){
+        if (!evalPointMorton(point, &morton)){
             return numeric_limits<uint32_t>::max();
         }
 
-        x = m_trans.mapX(std::min(std::max(point[0], 0.0), 1.0));
-        y = m_trans.mapY(std::min(std::max(point[1], 0.0), 1.0));
-        z = m_trans.mapZ(std::min(std::max(point[2], 0.0), 1.0));
-
-        if (x == TreeConstants::MAX_LENGTH) x = x - 1;
-        if (y == TreeConstants::MAX_LENGTH) y = y - 1;
-        if (z == TreeConstants::MAX_LENGTH) z = z - 1;
-        morton = PABLO::computeMorton(x,y,z);
-
 
         powner = 0;
         if(!m_serial) powner = findOwner(morton);
@@ -3098,7 +3837,7 @@ namespace bitpit {
             int32_t jump = idxtry;
             while(abs(jump) > 0){
                 
-                mortontry = m_octree.m_octants[idxtry].computeMorton();
+                mortontry = m_octree.computeMorton(idxtry);
                 jump = ((mortontry<morton)-(mortontry>morton))*abs(jump)/2;
                 idxtry += jump;
                 if (idxtry > noctants-1){
@@ -3112,20 +3851,20 @@ namespace bitpit {
                     }
                 }
             }
-            if(m_octree.m_octants[idxtry].computeMorton() == morton){
+            if(m_octree.computeMorton(idxtry) == morton){
                 return idxtry;
             }
             else{
                 // Step until the mortontry lower than morton (one idx of distance)
                 {
-                    while(m_octree.m_octants[idxtry].computeMorton() < morton){
+                    while(m_octree.computeMorton(idxtry) < morton){
                         idxtry++;
                         if(idxtry > noctants-1){
                             idxtry = noctants-1;
                             break;
                         }
                     }
-                    while(m_octree.m_octants[idxtry].computeMorton() > morton){
+                    while(m_octree.computeMorton(idxtry) > morton){
                         idxtry--;
                         if(idxtry > noctants-1){
                             idxtry = 0;
@@ -3146,7 +3885,7 @@ namespace bitpit {
             int32_t jump = idxtry;
             while(abs(jump) > 0){
                 
-                mortontry = m_octree.m_ghosts[idxtry].computeMorton();
+                mortontry = m_octree.computeGhostMorton(idxtry);
                 jump = ((mortontry<morton)-(mortontry>morton))*abs(jump)/2;
                 idxtry += jump;
                 if (idxtry > nghosts-1){
@@ -3160,21 +3899,21 @@ namespace bitpit {
                     }
                 }
             }
-            if(m_octree.m_ghosts[idxtry].computeMorton() == morton){
+            if(m_octree.computeGhostMorton(idxtry) == morton){
                 isghost = true;
                 return idxtry;
             }
             else{
                 // Step until the mortontry lower than morton (one idx of distance)
                 {
-                    while(m_octree.m_ghosts[idxtry].computeMorton() < morton){
+                    while(m_octree.computeGhostMorton(idxtry) < morton){
                         idxtry++;
                         if(idxtry > nghosts-1){
                             idxtry = nghosts-1;
                             break;
                         }
                     }
-                    while(m_octree.m_ghosts[idxtry].computeMorton() > morton){
+                    while(m_octree.computeGhostMorton(idxtry) > morton){
                         idxtry--;
                         if(idxtry > nghosts-1){
                             idxtry = 0;
@@ -3183,25 +3922,148 @@ namespace bitpit {
                     }
                 }
 
-                const Octant* octtry = getGhostOctant(idxtry);
-                dvector anchor_idxtry = {{getX(octtry),getY(octtry),getZ(octtry)}};
-                double size_try = getSize(octtry);
-                bool isInIdxtry = true;
+                const Octant* octtry = getGhostOctant(idxtry);
+                dvector anchor_idxtry = {{getX(octtry),getY(octtry),getZ(octtry)}};
+                double size_try = getSize(octtry);
+                bool isInIdxtry = true;
+
+                for(int i = 0; i < m_dim; ++i){
+                    isInIdxtry *= (point[i] >= anchor_idxtry[i] && point[i] <= anchor_idxtry[i] + size_try);
+                }
+
+                if( isInIdxtry){
+                    isghost = true;
+                    return idxtry;
+                }
+                else{
+                    return numeric_limits<uint32_t>::max();
+                }
+            }
+        }///end ghosts search
+    };
+
+    /** Get the octant owners of a set of points.
+     *
+     * The points are sorted along the Morton curve and the owners are found
+     * with a single sweep over the local octants. Points owned by other
+     * processes or outside the domain get an invalid index.
+     * \param[in] nPoints Number of points.
+     * \param[in] points Coordinates of the points.
+     * \param[out] ownerIdx Index of octant owner of each point (max uint32_t representable if the point
+     * is outside the local partition of the domain).
+     */
+    void
+    ParaTree::getPointsOwnerIdx(std::size_t nPoints, const darray3 *points, u32vector & ownerIdx) const {
+        ivector ownerRank;
+        getPointsOwnerIdx(nPoints, points, ownerIdx, ownerRank, false);
+    }
+
+    /** Get the octant owners of a set of points.
+     *
+     * The points are sorted along the Morton curve and the owners of the
+     * points in the local partition are found with a single sweep over the
+     * local octants.
+     *
+     * If the exchange is enabled, the points owned by other processes are sent
+     * to their owners and the local index of their octant owner is sent back,
+     * all with a single collective exchange. In this case the function has to
+     * be called by all the processes of the communicator.
+     * \param[in] nPoints Number of points.
+     * \param[in] points Coordinates of the points.
+     * \param[out] ownerIdx Index of octant owner of each point, the index is local to the owner process
+     * (max uint32_t representable if the point is outside the domain or if it is owned by another process
+     * and the exchange is not enabled).
+     * \param[out] ownerRank Rank of the process owning each point (negative if the point is outside the domain).
+     * \param[in] exchange If true, the indexes of the points owned by other processes are evaluated
+     * by their owners.
+     */
+    void
+    ParaTree::getPointsOwnerIdx(std::size_t nPoints, const darray3 *points, u32vector & ownerIdx, ivector & ownerRank, bool exchange) const {
+
+        // Morton number and owner rank of the points
+        u64vector mortons(nPoints);
+        ownerRank.assign(nPoints, -1);
+        for (std::size_t i = 0; i < nPoints; ++i){
+            if (!evalPointMorton(points[i].data(), &(mortons[i]))){
+                continue;
+            }
+
+            if (m_serial){
+                ownerRank[i] = m_rank;
+            }
+            else{
+                ownerRank[i] = findOwner(mortons[i]);
+            }
+        }
+
+        // Local owners
+        u64vector localMortons(mortons);
+        for (std::size_t i = 0; i < nPoints; ++i){
+            if (ownerRank[i] != m_rank){
+                localMortons[i] = numeric_limits<uint64_t>::max();
+            }
+        }
+
+        ownerIdx.resize(nPoints);
+        findPointsLocalOwner(nPoints, localMortons.data(), ownerIdx.data());
+
+#if BITPIT_ENABLE_MPI==1
+        // Remote owners
+        if (!exchange || m_serial){
+            return;
+        }
 
-                for(int i = 0; i < m_dim; ++i){
-                    isInIdxtry *= (point[i] >= anchor_idxtry[i] && point[i] <= anchor_idxtry[i] + size_try);
-                }
+        std::vector<int> sendCounts(m_nproc, 0);
+        for (std::size_t i = 0; i < nPoints; ++i){
+            if (ownerRank[i] >= 0 && ownerRank[i] != m_rank){
+                ++sendCounts[ownerRank[i]];
+            }
+        }
 
-                if( isInIdxtry){
-                    isghost = true;
-                    return idxtry;
-                }
-                else{
-                    return numeric_limits<uint32_t>::max();
-                }
+        std::vector<int> recvCounts(m_nproc, 0);
+        MPI_Alltoall(sendCounts.data(), 1, MPI_INT, recvCounts.data(), 1, MPI_INT, m_comm);
+
+        std::vector<int> sendDispls(m_nproc, 0);
+        std::vector<int> recvDispls(m_nproc, 0);
+        for (int p = 1; p < m_nproc; ++p){
+            sendDispls[p] = sendDispls[p-1] + sendCounts[p-1];
+            recvDispls[p] = recvDispls[p-1] + recvCounts[p-1];
+        }
+        std::size_t nSendPoints = sendDispls[m_nproc-1] + sendCounts[m_nproc-1];
+        std::size_t nRecvPoints = recvDispls[m_nproc-1] + recvCounts[m_nproc-1];
+
+        // Send the Morton numbers of the remote points, grouped by owner
+        std::vector<std::size_t> sendPoints(nSendPoints);
+        u64vector sendMortons(nSendPoints);
+        std::vector<int> sendOffsets(sendDispls);
+        for (std::size_t i = 0; i < nPoints; ++i){
+            int rank = ownerRank[i];
+            if (rank >= 0 && rank != m_rank){
+                std::size_t k = sendOffsets[rank]++;
+                sendPoints[k]  = i;
+                sendMortons[k] = mortons[i];
             }
-        }///end ghosts search
-    };
+        }
+
+        u64vector recvMortons(nRecvPoints);
+        MPI_Alltoallv(sendMortons.data(), sendCounts.data(), sendDispls.data(), MPI_UINT64_T,
+                      recvMortons.data(), recvCounts.data(), recvDispls.data(), MPI_UINT64_T, m_comm);
+
+        // Find the owners of the received points and send them back
+        u32vector recvOwners(nRecvPoints);
+        findPointsLocalOwner(nRecvPoints, recvMortons.data(), recvOwners.data());
+
+        u32vector sendOwners(nSendPoints);
+        MPI_Alltoallv(recvOwners.data(), recvCounts.data(), recvDispls.data(), MPI_UINT32_T,
+                      sendOwners.data(), sendCounts.data(), sendDispls.data(), MPI_UINT32_T, m_comm);
+
+        for (std::size_t k = 0; k < nSendPoints; ++k){
+            ownerIdx[sendPoints[k]] = sendOwners[k];
+        }
+#else
+        BITPIT_UNUSED(exchange);
+#endif
+    }
 
     /** Get the octant owner rank of an input point.
      * \param[in] point Coordinates of target point.
@@ -3579,6 +4441,7 @@ namespace bitpit {
         (*m_log) << " SETTLE MARKERS " << endl;
 
         balance21(true, false);
+        m_octree.updateOctantsSoA();
 
         (*m_log) << " " << endl;
         (*m_log) << "---------------------------------------------" << endl;
@@ -3595,6 +4458,7 @@ namespace bitpit {
     ParaTree::preadapt(){
 
         balance21(true, false);
+        m_octree.updateOctantsSoA();
 
         m_lastOp = OP_PRE_ADAPT;
 
@@ -3645,7 +4509,9 @@ namespace bitpit {
         bool done = false;
 
         done = private_adapt_mapidx(mapper_flag);
+        m_octree.updateOctantsSoA();
         m_status += done;
+        updateNeighbourCache();
         return done;
 
     };
@@ -3657,6 +4523,9 @@ namespace bitpit {
     bool
     ParaTree::adaptGlobalRefine(bool mapper_flag) {
         //TODO recoding for adapting with abs(marker) > 1
+        m_octree.invalidateOctantsSoA();
+        invalidateNeighbourCache();
+
         uint32_t nocts0 = getNumOctants();
         vector<Octant>::iterator iter, iterend = m_octree.m_octants.end();
 
@@ -3730,6 +4599,9 @@ namespace bitpit {
             m_lastOp = OP_ADAPT_UNMAPPED;
         }
 
+        m_octree.updateOctantsSoA();
+        updateNeighbourCache();
+
         return globalDone;
     }
 
@@ -3740,6 +4612,9 @@ namespace bitpit {
     bool
     ParaTree::adaptGlobalCoarse(bool mapper_flag) {
         //TODO recoding for adapting with abs(marker) > 1
+        m_octree.invalidateOctantsSoA();
+        invalidateNeighbourCache();
+
         uint32_t nocts0 = getNumOctants();
         vector<Octant>::iterator iter, iterend = m_octree.m_octants.end();
 
@@ -3823,6 +4698,9 @@ namespace bitpit {
             (*m_log) << "---------------------------------------------" << endl;
         }
 #endif
+        m_octree.updateOctantsSoA();
+        updateNeighbourCache();
+
         return globalDone;
     }
 
@@ -3902,10 +4780,15 @@ namespace bitpit {
     }
 
     /** Compute the connectivity of octants and store the coordinates of nodes.
+     * \param[in] flat If set to true the connectivity is computed in flat mode:
+     * the connectivity of all the octants is stored in a single array with a
+     * fixed stride (see getFlatConnectivity). In flat mode the connectivity
+     * returned by getConnectivity is empty, the connectivity of an octant can
+     * be accessed with getConnectivityView.
      */
     void
-    ParaTree::computeConnectivity() {
-        m_octree.computeConnectivity();
+    ParaTree::computeConnectivity(bool flat) {
+        m_octree.computeConnectivity(flat);
     }
 
     /** Clear the connectivity of octants.
@@ -3916,12 +4799,51 @@ namespace bitpit {
     }
 
     /** Update the connectivity of octants.
+     * The connectivity is computed in the same mode used for the current
+     * connectivity.
      */
     void
     ParaTree::updateConnectivity() {
         m_octree.updateConnectivity();
     }
 
+    /** Check if the connectivity is computed in flat mode.
+     * \return True if the connectivity is computed in flat mode, false otherwise.
+     */
+    bool
+    ParaTree::isConnectivityFlat() const {
+        return m_octree.m_isConnectivityFlat;
+    }
+
+    /** Get the flat connectivity of the octants.
+     * The connectivity is available only if it was computed in flat mode.
+     * \return Constant reference to the flat connectivity of the octants: the
+     * indices of the nodes of the i-th octant are stored in the range
+     * [i * nnodes, (i + 1) * nnodes).
+     */
+    const u32vector &
+    ParaTree::getFlatConnectivity() const {
+        return m_octree.m_flatConnectivity;
+    }
+
+    /** Get a view of the local connectivity of an octant.
+     * The view is available both in flat mode and in standard mode.
+     * \param[in] idx Local index of octant
+     * \return View of the connectivity of the octant (4/8 indices of nodes
+     * for 2D/3D case).
+     */
+    ConstProxyVector<uint32_t>
+    ParaTree::getConnectivityView(uint32_t idx) const {
+        const uint32_t *octantConnect;
+        if (m_octree.m_isConnectivityFlat) {
+            octantConnect = m_octree.m_flatConnectivity.data() + uint64_t(idx) * m_treeConstants->nNodes;
+        } else {
+            octantConnect = m_octree.m_connectivity[idx].data();
+        }
+
+        return ConstProxyVector<uint32_t>(octantConnect, m_treeConstants->nNodes);
+    }
+
     /** Get the connectivity of the octants
      * \return Constant reference to the connectivity matrix of noctants*nnodes with
      * the connectivity of each octant (4/8 indices of nodes for 2D/3D case).
@@ -4005,6 +4927,35 @@ namespace bitpit {
         return m_octree.m_ghostsConnectivity[getIdx(oct)];
     }
 
+    /** Get the flat connectivity of the ghost octants.
+     * The connectivity is available only if it was computed in flat mode.
+     * \return Constant reference to the flat connectivity of the ghost octants:
+     * the indices of the nodes of the i-th ghost octant are stored in the range
+     * [i * nnodes, (i + 1) * nnodes).
+     */
+    const u32vector &
+    ParaTree::getFlatGhostConnectivity() const {
+        return m_octree.m_flatGhostsConnectivity;
+    }
+
+    /** Get a view of the local connectivity of a ghost octant.
+     * The view is available both in flat mode and in standard mode.
+     * \param[in] idx Local index of ghost octant
+     * \return View of the connectivity of the ghost octant (4/8 indices of
+     * nodes for 2D/3D case).
+     */
+    ConstProxyVector<uint32_t>
+    ParaTree::getGhostConnectivityView(uint32_t idx) const {
+        const uint32_t *ghostConnect;
+        if (m_octree.m_isConnectivityFlat) {
+            ghostConnect = m_octree.m_flatGhostsConnectivity.data() + uint64_t(idx) * m_treeConstants->nNodes;
+        } else {
+            ghostConnect = m_octree.m_ghostsConnectivity[idx].data();
+        }
+
+        return ConstProxyVector<uint32_t>(ghostConnect, m_treeConstants->nNodes);
+    }
+
 
 
     /** Check if the grid is 2:1 balanced across intersection of balanceCodim codimension
@@ -4430,6 +5381,11 @@ namespace bitpit {
     void
     ParaTree::privateLoadBalance(uint32_t* partition){
 
+        m_octree.invalidateOctantsSoA();
+        m_octree.invalidateOctantsMortons();
+        m_octree.invalidateGhostsMortons();
+        invalidateNeighbourCache();
+
         std::unordered_map<int, std::array<uint32_t, 2>> sendRanges = evalLoadBalanceSendRanges(partition);
         std::unordered_map<int, std::array<uint32_t, 2>> recvRanges = evalLoadBalanceRecvRanges(partition);
 
@@ -4469,6 +5425,11 @@ namespace bitpit {
                 updateLoadBalance();
                 computeGhostHalo();
             }
+        else if (m_loadBalanceMemoryBudget > 0)
+            {
+                NoLBData noData;
+                privateStreamingLoadBalance(noData, partition);
+            }
         else
             {
                 (*m_log) << " " << endl;
@@ -4715,9 +5676,98 @@ namespace bitpit {
                 updateLoadBalance();
                 computeGhostHalo();
             }
+
+            m_octree.updateOctantsSoA();
+            updateNeighbourCache();
     };
 #endif
 
+    /*! Evaluate the Morton number of the logical cell containing a point.
+     * \param[in] point Coordinates of the point.
+     * \param[out] morton Morton number of the point.
+     * \return False if the point is outside the domain, true otherwise.
+     */
+    bool
+    ParaTree::evalPointMorton(const double *point, uint64_t *morton) const {
+        //ParaTree works in [0,1] domain
+        if (point[0] > 1+m_tol || point[1] > 1+m_tol || point[2] > 1+m_tol
+            || point[0] < -m_tol || point[1] < -m_tol || point[2] < -m_tol){
+            return false;
+        }
+
+        uint32_t x = m_trans.mapX(std::min(std::max(point[0], 0.0), 1.0));
+        uint32_t y = m_trans.mapY(std::min(std::max(point[1], 0.0), 1.0));
+        uint32_t z = m_trans.mapZ(std::min(std::max(point[2], 0.0), 1.0));
+
+        if (x == TreeConstants::MAX_LENGTH) x = x - 1;
+        if (y == TreeConstants::MAX_LENGTH) y = y - 1;
+        if (z == TreeConstants::MAX_LENGTH) z = z - 1;
+        *morton = PABLO::computeMorton(x,y,z);
+
+        return true;
+    }
+
+    /*! Find the local octants containing a set of points.
+     *
+     * The points are sorted by Morton number and then matched against the
+     * local octants with a single forward sweep: for each point, the search
+     * gallops from the owner of the previous point, hence the cost is linear
+     * in the number of points plus the logarithm of the distance between
+     * consecutive owners.
+     * \param[in] nPoints Number of points.
+     * \param[in] mortons Morton number of the points, points with Morton
+     * number equal to max uint64_t are skipped.
+     * \param[out] ownerIdx Local index of the octant containing each point
+     * (max uint32_t representable for the skipped points).
+     */
+    void
+    ParaTree::findPointsLocalOwner(std::size_t nPoints, const uint64_t *mortons, uint32_t *ownerIdx) const {
+        std::vector<std::pair<uint64_t, std::size_t>> sortedPoints;
+        sortedPoints.reserve(nPoints);
+        for (std::size_t i = 0; i < nPoints; ++i){
+            ownerIdx[i] = numeric_limits<uint32_t>::max();
+            if (mortons[i] != numeric_limits<uint64_t>::max()){
+                sortedPoints.emplace_back(mortons[i], i);
+            }
+        }
+
+        uint32_t nOctants = m_octree.m_octants.size();
+        if (nOctants == 0 || sortedPoints.empty()){
+            return;
+        }
+
+        std::sort(sortedPoints.begin(), sortedPoints.end());
+
+        uint32_t idx = 0;
+        for (const std::pair<uint64_t, std::size_t> &entry : sortedPoints){
+            uint64_t morton = entry.first;
+
+            // Gallop forward to bound the last octant whose Morton number
+            // is not greater than the one of the point
+            uint32_t lower = idx;
+            uint32_t step  = 1;
+            while (lower + step < nOctants && m_octree.computeMorton(lower + step) <= morton){
+                lower += step;
+                step  *= 2;
+            }
+
+            // Bisect the bounded range
+            uint32_t upper = std::min(lower + step, nOctants);
+            while (upper - lower > 1){
+                uint32_t middle = lower + (upper - lower) / 2;
+                if (m_octree.computeMorton(middle) <= morton){
+                    lower = middle;
+                }
+                else{
+                    upper = middle;
+                }
+            }
+
+            idx = lower;
+            ownerIdx[entry.second] = idx;
+        }
+    }
+
     /*! Get the size of an octant corresponding to a target level.
      * \param[in] level Input level.
      * \return Size of an octant of input level.
@@ -4758,21 +5808,26 @@ namespace bitpit {
     bool
     ParaTree::private_adapt_mapidx(bool mapflag) {
         //TODO recoding for adapting with abs(marker) > 1
+        m_octree.invalidateOctantsSoA();
 
         m_loadBalanceRanges.clear();
         uint32_t nocts0 = getNumOctants();
-        vector<Octant >::iterator iter, iterend = m_octree.m_octants.end();
-
-        for (iter = m_octree.m_octants.begin(); iter != iterend; ++iter){
-            iter->m_info[Octant::INFO_NEW4REFINEMENT] = false;
-            iter->m_info[Octant::INFO_NEW4COARSENING] = false;
-        }
 
         // m_mapIdx init
         u32vector().swap(m_mapIdx);
         if (mapflag) {
             m_mapIdx.resize(nocts0);
-            for (uint32_t i=0; i<nocts0; i++){
+        }
+
+#if BITPIT_ENABLE_OPENMP==1
+        #pragma omp parallel for schedule(static)
+#endif
+        for (uint32_t i=0; i<nocts0; i++){
+            Octant &octant = m_octree.m_octants[i];
+            octant.m_info[Octant::INFO_NEW4REFINEMENT] = false;
+            octant.m_info[Octant::INFO_NEW4COARSENING] = false;
+
+            if (mapflag) {
                 m_mapIdx[i] = i;
             }
         }
@@ -4939,6 +5994,8 @@ namespace bitpit {
 
     /*! Compute the partition of the octree over the processes (only compute the information about
      * how distribute the mesh). This is an weighted distribution method: each process will have the same weight.
+     * When the tree is distributed, the splits are evaluated by each process on its own octants starting
+     * from a parallel prefix sum of the local weights, hence the weights of the octants are never gathered.
      * \param[out] partition Pointer to partition information array. partition[i] = number of octants
      * to be stored on the i-th process (i-th rank).
      * \param[in] weight Pointer to weight array. weight[i] = weight of i-th local octant.
@@ -4973,200 +6030,62 @@ namespace bitpit {
         }
         else{
 
-            int weightSize = weight->size();
-            double* gweight;
-            double* lweight = new double[weightSize];
+            // Weight of the local octants and of the whole tree
+            uint32_t nLocalOctants = weight->size();
 
-            for (unsigned int i=0; i<weight->size(); i++){
-                lweight[i] = (*weight)[i];
+            double localWeight = 0.0;
+            for (uint32_t i = 0; i < nLocalOctants; ++i){
+                localWeight += (*weight)[i];
             }
 
-            int *oldpartition = new int[m_nproc];
-            int *displays = new int[m_nproc];
-            MPI_Allgather(&weightSize,1,MPI_INT,oldpartition,1,MPI_INT,m_comm);
-            int globalNofOctant = 0;
-            for(int i = 0; i < m_nproc; ++i){
-                displays[i] = globalNofOctant;
-                globalNofOctant += oldpartition[i];
+            double globalWeight = 0.0;
+            m_errorFlag = MPI_Allreduce(&localWeight,&globalWeight,1,MPI_DOUBLE,MPI_SUM,m_comm);
+            if (!(globalWeight > 0.0)){
+                computePartition(partition);
+                return;
             }
-            gweight = new double[globalNofOctant];
-            MPI_Allgatherv(lweight,weightSize,MPI_DOUBLE,gweight,oldpartition,displays,MPI_DOUBLE,m_comm);
 
-            double division_result = 0;
-            double global_weight = 0.0;
-            for (int i=0; i<globalNofOctant; i++){
-                global_weight += gweight[i];
+            // Weight of the octants stored on the previous processes
+            double offsetWeight = 0.0;
+            m_errorFlag = MPI_Exscan(&localWeight,&offsetWeight,1,MPI_DOUBLE,MPI_SUM,m_comm);
+            if (m_rank == 0){
+                offsetWeight = 0.0;
             }
-            division_result = global_weight/(double)m_nproc;
 
-            //Estimate resulting weight distribution starting from proc 0 (sending tail)
-            //Estimate sending weight by each proc in initial conf (sending tail)
-            uint32_t i = 0, tot = 0;
-            int iproc = 0;
-            while (iproc < m_nproc-1){
-                double partial_weight = 0.0;
-                partition[iproc] = 0;
-                while(partial_weight < division_result && (int32_t) i < globalNofOctant){
-                    partial_weight += gweight[i];
-                    tot++;
-                    partition[iproc]++;
-                    i++;
-                }
-                global_weight = 0;
-                for(int j = i; j < globalNofOctant; ++j)
-                    global_weight += gweight[j];
-                division_result = global_weight/double(m_nproc-(iproc+1));
-                iproc++;
+            uint64_t offsetIdx = 0;
+            if (m_rank > 0){
+                offsetIdx = m_partitionRangeGlobalIdx[m_rank-1] + 1;
             }
-            partition[m_nproc-1] = globalNofOctant - tot;
-
-            delete [] oldpartition;
-            delete [] displays;
-            delete [] lweight;
-            delete [] gweight;
-
-            //TODO CHECK OLD ALGORITHM
-            //		double division_result = 0;
-            //		double remind = 0;
-            //		dvector local_weight(m_nproc,0.0);
-            //		dvector temp_local_weight(m_nproc,0.0);
-            //		dvector2D sending_weight(m_nproc, dvector(m_nproc,0.0));
-            //		double* rbuff = new double[m_nproc];
-            //		double global_weight = 0.0;
-            //		for (int i=0; i<weight->size(); i++){
-            //			local_weight[m_rank] += (*weight)[i];
-            //		}
-            //		m_errorFlag = MPI_Allgather(&local_weight[m_rank],1,MPI_DOUBLE,rbuff,1,MPI_DOUBLE,m_comm);
-            //		for (int i=0; i<m_nproc; i++){
-            //			local_weight[i] = rbuff[i];
-            //			global_weight += rbuff[i];
-            //		}
-            //		delete [] rbuff; rbuff = NULL;
-            //		division_result = global_weight/(double)m_nproc;
-            //
-            //		//Estimate resulting weight distribution starting from proc 0 (sending tail)
-            //
-            //		temp_local_weight = local_weight;
-            //		//Estimate sending weight by each proc in initial conf (sending tail)
-            //
-            //		for (int iter = 0; iter < 1; iter++){
-            //
-            //			vector<double> delta(m_nproc);
-            //			for (int i=0; i<m_nproc; i++){
-            //				delta[i] = temp_local_weight[i] - division_result;
-            //			}
-            //
-            //			for (int i=0; i<m_nproc-1; i++){
-            //
-            //				double post_weight = 0.0;
-            //				for (int j=i+1; j<m_nproc; j++){
-            //					post_weight += temp_local_weight[j];
-            //				}
-            //				if (temp_local_weight[i] > division_result){
-            //
-            //					delta[i] = temp_local_weight[i] - division_result;
-            //					if (post_weight < division_result*(m_nproc-i-1)){
-            //
-            //						double post_delta =  division_result*(m_nproc-i-1) - post_weight;
-            //						double delta_sending = min(local_weight[i], min(delta[i], post_delta));
-            //						int jproc = i+1;
-            //						double sending = 0;
-            //						while (delta_sending > 0 && jproc<m_nproc){
-            //							sending = min(division_result, delta_sending);
-            //							sending = min(sending, (division_result-temp_local_weight[jproc]));
-            //							sending = max(sending, 0.0);
-            //							sending_weight[i][jproc] += sending;
-            //							temp_local_weight[jproc] += sending;
-            //							temp_local_weight[i] -= sending;
-            //							delta_sending -= sending;
-            //							delta[i] -= delta_sending;
-            //							jproc++;
-            //						}
-            //					} //post
-            //				}//weight>
-            //			}//iproc
-            //
-            //			for (int i = m_nproc-1; i>0; i--){
-            //
-            //				double pre_weight = 0.0;
-            //				for (int j=i-1; j>=0; j--){
-            //					pre_weight += temp_local_weight[j];
-            //				}
-            //				if (temp_local_weight[i] > division_result){
-            //
-            //					delta[i] = temp_local_weight[i] - division_result;
-            //					if (pre_weight < division_result*(i)){
-            //
-            //						double pre_delta =  division_result*(i) - pre_weight;
-            //						double delta_sending = min(local_weight[i], min(temp_local_weight[i], min(delta[i], pre_delta)));
-            //						int jproc = i-1;
-            //						double sending = 0;
-            //						while (delta_sending > 0 && jproc >=0){
-            //							sending = min(division_result, delta_sending);
-            //							sending = min(sending, (division_result-temp_local_weight[jproc]));
-            //							sending = max(sending, 0.0);
-            //							sending_weight[i][jproc] += sending;
-            //							temp_local_weight[jproc] += sending;
-            //							temp_local_weight[i] -= sending;
-            //							delta_sending -= sending;
-            //							delta[i] -= delta_sending;
-            //							jproc--;
-            //						}
-            //					}//pre
-            //				}//weight>
-            //			}//iproc
-            //		}//iter
-            //
-            //		//Update partition locally
-            //		//to send
-            //		u32vector sending_cell(m_nproc,0);
-            //		int i = getNumOctants();;
-            //		for (int jproc=m_nproc-1; jproc>m_rank; jproc--){
-            //			double pack_weight = 0.0;
-            //			while(pack_weight < sending_weight[m_rank][jproc] && i > 0){
-            //				i--;
-            //				pack_weight += (*weight)[i];
-            //				sending_cell[jproc]++;
-            //			}
-            //		}
-            //		partition[m_rank] = i;
-            //		i = 0;
-            //		for (int jproc=0; jproc<m_rank; jproc++){
-            //			double pack_weight = 0.0;
-            //			while(pack_weight < sending_weight[m_rank][jproc] && i <  getNumOctants()-1){
-            //				i++;
-            //				pack_weight += (*weight)[i];
-            //				sending_cell[jproc]++;
-            //			}
-            //		}
-            //		partition[m_rank] -= i;
-            //
-            //		//to receive
-            //		u32vector rec_cell(m_nproc,0);
-            //		MPI_Request* req = new MPI_Request[m_nproc*10];
-            //		MPI_Status* stats = new MPI_Status[m_nproc*10];
-            //		int nReq = 0;
-            //		for (int iproc=0; iproc<m_nproc; iproc++){
-            //			m_errorFlag = MPI_Irecv(&rec_cell[iproc],1,MPI_UINT32_T,iproc,m_rank,m_comm,&req[nReq]);
-            //			++nReq;
-            //		}
-            //		for (int iproc=0; iproc<m_nproc; iproc++){
-            //			m_errorFlag =  MPI_Isend(&sending_cell[iproc],1,MPI_UINT32_T,iproc,iproc,m_comm,&req[nReq]);
-            //			++nReq;
-            //		}
-            //		MPI_Waitall(nReq,req,stats);
-            //
-            //		delete [] req; req = NULL;
-            //		delete [] stats; stats = NULL;
+
+            // Split the local octants along the Morton curve
             //
-            //		i = 0;
-            //		for (int jproc=0; jproc<m_nproc; jproc++){
-            //			i+= rec_cell[jproc];
-            //		}
-            //		partition[m_rank] += i;
-            //		uint32_t part = partition[m_rank];
-            //		m_errorFlag = MPI_Allgather(&part,1,MPI_UINT32_T,partition,1,MPI_UINT32_T,m_comm);
+            // An octant is assigned to the process whose share of the global
+            // weight contains the weight of all the octants that precede it.
+            // Since the assignment is monotone along the curve, the partition
+            // is defined by the global index of the first octant of each
+            // process. Every process evaluates the splits falling into its own
+            // range, a global reduction then collects all the splits.
+            std::vector<uint64_t> firstIdx(m_nproc, m_globalNumOctants);
+            firstIdx[0] = 0;
+
+            double prefixWeight = offsetWeight;
+            int prevDest = 0;
+            for (uint32_t i = 0; i < nLocalOctants; ++i){
+                int dest = std::min(m_nproc - 1, int(prefixWeight * m_nproc / globalWeight));
+                for (int iproc = prevDest + 1; iproc <= dest; ++iproc){
+                    firstIdx[iproc] = offsetIdx + i;
+                }
+                prevDest = std::max(prevDest, dest);
+
+                prefixWeight += (*weight)[i];
+            }
+
+            m_errorFlag = MPI_Allreduce(MPI_IN_PLACE,firstIdx.data(),m_nproc,MPI_UINT64_T,MPI_MIN,m_comm);
 
+            for (int iproc = 0; iproc < m_nproc - 1; ++iproc){
+                partition[iproc] = uint32_t(firstIdx[iproc+1] - firstIdx[iproc]);
+            }
+            partition[m_nproc-1] = uint32_t(m_globalNumOctants - firstIdx[m_nproc-1]);
         }
     };
 
@@ -5288,6 +6207,7 @@ namespace bitpit {
     ParaTree::updateLoadBalance() {
         //update sizes
         m_octree.m_sizeOctants = m_octree.m_octants.size();
+        m_octree.updateOctantsMortons();
 
         m_octree.updateLocalMaxDepth();
         uint64_t* rbuff = new uint64_t[m_nproc];
@@ -5436,7 +6356,9 @@ namespace bitpit {
                 }
             }
         }
+        m_pborders.resize(countpbd);
         m_pborders.shrink_to_fit();
+        m_internals.resize(countint);
         m_internals.shrink_to_fit();
 
         // Build ghosts
@@ -5934,6 +6856,7 @@ namespace bitpit {
             m_octree.m_sizeGhosts += nRankGhosts;
         }
 
+        m_octree.invalidateGhostsMortons();
         m_octree.m_ghosts.resize(m_octree.m_sizeGhosts);
         m_octree.m_globalIdxGhosts.resize(m_octree.m_sizeGhosts);
 
@@ -5969,14 +6892,19 @@ namespace bitpit {
             }
         }
 
+        m_octree.updateGhostsMortons();
+
         // Wait for the communications to complete
         ghostDataCommunicator.waitAllSends();
     }
 
     /*! Communicate the marker of the octants and the auxiliary info[15].
+     * \param[out] ghostOffsets If not null, on output will contain, for each
+     * rank the ghosts are received from, the index of the first ghost owned
+     * by that rank
      */
     void
-    ParaTree::commMarker() {
+    ParaTree::commMarker(std::unordered_map<int, uint32_t> *ghostOffsets) {
         // If the tree is not partitioned, there is nothing to communicate.
         if (m_serial) {
             return;
@@ -6019,11 +6947,19 @@ namespace bitpit {
         std::vector<int> recvRanks = markerCommunicator.getRecvRanks();
         std::sort(recvRanks.begin(), recvRanks.end());
 
+        if (ghostOffsets) {
+            ghostOffsets->clear();
+        }
+
         uint32_t ghostIdx = 0;
         for(int rank : recvRanks){
             markerCommunicator.waitRecv(rank);
             RecvBuffer &recvBuffer = markerCommunicator.getRecvBuffer(rank);
 
+            if (ghostOffsets) {
+                (*ghostOffsets)[rank] = ghostIdx;
+            }
+
             const std::size_t nRankGhosts = recvBuffer.getSize() / MARKER_ENTRY_BINARY_SIZE;
             for(std::size_t i = 0; i < nRankGhosts; ++i){
                 int8_t marker;
@@ -6040,6 +6976,167 @@ namespace bitpit {
 
         markerCommunicator.waitAllSends();
     }
+
+    /*! Find the first ghost octant owned by the specified process.
+     * Ghost octants are sorted by Morton number, hence the ghosts owned by
+     * a process are stored contiguously.
+     * \param[in] rank Rank of the process
+     * \return Local index of the first ghost octant owned by the specified
+     * process, if the process owns no ghosts the index of the first ghost owned
+     * by the following processes is returned.
+     */
+    uint32_t
+    ParaTree::findFirstGhostOfRank(int rank) const {
+        uint64_t firstGlobalIdx = 0;
+        if (rank > 0) {
+            firstGlobalIdx = m_partitionRangeGlobalIdx[rank - 1] + 1;
+        }
+
+        const u64vector &ghostGlobalIdxs = m_octree.m_globalIdxGhosts;
+        u64vector::const_iterator firstGhostItr = std::lower_bound(ghostGlobalIdxs.begin(), ghostGlobalIdxs.end(), firstGlobalIdx);
+
+        return static_cast<uint32_t>(std::distance(ghostGlobalIdxs.begin(), firstGhostItr));
+    }
+
+    /*! Check if a split-phase communication of user data is active.
+     * \return True if a communication has been started with startCommunication
+     * and not yet finished with finishCommunication, false otherwise.
+     */
+    bool
+    ParaTree::isCommunicationActive() const {
+        return static_cast<bool>(m_userDataCommunicator);
+    }
+
+    /*! Initialize the frontier used by the 2:1 balance to exchange only the
+     * markers that have been modified.
+     *
+     * The markers of the ghosts have to be up-to-date when this function is
+     * called: the snapshot of the border octants taken here is what the
+     * receiving processes already know.
+     * \param[in] ghostOffsets Index of the first ghost owned by each rank the
+     * ghosts are received from, as returned by the last marker communication
+     * \param[out] frontier Frontier that will be initialized
+     */
+    void
+    ParaTree::initializeBalanceFrontier(const std::unordered_map<int, uint32_t> &ghostOffsets, BalanceFrontier *frontier) {
+        frontier->ghostOffsets = ghostOffsets;
+
+        uint32_t nOctants = m_octree.getNumOctants();
+        frontier->sentMarkers.assign(nOctants, 0);
+        frontier->sentAux.assign(nOctants, false);
+        for(const auto &bordersPerProcEntry : m_bordersPerProc){
+            for(uint32_t idx : bordersPerProcEntry.second){
+                const Octant &octant = m_octree.m_octants[idx];
+                frontier->sentMarkers[idx] = octant.getMarker();
+                frontier->sentAux[idx] = octant.m_info[Octant::INFO_AUX];
+            }
+        }
+
+        frontier->ghosts.clear();
+    }
+
+    /*! Communicate the marker and the auxiliary info[15] of the border octants
+     * modified since the previous communication.
+     *
+     * Each entry of the communication buffer contains the position of the
+     * octant in the list of borders sent to the receiving process, followed
+     * by the marker and the auxiliary info. Processes with no modified border
+     * octants do not send any message. The indices of the ghosts updated by
+     * the communication are appended to the ghost list of the frontier.
+     * \param[in,out] frontier Frontier of the 2:1 balance
+     * \return The number of marker entries sent by this process.
+     */
+    uint32_t
+    ParaTree::commMarkerFrontier(BalanceFrontier *frontier) {
+        // Binary size of a marker entry in the communication buffer
+        const std::size_t MARKER_ENTRY_BINARY_SIZE = sizeof(uint32_t) + sizeof(int8_t) + sizeof(bool);
+
+        // Fill communication buffers with the modified border octants
+        DataCommunicator markerCommunicator(m_comm);
+
+        uint32_t nSentEntries = 0;
+        u32vector modifiedBorders;
+        for(const auto &bordersPerProcEntry : m_bordersPerProc){
+            int rank = bordersPerProcEntry.first;
+            const std::vector<uint32_t> &rankBordersPerProc = bordersPerProcEntry.second;
+            const std::size_t nRankBorders = rankBordersPerProc.size();
+
+            modifiedBorders.clear();
+            for(std::size_t i = 0; i < nRankBorders; ++i){
+                uint32_t idx = rankBordersPerProc[i];
+                const Octant &octant = m_octree.m_octants[idx];
+                if (octant.getMarker() != frontier->sentMarkers[idx] || octant.m_info[Octant::INFO_AUX] != frontier->sentAux[idx]) {
+                    modifiedBorders.push_back(i);
+                }
+            }
+
+            if (modifiedBorders.empty()) {
+                continue;
+            }
+
+            std::size_t buffSize = modifiedBorders.size() * MARKER_ENTRY_BINARY_SIZE;
+            markerCommunicator.setSend(rank, buffSize);
+
+            SendBuffer &sendBuffer = markerCommunicator.getSendBuffer(rank);
+            for(uint32_t i : modifiedBorders){
+                const Octant &octant = m_octree.m_octants[rankBordersPerProc[i]];
+                sendBuffer << i;
+                sendBuffer << octant.getMarker();
+                sendBuffer << octant.m_info[Octant::INFO_AUX];
+            }
+
+            nSentEntries += modifiedBorders.size();
+        }
+
+        markerCommunicator.discoverRecvs();
+        markerCommunicator.startAllRecvs();
+        markerCommunicator.startAllSends();
+
+        // Update the snapshot of the border octants
+        //
+        // An octant may be a border for more than one process, hence the
+        // snapshot can be updated only after all the buffers are filled.
+        for(const auto &bordersPerProcEntry : m_bordersPerProc){
+            for(uint32_t idx : bordersPerProcEntry.second){
+                const Octant &octant = m_octree.m_octants[idx];
+                frontier->sentMarkers[idx] = octant.getMarker();
+                frontier->sentAux[idx] = octant.m_info[Octant::INFO_AUX];
+            }
+        }
+
+        // Update the modified ghosts
+        int nCompletedRecvs = 0;
+        while (nCompletedRecvs < markerCommunicator.getRecvCount()) {
+            int rank = markerCommunicator.waitAnyRecv();
+            RecvBuffer &recvBuffer = markerCommunicator.getRecvBuffer(rank);
+
+            uint32_t ghostOffset = frontier->ghostOffsets.at(rank);
+            const std::size_t nRankEntries = recvBuffer.getSize() / MARKER_ENTRY_BINARY_SIZE;
+            for(std::size_t n = 0; n < nRankEntries; ++n){
+                uint32_t i;
+                recvBuffer >> i;
+
+                uint32_t ghostIdx = ghostOffset + i;
+                Octant &ghost = m_octree.m_ghosts[ghostIdx];
+
+                int8_t marker;
+                recvBuffer >> marker;
+                ghost.setMarker(marker);
+
+                bool aux;
+                recvBuffer >> aux;
+                ghost.m_info[Octant::INFO_AUX] = aux;
+
+                frontier->ghosts.push_back(ghostIdx);
+            }
+
+            ++nCompletedRecvs;
+        }
+
+        markerCommunicator.waitAllSends();
+
+        return nSentEntries;
+    }
 #endif
 
     /*! Update the distributed octree over the processes after a coarsening procedure
@@ -6101,6 +7198,15 @@ namespace bitpit {
     }
 
     /*!Balance 2:1 the octree.
+     *
+     * The balance is reached through an iterative procedure: at each iteration
+     * the markers of the border octants are exchanged and the ghosts with the
+     * AUX bit set are used to propagate the balance inside the partitions.
+     * With the frontier strategy (the default on distributed trees), after the
+     * first iteration only the markers of the border octants modified by the
+     * previous iteration are exchanged and only the ghosts they refer to are
+     * re-examined. The number of octants visited by each iteration is stored
+     * and can be retrieved with getBalanceVisits().
      * \param[in] verbose If set to true output messages will be printed on
      * the logger
      * \param[in] balanceNewOctants If set to true also new octants will be
@@ -6109,6 +7215,9 @@ namespace bitpit {
     void
     ParaTree::balance21(bool verbose, bool balanceNewOctants){
 
+        // The markers are updated directly on the octants
+        m_octree.invalidateOctantsSoA();
+
         // Print header
         if (verbose){
             (*m_log) << "---------------------------------------------" << endl;
@@ -6118,7 +7227,17 @@ namespace bitpit {
             (*m_log) << " " << endl;
         }
 
+#if BITPIT_ENABLE_MPI==1
+        // Frontier of the balance
+        bool useFrontier = (!m_serial && m_balanceStrategy == BALANCE_STRATEGY_FRONTIER);
+
+        std::unordered_map<int, uint32_t> ghostOffsets;
+        BalanceFrontier frontier;
+#endif
+
         // 2:1 balancing
+        m_balanceVisits.clear();
+
         int iteration = 0;
         bool markersModified = true;
         while (markersModified) {
@@ -6131,7 +7250,13 @@ namespace bitpit {
 
 #if BITPIT_ENABLE_MPI==1
             // Communicate markers
-            commMarker();
+            uint32_t nExchanged = 0;
+            if (useFrontier && !processInternals) {
+                frontier.ghosts.clear();
+                nExchanged += commMarkerFrontier(&frontier);
+            } else {
+                commMarker();
+            }
 #endif
 
             // Pre-processing for 2:1 balancing
@@ -6139,11 +7264,36 @@ namespace bitpit {
 
 #if BITPIT_ENABLE_MPI==1
             // Communicate markers
-            commMarker();
+            if (useFrontier && !processInternals) {
+                nExchanged += commMarkerFrontier(&frontier);
+            } else if (useFrontier) {
+                commMarker(&ghostOffsets);
+                initializeBalanceFrontier(ghostOffsets, &frontier);
+            } else {
+                commMarker();
+            }
 #endif
 
             // Execute local loadbalance
-            markersModified = m_octree.localBalance(balanceNewOctants, processInternals);
+            const u32vector *ghostFrontier = nullptr;
+#if BITPIT_ENABLE_MPI==1
+            if (useFrontier && !processInternals) {
+                std::sort(frontier.ghosts.begin(), frontier.ghosts.end());
+                frontier.ghosts.erase(std::unique(frontier.ghosts.begin(), frontier.ghosts.end()), frontier.ghosts.end());
+                ghostFrontier = &frontier.ghosts;
+
+                if (verbose){
+                    (*m_log) << " Exchanged markers	:	" + to_string(nExchanged) << endl;
+                }
+            }
+#endif
+
+            uint32_t nVisited;
+            markersModified = m_octree.localBalance(balanceNewOctants, processInternals, ghostFrontier, &nVisited);
+            m_balanceVisits.push_back(nVisited);
+            if (verbose){
+                (*m_log) << " Visited octants	:	" + to_string(nVisited) << endl;
+            }
 #if BITPIT_ENABLE_MPI==1
             if (!m_serial) {
                 MPI_Allreduce(MPI_IN_PLACE, &markersModified, 1, MPI_C_BOOL, MPI_LOR, m_comm);
@@ -6162,7 +7312,11 @@ namespace bitpit {
 
 #if BITPIT_ENABLE_MPI==1
         // Communicate markers
-        commMarker();
+        if (useFrontier) {
+            commMarkerFrontier(&frontier);
+        } else {
+            commMarker();
+        }
 #endif
 
         // Print footer
@@ -6185,7 +7339,7 @@ namespace bitpit {
     void
     ParaTree::write(const std::string &filename) {
 
-        if (m_octree.m_connectivity.size() == 0) {
+        if (m_octree.m_connectivity.size() == 0 && m_octree.m_flatConnectivity.size() == 0) {
             m_octree.computeConnectivity();
         }
 
@@ -6200,13 +7354,13 @@ namespace bitpit {
             return;
         }
         int nofNodes = m_octree.m_nodes.size();
-        int nofOctants = m_octree.m_connectivity.size();
-        int nofGhosts = m_octree.m_ghostsConnectivity.size();
+        int nofOctants = getNumOctants();
+        int nofGhosts = getNumGhosts();
         int nofAll = nofGhosts + nofOctants;
         out << "<?xml version=\"1.0\"?>" << endl
             << "<VTKFile type=\"UnstructuredGrid\" version=\"0.1\" byte_order=\"BigEndian\">" << endl
             << "  <UnstructuredGrid>" << endl
-            << "    <Piece NumberOfCells=\"" << m_octree.m_connectivity.size() + m_octree.m_ghostsConnectivity.size() << "\" NumberOfPoints=\"" << m_octree.m_nodes.size() << "\">" << endl;
+            << "    <Piece NumberOfCells=\"" << nofAll << "\" NumberOfPoints=\"" << m_octree.m_nodes.size() << "\">" << endl;
         out << "      <Points>" << endl
             << "        <DataArray type=\"Float64\" Name=\"Coordinates\" NumberOfComponents=\""<< 3 <<"\" format=\"ascii\">" << endl
             << "          " << std::fixed;
@@ -6241,7 +7395,7 @@ namespace bitpit {
                                 jj = 2;
                             }
                         }
-                        out << m_octree.m_connectivity[i][jj] << " ";
+                        out << getConnectivityView(i)[jj] << " ";
                     }
                 if((i+1)%3==0 && i!=nofOctants-1)
                     out << endl << "          ";
@@ -6262,7 +7416,7 @@ namespace bitpit {
                                 jj = 2;
                             }
                         }
-                        out << m_octree.m_ghostsConnectivity[i][jj] << " ";
+                        out << getGhostConnectivityView(i)[jj] << " ";
                     }
                 if((i+1)%3==0 && i!=nofGhosts-1)
                     out << endl << "          ";
@@ -6340,7 +7494,7 @@ namespace bitpit {
     void
     ParaTree::writeTest(const std::string &filename, vector<double> data) {
 
-        if (m_octree.m_connectivity.size() == 0) {
+        if (m_octree.m_connectivity.size() == 0 && m_octree.m_flatConnectivity.size() == 0) {
             m_octree.computeConnectivity();
         }
 
@@ -6355,16 +7509,16 @@ namespace bitpit {
             return;
         }
         int nofNodes = m_octree.m_nodes.size();
-        int nofOctants = m_octree.m_connectivity.size();
+        int nofOctants = getNumOctants();
         int nofAll = nofOctants;
         out << "<?xml version=\"1.0\"?>" << endl
             << "<VTKFile type=\"UnstructuredGrid\" version=\"0.1\" byte_order=\"BigEndian\">" << endl
             << "  <UnstructuredGrid>" << endl
-            << "    <Piece NumberOfCells=\"" << m_octree.m_connectivity.size() << "\" NumberOfPoints=\"" << m_octree.m_nodes.size() << "\">" << endl;
+            << "    <Piece NumberOfCells=\"" << nofOctants << "\" NumberOfPoints=\"" << m_octree.m_nodes.size() << "\">" << endl;
         out << "      <CellData Scalars=\"Data\">" << endl;
         out << "      <DataArray type=\"Float64\" Name=\"Data\" NumberOfComponents=\"1\" format=\"ascii\">" << endl
             << "          " << std::fixed;
-        int ndata = m_octree.m_connectivity.size();
+        int ndata = nofOctants;
         for(int i = 0; i < ndata; i++)
             {
                 out << std::setprecision(6) << data[i] << " ";
@@ -6407,7 +7561,7 @@ namespace bitpit {
                                 jj = 2;
                             }
                         }
-                        out << m_octree.m_connectivity[i][jj] << " ";
+                        out << getConnectivityView(i)[jj] << " ";
                     }
                 if((i+1)%3==0 && i!=nofOctants-1)
                     out << endl << "          ";
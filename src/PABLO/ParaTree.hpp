@@ -39,7 +39,9 @@
 #include "LocalTree.hpp"
 #include "Map.hpp"
 #include "bitpit_IO.hpp"
+#include "bitpit_containers.hpp"
 #include <map>
+#include <memory>
 #include <unordered_map>
 #include <unordered_set>
 #include <set>
@@ -87,6 +89,7 @@ namespace bitpit {
         // =================================================================================== //
     public:
         static const std::string	DEFAULT_LOG_FILE;			/**<Default name of logger file.*/
+        static const std::size_t	CHECKPOINT_OCTANT_SIZE;		/**<Size, in bytes, of an octant record in the checkpoint files.*/
 
         typedef std::unordered_map<int, std::array<uint32_t, 2>> ExchangeRanges;
 
@@ -100,6 +103,16 @@ namespace bitpit {
             OP_LOADBALANCE
         };
 
+        enum OctantLayout {
+            OCTANT_LAYOUT_AOS,
+            OCTANT_LAYOUT_SOA
+        };
+
+        enum BalanceStrategy {
+            BALANCE_STRATEGY_SWEEP,
+            BALANCE_STRATEGY_FRONTIER
+        };
+
         struct LoadBalanceRanges {
             enum ExchangeAction {
                 ACTION_UNDEFINED = -1,
@@ -131,6 +144,28 @@ namespace bitpit {
             std::unordered_map<uint64_t, int> population;
         };
 
+        struct BalanceFrontier {
+            std::unordered_map<int, uint32_t> ghostOffsets;
+            std::vector<int8_t> sentMarkers;
+            std::vector<bool> sentAux;
+            u32vector ghosts;
+        };
+
+        struct NeighbourCache {
+            uint8_t maxCodim;
+            bool valid;
+            uint64_t status;
+            uint8_t nEntities;
+            std::array<uint8_t, 4> firstEntity;
+            std::vector<std::size_t> offsets;
+            u32vector neighbours;
+            std::vector<uint8_t> ghostFlags;
+
+            NeighbourCache();
+
+            void clear();
+        };
+
         //undistributed members
         std::vector<uint64_t>	m_partitionFirstDesc; 			/**<Global array containing position of the first possible octant in each processor*/
         std::vector<uint64_t>	m_partitionLastDesc; 			/**<Global array containing position of the last possible octant in each processor*/
@@ -162,6 +197,10 @@ namespace bitpit {
         int 					m_errorFlag;					/**<MPI error flag*/
         bool 					m_serial;						/**<True if the octree is the same on each processor, False if the octree is distributed*/
         double					m_tol;							/**<Tolerance for geometric operations.*/
+        BalanceStrategy			m_balanceStrategy;				/**<Strategy used to iterate the 2:1 balance of distributed trees.*/
+        u32vector				m_balanceVisits;				/**<Number of octants visited by each iteration of the last 2:1 balance.*/
+        std::size_t				m_loadBalanceMemoryBudget;		/**<Memory, in bytes, available to the buffers of a streaming load balance (zero disables streaming).*/
+        NeighbourCache			m_neighbourCache;				/**<Precomputed neighbours of the local octants.*/
 
         //map members
         Map 					m_trans;						/**<Transformation map from m_logical to physical domain*/
@@ -182,6 +221,7 @@ namespace bitpit {
 #if BITPIT_ENABLE_MPI==1
         //TODO Duplicate communicator
         MPI_Comm 				m_comm;							/**<MPI communicator*/
+        std::unique_ptr<DataCommunicator> m_userDataCommunicator;	/**<Communicator of the active split-phase communication of user data*/
 #endif
 
         // =================================================================================== //
@@ -214,6 +254,14 @@ namespace bitpit {
         virtual void	dump(std::ostream &stream, bool full = true);
         virtual void	restore(std::istream &stream);
 
+        void	dumpCheckpoint(const std::string &filename);
+        void	restoreCheckpoint(const std::string &filename);
+
+    protected:
+        virtual void	dumpCheckpointHeader(std::ostream &stream);
+        virtual void	restoreCheckpointHeader(std::istream &stream);
+
+    public:
         void	printHeader();
         void	printFooter();
 
@@ -269,6 +317,13 @@ namespace bitpit {
         bool		getPeriodic(uint8_t i) const;
         void		setPeriodic(uint8_t i);
         void		setTol(double tol = 1.0e-14);
+        OctantLayout getOctantLayout() const;
+        void		setOctantLayout(OctantLayout layout);
+        BalanceStrategy getBalanceStrategy() const;
+        void		setBalanceStrategy(BalanceStrategy strategy);
+        std::size_t getLoadBalanceMemoryBudget() const;
+        void		setLoadBalanceMemoryBudget(std::size_t budget);
+        u32vector	getBalanceVisits() const;
 
         // =================================================================================== //
         // INDEX BASED METHODS																   //
@@ -303,6 +358,7 @@ namespace bitpit {
         bool 		getIsNewC(uint32_t idx) const;
         uint64_t 	getGlobalIdx(uint32_t idx) const;
         uint64_t 	getGhostGlobalIdx(uint32_t idx) const;
+        uint64_t 	getGhostMorton(uint32_t idx) const;
         uint32_t    getLocalIdx(uint64_t gidx) const;
         uint32_t    getLocalIdx(uint64_t gidx,int rank) const;
         void        getLocalIdx(uint64_t gidx,uint32_t & lidx,int & rank) const;
@@ -440,6 +496,9 @@ namespace bitpit {
         // =================================================================================== //
 
         void        findAllGlobalNeighbours(uint32_t idx, std::vector<uint64_t> &globalNeighs);
+        uint8_t     getNofCodimensionEntities(uint8_t codim) const;
+        void        invalidateNeighbourCache();
+        bool        isNeighbourCached(uint8_t iface, uint8_t codim) const;
         void        findNeighbours(const Octant* oct, bool haveIidx, uint32_t idx, uint8_t iface, uint8_t codim, u32vector & neighbours, bvector & isghost, bool onlyinternals = false) const;
     public:
         void 		findNeighbours(uint32_t idx, uint8_t iface, uint8_t codim, u32vector & neighbours, bvector & isghost) const;
@@ -449,6 +508,12 @@ namespace bitpit {
         void 		findGhostNeighbours(const Octant* oct, uint8_t iface, uint8_t codim, u32vector & neighbours, bvector & isghost) const;
         void 		findAllNodeNeighbours(uint32_t idx, uint32_t inode, u32vector & neighbours, bvector & isghost);
         void 		findAllNodeNeighbours(const Octant* oct, uint32_t inode, u32vector & neighbours, bvector & isghost) const;
+        void 		enableNeighbourCache(uint8_t maxCodim = 1);
+        void 		disableNeighbourCache();
+        uint8_t 	getNeighbourCacheCodimension() const;
+        bool 		isNeighbourCacheValid() const;
+        void 		updateNeighbourCache();
+        ConstProxyVector<uint32_t> getNeighboursView(uint32_t idx, uint8_t iface, uint8_t codim, ConstProxyVector<uint8_t> *isghost = nullptr) const;
         Octant* 	getPointOwner(const dvector &point);
         Octant* 	getPointOwner(const dvector &point, bool & isghost);
         Octant* 	getPointOwner(const darray3 &point);
@@ -459,6 +524,8 @@ namespace bitpit {
         uint32_t 	getPointOwnerIdx(const dvector &point, bool & isghost) const;
         uint32_t 	getPointOwnerIdx(const darray3 &point) const;
         uint32_t 	getPointOwnerIdx(const darray3 &point, bool & isghost) const;
+        void 		getPointsOwnerIdx(std::size_t nPoints, const darray3 *points, u32vector & ownerIdx) const;
+        void 		getPointsOwnerIdx(std::size_t nPoints, const darray3 *points, u32vector & ownerIdx, ivector & ownerRank, bool exchange = false) const;
         void 		findAllCodimensionNeighbours(uint32_t idx, u32vector & neighbours, bvector & isghost);
         void 		findAllCodimensionNeighbours(Octant* oct, u32vector & neighbours, bvector & isghost);
         void 		findGhostAllCodimensionNeighbours(uint32_t idx, u32vector & neighbours, bvector & isghost);
@@ -485,9 +552,12 @@ namespace bitpit {
         bool        adapt(bool mapper_flag = false);
         bool 		adaptGlobalRefine(bool mapper_flag = false);
         bool 		adaptGlobalCoarse(bool mapper_flag = false);
-        void 		computeConnectivity();
+        void 		computeConnectivity(bool flat = false);
         void 		clearConnectivity();
         void 		updateConnectivity();
+        bool        isConnectivityFlat() const;
+        const u32vector & getFlatConnectivity() const;
+        ConstProxyVector<uint32_t> getConnectivityView(uint32_t idx) const;
         const u32vector2D & getConnectivity() const;
         const u32vector & getConnectivity(uint32_t idx) const;
         const u32vector & getConnectivity(Octant* oct) const;
@@ -497,6 +567,8 @@ namespace bitpit {
         const u32vector2D & getGhostConnectivity() const;
         const u32vector & getGhostConnectivity(uint32_t idx) const;
         const u32vector & getGhostConnectivity(const Octant* oct) const;
+        const u32vector & getFlatGhostConnectivity() const;
+        ConstProxyVector<uint32_t> getGhostConnectivityView(uint32_t idx) const;
         bool        check21Balance();
 #if BITPIT_ENABLE_MPI==1
         void 		loadBalance(dvector* weight = NULL);
@@ -541,7 +613,10 @@ namespace bitpit {
         void 		exchangeGhostHaloAccretions(DataCommunicator *dataCommunicator, std::vector<AccretionData> *accretions);
 
         void 		computeGhostHalo();
-        void 		commMarker();
+        void 		commMarker(std::unordered_map<int, uint32_t> *ghostOffsets = nullptr);
+        void 		initializeBalanceFrontier(const std::unordered_map<int, uint32_t> &ghostOffsets, BalanceFrontier *frontier);
+        uint32_t 	commMarkerFrontier(BalanceFrontier *frontier);
+        uint32_t 	findFirstGhostOfRank(int rank) const;
 #endif
         void 		updateAfterCoarse();
         void 		balance21(bool verbose, bool balanceNewOctants);
@@ -549,6 +624,9 @@ namespace bitpit {
 
         bool		isInternal(uint64_t gidx) const;
 
+        bool		evalPointMorton(const double *point, uint64_t *morton) const;
+        void		findPointsLocalOwner(std::size_t nPoints, const uint64_t *mortons, uint32_t *ownerIdx) const;
+
         // =================================================================================== //
         // TESTING OUTPUT METHODS												    			   //
         // =================================================================================== //
@@ -562,12 +640,37 @@ namespace bitpit {
 #if BITPIT_ENABLE_MPI==1
 
         /** Communicate data provided by the user between the processes.
+         * \param[in] userData User interface to communicate the data.
          */
         template<class Impl>
         void
         communicate(DataCommInterface<Impl> & userData){
+            startCommunication(userData);
+            finishCommunication(userData);
+        };
+
+        /** Start the communication of data provided by the user between the
+         * processes.
+         * The data of the border octants is gathered and the non-blocking
+         * sends and receives are posted; the data of the ghost octants will be
+         * scattered by finishCommunication. In the meantime the caller can
+         * work on the internal octants (see getInternalOctantsBegin), whose
+         * neighbours are all local octants: the data to be sent has already
+         * been gathered, hence it can be safely modified. The tree must not be
+         * modified until the communication is finished and only one
+         * communication can be active at a time.
+         * \param[in] userData User interface to communicate the data.
+         */
+        template<class Impl>
+        void
+        startCommunication(DataCommInterface<Impl> & userData){
+            if (m_userDataCommunicator) {
+                throw std::runtime_error("A communication of user data is already active.");
+            }
+
             //BUILD SEND BUFFERS
-            DataCommunicator communicator(m_comm);
+            m_userDataCommunicator = std::unique_ptr<DataCommunicator>(new DataCommunicator(m_comm));
+            DataCommunicator &communicator = *m_userDataCommunicator;
             size_t fixedDataSize = userData.fixedSize();
             std::map<int,u32vector >::iterator bitend = m_bordersPerProc.end();
             std::map<int,u32vector >::iterator bitbegin = m_bordersPerProc.begin();
@@ -602,24 +705,43 @@ namespace bitpit {
             communicator.startAllRecvs();
 
             communicator.startAllSends();
+        };
+
+        /** Finish the communication of data provided by the user between the
+         * processes.
+         * The receive buffers are read as soon as they arrive, the data
+         * received from a process is scattered to the ghost octants owned by
+         * that process.
+         * \param[in] userData User interface to communicate the data, it
+         * should be the same interface used to start the communication.
+         */
+        template<class Impl>
+        void
+        finishCommunication(DataCommInterface<Impl> & userData){
+            if (!m_userDataCommunicator) {
+                throw std::runtime_error("No communication of user data is active.");
+            }
 
             //READ RECEIVE BUFFERS
-            int ghostOffset = 0;
-            vector<int> recvRanks = communicator.getRecvRanks();
-            std::sort(recvRanks.begin(),recvRanks.end());
-            for(int rank : recvRanks){
-                communicator.waitRecv(rank);
+            DataCommunicator &communicator = *m_userDataCommunicator;
+            int nRecvs = communicator.getRecvCount();
+            for(int n = 0; n < nRecvs; ++n){
+                int rank = communicator.waitAnyRecv();
                 RecvBuffer & recvBuffer = communicator.getRecvBuffer(rank);
+                uint32_t ghostOffset = findFirstGhostOfRank(rank);
                 size_t nofGhostFromThisProc = 0;
                 recvBuffer >> nofGhostFromThisProc;
                 for(size_t k = 0; k < nofGhostFromThisProc; ++k){
                     userData.scatter(recvBuffer, k+ghostOffset);
                 }
-                ghostOffset += nofGhostFromThisProc;
             }
             communicator.waitAllSends();
+
+            m_userDataCommunicator.reset();
         };
 
+        bool isCommunicationActive() const;
+
         /** Distribute Load-Balancing the octants (with user defined weights) of the whole tree and data provided by the user
          * over the processes of the job following the Morton order.
          * Until loadBalance is not called for the first time the mesh is serial.
@@ -736,6 +858,11 @@ namespace bitpit {
         void
         privateLoadBalance(DataLBInterface<Impl> & userData,uint32_t* partition){
 
+            m_octree.invalidateOctantsSoA();
+            m_octree.invalidateOctantsMortons();
+            m_octree.invalidateGhostsMortons();
+            invalidateNeighbourCache();
+
             if(m_serial)
             {
                 m_lastOp = OP_LOADBALANCE_FIRST;
@@ -764,6 +891,10 @@ namespace bitpit {
                 updateLoadBalance();
                 computeGhostHalo();
             }
+            else if (m_loadBalanceMemoryBudget > 0)
+            {
+                privateStreamingLoadBalance(userData, partition);
+            }
             else
             {
                 (*m_log) << " " << endl;
@@ -1069,6 +1200,263 @@ namespace bitpit {
             std::unordered_map<int, std::array<uint32_t, 2>> recvRanges = evalLoadBalanceRecvRanges(partition);
 
             m_loadBalanceRanges = LoadBalanceRanges(m_serial, sendRanges, recvRanges);
+
+            m_octree.updateOctantsSoA();
+            updateNeighbourCache();
+        };
+
+        /** Migrate octants and user data among the processes in bounded-size
+         * chunks, so that the transient memory used by the communication
+         * buffers does not exceed the load balance memory budget.
+         *
+         * The migration is performed in rounds: in every round each process
+         * sends to each of its destinations the next chunk of octants (plus
+         * their user data) and inserts the received octants directly in the
+         * storage, in a staging area that follows the current octants. Half
+         * of the budget is reserved to the send buffers and half to the
+         * receive buffers; chunks contain at least one octant, hence a single
+         * octant larger than the chunk size exceeds the budget. Once all the
+         * octants have been exchanged, residents and received octants are
+         * moved to their final positions.
+         * \param[in] userData User data that will be distributed among the
+         * processes.
+         * \param[in] partition Target distribution of octants over processes.
+         */
+        template<class Impl>
+        void
+        privateStreamingLoadBalance(DataLBInterface<Impl> & userData, uint32_t* partition){
+
+            (*m_log) << " " << endl;
+            (*m_log) << " Initial Parallel partition (streaming) : " << endl;
+            (*m_log) << " Octants for proc	"+ std::to_string(static_cast<unsigned long long>(0))+"	:	" + std::to_string(static_cast<unsigned long long>(m_partitionRangeGlobalIdx[0]+1)) << endl;
+            for(int ii=1; ii<m_nproc; ii++){
+                (*m_log) << " Octants for proc	"+ std::to_string(static_cast<unsigned long long>(ii))+"	:	" + std::to_string(static_cast<unsigned long long>(m_partitionRangeGlobalIdx[ii]-m_partitionRangeGlobalIdx[ii-1])) << endl;
+            }
+
+            //empty ghosts
+            m_octree.m_ghosts.clear();
+            m_octree.m_sizeGhosts = 0;
+
+            // Octants to be exchanged
+            //
+            // Send ranges are expressed in current local indexes, receive
+            // ranges in local indexes after the load balance.
+            std::vector<uint64_t> oldOffsets(m_nproc + 1, 0);
+            std::vector<uint64_t> newOffsets(m_nproc + 1, 0);
+            for (int p = 0; p < m_nproc; ++p) {
+                oldOffsets[p + 1] = m_partitionRangeGlobalIdx[p] + 1;
+                newOffsets[p + 1] = newOffsets[p] + partition[p];
+            }
+
+            ExchangeRanges sendRanges;
+            ExchangeRanges recvRanges;
+            for (int p = 0; p < m_nproc; ++p) {
+                if (p == m_rank) {
+                    continue;
+                }
+
+                uint64_t sendBegin = std::max(oldOffsets[m_rank], newOffsets[p]);
+                uint64_t sendEnd   = std::min(oldOffsets[m_rank + 1], newOffsets[p + 1]);
+                if (sendEnd > sendBegin) {
+                    sendRanges[p] = {{static_cast<uint32_t>(sendBegin - oldOffsets[m_rank]), static_cast<uint32_t>(sendEnd - oldOffsets[m_rank])}};
+                }
+
+                uint64_t recvBegin = std::max(oldOffsets[p], newOffsets[m_rank]);
+                uint64_t recvEnd   = std::min(oldOffsets[p + 1], newOffsets[m_rank + 1]);
+                if (recvEnd > recvBegin) {
+                    recvRanges[p] = {{static_cast<uint32_t>(recvBegin - newOffsets[m_rank]), static_cast<uint32_t>(recvEnd - newOffsets[m_rank])}};
+                }
+            }
+
+            uint32_t nOldOctants = getNumOctants();
+            uint32_t nHeadSends = 0;
+            uint32_t nTailSends = 0;
+            std::unordered_map<int, uint32_t> nextSends;
+            for (const auto &entry : sendRanges) {
+                int rank = entry.first;
+                const std::array<uint32_t, 2> &range = entry.second;
+                if (range[1] <= range[0]) {
+                    continue;
+                }
+
+                if (rank < m_rank) {
+                    nHeadSends += range[1] - range[0];
+                } else {
+                    nTailSends += range[1] - range[0];
+                }
+                nextSends[rank] = range[0];
+            }
+
+            uint32_t nHeadRecvs = 0;
+            uint32_t nTailRecvs = 0;
+            std::unordered_map<int, uint32_t> nextRecvs;
+            for (const auto &entry : recvRanges) {
+                int rank = entry.first;
+                const std::array<uint32_t, 2> &range = entry.second;
+                if (range[1] <= range[0]) {
+                    continue;
+                }
+
+                if (rank < m_rank) {
+                    nHeadRecvs += range[1] - range[0];
+                } else {
+                    nTailRecvs += range[1] - range[0];
+                }
+                nextRecvs[rank] = range[0];
+            }
+
+            uint32_t nResidents = nOldOctants - nHeadSends - nTailSends;
+            uint32_t nNewOctants = nHeadRecvs + nResidents + nTailRecvs;
+
+            // Staging area
+            //
+            // Received octants are stored after the current octants, the
+            // staging area begins far enough to allow the residents to be
+            // moved to their final position without overwriting it.
+            uint32_t stagingBegin = std::max(nOldOctants, nHeadRecvs + nResidents);
+            uint32_t stagingSize  = nHeadRecvs + nTailRecvs;
+
+            m_octree.m_octants.resize(stagingBegin + stagingSize, Octant(m_dim));
+            userData.resize(stagingBegin + stagingSize);
+
+            // Chunk size
+            //
+            // Every process exchanges at most one chunk per peer in each
+            // round, the chunk size is evaluated from the maximum number of
+            // peers among all the processes.
+            int nLocalPeers = static_cast<int>(std::max(nextSends.size(), nextRecvs.size()));
+            int nMaxPeers;
+            m_errorFlag = MPI_Allreduce(&nLocalPeers, &nMaxPeers, 1, MPI_INT, MPI_MAX, m_comm);
+
+            std::size_t chunkSize = m_loadBalanceMemoryBudget / (2 * std::max(nMaxPeers, 1));
+
+            // Exchange the octants
+            std::size_t fixedDataSize = userData.fixedSize();
+            std::size_t octantBinarySize = Octant::getBinarySize();
+
+            DataCommunicator lbCommunicator(m_comm);
+            std::size_t nRounds = 0;
+            while (true) {
+                bool localPending = false;
+                for (const auto &entry : nextSends) {
+                    if (entry.second < sendRanges.at(entry.first)[1]) {
+                        localPending = true;
+                        break;
+                    }
+                }
+
+                bool globalPending;
+                m_errorFlag = MPI_Allreduce(&localPending, &globalPending, 1, MPI_C_BOOL, MPI_LOR, m_comm);
+                if (!globalPending) {
+                    break;
+                }
+
+                // Build the chunks
+                lbCommunicator.clearAllSends();
+                for (auto &entry : nextSends) {
+                    int rank = entry.first;
+                    uint32_t &nextSend = entry.second;
+                    uint32_t sendEnd = sendRanges.at(rank)[1];
+                    if (nextSend >= sendEnd) {
+                        continue;
+                    }
+
+                    std::size_t buffSize = sizeof(uint32_t);
+                    uint32_t chunkEnd = nextSend;
+                    while (chunkEnd < sendEnd) {
+                        std::size_t entrySize = octantBinarySize;
+                        if (fixedDataSize != 0) {
+                            entrySize += fixedDataSize;
+                        } else {
+                            entrySize += userData.size(chunkEnd);
+                        }
+
+                        if (chunkEnd > nextSend && buffSize + entrySize > chunkSize) {
+                            break;
+                        }
+
+                        buffSize += entrySize;
+                        ++chunkEnd;
+                    }
+
+                    lbCommunicator.setSend(rank, buffSize);
+                    SendBuffer &sendBuffer = lbCommunicator.getSendBuffer(rank);
+                    sendBuffer << (chunkEnd - nextSend);
+                    for (uint32_t i = nextSend; i < chunkEnd; ++i) {
+                        sendBuffer << m_octree.m_octants[i];
+                        userData.gather(sendBuffer, i);
+                    }
+
+                    nextSend = chunkEnd;
+                }
+
+                lbCommunicator.discoverRecvs();
+                lbCommunicator.startAllRecvs();
+                lbCommunicator.startAllSends();
+
+                // Insert the received octants in the staging area
+                int nRecvs = lbCommunicator.getRecvCount();
+                for (int n = 0; n < nRecvs; ++n) {
+                    int rank = lbCommunicator.waitAnyRecv();
+                    RecvBuffer &recvBuffer = lbCommunicator.getRecvBuffer(rank);
+
+                    uint32_t &nextRecv = nextRecvs.at(rank);
+                    uint32_t stagingOffset = stagingBegin;
+                    if (rank > m_rank) {
+                        stagingOffset -= nResidents;
+                    }
+
+                    uint32_t nChunkOctants;
+                    recvBuffer >> nChunkOctants;
+                    for (uint32_t k = 0; k < nChunkOctants; ++k) {
+                        uint32_t stagingIdx = stagingOffset + nextRecv;
+                        recvBuffer >> m_octree.m_octants[stagingIdx];
+                        userData.scatter(recvBuffer, stagingIdx);
+                        ++nextRecv;
+                    }
+                }
+
+                lbCommunicator.waitAllSends();
+                ++nRounds;
+            }
+
+            (*m_log) << " Number of migration rounds	:	" + std::to_string(static_cast<unsigned long long>(nRounds)) << endl;
+
+            // Move residents to their final position
+            if (nHeadRecvs > nHeadSends) {
+                for (uint32_t k = nResidents; k > 0; --k) {
+                    m_octree.m_octants[nHeadRecvs + k - 1] = m_octree.m_octants[nHeadSends + k - 1];
+                    userData.move(nHeadSends + k - 1, nHeadRecvs + k - 1);
+                }
+            } else if (nHeadRecvs < nHeadSends) {
+                for (uint32_t k = 0; k < nResidents; ++k) {
+                    m_octree.m_octants[nHeadRecvs + k] = m_octree.m_octants[nHeadSends + k];
+                    userData.move(nHeadSends + k, nHeadRecvs + k);
+                }
+            }
+
+            // Move received octants to their final position
+            for (uint32_t k = 0; k < nHeadRecvs; ++k) {
+                m_octree.m_octants[k] = m_octree.m_octants[stagingBegin + k];
+                userData.move(stagingBegin + k, k);
+            }
+
+            for (uint32_t k = 0; k < nTailRecvs; ++k) {
+                m_octree.m_octants[nHeadRecvs + nResidents + k] = m_octree.m_octants[stagingBegin + nHeadRecvs + k];
+                userData.move(stagingBegin + nHeadRecvs + k, nHeadRecvs + nResidents + k);
+            }
+
+            m_octree.m_octants.resize(nNewOctants, Octant(m_dim));
+            octvector(m_octree.m_octants).swap(m_octree.m_octants);
+
+            userData.resize(nNewOctants);
+            userData.shrink();
+
+            //Update and ghosts here
+            updateLoadBalance();
+            computeGhostHalo();
+            uint32_t nofGhosts = getNumGhosts();
+            userData.resizeGhost(nofGhosts);
         };
 #endif
 
@@ -0,0 +1,520 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2019 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <stdexcept>
+
+#include "morton.hpp"
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define BITPIT_PABLO_MORTON_X86 1
+#include <immintrin.h>
+#else
+#define BITPIT_PABLO_MORTON_X86 0
+#endif
+
+namespace bitpit {
+
+namespace PABLO {
+
+namespace {
+
+// =================================================================================== //
+// SCALAR KERNELS
+// =================================================================================== //
+
+// The scalar kernels process the items in blocks of fixed size, this allows the
+// compiler to vectorize the blocks with the instructions available on all the
+// processors of the target architecture.
+const std::size_t SCALAR_BLOCK_SIZE = 8;
+
+void computeMortons3DScalar(std::size_t n, const uint32_t *x, const uint32_t *y, const uint32_t *z, uint64_t *mortons)
+{
+    std::size_t i = 0;
+    for (; i + SCALAR_BLOCK_SIZE <= n; i += SCALAR_BLOCK_SIZE) {
+        for (std::size_t k = 0; k < SCALAR_BLOCK_SIZE; ++k) {
+            mortons[i + k] = computeMorton(x[i + k], y[i + k], z[i + k]);
+        }
+    }
+
+    for (; i < n; ++i) {
+        mortons[i] = computeMorton(x[i], y[i], z[i]);
+    }
+}
+
+void computeMortons2DScalar(std::size_t n, const uint32_t *x, const uint32_t *y, uint64_t *mortons)
+{
+    std::size_t i = 0;
+    for (; i + SCALAR_BLOCK_SIZE <= n; i += SCALAR_BLOCK_SIZE) {
+        for (std::size_t k = 0; k < SCALAR_BLOCK_SIZE; ++k) {
+            mortons[i + k] = computeMorton(x[i + k], y[i + k]);
+        }
+    }
+
+    for (; i < n; ++i) {
+        mortons[i] = computeMorton(x[i], y[i]);
+    }
+}
+
+void decodeMortons3DScalar(std::size_t n, const uint64_t *mortons, uint32_t *x, uint32_t *y, uint32_t *z)
+{
+    std::size_t i = 0;
+    for (; i + SCALAR_BLOCK_SIZE <= n; i += SCALAR_BLOCK_SIZE) {
+        for (std::size_t k = 0; k < SCALAR_BLOCK_SIZE; ++k) {
+            x[i + k] = compactBy3(mortons[i + k]);
+        }
+        for (std::size_t k = 0; k < SCALAR_BLOCK_SIZE; ++k) {
+            y[i + k] = compactBy3(mortons[i + k] >> 1);
+        }
+        for (std::size_t k = 0; k < SCALAR_BLOCK_SIZE; ++k) {
+            z[i + k] = compactBy3(mortons[i + k] >> 2);
+        }
+    }
+
+    for (; i < n; ++i) {
+        decodeMorton(mortons[i], x + i, y + i, z + i);
+    }
+}
+
+void decodeMortons2DScalar(std::size_t n, const uint64_t *mortons, uint32_t *x, uint32_t *y)
+{
+    std::size_t i = 0;
+    for (; i + SCALAR_BLOCK_SIZE <= n; i += SCALAR_BLOCK_SIZE) {
+        for (std::size_t k = 0; k < SCALAR_BLOCK_SIZE; ++k) {
+            x[i + k] = compactBy2(mortons[i + k]);
+        }
+        for (std::size_t k = 0; k < SCALAR_BLOCK_SIZE; ++k) {
+            y[i + k] = compactBy2(mortons[i + k] >> 1);
+        }
+    }
+
+    for (; i < n; ++i) {
+        decodeMorton(mortons[i], x + i, y + i);
+    }
+}
+
+#if BITPIT_PABLO_MORTON_X86
+// =================================================================================== //
+// AVX2 KERNELS
+// =================================================================================== //
+
+__attribute__((target("avx2")))
+inline __m256i splitBy3AVX2(__m256i x)
+{
+    x = _mm256_and_si256(x, _mm256_set1_epi64x(0x1fffff));
+    x = _mm256_and_si256(_mm256_or_si256(x, _mm256_slli_epi64(x, 32)), _mm256_set1_epi64x(0x1f00000000ffff));
+    x = _mm256_and_si256(_mm256_or_si256(x, _mm256_slli_epi64(x, 16)), _mm256_set1_epi64x(0x1f0000ff0000ff));
+    x = _mm256_and_si256(_mm256_or_si256(x, _mm256_slli_epi64(x, 8)), _mm256_set1_epi64x(0x100f00f00f00f00f));
+    x = _mm256_and_si256(_mm256_or_si256(x, _mm256_slli_epi64(x, 4)), _mm256_set1_epi64x(0x10c30c30c30c30c3));
+    x = _mm256_and_si256(_mm256_or_si256(x, _mm256_slli_epi64(x, 2)), _mm256_set1_epi64x(0x1249249249249249));
+
+    return x;
+}
+
+__attribute__((target("avx2")))
+inline __m256i splitBy2AVX2(__m256i x)
+{
+    x = _mm256_and_si256(_mm256_or_si256(x, _mm256_slli_epi64(x, 16)), _mm256_set1_epi64x(0xFFFF0000FFFF));
+    x = _mm256_and_si256(_mm256_or_si256(x, _mm256_slli_epi64(x, 8)), _mm256_set1_epi64x(0xFF00FF00FF00FF));
+    x = _mm256_and_si256(_mm256_or_si256(x, _mm256_slli_epi64(x, 4)), _mm256_set1_epi64x(0xF0F0F0F0F0F0F0F));
+    x = _mm256_and_si256(_mm256_or_si256(x, _mm256_slli_epi64(x, 2)), _mm256_set1_epi64x(0x3333333333333333));
+    x = _mm256_and_si256(_mm256_or_si256(x, _mm256_slli_epi64(x, 1)), _mm256_set1_epi64x(0x5555555555555555));
+
+    return x;
+}
+
+__attribute__((target("avx2")))
+inline __m256i compactBy3AVX2(__m256i x)
+{
+    x = _mm256_and_si256(x, _mm256_set1_epi64x(0x1249249249249249));
+    x = _mm256_and_si256(_mm256_xor_si256(x, _mm256_srli_epi64(x, 2)), _mm256_set1_epi64x(0x10c30c30c30c30c3));
+    x = _mm256_and_si256(_mm256_xor_si256(x, _mm256_srli_epi64(x, 4)), _mm256_set1_epi64x(0x100f00f00f00f00f));
+    x = _mm256_and_si256(_mm256_xor_si256(x, _mm256_srli_epi64(x, 8)), _mm256_set1_epi64x(0x1f0000ff0000ff));
+    x = _mm256_and_si256(_mm256_xor_si256(x, _mm256_srli_epi64(x, 16)), _mm256_set1_epi64x(0x1f00000000ffff));
+    x = _mm256_and_si256(_mm256_xor_si256(x, _mm256_srli_epi64(x, 32)), _mm256_set1_epi64x(0x1fffff));
+
+    return x;
+}
+
+__attribute__((target("avx2")))
+inline __m256i compactBy2AVX2(__m256i x)
+{
+    x = _mm256_and_si256(x, _mm256_set1_epi64x(0x5555555555555555));
+    x = _mm256_and_si256(_mm256_xor_si256(x, _mm256_srli_epi64(x, 1)), _mm256_set1_epi64x(0x3333333333333333));
+    x = _mm256_and_si256(_mm256_xor_si256(x, _mm256_srli_epi64(x, 2)), _mm256_set1_epi64x(0xF0F0F0F0F0F0F0F));
+    x = _mm256_and_si256(_mm256_xor_si256(x, _mm256_srli_epi64(x, 4)), _mm256_set1_epi64x(0xFF00FF00FF00FF));
+    x = _mm256_and_si256(_mm256_xor_si256(x, _mm256_srli_epi64(x, 8)), _mm256_set1_epi64x(0xFFFF0000FFFF));
+    x = _mm256_and_si256(_mm256_xor_si256(x, _mm256_srli_epi64(x, 16)), _mm256_set1_epi64x(0xFFFFFFFF));
+
+    return x;
+}
+
+__attribute__((target("avx2")))
+inline __m256i loadCoordinatesAVX2(const uint32_t *coords)
+{
+    return _mm256_cvtepu32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i *>(coords)));
+}
+
+__attribute__((target("avx2")))
+inline void storeCoordinatesAVX2(__m256i coords, uint32_t *dest)
+{
+    // Gather the low halves of the 64-bit lanes in the low 128 bits
+    const __m256i permutation = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+    __m256i packed = _mm256_permutevar8x32_epi32(coords, permutation);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dest), _mm256_castsi256_si128(packed));
+}
+
+__attribute__((target("avx2")))
+void computeMortons3DAVX2(std::size_t n, const uint32_t *x, const uint32_t *y, const uint32_t *z, uint64_t *mortons)
+{
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i mx = splitBy3AVX2(loadCoordinatesAVX2(x + i));
+        __m256i my = splitBy3AVX2(loadCoordinatesAVX2(y + i));
+        __m256i mz = splitBy3AVX2(loadCoordinatesAVX2(z + i));
+        __m256i morton = _mm256_or_si256(mx, _mm256_or_si256(_mm256_slli_epi64(my, 1), _mm256_slli_epi64(mz, 2)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(mortons + i), morton);
+    }
+
+    computeMortons3DScalar(n - i, x + i, y + i, z + i, mortons + i);
+}
+
+__attribute__((target("avx2")))
+void computeMortons2DAVX2(std::size_t n, const uint32_t *x, const uint32_t *y, uint64_t *mortons)
+{
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i mx = splitBy2AVX2(loadCoordinatesAVX2(x + i));
+        __m256i my = splitBy2AVX2(loadCoordinatesAVX2(y + i));
+        __m256i morton = _mm256_or_si256(mx, _mm256_slli_epi64(my, 1));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(mortons + i), morton);
+    }
+
+    computeMortons2DScalar(n - i, x + i, y + i, mortons + i);
+}
+
+__attribute__((target("avx2")))
+void decodeMortons3DAVX2(std::size_t n, const uint64_t *mortons, uint32_t *x, uint32_t *y, uint32_t *z)
+{
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i morton = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(mortons + i));
+        storeCoordinatesAVX2(compactBy3AVX2(morton), x + i);
+        storeCoordinatesAVX2(compactBy3AVX2(_mm256_srli_epi64(morton, 1)), y + i);
+        storeCoordinatesAVX2(compactBy3AVX2(_mm256_srli_epi64(morton, 2)), z + i);
+    }
+
+    decodeMortons3DScalar(n - i, mortons + i, x + i, y + i, z + i);
+}
+
+__attribute__((target("avx2")))
+void decodeMortons2DAVX2(std::size_t n, const uint64_t *mortons, uint32_t *x, uint32_t *y)
+{
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i morton = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(mortons + i));
+        storeCoordinatesAVX2(compactBy2AVX2(morton), x + i);
+        storeCoordinatesAVX2(compactBy2AVX2(_mm256_srli_epi64(morton, 1)), y + i);
+    }
+
+    decodeMortons2DScalar(n - i, mortons + i, x + i, y + i);
+}
+
+// =================================================================================== //
+// BMI2 KERNELS
+// =================================================================================== //
+
+const uint64_t BMI2_MASK_3D_X = 0x1249249249249249;
+const uint64_t BMI2_MASK_3D_Y = BMI2_MASK_3D_X << 1;
+const uint64_t BMI2_MASK_3D_Z = BMI2_MASK_3D_X << 2;
+const uint64_t BMI2_MASK_2D_X = 0x5555555555555555;
+const uint64_t BMI2_MASK_2D_Y = BMI2_MASK_2D_X << 1;
+
+__attribute__((target("bmi2")))
+void computeMortons3DBMI2(std::size_t n, const uint32_t *x, const uint32_t *y, const uint32_t *z, uint64_t *mortons)
+{
+    for (std::size_t i = 0; i < n; ++i) {
+        mortons[i] = _pdep_u64(x[i], BMI2_MASK_3D_X) | _pdep_u64(y[i], BMI2_MASK_3D_Y) | _pdep_u64(z[i], BMI2_MASK_3D_Z);
+    }
+}
+
+__attribute__((target("bmi2")))
+void computeMortons2DBMI2(std::size_t n, const uint32_t *x, const uint32_t *y, uint64_t *mortons)
+{
+    for (std::size_t i = 0; i < n; ++i) {
+        mortons[i] = _pdep_u64(x[i], BMI2_MASK_2D_X) | _pdep_u64(y[i], BMI2_MASK_2D_Y);
+    }
+}
+
+__attribute__((target("bmi2")))
+void decodeMortons3DBMI2(std::size_t n, const uint64_t *mortons, uint32_t *x, uint32_t *y, uint32_t *z)
+{
+    for (std::size_t i = 0; i < n; ++i) {
+        x[i] = static_cast<uint32_t>(_pext_u64(mortons[i], BMI2_MASK_3D_X));
+        y[i] = static_cast<uint32_t>(_pext_u64(mortons[i], BMI2_MASK_3D_Y));
+        z[i] = static_cast<uint32_t>(_pext_u64(mortons[i], BMI2_MASK_3D_Z));
+    }
+}
+
+__attribute__((target("bmi2")))
+void decodeMortons2DBMI2(std::size_t n, const uint64_t *mortons, uint32_t *x, uint32_t *y)
+{
+    for (std::size_t i = 0; i < n; ++i) {
+        x[i] = static_cast<uint32_t>(_pext_u64(mortons[i], BMI2_MASK_2D_X));
+        y[i] = static_cast<uint32_t>(_pext_u64(mortons[i], BMI2_MASK_2D_Y));
+    }
+}
+#endif
+
+// =================================================================================== //
+// DISPATCH
+// =================================================================================== //
+
+/**
+* Select the default kernel for the running processor.
+*
+* \result The default kernel.
+*/
+MortonKernel selectDefaultMortonKernel()
+{
+    // Processors before Zen 3 implement pdep/pext in microcode, on those
+    // processors the AVX2 kernel is much faster than the BMI2 one.
+    bool isBMI2Slow = false;
+#if BITPIT_PABLO_MORTON_X86
+    isBMI2Slow = __builtin_cpu_is("znver1") || __builtin_cpu_is("znver2");
+#endif
+
+    if (isMortonKernelSupported(MORTON_KERNEL_BMI2) && !isBMI2Slow) {
+        return MORTON_KERNEL_BMI2;
+    } else if (isMortonKernelSupported(MORTON_KERNEL_AVX2)) {
+        return MORTON_KERNEL_AVX2;
+    } else if (isMortonKernelSupported(MORTON_KERNEL_BMI2)) {
+        return MORTON_KERNEL_BMI2;
+    }
+
+    return MORTON_KERNEL_SCALAR;
+}
+
+/**
+* Get a reference to the kernel currently used by the batch functions.
+*
+* \result A reference to the kernel currently used by the batch functions.
+*/
+MortonKernel & activeMortonKernel()
+{
+    static MortonKernel kernel = selectDefaultMortonKernel();
+
+    return kernel;
+}
+
+}
+
+/**
+* Check if the specified kernel can be used on the running processor.
+*
+* \param kernel is the kernel
+* \result Returns true if the kernel can be used, false otherwise.
+*/
+bool isMortonKernelSupported(MortonKernel kernel)
+{
+    switch (kernel) {
+
+    case MORTON_KERNEL_SCALAR:
+        return true;
+
+#if BITPIT_PABLO_MORTON_X86
+    case MORTON_KERNEL_AVX2:
+        return __builtin_cpu_supports("avx2");
+
+    case MORTON_KERNEL_BMI2:
+        return __builtin_cpu_supports("bmi2");
+#endif
+
+    default:
+        return false;
+
+    }
+}
+
+/**
+* Get the kernel used by the batch Morton functions.
+*
+* Unless a kernel is explicitly set, the BMI2 kernel is used when the
+* processor supports it, otherwise the AVX2 kernel is used when the
+* processor supports it, otherwise the scalar kernel is used. On AMD
+* processors that implement BMI2 in microcode, the AVX2 kernel is
+* preferred over the BMI2 one.
+*
+* \result The kernel used by the batch Morton functions.
+*/
+MortonKernel getMortonKernel()
+{
+    return activeMortonKernel();
+}
+
+/**
+* Set the kernel used by the batch Morton functions.
+*
+* The kernel is shared by all the trees, it should not be changed while
+* other threads are using the batch functions.
+*
+* \param kernel is the kernel
+*/
+void setMortonKernel(MortonKernel kernel)
+{
+    if (!isMortonKernelSupported(kernel)) {
+        throw std::runtime_error("The requested Morton kernel is not supported by the processor.");
+    }
+
+    activeMortonKernel() = kernel;
+}
+
+/**
+* Compute the Morton numbers of the given sets of coordinates.
+*
+* The results are the same of calling computeMorton on each set of
+* coordinates.
+*
+* \param n is the number of sets of coordinates
+* \param x are the integer x positions
+* \param y are the integer y positions
+* \param z are the integer z positions
+* \param[out] mortons on output will contain the Morton numbers, it should
+* be large enough to contain n values
+*/
+void computeMortons(std::size_t n, const uint32_t *x, const uint32_t *y, const uint32_t *z, uint64_t *mortons)
+{
+    switch (getMortonKernel()) {
+
+#if BITPIT_PABLO_MORTON_X86
+    case MORTON_KERNEL_AVX2:
+        computeMortons3DAVX2(n, x, y, z, mortons);
+        break;
+
+    case MORTON_KERNEL_BMI2:
+        computeMortons3DBMI2(n, x, y, z, mortons);
+        break;
+#endif
+
+    default:
+        computeMortons3DScalar(n, x, y, z, mortons);
+        break;
+
+    }
+}
+
+/**
+* Compute the Morton numbers of the given sets of coordinates.
+*
+* The results are the same of calling computeMorton on each set of
+* coordinates.
+*
+* \param n is the number of sets of coordinates
+* \param x are the integer x positions
+* \param y are the integer y positions
+* \param[out] mortons on output will contain the Morton numbers, it should
+* be large enough to contain n values
+*/
+void computeMortons(std::size_t n, const uint32_t *x, const uint32_t *y, uint64_t *mortons)
+{
+    switch (getMortonKernel()) {
+
+#if BITPIT_PABLO_MORTON_X86
+    case MORTON_KERNEL_AVX2:
+        computeMortons2DAVX2(n, x, y, mortons);
+        break;
+
+    case MORTON_KERNEL_BMI2:
+        computeMortons2DBMI2(n, x, y, mortons);
+        break;
+#endif
+
+    default:
+        computeMortons2DScalar(n, x, y, mortons);
+        break;
+
+    }
+}
+
+/**
+* Compute the coordinates associated with the given Morton numbers.
+*
+* \param n is the number of Morton numbers
+* \param mortons are the Morton numbers
+* \param[out] x on output will contain the integer x positions
+* \param[out] y on output will contain the integer y positions
+* \param[out] z on output will contain the integer z positions
+*/
+void decodeMortons(std::size_t n, const uint64_t *mortons, uint32_t *x, uint32_t *y, uint32_t *z)
+{
+    switch (getMortonKernel()) {
+
+#if BITPIT_PABLO_MORTON_X86
+    case MORTON_KERNEL_AVX2:
+        decodeMortons3DAVX2(n, mortons, x, y, z);
+        break;
+
+    case MORTON_KERNEL_BMI2:
+        decodeMortons3DBMI2(n, mortons, x, y, z);
+        break;
+#endif
+
+    default:
+        decodeMortons3DScalar(n, mortons, x, y, z);
+        break;
+
+    }
+}
+
+/**
+* Compute the coordinates associated with the given Morton numbers.
+*
+* \param n is the number of Morton numbers
+* \param mortons are the Morton numbers
+* \param[out] x on output will contain the integer x positions
+* \param[out] y on output will contain the integer y positions
+*/
+void decodeMortons(std::size_t n, const uint64_t *mortons, uint32_t *x, uint32_t *y)
+{
+    switch (getMortonKernel()) {
+
+#if BITPIT_PABLO_MORTON_X86
+    case MORTON_KERNEL_AVX2:
+        decodeMortons2DAVX2(n, mortons, x, y);
+        break;
+
+    case MORTON_KERNEL_BMI2:
+        decodeMortons2DBMI2(n, mortons, x, y);
+        break;
+#endif
+
+    default:
+        decodeMortons2DScalar(n, mortons, x, y);
+        break;
+
+    }
+}
+
+}
+
+}
@@ -25,6 +25,7 @@
 #ifndef __BITPIT_PABLO_MORTON_HPP__
 #define __BITPIT_PABLO_MORTON_HPP__
 
+#include <cstddef>
 #include <cstdint>
 
 namespace bitpit {
@@ -71,6 +72,46 @@ inline uint64_t splitBy2(uint32_t a)
     return x;
 }
 
+/**
+* Compact the bits of a given integer that are 3 positions apart.
+*
+* This is the inverse of splitBy3.
+*
+* \param x is an integer with separated bits
+* \result Compacted bits.
+*/
+inline uint32_t compactBy3(uint64_t x)
+{
+    x &= 0x1249249249249249;
+    x = (x ^ (x >> 2)) & 0x10c30c30c30c30c3;
+    x = (x ^ (x >> 4)) & 0x100f00f00f00f00f;
+    x = (x ^ (x >> 8)) & 0x1f0000ff0000ff;
+    x = (x ^ (x >> 16)) & 0x1f00000000ffff;
+    x = (x ^ (x >> 32)) & 0x1fffff;
+
+    return static_cast<uint32_t>(x);
+}
+
+/**
+* Compact the bits of a given integer that are 2 positions apart.
+*
+* This is the inverse of splitBy2.
+*
+* \param x is an integer with separated bits
+* \result Compacted bits.
+*/
+inline uint32_t compactBy2(uint64_t x)
+{
+    x &= 0x5555555555555555;
+    x = (x ^ (x >> 1)) & 0x3333333333333333;
+    x = (x ^ (x >> 2)) & 0xF0F0F0F0F0F0F0F;
+    x = (x ^ (x >> 4)) & 0xFF00FF00FF00FF;
+    x = (x ^ (x >> 8)) & 0xFFFF0000FFFF;
+    x = (x ^ (x >> 16)) & 0xFFFFFFFF;
+
+    return static_cast<uint32_t>(x);
+}
+
 /**
 * Compute the Morton number of the given set of coordinates.
 *
@@ -106,6 +147,52 @@ inline uint64_t computeMorton(uint32_t x, uint32_t y)
     return morton;
 }
 
+/**
+* Compute the coordinates associated with the given Morton number.
+*
+* \param morton is the Morton number
+* \param[out] x is the integer x position
+* \param[out] y is the integer y position
+* \param[out] z is the integer z position
+*/
+inline void decodeMorton(uint64_t morton, uint32_t *x, uint32_t *y, uint32_t *z)
+{
+    *x = compactBy3(morton);
+    *y = compactBy3(morton >> 1);
+    *z = compactBy3(morton >> 2);
+}
+
+/**
+* Compute the coordinates associated with the given Morton number.
+*
+* \param morton is the Morton number
+* \param[out] x is the integer x position
+* \param[out] y is the integer y position
+*/
+inline void decodeMorton(uint64_t morton, uint32_t *x, uint32_t *y)
+{
+    *x = compactBy2(morton);
+    *y = compactBy2(morton >> 1);
+}
+
+/**
+* Kernels that can be used by the batch Morton functions.
+*/
+enum MortonKernel {
+    MORTON_KERNEL_SCALAR,   //!< Portable "magic bits" implementation
+    MORTON_KERNEL_AVX2,     //!< "Magic bits" implementation on four AVX2 lanes
+    MORTON_KERNEL_BMI2      //!< BMI2 bit deposit/extract instructions
+};
+
+bool isMortonKernelSupported(MortonKernel kernel);
+MortonKernel getMortonKernel();
+void setMortonKernel(MortonKernel kernel);
+
+void computeMortons(std::size_t n, const uint32_t *x, const uint32_t *y, const uint32_t *z, uint64_t *mortons);
+void computeMortons(std::size_t n, const uint32_t *x, const uint32_t *y, uint64_t *mortons);
+void decodeMortons(std::size_t n, const uint64_t *mortons, uint32_t *x, uint32_t *y, uint32_t *z);
+void decodeMortons(std::size_t n, const uint64_t *mortons, uint32_t *x, uint32_t *y);
+
 /**
 * Compute the XYZ key of the given set of coordinates.
 *
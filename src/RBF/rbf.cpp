@@ -22,7 +22,9 @@
  *
 \*---------------------------------------------------------------------------*/
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
 #include <set>
 
 #include "bitpit_private_lapacke.hpp"
@@ -74,6 +76,7 @@ RBFKernel::RBFKernel()
     m_fields        = 0;
 
     m_mode = RBFMode::INTERP;
+    m_solverMode = RBFSolverMode::DENSE;
 
     m_maxFields = -1;
     m_value.clear();
@@ -89,7 +92,7 @@ RBFKernel::RBFKernel()
 RBFKernel::RBFKernel(const RBFKernel & other)
     : m_fields(other.m_fields), m_mode(other.m_mode),
       m_supportRadius(other.m_supportRadius), m_typef(other.m_typef),
-      m_fPtr(other.m_fPtr), m_error(other.m_error), m_value(other.m_value),
+      m_fPtr(other.m_fPtr), m_solverMode(other.m_solverMode), m_error(other.m_error), m_value(other.m_value),
       m_weight(other.m_weight), m_activeNodes(other.m_activeNodes),
       m_maxFields(other.m_maxFields), m_nodes(other.m_nodes)
 {
@@ -107,6 +110,7 @@ void RBFKernel::swap(RBFKernel &x) noexcept
    std::swap(m_supportRadius, x.m_supportRadius);
    std::swap(m_typef, x.m_typef);
    std::swap(m_fPtr, x.m_fPtr);
+   std::swap(m_solverMode, x.m_solverMode);
    std::swap(m_error, x.m_error);
    std::swap(m_value, x.m_value);
    std::swap(m_weight, x.m_weight);
@@ -397,6 +401,52 @@ void RBFKernel::setMode(RBFMode mode)
     m_mode = mode;
 }
 
+/*!
+ * Set the strategy used to assemble and solve the interpolation system.
+ *
+ * The sparse mode assembles only the pairs of nodes whose distance is
+ * within the support radius, hence it can be used only with compactly
+ * supported basis functions: when the basis function has a global support
+ * (or it is a custom function) the dense mode is always used.
+ *
+ * @param[in] mode solver mode. Ref to RBFSolverMode enum
+ */
+void RBFKernel::setSolverMode(RBFSolverMode mode)
+{
+    m_solverMode = mode;
+}
+
+/*!
+ * Return the strategy used to assemble and solve the interpolation system.
+ * @return solver mode
+ */
+RBFSolverMode RBFKernel::getSolverMode()
+{
+    return m_solverMode;
+}
+
+/*!
+ * Checks if the basis function linked to the class has a compact support,
+ * i.e. if it vanishes for normalized distances greater than one.
+ * Custom basis functions are considered globally supported.
+ * @return true if the basis function has a compact support
+ */
+bool RBFKernel::isCompactSupport()
+{
+    switch (m_typef) {
+
+    case (RBFBasisFunction::CUSTOM):
+    case (RBFBasisFunction::GAUSS90):
+    case (RBFBasisFunction::GAUSS95):
+    case (RBFBasisFunction::GAUSS99):
+        return false;
+
+    default:
+        return true;
+
+    }
+}
+
 /*!
  * Sets all the type of available data at one node.
  * In INTERP mode, set each field value at the target node
@@ -623,84 +673,138 @@ std::vector<double> RBFKernel::evalRBF(int jnode)
 }
 
 /*!
- * Calculates the RBF weights using all currently active nodes and just given target fields.
- * Regular LU solver for linear system A*X=B is employed (LAPACKE dgesv).
- * Supported ONLY in INTERP mode.
+ * Evaluates the RBF on a set of points. Supported in both modes.
  *
- * @return integer error flag . If 0-successfull computation, if 1-errors occurred, if -1 dummy method call
+ * For compactly supported basis functions only the nodes within the support
+ * radius of each point are visited, the search is performed using
+ * RBFKernel::findNodesInRadius. For globally supported basis functions all
+ * active nodes are visited.
+ *
+ * When OpenMP support is enabled, points are evaluated concurrently: derived
+ * classes should therefore provide thread-safe implementations of the
+ * distance evaluation and of the node search.
+ *
+ * @param[in] nPoints number of points
+ * @param[in] points pointer to the coordinates of the points where to evaluate the RBF
+ * @param[out] values pointer to the caller-provided storage that on output will contain
+ * the interpolated/parameterized values, values are stored point by point, i.e., the
+ * value of the j-th field on the n-th point is stored in values[n * getDataCount() + j]
  */
-int RBFKernel::solve()
+void RBFKernel::evalRBF(std::size_t nPoints, const std::array<double,3> *points, double *values)
 {
-    if(m_mode == RBFMode::PARAM) {
-        return -1;
+    bool compactSupport = isCompactSupport();
+    if (compactSupport) {
+        initializeNodeSearch();
     }
 
-    int  j, k;
-    double dist;
+    std::vector<int> activeSet;
+    if (!compactSupport) {
+        activeSet = getActiveSet();
+    }
 
-    int nS      = getActiveCount();
-    int nrhs    = getDataCount();
+    long nEvalPoints = nPoints;
+
+#if BITPIT_ENABLE_OPENMP==1
+    #pragma omp parallel
+#endif
+    {
+        std::vector<int> neighs;
+
+#if BITPIT_ENABLE_OPENMP==1
+        #pragma omp for schedule(static)
+#endif
+        for (long n = 0; n < nEvalPoints; ++n) {
+            const std::array<double,3> &point = points[n];
+            double *pointValues = values + n * m_fields;
+            for (int j = 0; j < m_fields; ++j) {
+                pointValues[j] = 0.;
+            }
 
-    int lda     = nS;
-    int ldb     = nS;
-    int info;
-    int ipiv[nS];
+            const std::vector<int> *evalNodes;
+            if (compactSupport) {
+                neighs.clear();
+                findNodesInRadius(point, m_supportRadius, &neighs);
+                evalNodes = &neighs;
+            } else {
+                evalNodes = &activeSet;
+            }
 
-    std::vector<int> activeSet( getActiveSet() );
+            for (int i : *evalNodes) {
+                if (!m_activeNodes[i]) {
+                    continue;
+                }
 
-    std::vector<double> A(lda * nS);
-    std::vector<double> b(ldb * nrhs);
+                double basis = evalBasis( calcDist(point, i) / m_supportRadius );
+                if (basis == 0.) {
+                    continue;
+                }
 
-    k=0;
-    for( j=0; j<nrhs; ++j) {
-        for( const auto & i : activeSet ) {
-            b[k] = m_value[j][i];
-            ++k;
+                for (int j = 0; j < m_fields; ++j) {
+                    pointValues[j] += basis * m_weight[j][i];
+                }
+            }
         }
     }
+}
 
-    k=0;
-    for( const auto &i : activeSet ) {
-        for( const auto &j : activeSet ){
-
-            dist = calcDist(j,i) / m_supportRadius;
-            A[k] = evalBasis( dist );
-            k++;
-        }
-    }
+/*!
+ * Evaluates the RBF on a set of points. Supported in both modes.
+ *
+ * See RBFKernel::evalRBF(std::size_t, const std::array<double,3> *, double *)
+ * for a description of the algorithm.
+ *
+ * @param[in] points coordinates of the points where to evaluate the RBF
+ * @param[out] values on output will contain the interpolated/parameterized
+ * values, the container is resized to the number of points times the number of
+ * fields and values are stored point by point
+ */
+void RBFKernel::evalRBF(const std::vector<std::array<double,3>> &points, std::vector<double> *values)
+{
+    values->resize(points.size() * m_fields);
 
-    info = LAPACKE_dgesv( LAPACK_COL_MAJOR, nS, nrhs, A.data(), lda, ipiv, b.data(), ldb );
+    evalRBF(points.size(), points.data(), values->data());
+}
 
-    if( info > 0 ) {
-        printf( "The diagonal element of the triangular factor of the linear system matrix \n" );
-        printf( "U(%i,%i) is zero, so that matrix is singular;\n", info, info );
-        printf( "the solution could not be computed.\n" );
-        return 1;
+/*!
+ * Calculates the RBF weights using all currently active nodes and just given target fields.
+ * The interpolation system is assembled and solved according to the solver mode
+ * (see RBFKernel::setSolverMode): the dense mode employs a regular LU solver for
+ * the linear system A*X=B (LAPACKE dgesv), whereas the sparse mode, available
+ * only for compactly supported basis functions, assembles the non-zero entries
+ * of the system and solves it with a Jacobi preconditioned conjugate gradient.
+ * Supported ONLY in INTERP mode.
+ *
+ * @return integer error flag . If 0-successfull computation, if 1-errors occurred, if -1 dummy method call
+ */
+int RBFKernel::solve()
+{
+    if(m_mode == RBFMode::PARAM) {
+        return -1;
     }
 
-    m_weight.resize(nrhs);
-
-    k=0;
-    for( j=0; j<nrhs; ++j) {
-        m_weight[j].resize(m_nodes,0);
-
-        for( const auto &i : activeSet ) {
-            m_weight[j][i] = b[k];
-            ++k;
-        }
+    if(m_solverMode == RBFSolverMode::SPARSE && isCompactSupport()) {
+        return solveSparse();
     }
 
-    return 0;
+    return solveDense();
 }
 
 /*!
  * Determines effective set of nodes to be used using greedy algorithm and calculate weights on them.
  * Automatically choose which set of RBFKernel nodes is active or not, according to the given tolerance.
+ *
+ * Weights are evaluated as solution of the linear least squares problem defined on all the nodes.
+ * By default, the problem is solved from scratch each time a node is added to the active set (see
+ * RBFKernel::solveLSQ). In incremental mode, the QR factorization of the least squares matrix is
+ * updated each time a node is added and the interpolation error is updated accordingly, hence the
+ * cost of adding a node grows only linearly with the number of active nodes (see
+ * RBFKernel::greedyIncremental).
  * Supported ONLY in INTERP mode.
  * @param[in] tolerance error tolerance for adding nodes
+ * @param[in] incremental if set to true, the incremental mode will be used
  * @return integer error flag . If 0-successfull computation and tolerance met, if 1-errors occurred, not enough nodes, if -1 dummy method call
  */
-int RBFKernel::greedy( double tolerance)
+int RBFKernel::greedy( double tolerance, bool incremental)
 {
     if(m_mode == RBFMode::PARAM)    return -1;
 
@@ -723,6 +827,10 @@ int RBFKernel::greedy( double tolerance)
 
     }
 
+    if( incremental ) {
+        return greedyIncremental(tolerance);
+    }
+
     ios::fmtflags streamFlags(log::cout().flags());
 
     int errorFlag = 0;
@@ -828,6 +936,157 @@ int RBFKernel::addGreedyPoint( )
     return index;
 }
 
+/*!
+ * Greedy selection of the active nodes with incremental update of the least squares solution.
+ *
+ * The least squares matrix has a row for each node and a column for each active node. The
+ * method keeps a QR factorization of the matrix, computed with a Gram-Schmidt process with
+ * re-orthogonalization: when a node is added, a column is appended to the matrix and it is
+ * orthogonalized against the current orthonormal basis, giving a new column of both Q and R.
+ * The residual of the least squares problem, whose norm on each node is the interpolation
+ * error, is updated removing its component along the new basis vector. Weights are evaluated
+ * by back substitution once the selection is completed.
+ *
+ * If the column of a selected node is linearly dependent on the columns of the current active
+ * nodes, the node is marked as active but it does not contribute to the interpolation, i.e.,
+ * its weight will be zero.
+ *
+ * The error vector should have already been initialized with the norm of the values to be
+ * interpolated and all the nodes should have already been deactivated.
+ * Supported ONLY in INTERP mode.
+ * @param[in] tolerance error tolerance for adding nodes
+ * @return integer error flag . If 0-successfull computation and tolerance met, if 1-errors occurred, not enough nodes, if -1 dummy method call
+ */
+int RBFKernel::greedyIncremental( double tolerance)
+{
+    if(m_mode == RBFMode::PARAM)    return -1;
+
+    const double DEPENDENCY_TOLERANCE = 1.e-12;
+
+    int nP   = m_nodes;
+    int nrhs = getDataCount();
+
+    bool compactSupport = isCompactSupport();
+
+    // Factorization and residual
+    std::vector<int>                    columnNodes;
+    std::vector<std::vector<double>>    Q;
+    std::vector<std::vector<double>>    R;
+    std::vector<std::vector<double>>    Qtb(nrhs);
+    std::vector<std::vector<double>>    residual(m_value.begin(), m_value.begin() + nrhs);
+
+    // Greedy selection
+    ios::fmtflags streamFlags(log::cout().flags());
+
+    std::vector<double> column(nP);
+    std::vector<int>    neighs;
+
+    int errorFlag = 0;
+    double error = 1.e18;
+    while( error > tolerance ) {
+        int node = addGreedyPoint();
+        if( node == -1 ) {
+            errorFlag = 1;
+            break;
+        }
+
+        m_activeNodes[node] = true;
+
+        // Column of the new node
+        if( compactSupport ) {
+            std::fill(column.begin(), column.end(), 0.);
+
+            neighs.clear();
+            findNodesInRadius(node, m_supportRadius, &neighs);
+            for( int i : neighs ) {
+                column[i] = evalBasis( calcDist(node,i) / m_supportRadius );
+            }
+        } else {
+            for( int i=0; i<nP; ++i ) {
+                column[i] = evalBasis( calcDist(node,i) / m_supportRadius );
+            }
+        }
+
+        // Orthogonalization against the current basis
+        std::size_t nColumns = Q.size();
+        std::vector<double> columnR(nColumns + 1, 0.);
+
+        double columnNorm = norm2(column);
+        for( int pass=0; pass<2; ++pass ) {
+            for( std::size_t k=0; k<nColumns; ++k ) {
+                const std::vector<double> &q = Q[k];
+
+                double h = dotProduct(q, column);
+                for( int i=0; i<nP; ++i ) {
+                    column[i] -= h * q[i];
+                }
+                columnR[k] += h;
+            }
+        }
+
+        double orthogonalNorm = norm2(column);
+        if( orthogonalNorm > DEPENDENCY_TOLERANCE * columnNorm ) {
+            for( int i=0; i<nP; ++i ) {
+                column[i] /= orthogonalNorm;
+            }
+            columnR[nColumns] = orthogonalNorm;
+
+            // Update the residual
+            for( int j=0; j<nrhs; ++j ) {
+                double c = dotProduct(column, residual[j]);
+                for( int i=0; i<nP; ++i ) {
+                    residual[j][i] -= c * column[i];
+                }
+                Qtb[j].push_back(c);
+            }
+
+            columnNodes.push_back(node);
+            Q.push_back(column);
+            R.push_back(std::move(columnR));
+        }
+
+        // Update the error
+        error = 0.;
+        for( int i=0; i<nP; ++i ) {
+            double nodeError = 0.;
+            for( int j=0; j<nrhs; ++j ) {
+                nodeError += residual[j][i] * residual[j][i];
+            }
+            nodeError = std::sqrt(nodeError);
+
+            m_error[i] = nodeError;
+            error = std::max(error, nodeError);
+        }
+
+        log::cout() << std::scientific;
+        log::cout() << " error now " << error << " active nodes" << getActiveCount() << " / " << m_nodes << std::endl;
+    }
+
+    log::cout().flags(streamFlags);
+
+    // Evaluate the weights by back substitution
+    std::size_t nColumns = columnNodes.size();
+
+    m_weight.resize(nrhs);
+    std::vector<double> x(nColumns);
+    for( int j=0; j<nrhs; ++j ) {
+        for( std::size_t k=nColumns; k-- > 0; ) {
+            double sum = Qtb[j][k];
+            for( std::size_t l=k+1; l<nColumns; ++l ) {
+                sum -= R[l][k] * x[l];
+            }
+            x[k] = sum / R[k][k];
+        }
+
+        m_weight[j].assign(m_nodes, 0.);
+        for( std::size_t k=0; k<nColumns; ++k ) {
+            m_weight[j][columnNodes[k]] = x[k];
+        }
+    }
+
+    return errorFlag;
+}
+
 /*!
  * Calculates the relative error between rbf interpolation and exact values at nodes.
  * Supported only in INTERP mode.
@@ -871,6 +1130,313 @@ double RBFKernel::evalError( )
     return maxError;
 }
 
+/*!
+ * Calculates the RBF weights using all currently active nodes and just given target fields.
+ * The full interpolation matrix is assembled and the linear system A*X=B is solved
+ * with a regular LU solver (LAPACKE dgesv).
+ * Supported ONLY in INTERP mode.
+ *
+ * @return integer error flag . If 0-successfull computation, if 1-errors occurred, if -1 dummy method call
+ */
+int RBFKernel::solveDense()
+{
+    if(m_mode == RBFMode::PARAM) {
+        return -1;
+    }
+
+    int  j, k;
+    double dist;
+
+    int nS      = getActiveCount();
+    int nrhs    = getDataCount();
+
+    int lda     = nS;
+    int ldb     = nS;
+    int info;
+    std::vector<int> ipiv(nS);
+
+    std::vector<int> activeSet( getActiveSet() );
+
+    std::vector<double> A(lda * nS);
+    std::vector<double> b(ldb * nrhs);
+
+    k=0;
+    for( j=0; j<nrhs; ++j) {
+        for( const auto & i : activeSet ) {
+            b[k] = m_value[j][i];
+            ++k;
+        }
+    }
+
+    k=0;
+    for( const auto &i : activeSet ) {
+        for( const auto &j : activeSet ){
+
+            dist = calcDist(j,i) / m_supportRadius;
+            A[k] = evalBasis( dist );
+            k++;
+        }
+    }
+
+    info = LAPACKE_dgesv( LAPACK_COL_MAJOR, nS, nrhs, A.data(), lda, ipiv.data(), b.data(), ldb );
+
+    if( info > 0 ) {
+        printf( "The diagonal element of the triangular factor of the linear system matrix \n" );
+        printf( "U(%i,%i) is zero, so that matrix is singular;\n", info, info );
+        printf( "the solution could not be computed.\n" );
+        return 1;
+    }
+
+    m_weight.resize(nrhs);
+
+    k=0;
+    for( j=0; j<nrhs; ++j) {
+        m_weight[j].resize(m_nodes,0);
+
+        for( const auto &i : activeSet ) {
+            m_weight[j][i] = b[k];
+            ++k;
+        }
+    }
+
+    return 0;
+}
+
+/*!
+ * Calculates the RBF weights using all currently active nodes and just given target fields.
+ *
+ * Only the pairs of active nodes whose distance is within the support radius
+ * give a non-zero contribution to the interpolation matrix: these pairs are
+ * found through RBFKernel::findNodesInRadius and the matrix is stored in
+ * compressed sparse row format. Since compactly supported Wendland functions
+ * give a symmetric positive definite matrix, the system is solved with a
+ * conjugate gradient preconditioned with the diagonal of the matrix. The
+ * current weights, if available, are used as initial guess.
+ *
+ * The method is meant to be used only with compactly supported basis
+ * functions. Convergence of the solver is guaranteed only for basis functions
+ * that are positive definite (e.g., WENDLANDC2).
+ * Supported ONLY in INTERP mode.
+ *
+ * @return integer error flag . If 0-successfull computation, if 1-errors occurred, if -1 dummy method call
+ */
+int RBFKernel::solveSparse()
+{
+    if(m_mode == RBFMode::PARAM) {
+        return -1;
+    }
+
+    const double RELATIVE_TOLERANCE = 1.e-12;
+
+    int nS      = getActiveCount();
+    int nrhs    = getDataCount();
+
+    std::vector<int> activeSet( getActiveSet() );
+
+    // Position of the nodes in the active set
+    std::vector<int> activePosition(m_nodes, -1);
+    for( int k=0; k<nS; ++k ) {
+        activePosition[activeSet[k]] = k;
+    }
+
+    // Assemble the matrix in CSR format
+    std::vector<std::size_t> rowPointers(nS + 1);
+    std::vector<int>         columns;
+    std::vector<double>      values;
+    std::vector<double>      diagonal(nS, 0.);
+
+    columns.reserve(nS);
+    values.reserve(nS);
+
+    std::vector<int> neighs;
+    rowPointers[0] = 0;
+    for( int row=0; row<nS; ++row ) {
+        int i = activeSet[row];
+
+        neighs.clear();
+        findNodesInRadius(i, m_supportRadius, &neighs);
+        std::sort(neighs.begin(), neighs.end());
+
+        for( int j : neighs ) {
+            int column = activePosition[j];
+            if( column < 0 ) {
+                continue;
+            }
+
+            double value = evalBasis( calcDist(i,j) / m_supportRadius );
+            if( value == 0. ) {
+                continue;
+            }
+
+            columns.push_back(column);
+            values.push_back(value);
+            if( column == row ) {
+                diagonal[row] = value;
+            }
+        }
+
+        rowPointers[row + 1] = columns.size();
+    }
+
+    for( int row=0; row<nS; ++row ) {
+        if( diagonal[row] <= 0. ) {
+            log::cout() << "The diagonal of the linear system matrix is not positive, the solution could not be computed." << std::endl;
+            return 1;
+        }
+    }
+
+    // Solve the system for each field
+    std::vector<double> x(nS);
+    std::vector<double> r(nS);
+    std::vector<double> z(nS);
+    std::vector<double> p(nS);
+    std::vector<double> q(nS);
+
+    auto multiply = [&rowPointers, &columns, &values, nS](const std::vector<double> &in, std::vector<double> *out) {
+        for( int row=0; row<nS; ++row ) {
+            double sum = 0.;
+            for( std::size_t k=rowPointers[row]; k<rowPointers[row + 1]; ++k ) {
+                sum += values[k] * in[columns[k]];
+            }
+            (*out)[row] = sum;
+        }
+    };
+
+    int maxIterations = std::max(10 * nS, 100);
+
+    m_weight.resize(nrhs);
+    for( int field=0; field<nrhs; ++field ) {
+        std::vector<double> &weight = m_weight[field];
+        bool warmStart = ((int) weight.size() == m_nodes);
+
+        // Initial guess and residual
+        for( int k=0; k<nS; ++k ) {
+            x[k] = warmStart ? weight[activeSet[k]] : 0.;
+        }
+
+        multiply(x, &q);
+
+        double rhsNorm = 0.;
+        for( int k=0; k<nS; ++k ) {
+            double rhs = m_value[field][activeSet[k]];
+            r[k] = rhs - q[k];
+            rhsNorm += rhs * rhs;
+        }
+        rhsNorm = std::sqrt(rhsNorm);
+
+        // Conjugate gradient iterations
+        double residualNorm = norm2(r);
+        double tolerance = RELATIVE_TOLERANCE * std::max(rhsNorm, std::numeric_limits<double>::min());
+
+        double rz = 0.;
+        int iteration = 0;
+        while( residualNorm > tolerance ) {
+            if( iteration == maxIterations ) {
+                log::cout() << "The conjugate gradient did not converge, the solution could not be computed." << std::endl;
+                return 1;
+            }
+
+            double rzOld = rz;
+            rz = 0.;
+            for( int k=0; k<nS; ++k ) {
+                z[k] = r[k] / diagonal[k];
+                rz  += r[k] * z[k];
+            }
+
+            if( iteration == 0 ) {
+                p = z;
+            } else {
+                double beta = rz / rzOld;
+                for( int k=0; k<nS; ++k ) {
+                    p[k] = z[k] + beta * p[k];
+                }
+            }
+
+            multiply(p, &q);
+
+            double pq = dotProduct(p, q);
+            if( pq <= 0. ) {
+                log::cout() << "The linear system matrix is not positive definite, the solution could not be computed." << std::endl;
+                return 1;
+            }
+
+            double alpha = rz / pq;
+            for( int k=0; k<nS; ++k ) {
+                x[k] += alpha * p[k];
+                r[k] -= alpha * q[k];
+            }
+
+            residualNorm = norm2(r);
+            ++iteration;
+        }
+
+        // Store the weights
+        weight.assign(m_nodes, 0.);
+        for( int k=0; k<nS; ++k ) {
+            weight[activeSet[k]] = x[k];
+        }
+    }
+
+    return 0;
+}
+
+/*!
+ * Initializes the data structures needed by the node search.
+ *
+ * The method is called before searching the nodes within a radius from
+ * multiple threads, derived classes that build their spatial index on
+ * demand should build it here. The default implementation does nothing.
+ */
+void RBFKernel::initializeNodeSearch()
+{
+}
+
+/*!
+ * Finds the RBF nodes whose distance from the specified node is less than
+ * or equal to the given radius. The specified node is included in the list.
+ *
+ * The default implementation evaluates the distance between the specified
+ * node and all other nodes; derived classes that are aware of the position
+ * of the nodes should override this method with a search based on a spatial
+ * index.
+ *
+ * @param[in] i index of the node
+ * @param[in] radius search radius
+ * @param[out] neighs on output will contain the indices of the nodes found,
+ * nodes are appended to the list
+ */
+void RBFKernel::findNodesInRadius(int i, double radius, std::vector<int> *neighs)
+{
+    for( int j=0; j<m_nodes; ++j ) {
+        if( calcDist(i,j) <= radius ) {
+            neighs->push_back(j);
+        }
+    }
+}
+
+/*!
+ * Finds the RBF nodes whose distance from the specified point is less than
+ * or equal to the given radius.
+ *
+ * The default implementation evaluates the distance between the specified
+ * point and all the nodes; derived classes that are aware of the position
+ * of the nodes should override this method with a search based on a spatial
+ * index.
+ *
+ * @param[in] point coordinates of the point
+ * @param[in] radius search radius
+ * @param[out] neighs on output will contain the indices of the nodes found,
+ * nodes are appended to the list
+ */
+void RBFKernel::findNodesInRadius(const std::array<double,3> &point, double radius, std::vector<int> *neighs)
+{
+    for( int j=0; j<m_nodes; ++j ) {
+        if( calcDist(point,j) <= radius ) {
+            neighs->push_back(j);
+        }
+    }
+}
+
 /*!
  * Calculates the RBFKernel weights using all active nodes and just given target fields.
  * Compute weights as solution of a linear least squares problem (LAPACKE dglsd).
@@ -1010,6 +1576,7 @@ void RBF::swap(RBF &x) noexcept
     RBFKernel::swap(x);
 
     std::swap(m_node, x.m_node);
+    std::swap(m_nodeTree, x.m_nodeTree);
 }
 
 /*!
@@ -1033,6 +1600,8 @@ int RBF::addNode( const std::array<double,3> &node )
     m_activeNodes.push_back(true);
     m_nodes++;
 
+    m_nodeTree.reset();
+
     return m_nodes;
 }
 
@@ -1059,6 +1628,8 @@ std::vector<int> RBF::addNode( const std::vector<std::array<double,3>> &node )
 
     m_activeNodes.resize( m_nodes, true );
 
+    m_nodeTree.reset();
+
     return ids;
 }
 
@@ -1077,6 +1648,8 @@ bool RBF::removeNode(int id)
     m_node.erase(m_node.begin()+id);
     m_activeNodes.erase(m_activeNodes.begin()+id);
 
+    m_nodeTree.reset();
+
     return true;
 }
 
@@ -1108,6 +1681,8 @@ bool RBF::removeNode(std::vector<int> & list)
         }
     }
 
+    m_nodeTree.reset();
+
     return(extracted == (int)(list.size()));
 }
 
@@ -1119,6 +1694,106 @@ void RBF::removeAllNodes()
     m_nodes = 0;
     m_node.clear();
     m_activeNodes.clear();
+
+    m_nodeTree.reset();
+}
+
+/*!
+ * Initializes the data structures needed by the node search, i.e., builds
+ * the kd-tree of the nodes if it is not up-to-date.
+ */
+void RBF::initializeNodeSearch()
+{
+    if (!m_nodeTree) {
+        buildNodeTree();
+    }
+}
+
+/*!
+ * Finds the RBF nodes whose distance from the specified node is less than
+ * or equal to the given radius. The specified node is included in the list.
+ *
+ * The search is performed using a kd-tree of the nodes, the tree is built
+ * the first time it is needed and it is rebuilt after nodes are added or
+ * removed.
+ *
+ * @param[in] i index of the node
+ * @param[in] radius search radius
+ * @param[out] neighs on output will contain the indices of the nodes found,
+ * nodes are appended to the list
+ */
+void RBF::findNodesInRadius(int i, double radius, std::vector<int> *neighs)
+{
+    initializeNodeSearch();
+
+    m_nodeTree->hNeighbors(&(m_node[i]), radius, neighs, nullptr);
+}
+
+/*!
+ * Finds the RBF nodes whose distance from the specified point is less than
+ * or equal to the given radius.
+ *
+ * The search is performed using the kd-tree of the nodes. The method is
+ * thread-safe only if the tree is up-to-date (see RBF::initializeNodeSearch).
+ *
+ * @param[in] point coordinates of the point
+ * @param[in] radius search radius
+ * @param[out] neighs on output will contain the indices of the nodes found,
+ * nodes are appended to the list
+ */
+void RBF::findNodesInRadius(const std::array<double,3> &point, double radius, std::vector<int> *neighs)
+{
+    initializeNodeSearch();
+
+    m_nodeTree->hNeighbors(&point, radius, neighs, nullptr);
+}
+
+/*!
+ * Builds the kd-tree of the RBF nodes.
+ *
+ * Nodes are inserted in the tree recursively, starting from the median of
+ * the coordinate used by the tree to split the current level. This leads
+ * to a balanced tree even if the nodes are spatially sorted.
+ */
+void RBF::buildNodeTree()
+{
+    m_nodeTree.reset(new KdTree<3, std::array<double,3>, int>(std::max(m_nodes, 1)));
+    if (m_nodes == 0) {
+        return;
+    }
+
+    std::vector<int> nodeIds(m_nodes);
+    for (int i = 0; i < m_nodes; ++i) {
+        nodeIds[i] = i;
+    }
+
+    // Each entry of the stack is a range of node ids and its tree level
+    std::vector<std::array<int, 3>> ranges;
+    ranges.push_back({{0, m_nodes, 0}});
+    while (!ranges.empty()) {
+        std::array<int, 3> range = ranges.back();
+        ranges.pop_back();
+
+        int begin = range[0];
+        int end   = range[1];
+        int level = range[2];
+        if (begin == end) {
+            continue;
+        }
+
+        int dim = level % 3;
+        int median = begin + (end - begin) / 2;
+        std::nth_element(nodeIds.begin() + begin, nodeIds.begin() + median, nodeIds.begin() + end,
+            [this, dim](int n1, int n2) {
+                return (m_node[n1][dim] < m_node[n2][dim]);
+            });
+
+        int label = nodeIds[median];
+        m_nodeTree->insert(&(m_node[label]), label);
+
+        ranges.push_back({{median + 1, end, level + 1}});
+        ranges.push_back({{begin, median, level + 1}});
+    }
 }
 
 /*!
@@ -27,6 +27,9 @@
 
 #include <vector>
 #include <array>
+#include <memory>
+
+#include "bitpit_SA.hpp"
 
 namespace bitpit{
 
@@ -62,6 +65,16 @@ enum class RBFMode {
     PARAM  = 2  /**< RBF class used as pure parameterizator*/
 };
 
+/*!
+ * @enum RBFSolverMode
+ * @ingroup RBF
+ * @brief Enum class defining how the RBF interpolation system is assembled and solved
+ */
+enum class RBFSolverMode {
+    DENSE  = 0, /**< Dense assembly of the system, solved with LU factorization (LAPACKE dgesv) */
+    SPARSE = 1  /**< Sparse assembly of the node pairs within the support radius, solved with Jacobi preconditioned CG. Used only with compactly supported basis functions */
+};
+
 class RBFKernel{
 
 private:
@@ -70,6 +83,7 @@ private:
     double  m_supportRadius;                        /**<Support radius of function used as Radiabl Basis Function.*/
     RBFBasisFunction m_typef;                       /**<Recognize type of RBF shape function actually in the class. */
     double  (*m_fPtr)(double);
+    RBFSolverMode m_solverMode;                     /**<Assembly and solution strategy of the interpolation system. */
 
     std::vector<double>                 m_error;    /**<Interpolation error of a field evaluated on each RBF node (auxiliary memeber used in Greedy algorithm).*/
 
@@ -108,6 +122,11 @@ public:
     void                    setMode(RBFMode mode);
     RBFMode                 getMode();
 
+    void                    setSolverMode(RBFSolverMode mode);
+    RBFSolverMode           getSolverMode();
+
+    bool                    isCompactSupport();
+
     void                    setDataToNode (int , const std::vector<double> &);
     void                    setDataToAllNodes(int , const std::vector<double> &);
 
@@ -122,17 +141,26 @@ public:
 
     std::vector<double>     evalRBF(const std::array<double,3> &);
     std::vector<double>     evalRBF(int jnode);
+    void                    evalRBF(std::size_t nPoints, const std::array<double,3> *points, double *values);
+    void                    evalRBF(const std::vector<std::array<double,3>> &points, std::vector<double> *values);
     double                  evalBasis(double);
 
     int                     solve();
-    int                     greedy(double);
+    int                     greedy(double, bool incremental = false);
 
 protected:
     double                  evalError();
     int                     addGreedyPoint();
+    int                     greedyIncremental(double);
     int                     solveLSQ();
+    int                     solveDense();
+    int                     solveSparse();
     void                    swap(RBFKernel & x) noexcept;
 
+    virtual void            initializeNodeSearch();
+    virtual void            findNodesInRadius(int i, double radius, std::vector<int> *neighs);
+    virtual void            findNodesInRadius(const std::array<double,3> &point, double radius, std::vector<int> *neighs);
+
 private:
 
     virtual double calcDist(int i, int j) = 0;
@@ -145,6 +173,8 @@ class RBF : public RBFKernel {
 protected:
     std::vector<std::array<double,3>>   m_node;     /**< list of RBF nodes */
 
+    std::unique_ptr<KdTree<3, std::array<double,3>, int>> m_nodeTree; /**< spatial index of the RBF nodes, built on demand */
+
 public:
     ~RBF();
     RBF(RBFBasisFunction = RBFBasisFunction::WENDLANDC2);
@@ -162,6 +192,12 @@ public:
 protected:
     void     swap(RBF & x) noexcept;
 
+    void     initializeNodeSearch();
+    void     findNodesInRadius(int i, double radius, std::vector<int> *neighs);
+    void     findNodesInRadius(const std::array<double,3> &point, double radius, std::vector<int> *neighs);
+
+    void     buildNodeTree();
+
 private:
     double calcDist(int i, int j);
     double calcDist(const std::array<double,3> & point, int j);
@@ -34,6 +34,7 @@
 #include <functional>
 #include <iomanip>
 #include <iostream>
+#include <iterator>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -72,6 +73,9 @@ void eraseValue(std::vector<T> &, const T&);
 template <class T>
 std::vector<T> intersectionVector(const std::vector<T>&, const std::vector<T>&);
 
+template <typename RandomIterator, typename Comparator = std::less<typename std::iterator_traits<RandomIterator>::value_type> >
+void parallelSort(RandomIterator first, RandomIterator last, Comparator comparator = Comparator());
+
 #ifndef __BITPIT_COMMON_UTILS_SRC__
 extern template bool addToOrderedVector<>(const long&, std::vector<long>&, std::less<long>);
 extern template bool addToOrderedVector<>(const unsigned long&, std::vector<unsigned long>&, std::less<unsigned long>);
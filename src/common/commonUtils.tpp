@@ -27,6 +27,10 @@
 
 /*! \file */
 
+#if BITPIT_ENABLE_OPENMP==1
+#include <omp.h>
+#endif
+
 namespace bitpit {
 
 namespace utils {
@@ -171,6 +175,71 @@ std::vector<T> intersectionVector(const std::vector<T> &vec_1, const std::vector
     return intersect;
 }
 
+/*!
+* \ingroup common_misc
+*
+* Sorts the elements in the specified range.
+*
+* When multi-threading is enabled, the range is split into as many chunks
+* as the available threads, the chunks are sorted concurrently and then
+* merged pairwise. Otherwise the elements are sorted using std::sort.
+*
+* The sort is not stable.
+*
+* \tparam RandomIterator is the type of the iterators defining the range
+* \tparam Comparator is the type of the binary function used for the
+* comparison of the elements
+*
+* \param first is the iterator to the first element of the range
+* \param last is the iterator past the last element of the range
+* \param comparator is a binary function that accepts two elements of the
+* range and returns true if the first argument should be placed before the
+* second one
+*/
+template <typename RandomIterator, typename Comparator>
+void parallelSort(RandomIterator first, RandomIterator last, Comparator comparator)
+{
+#if BITPIT_ENABLE_OPENMP==1
+    // Small ranges are sorted serially
+    const std::size_t MIN_CHUNK_SIZE = 4096;
+
+    std::size_t nElements = static_cast<std::size_t>(std::distance(first, last));
+    int nChunks = static_cast<int>(std::min(nElements / MIN_CHUNK_SIZE, static_cast<std::size_t>(omp_get_max_threads())));
+    if (nChunks < 2) {
+        std::sort(first, last, comparator);
+        return;
+    }
+
+    // Sort the chunks
+    std::vector<std::size_t> chunkBegins(nChunks + 1);
+    for (int i = 0; i <= nChunks; ++i) {
+        chunkBegins[i] = (nElements * i) / nChunks;
+    }
+
+    #pragma omp parallel for schedule(static, 1)
+    for (int i = 0; i < nChunks; ++i) {
+        std::sort(first + chunkBegins[i], first + chunkBegins[i + 1], comparator);
+    }
+
+    // Merge the chunks
+    for (int width = 1; width < nChunks; width *= 2) {
+        #pragma omp parallel for schedule(static, 1)
+        for (int i = 0; i < nChunks; i += 2 * width) {
+            if (i + width >= nChunks) {
+                continue;
+            }
+
+            RandomIterator chunkBegin  = first + chunkBegins[i];
+            RandomIterator chunkMiddle = first + chunkBegins[i + width];
+            RandomIterator chunkEnd    = first + chunkBegins[std::min(i + 2 * width, nChunks)];
+            std::inplace_merge(chunkBegin, chunkMiddle, chunkEnd, comparator);
+        }
+    }
+#else
+    std::sort(first, last, comparator);
+#endif
+}
+
 /*!
 * \ingroup common_misc
 *
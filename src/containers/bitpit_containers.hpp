@@ -38,6 +38,7 @@
 #include "binary_stream.hpp"
 #include "flatVector2D.hpp"
 #include "piercedKernel.hpp"
+#include "piercedPositionMap.hpp"
 #include "piercedStorage.hpp"
 #include "piercedVector.hpp"
 #include "piercedStorageRange.hpp"
@@ -28,13 +28,13 @@
 #include <algorithm>
 #include <cassert>
 #include <limits>
-#include <unordered_map>
 #include <type_traits>
 #include <vector>
 
 #include "bitpit_common.hpp"
 
 #include "piercedSync.hpp"
+#include "piercedPositionMap.hpp"
 #include "piercedKernelIterator.hpp"
 #include "piercedKernelRange.hpp"
 
@@ -134,6 +134,11 @@ public:
     */
     typedef typename std::vector<id_t>::const_iterator raw_const_iterator;
 
+    /**
+    * Type of the map that links ids and positions
+    */
+    typedef BasePiercedPositionMap::MapType PositionMapType;
+
     /**
     * Constant range
     */
@@ -351,6 +356,9 @@ public:
 
     void flush();
 
+    void setPositionMapType(PositionMapType type);
+    PositionMapType getPositionMapType() const;
+
     // Methods that extract information about the kernel
     bool contiguous() const;
     void dump() const;
@@ -448,37 +456,6 @@ protected:
     ShrinkToFitAction _shrinkToFit();
 
 private:
-    /**
-    * Hasher for the id map.
-    *
-    * Since the id are uniques, the hasher can be a function that
-    * takes the id and cast it to a std::size_t.
-    *
-    * The hasher is defined as a struct, because a struct can be
-    * passed as an object into metafunctions (meaning that the type
-    * deduction for the template paramenters can take place, and
-    * also meaning that inlining is easier for the compiler). A bare
-    * function would have to be passed as a function pointer.
-    * To transform a function template into a function pointer,
-    * the template would have to be manually instantiated (with a
-    * perhaps unknown type argument).
-    */
-    struct PiercedHasher {
-        /**
-        * Function call operator that casts the specified
-        * value to a std::size_t.
-        *
-        * \tparam U type of the value
-        * \param value is the value to be casted
-        * \result Returns the value casted to a std::size_t.
-        */
-        template<typename U>
-        constexpr std::size_t operator()(U&& value) const noexcept
-        {
-            return static_cast<std::size_t>(std::forward<U>(value));
-        }
-    };
-
     /**
     * Compares the id of the elements in the specified position.
     *
@@ -528,7 +505,7 @@ private:
     * Map that links the id of the elements and their position inside the
     * internal vector.
     */
-    std::unordered_map<id_t, std::size_t, PiercedHasher> m_pos;
+    PiercedPositionMap<id_t> m_pos;
 
     /**
     * Position of the first element in the internal vector.
@@ -104,10 +104,9 @@ typename PiercedKernel<id_t>::ClearAction PiercedKernel<id_t>::_clear(bool relea
 {
     // Clear positions
     m_ids.clear();
-    m_pos.clear();
+    m_pos.clear(release);
     if (release) {
         std::vector<id_t>().swap(m_ids);
-        std::unordered_map<id_t, std::size_t, PiercedHasher>().swap(m_pos);
     }
 
     // Reset begin and end
@@ -434,7 +433,7 @@ typename PiercedKernel<id_t>::SortAction PiercedKernel<id_t>::_sort(std::size_t
     // Update the positions
     m_pos.clear();
     for (std::size_t i = 0; i < updatedKernelRawSize; ++i) {
-        m_pos[m_ids[i]] = i;
+        m_pos.set(m_ids[i], i);
     }
 
     // Return the permutations
@@ -615,7 +614,7 @@ void PiercedKernel<id_t>::swap(PiercedKernel &x) noexcept
     std::swap(x.m_end_pos, m_end_pos);
     std::swap(x.m_dirty_begin_pos, m_dirty_begin_pos);
     std::swap(x.m_ids, m_ids);
-    std::swap(x.m_pos, m_pos);
+    x.m_pos.swap(m_pos);
     std::swap(x.m_holes, m_holes);
     std::swap(x.m_holes_regular_begin, m_holes_regular_begin);
     std::swap(x.m_holes_regular_end, m_holes_regular_end);
@@ -635,6 +634,37 @@ void PiercedKernel<id_t>::flush()
     holesFlush();
 }
 
+/**
+* Sets the type of the map that links the ids of the elements to their
+* position inside the kernel.
+*
+* Node-based hash maps are a good general purpose choice. Flat maps store
+* all the entries contiguously and are faster for lookup-heavy workloads.
+* Dense maps are the fastest choice, but their memory footprint depends on
+* the maximum id stored in the kernel, hence they should be used only when
+* the ids of the elements are (almost) consecutive.
+*
+* \param type is the type of the map
+*/
+template<typename id_t>
+void PiercedKernel<id_t>::setPositionMapType(PositionMapType type)
+{
+    m_pos.setType(type);
+}
+
+/**
+* Gets the type of the map that links the ids of the elements to their
+* position inside the kernel.
+*
+* \result The type of the map that links the ids of the elements to their
+* position inside the kernel.
+*/
+template<typename id_t>
+typename PiercedKernel<id_t>::PositionMapType PiercedKernel<id_t>::getPositionMapType() const
+{
+    return m_pos.getType();
+}
+
 /**
 * Dumps to screen the internal data.
 */
@@ -680,9 +710,9 @@ void PiercedKernel<id_t>::dump() const
     std::cout << std::endl;
     std::cout << " Poistion map: " << std::endl;
     if (size() > 0) {
-        for (auto itr = m_pos.cbegin(); itr != m_pos.cend(); ++itr) {
-            std::cout << itr->first << " -> " << itr->second << std::endl;
-        }
+        m_pos.forEach([](id_t id, std::size_t pos) {
+            std::cout << id << " -> " << pos << std::endl;
+        });
     } else {
         std::cout << "None" << std::endl;
     }
@@ -696,15 +726,13 @@ void PiercedKernel<id_t>::dump() const
 template<typename id_t>
 void PiercedKernel<id_t>::checkIntegrity() const
 {
-    for (const auto &entry : m_pos) {
-        id_t id = entry.first;
-        std::size_t pos = entry.second;
+    m_pos.forEach([this](id_t id, std::size_t pos) {
         if (m_ids[pos] != id) {
             std::cout << " Position " << pos << " should contain the element with id " << id << std::endl;
             std::cout << " but it contains the element with id " << m_ids[pos] << std::endl;
             throw std::runtime_error("Integrity check error");
         }
-    }
+    });
 
     for (std::size_t pos = m_begin_pos; pos < m_end_pos; ++pos) {
         id_t id = m_ids[pos];
@@ -1043,9 +1071,9 @@ id_t PiercedKernel<id_t>::getSizeMarker(std::size_t targetSize, const id_t &fall
 template<typename id_t>
 typename PiercedKernel<id_t>::const_iterator PiercedKernel<id_t>::find(const id_t &id) const noexcept
 {
-    auto iterator = m_pos.find(id);
-    if (iterator != m_pos.end()) {
-        return rawFind(iterator->second);
+    std::size_t pos = m_pos.find(id);
+    if (pos != PiercedPositionMap<id_t>::NOT_FOUND) {
+        return rawFind(pos);
     } else {
         return end();
     }
@@ -1344,7 +1372,7 @@ typename PiercedKernel<id_t>::FillAction PiercedKernel<id_t>::fillAppend(id_t id
     setEndPos(rawSize());
 
     // Update the id map
-    m_pos[id] = m_end_pos - 1;
+    m_pos.set(id, m_end_pos - 1);
 
     // Update the storage
     FillAction fillAction(FillAction::TYPE_APPEND);
@@ -1477,10 +1505,10 @@ typename PiercedKernel<id_t>::FillAction PiercedKernel<id_t>::fillInsert(std::si
     for (std::size_t i = pos + 1; i < m_end_pos; ++i) {
         id_t id_i = m_ids[i];
         if (id_i >= 0) {
-            m_pos[id_i] = i;
+            m_pos.set(id_i, i);
         }
     }
-    m_pos[id] = pos;
+    m_pos.set(id, pos);
 
     // Update the regular holes
     if (m_holes_regular_begin != m_holes_regular_end) {
@@ -2177,7 +2205,7 @@ template<typename id_t>
 void PiercedKernel<id_t>::setPosId(std::size_t pos, id_t id)
 {
     m_ids[pos] = id;
-    m_pos[id]  = pos;
+    m_pos.set(id, pos);
 }
 
 /**
@@ -2213,7 +2241,7 @@ template<typename id_t>
 void PiercedKernel<id_t>::swapPosIds(std::size_t pos_1, id_t id_1, std::size_t pos_2, id_t id_2)
 {
     std::swap(m_ids[pos_1], m_ids[pos_2]);
-    std::swap(m_pos[id_1], m_pos[id_2]);
+    m_pos.swapPositions(id_1, id_2);
 }
 
 /**
@@ -2327,7 +2355,7 @@ void PiercedKernel<id_t>::restore(std::istream &stream)
         std::size_t pos;
         utils::binary::read(stream, pos);
 
-        m_pos.insert({id, pos});
+        m_pos.set(id, pos);
     }
 
     // Postions data
@@ -2378,10 +2406,10 @@ void PiercedKernel<id_t>::dump(std::ostream &stream) const
     // Ids data
     std::size_t nIds = m_pos.size();
     utils::binary::write(stream, nIds);
-    for (const auto &entry : m_pos) {
-        utils::binary::write(stream, entry.first);
-        utils::binary::write(stream, entry.second);
-    }
+    m_pos.forEach([&stream](id_t id, std::size_t pos) {
+        utils::binary::write(stream, id);
+        utils::binary::write(stream, pos);
+    });
 
     // Postions data
     std::size_t nPositions = m_ids.size();
@@ -0,0 +1,214 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2019 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+
+#ifndef __BITPIT_PIERCED_POSITION_MAP_HPP__
+#define __BITPIT_PIERCED_POSITION_MAP_HPP__
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace bitpit {
+
+/**
+* \ingroup containers
+*
+* \brief Base class for the pierced position map.
+*/
+class BasePiercedPositionMap {
+
+public:
+    /**
+    * Type of the map
+    */
+    enum MapType {
+        MAP_TYPE_HASH,
+        MAP_TYPE_FLAT,
+        MAP_TYPE_DENSE
+    };
+
+    /**
+    * Position returned when an id is not in the map
+    */
+    static const std::size_t NOT_FOUND = std::numeric_limits<std::size_t>::max();
+
+    virtual ~BasePiercedPositionMap() = default;
+
+protected:
+    BasePiercedPositionMap() = default;
+
+};
+
+/**
+* \ingroup containers
+*
+* \brief Map that links the id of the elements of a pierced kernel to their
+* position inside the kernel.
+*
+* \details
+* Ids stored in the map are non-negative, the map can use three different
+* data structures:
+*  - MAP_TYPE_HASH, a node-based hash map (std::unordered_map);
+*  - MAP_TYPE_FLAT, a flat hash table with open addressing and linear
+*    probing, entries are stored contiguously in a single vector, hence
+*    lookups touch only one or two cache lines;
+*  - MAP_TYPE_DENSE, a vector directly indexed by the id, whose size is
+*    equal to the maximum id stored in the map plus one. This is the fastest
+*    data structure, but it should be used only when the ids are consecutive
+*    (e.g., after renumbering the elements), otherwise its memory footprint
+*    is proportional to the maximum id rather than to the number of entries.
+*
+* \tparam id_t The type of the ids stored in the map
+*/
+template<typename id_t = long>
+class PiercedPositionMap : public BasePiercedPositionMap {
+
+static_assert(std::is_integral<id_t>::value, "Signed integer required for id.");
+static_assert(std::numeric_limits<id_t>::is_signed, "Signed integer required for id.");
+
+public:
+    PiercedPositionMap(MapType type = MAP_TYPE_HASH);
+
+    MapType getType() const;
+    void setType(MapType type);
+
+    bool empty() const;
+    std::size_t size() const;
+
+    std::size_t count(id_t id) const;
+    std::size_t find(id_t id) const noexcept;
+    std::size_t at(id_t id) const;
+
+    void set(id_t id, std::size_t pos);
+    void erase(id_t id);
+    void swapPositions(id_t id_1, id_t id_2);
+
+    void clear(bool release = false);
+    void reserve(std::size_t n);
+
+    void swap(PiercedPositionMap &x) noexcept;
+
+    template<typename Function>
+    void forEach(Function function) const;
+
+private:
+    /**
+    * Hasher for the node-based map.
+    *
+    * Since the id are uniques, the hasher can be a function that
+    * takes the id and cast it to a std::size_t.
+    *
+    * The hasher is defined as a struct, because a struct can be
+    * passed as an object into metafunctions (meaning that the type
+    * deduction for the template paramenters can take place, and
+    * also meaning that inlining is easier for the compiler). A bare
+    * function would have to be passed as a function pointer.
+    * To transform a function template into a function pointer,
+    * the template would have to be manually instantiated (with a
+    * perhaps unknown type argument).
+    */
+    struct PiercedHasher {
+        /**
+        * Function call operator that casts the specified
+        * value to a std::size_t.
+        *
+        * \tparam U type of the value
+        * \param value is the value to be casted
+        * \result Returns the value casted to a std::size_t.
+        */
+        template<typename U>
+        constexpr std::size_t operator()(U&& value) const noexcept
+        {
+            return static_cast<std::size_t>(std::forward<U>(value));
+        }
+    };
+
+    /**
+    * Slot of the flat table
+    */
+    struct FlatSlot {
+        id_t id;
+        std::size_t pos;
+    };
+
+    /**
+    * Id of the empty slots of the flat table.
+    */
+    static const id_t FLAT_EMPTY_ID = -1;
+
+    /**
+    * Minimum number of slots of the flat table.
+    */
+    static const std::size_t FLAT_MIN_CAPACITY = 16;
+
+    /**
+    * Type of the map
+    */
+    MapType m_type;
+
+    /**
+    * Number of entries
+    */
+    std::size_t m_size;
+
+    /**
+    * Node-based hash map
+    */
+    std::unordered_map<id_t, std::size_t, PiercedHasher> m_hash;
+
+    /**
+    * Slots of the flat table, the number of slots is a power of two
+    */
+    std::vector<FlatSlot> m_flat;
+
+    /**
+    * Number of bits needed to index the slots of the flat table
+    */
+    int m_flatBits;
+
+    /**
+    * Dense vector indexed by the ids
+    */
+    std::vector<std::size_t> m_dense;
+
+    std::size_t flatHome(id_t id) const;
+    std::size_t flatFindSlot(id_t id) const;
+    void flatRehash(std::size_t capacity);
+    std::size_t flatEvalCapacity(std::size_t n) const;
+
+};
+
+}
+
+// Include the implementation
+#include "piercedPositionMap.tpp"
+
+#endif
@@ -0,0 +1,566 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2019 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+
+#ifndef __BITPIT_PIERCED_POSITION_MAP_TPP__
+#define __BITPIT_PIERCED_POSITION_MAP_TPP__
+
+namespace bitpit {
+
+// Definition of static constants of PiercedPositionMap
+template<typename id_t>
+const id_t PiercedPositionMap<id_t>::FLAT_EMPTY_ID;
+
+template<typename id_t>
+const std::size_t PiercedPositionMap<id_t>::FLAT_MIN_CAPACITY;
+
+/**
+* Constructs an empty position map.
+*
+* \param type is the type of the map
+*/
+template<typename id_t>
+PiercedPositionMap<id_t>::PiercedPositionMap(MapType type)
+    : BasePiercedPositionMap(),
+      m_type(type), m_size(0), m_flatBits(0)
+{
+}
+
+/**
+* Gets the type of the map.
+*
+* \result The type of the map.
+*/
+template<typename id_t>
+typename PiercedPositionMap<id_t>::MapType PiercedPositionMap<id_t>::getType() const
+{
+    return m_type;
+}
+
+/**
+* Sets the type of the map.
+*
+* The entries currently stored in the map are moved to the data structure
+* of the new type.
+*
+* \param type is the type of the map
+*/
+template<typename id_t>
+void PiercedPositionMap<id_t>::setType(MapType type)
+{
+    if (type == m_type) {
+        return;
+    }
+
+    // Extract current entries
+    std::vector<std::pair<id_t, std::size_t>> entries;
+    entries.reserve(m_size);
+    forEach([&entries](id_t id, std::size_t pos) {
+        entries.emplace_back(id, pos);
+    });
+
+    // Rebuild the map
+    clear(true);
+
+    m_type = type;
+    reserve(entries.size());
+    for (const auto &entry : entries) {
+        set(entry.first, entry.second);
+    }
+}
+
+/**
+* Checks if the map is empty.
+*
+* \result Returns true if the map contains no entries, false otherwise.
+*/
+template<typename id_t>
+bool PiercedPositionMap<id_t>::empty() const
+{
+    return (m_size == 0);
+}
+
+/**
+* Gets the number of entries stored in the map.
+*
+* \result The number of entries stored in the map.
+*/
+template<typename id_t>
+std::size_t PiercedPositionMap<id_t>::size() const
+{
+    return m_size;
+}
+
+/**
+* Counts the entries with the specified id.
+*
+* \param id is the id to look for
+* \result Returns 1 if the map contains the specified id, or zero otherwise.
+*/
+template<typename id_t>
+std::size_t PiercedPositionMap<id_t>::count(id_t id) const
+{
+    return (find(id) != NOT_FOUND) ? 1 : 0;
+}
+
+/**
+* Gets the position associated to the specified id.
+*
+* \param id is the id to look for
+* \result The position associated to the specified id, if the id is not in
+* the map, NOT_FOUND is returned.
+*/
+template<typename id_t>
+std::size_t PiercedPositionMap<id_t>::find(id_t id) const noexcept
+{
+    if (id < 0) {
+        return NOT_FOUND;
+    }
+
+    switch (m_type) {
+
+    case MAP_TYPE_FLAT:
+    {
+        if (m_flat.empty()) {
+            return NOT_FOUND;
+        }
+
+        std::size_t slot = flatFindSlot(id);
+        if (m_flat[slot].id == FLAT_EMPTY_ID) {
+            return NOT_FOUND;
+        }
+
+        return m_flat[slot].pos;
+    }
+
+    case MAP_TYPE_DENSE:
+    {
+        if (static_cast<std::size_t>(id) >= m_dense.size()) {
+            return NOT_FOUND;
+        }
+
+        return m_dense[id];
+    }
+
+    default:
+    {
+        auto itr = m_hash.find(id);
+        if (itr == m_hash.end()) {
+            return NOT_FOUND;
+        }
+
+        return itr->second;
+    }
+
+    }
+}
+
+/**
+* Gets the position associated to the specified id.
+*
+* If the id is not in the map, an exception is thrown.
+*
+* \param id is the id to look for
+* \result The position associated to the specified id.
+*/
+template<typename id_t>
+std::size_t PiercedPositionMap<id_t>::at(id_t id) const
+{
+    std::size_t pos = find(id);
+    if (pos == NOT_FOUND) {
+        throw std::out_of_range("Id not found in the position map");
+    }
+
+    return pos;
+}
+
+/**
+* Associates a position to the specified id.
+*
+* If the id is already in the map, its position is updated.
+*
+* \param id is the id, it should be a non-negative value
+* \param pos is the position to associate to the id
+*/
+template<typename id_t>
+void PiercedPositionMap<id_t>::set(id_t id, std::size_t pos)
+{
+    assert(id >= 0);
+
+    switch (m_type) {
+
+    case MAP_TYPE_FLAT:
+    {
+        if (m_flat.empty() || 4 * (m_size + 1) > 3 * m_flat.size()) {
+            flatRehash(flatEvalCapacity(m_size + 1));
+        }
+
+        std::size_t slot = flatFindSlot(id);
+        if (m_flat[slot].id == FLAT_EMPTY_ID) {
+            m_flat[slot].id = id;
+            ++m_size;
+        }
+        m_flat[slot].pos = pos;
+        break;
+    }
+
+    case MAP_TYPE_DENSE:
+    {
+        std::size_t index = static_cast<std::size_t>(id);
+        if (index >= m_dense.size()) {
+            m_dense.resize(std::max(index + 1, 2 * m_dense.size()), NOT_FOUND);
+        }
+
+        if (m_dense[index] == NOT_FOUND) {
+            ++m_size;
+        }
+        m_dense[index] = pos;
+        break;
+    }
+
+    default:
+    {
+        m_hash[id] = pos;
+        m_size = m_hash.size();
+        break;
+    }
+
+    }
+}
+
+/**
+* Removes the entry with the specified id.
+*
+* If the id is not in the map, the function does nothing.
+*
+* \param id is the id to remove
+*/
+template<typename id_t>
+void PiercedPositionMap<id_t>::erase(id_t id)
+{
+    if (id < 0) {
+        return;
+    }
+
+    switch (m_type) {
+
+    case MAP_TYPE_FLAT:
+    {
+        if (m_flat.empty()) {
+            return;
+        }
+
+        std::size_t hole = flatFindSlot(id);
+        if (m_flat[hole].id == FLAT_EMPTY_ID) {
+            return;
+        }
+
+        // Backward shift deletion: the entries that follow the hole in
+        // the probe sequence are moved back, so that no tombstones are
+        // needed to keep the probe sequences unbroken.
+        std::size_t mask = m_flat.size() - 1;
+        std::size_t slot = hole;
+        while (true) {
+            slot = (slot + 1) & mask;
+            if (m_flat[slot].id == FLAT_EMPTY_ID) {
+                break;
+            }
+
+            std::size_t home = flatHome(m_flat[slot].id);
+            bool isHomeInRange;
+            if (hole <= slot) {
+                isHomeInRange = (hole < home && home <= slot);
+            } else {
+                isHomeInRange = (hole < home || home <= slot);
+            }
+
+            if (isHomeInRange) {
+                continue;
+            }
+
+            m_flat[hole] = m_flat[slot];
+            hole = slot;
+        }
+
+        m_flat[hole].id = FLAT_EMPTY_ID;
+        --m_size;
+        break;
+    }
+
+    case MAP_TYPE_DENSE:
+    {
+        std::size_t index = static_cast<std::size_t>(id);
+        if (index < m_dense.size() && m_dense[index] != NOT_FOUND) {
+            m_dense[index] = NOT_FOUND;
+            --m_size;
+        }
+        break;
+    }
+
+    default:
+    {
+        m_hash.erase(id);
+        m_size = m_hash.size();
+        break;
+    }
+
+    }
+}
+
+/**
+* Swaps the positions associated to the specified ids.
+*
+* Both ids should already be in the map.
+*
+* \param id_1 is the first id
+* \param id_2 is the second id
+*/
+template<typename id_t>
+void PiercedPositionMap<id_t>::swapPositions(id_t id_1, id_t id_2)
+{
+    std::size_t pos_1 = at(id_1);
+    std::size_t pos_2 = at(id_2);
+
+    set(id_1, pos_2);
+    set(id_2, pos_1);
+}
+
+/**
+* Removes all entries from the map.
+*
+* \param release if set to true, the memory used by the map is released
+*/
+template<typename id_t>
+void PiercedPositionMap<id_t>::clear(bool release)
+{
+    m_size = 0;
+
+    m_hash.clear();
+    if (release) {
+        std::unordered_map<id_t, std::size_t, PiercedHasher>().swap(m_hash);
+    }
+
+    if (release) {
+        std::vector<FlatSlot>().swap(m_flat);
+        m_flatBits = 0;
+    } else {
+        for (FlatSlot &slot : m_flat) {
+            slot.id = FLAT_EMPTY_ID;
+        }
+    }
+
+    if (release) {
+        std::vector<std::size_t>().swap(m_dense);
+    } else {
+        std::fill(m_dense.begin(), m_dense.end(), NOT_FOUND);
+    }
+}
+
+/**
+* Requests that the map capacity be at least enough to contain n entries.
+*
+* For dense maps, the capacity is intended as the maximum id that can be
+* stored without reallocating the map plus one.
+*
+* \param n the minimum capacity requested for the map
+*/
+template<typename id_t>
+void PiercedPositionMap<id_t>::reserve(std::size_t n)
+{
+    switch (m_type) {
+
+    case MAP_TYPE_FLAT:
+    {
+        std::size_t capacity = flatEvalCapacity(n);
+        if (capacity > m_flat.size()) {
+            flatRehash(capacity);
+        }
+        break;
+    }
+
+    case MAP_TYPE_DENSE:
+    {
+        m_dense.reserve(n);
+        break;
+    }
+
+    default:
+    {
+        m_hash.reserve(n);
+        break;
+    }
+
+    }
+}
+
+/**
+* Exchanges the content of the map by the content of x, which is another
+* map of the same type.
+*
+* \param x Another map of the same type whose content is swapped with that
+* of this map.
+*/
+template<typename id_t>
+void PiercedPositionMap<id_t>::swap(PiercedPositionMap &x) noexcept
+{
+    std::swap(x.m_type, m_type);
+    std::swap(x.m_size, m_size);
+    std::swap(x.m_hash, m_hash);
+    std::swap(x.m_flat, m_flat);
+    std::swap(x.m_flatBits, m_flatBits);
+    std::swap(x.m_dense, m_dense);
+}
+
+/**
+* Applies the specified function to all the entries of the map.
+*
+* Entries are visited in an unspecified order.
+*
+* \param function is the function to apply, it will receive as arguments
+* the id and the position of the entry
+*/
+template<typename id_t>
+template<typename Function>
+void PiercedPositionMap<id_t>::forEach(Function function) const
+{
+    switch (m_type) {
+
+    case MAP_TYPE_FLAT:
+    {
+        for (const FlatSlot &slot : m_flat) {
+            if (slot.id != FLAT_EMPTY_ID) {
+                function(slot.id, slot.pos);
+            }
+        }
+        break;
+    }
+
+    case MAP_TYPE_DENSE:
+    {
+        std::size_t nIds = m_dense.size();
+        for (std::size_t id = 0; id < nIds; ++id) {
+            if (m_dense[id] != NOT_FOUND) {
+                function(static_cast<id_t>(id), m_dense[id]);
+            }
+        }
+        break;
+    }
+
+    default:
+    {
+        for (const auto &entry : m_hash) {
+            function(entry.first, entry.second);
+        }
+        break;
+    }
+
+    }
+}
+
+/**
+* Evaluates the slot of the flat table where the probe sequence of the
+* specified id starts.
+*
+* Fibonacci hashing is used: the id is multiplied by 2^64 divided by the
+* golden ratio and the highest bits of the result are taken. Consecutive
+* ids (or ids with a regular stride) are scattered across the table, this
+* keeps the probe sequences short even when the ids are densely packed.
+*
+* \param id is the id
+* \result The slot where the probe sequence of the specified id starts.
+*/
+template<typename id_t>
+std::size_t PiercedPositionMap<id_t>::flatHome(id_t id) const
+{
+    return static_cast<std::size_t>((static_cast<uint64_t>(id) * UINT64_C(11400714819323198485)) >> (64 - m_flatBits));
+}
+
+/**
+* Finds the slot of the flat table that contains the specified id or, if
+* the id is not in the table, the empty slot where the id should be stored.
+*
+* The table should contain at least one empty slot.
+*
+* \param id is the id
+* \result The slot associated to the specified id.
+*/
+template<typename id_t>
+std::size_t PiercedPositionMap<id_t>::flatFindSlot(id_t id) const
+{
+    std::size_t mask = m_flat.size() - 1;
+    std::size_t slot = flatHome(id);
+    while (true) {
+        id_t slotId = m_flat[slot].id;
+        if (slotId == id || slotId == FLAT_EMPTY_ID) {
+            return slot;
+        }
+
+        slot = (slot + 1) & mask;
+    }
+}
+
+/**
+* Rebuilds the flat table using the specified number of slots.
+*
+* \param capacity is the number of slots, it should be a power of two
+*/
+template<typename id_t>
+void PiercedPositionMap<id_t>::flatRehash(std::size_t capacity)
+{
+    std::vector<FlatSlot> previousSlots(capacity, FlatSlot{FLAT_EMPTY_ID, 0});
+    previousSlots.swap(m_flat);
+
+    m_flatBits = 0;
+    for (std::size_t k = capacity; k > 1; k >>= 1) {
+        ++m_flatBits;
+    }
+
+    for (const FlatSlot &previousSlot : previousSlots) {
+        if (previousSlot.id != FLAT_EMPTY_ID) {
+            m_flat[flatFindSlot(previousSlot.id)] = previousSlot;
+        }
+    }
+}
+
+/**
+* Evaluates the number of slots of the flat table needed to store the
+* specified number of entries while keeping the load factor below 3/4.
+*
+* \param n is the number of entries
+* \result The number of slots needed to store the entries.
+*/
+template<typename id_t>
+std::size_t PiercedPositionMap<id_t>::flatEvalCapacity(std::size_t n) const
+{
+    std::size_t capacity = std::max(FLAT_MIN_CAPACITY, m_flat.size());
+    while (4 * n > 3 * capacity) {
+        capacity *= 2;
+    }
+
+    return capacity;
+}
+
+}
+
+#endif
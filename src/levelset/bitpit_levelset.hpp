@@ -42,6 +42,7 @@
 
 #include "levelSetObject.hpp"
 #include "levelSetMetaObject.hpp"
+#include "levelSetCachedStorage.hpp"
 #include "levelSetCachedObject.hpp"
 #include "levelSetSegmentation.hpp"
 #include "levelSetBoolean.hpp"
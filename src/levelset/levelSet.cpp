@@ -59,6 +59,9 @@ namespace bitpit {
  * The user may set the size of the narrow band explicitly.
  * Alternatively LevelSet will guarantee a least on cell center with exact levelset values across the zero-levelset iso-surface.
  *
+ * Outside the narrow band, the sign of the levelset can be propagated to the whole domain (see setPropagateSign()) and
+ * approximate distances can be obtained extending the narrow band values with a fast marching method (see setExtendDistance()).
+ *
  * LevelSet will test if the underlying mesh can provide a MPI communicator.
  * In case LevelSet is parallelized according the underlying mesh partitioning.
 */
@@ -74,6 +77,7 @@ LevelSet::LevelSet() {
 
     m_signedDF    = true ;
     m_propagateS  = false;
+    m_extendD     = false;
 
 }
 
@@ -499,6 +503,16 @@ void LevelSet::setPropagateSign(bool flag){
     m_propagateS = flag;
 }
 
+/*!
+ * Set if the levelset distance has to be extended from the narrow band to the whole domain.
+ * Outside the narrow band the distance will be approximated using a fast marching method,
+ * see LevelSetCachedObject::extendDistance().
+ * @param[in] flag True/false to active/disable the extension .
+ */
+void LevelSet::setExtendDistance(bool flag){
+    m_extendD = flag;
+}
+
 /*!
  * Manually set the physical size of the narrow band.
  * @param[in] r Size of the narrow band.
@@ -527,6 +541,7 @@ void LevelSet::compute(){
         visitor.exchangeGhosts();
 #endif
         if(m_propagateS) visitor.propagateSign() ;
+        if(m_extendD) visitor.extendDistance() ;
     }
 }
 
@@ -553,6 +568,7 @@ void LevelSet::update( const std::vector<adaption::Info> &mapper ){
         visitor.exchangeGhosts();
 #endif
         if(m_propagateS) visitor.propagateSign() ;
+        if(m_extendD) visitor.extendDistance() ;
     }
 }
 
@@ -613,6 +629,7 @@ void LevelSet::dump( std::ostream &stream ){
     utils::binary::write(stream, m_useNarrowBand);
     utils::binary::write(stream, m_signedDF);
     utils::binary::write(stream, m_propagateS);
+    utils::binary::write(stream, m_extendD);
 
     for( const auto &object : m_objects ){
         object.second->dump( stream ) ;
@@ -629,6 +646,7 @@ void LevelSet::restore( std::istream &stream ){
     utils::binary::read(stream, m_useNarrowBand);
     utils::binary::read(stream, m_signedDF);
     utils::binary::read(stream, m_propagateS);
+    utils::binary::read(stream, m_extendD);
 
     for( const auto &object : m_objects ){
         object.second->restore( stream ) ;
@@ -58,6 +58,7 @@ class LevelSet{
     bool                    m_useNarrowBand;        /**< Flag if user has set size of narrow band (default=false)  */
     bool                    m_signedDF;             /**< Flag for sigend/unsigned distance function (default = true) */
     bool                    m_propagateS;           /**< Flag for sign propagation from narrow band (default = false) */
+    bool                    m_extendD;              /**< Flag for distance extension from narrow band (default = false) */
 
     int                     registerObject( std::unique_ptr<LevelSetObject> && ) ;
     void                    addProcessingOrder(int) ;
@@ -105,6 +106,7 @@ class LevelSet{
 
     void                    setSign(bool);
     void                    setPropagateSign(bool) ;
+    void                    setExtendDistance(bool) ;
 
     void                    dump( std::ostream &);
     void                    restore( std::istream &);
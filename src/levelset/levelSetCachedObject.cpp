@@ -26,9 +26,12 @@
 # include <mpi.h>
 # include "bitpit_communications.hpp"
 # endif
+# include <algorithm>
 # include <stack>
+# include <limits>
 
 # include "bitpit_operators.hpp"
+# include "bitpit_SA.hpp"
 # include "bitpit_CG.hpp"
 # include "bitpit_patchkernel.hpp"
 # include "bitpit_volcartesian.hpp"
@@ -50,10 +53,28 @@ const int LevelSetCachedObject::PROPAGATION_STATUS_REACHED  =   1;
 const int LevelSetCachedObject::PROPAGATION_SIGN_DUMMY     = -2;
 const int LevelSetCachedObject::PROPAGATION_SIGN_UNDEFINED =  0;
 
+const std::size_t LevelSetCachedObject::PROPAGATION_REGION_FIELD_ROOT = 0;
+const std::size_t LevelSetCachedObject::PROPAGATION_REGION_FIELD_SIGN = 1;
+const long LevelSetCachedObject::PROPAGATION_CHUNK_SIZE = 256;
+
+const int LevelSetCachedObject::DISTANCE_STATUS_FAR      = 0;
+const int LevelSetCachedObject::DISTANCE_STATUS_TRIAL    = 1;
+const int LevelSetCachedObject::DISTANCE_STATUS_ACCEPTED = 2;
+const int LevelSetCachedObject::DISTANCE_STATUS_EXACT    = 3;
+
+const double LevelSetCachedObject::CACHE_DENSE_OCCUPANCY  = 0.5;
+const double LevelSetCachedObject::CACHE_SPARSE_OCCUPANCY = 0.25;
+
 /*!
 	@ingroup levelset
 	@interface LevelSetCachedObject
 	@brief Interface class for all objects which need to store the discrete values of levelset function.
+
+	Cached information can be stored in a sparse container, that contains
+	only the cells for which the levelset has been evaluated, or in a dense
+	container synchronized with the cells of the mesh, whose lookups are
+	reads of the slot associated to the raw index of the cell. The storage
+	is chosen according to the cache mode, see setCacheMode().
 */
 
 /*!
@@ -66,7 +87,162 @@ LevelSetCachedObject::~LevelSetCachedObject( ){
  * Constructor
  * @param[in] id id assigned to object
  */
-LevelSetCachedObject::LevelSetCachedObject(int id) : LevelSetObject(id){
+LevelSetCachedObject::LevelSetCachedObject(int id) : LevelSetObject(id), m_cacheMode(LevelSetCacheMode::AUTOMATIC){
+}
+
+/*!
+ * Sets the kernel for the object.
+ * If the kernel changes, dense storage is switched back to sparse storage
+ * before setting the new kernel, then the storage is chosen again.
+ * @param[in] kernel is the LevelSetKernel
+ */
+void LevelSetCachedObject::setKernel(LevelSetKernel *kernel) {
+
+    if (kernel != m_kernelPtr && m_ls.isDense()) {
+        switchCacheStorage(false);
+    }
+
+    LevelSetObject::setKernel(kernel);
+
+    updateCacheStorage();
+}
+
+/*!
+ * Sets the mode used for storing the cached information.
+ *
+ * In automatic mode, dense storage is used when the cells with cached
+ * information are at least half of the cells of the mesh and sparse storage
+ * is restored when they drop below one quarter. The storage is chosen after
+ * the evaluation of the levelset and after the propagation of the sign.
+ *
+ * Dense storage is faster for the internal loops over the cells, such as
+ * sign propagation, because they read the information using the raw index
+ * of the cells. Public lookups (e.g., getLS(), getGradient()) receive the
+ * id of the cell, which has to be looked up in the mesh: in dense storage
+ * their cost is about the same as in sparse storage.
+ *
+ * Dense storage is registered for synchronization with the cells of the
+ * mesh, hence the mesh has to outlive the object. Dense storage is not
+ * available for meshes that don't store their cells or whose cells may be
+ * sent to other processes (values of the sent cells would be lost during
+ * partitioning), for those meshes sparse storage will always be used.
+ * @param[in] mode is the cache mode
+ */
+void LevelSetCachedObject::setCacheMode(LevelSetCacheMode mode) {
+
+    m_cacheMode = mode;
+
+    updateCacheStorage();
+}
+
+/*!
+ * Gets the mode used for storing the cached information.
+ * @return The cache mode.
+ */
+LevelSetCacheMode LevelSetCachedObject::getCacheMode() const {
+    return m_cacheMode;
+}
+
+/*!
+ * Checks if the cached information is stored in dense storage.
+ * @return true if the cached information is stored in dense storage,
+ * false otherwise.
+ */
+bool LevelSetCachedObject::isCacheDense() const {
+    return m_ls.isDense();
+}
+
+/*!
+ * Checks if dense storage can be used for the mesh of the kernel.
+ * @return true if dense storage can be used, false otherwise.
+ */
+bool LevelSetCachedObject::isCacheDenseSupported() const {
+
+    if (!m_kernelPtr) {
+        return false;
+    }
+
+    const VolumeKernel &mesh = *(m_kernelPtr->getMesh()) ;
+    if (mesh.getCells().size() != (std::size_t) mesh.getCellCount()) {
+        return false;
+    }
+
+#if BITPIT_ENABLE_MPI
+    if (mesh.isCommunicatorSet()) {
+        return false;
+    }
+#endif
+
+    return true;
+}
+
+/*!
+ * Chooses the storage of the cached information according to the cache
+ * mode and, in automatic mode, to the fraction of cells with cached
+ * information.
+ */
+void LevelSetCachedObject::updateCacheStorage() {
+
+    bool dense = false;
+    if (isCacheDenseSupported()) {
+        switch (m_cacheMode) {
+
+        case LevelSetCacheMode::SPARSE:
+            dense = false;
+            break;
+
+        case LevelSetCacheMode::DENSE:
+            dense = true;
+            break;
+
+        case LevelSetCacheMode::AUTOMATIC:
+        {
+            long nCells = m_kernelPtr->getMesh()->getCellCount();
+            if (nCells == 0) {
+                dense = m_ls.isDense();
+                break;
+            }
+
+            double occupancy = (double) m_ls.size() / nCells;
+            if (m_ls.isDense()) {
+                dense = (occupancy >= CACHE_SPARSE_OCCUPANCY);
+            } else {
+                dense = (occupancy >= CACHE_DENSE_OCCUPANCY);
+            }
+            break;
+        }
+
+        }
+    }
+
+    if (dense != m_ls.isDense()) {
+        switchCacheStorage(dense);
+    }
+}
+
+/*!
+ * Switches the storage of the cached information.
+ * @param[in] dense if set to true, cached information will be moved into
+ * dense storage, otherwise it will be moved into sparse storage
+ */
+void LevelSetCachedObject::switchCacheStorage(bool dense) {
+
+    if (dense) {
+        m_ls.setDense(&(m_kernelPtr->getMesh()->getCells()));
+    } else {
+        m_ls.setSparse();
+    }
+
+    __switchCacheStorage(dense);
+}
+
+/*!
+ * Switches the storage of the cached information of derived classes.
+ * @param[in] dense if set to true, cached information will be moved into
+ * dense storage, otherwise it will be moved into sparse storage
+ */
+void LevelSetCachedObject::__switchCacheStorage(bool dense) {
+    BITPIT_UNUSED(dense);
 }
 
 /*!
@@ -76,15 +252,37 @@ LevelSetCachedObject::LevelSetCachedObject(int id) : LevelSetObject(id){
 */
 LevelSetInfo LevelSetCachedObject::getLevelSetInfo( long i)const{
 
-    auto itr = m_ls.find(i);
-    if ( itr == m_ls.end() ){
+    const LevelSetInfo *info = m_ls.find(i);
+    if ( !info ){
         return LevelSetInfo();
     }
 
-    return *itr;
+    return *info;
 
 } 
 
+/*!
+ * Gets a constant pointer to the levelset information cached for the
+ * specified cell.
+ *
+ * In dense storage the information is read from the slot associated to
+ * the raw index of the cell, hence the id of the cell doesn't need to be
+ * looked up. In sparse storage the information is searched using the id.
+ * @param[in] id is the id of the cell
+ * @param[in] rawIndex is the raw index of the cell in the mesh
+ * @return A constant pointer to the information cached for the cell, if
+ * no information is cached for the cell a null pointer is returned.
+ */
+const LevelSetInfo * LevelSetCachedObject::findLevelSetInfo( long id, std::size_t rawIndex ) const {
+
+    if ( m_ls.isDense() ){
+        return m_ls.rawFind(rawIndex);
+    }
+
+    return m_ls.find(id);
+
+}
+
 /*!
  * Get the levelset value of cell
  * @param[in] i cell index
@@ -92,12 +290,12 @@ LevelSetInfo LevelSetCachedObject::getLevelSetInfo( long i)const{
  */
 double LevelSetCachedObject::getLS( long i)const {
 
-    auto itr = m_ls.find(i);
-    if ( itr == m_ls.end() ){
+    const LevelSetInfo *info = m_ls.find(i);
+    if ( !info ){
         return levelSetDefaults::VALUE;
     }
 
-    return itr->value;
+    return info->value;
 
 }
 
@@ -108,12 +306,12 @@ double LevelSetCachedObject::getLS( long i)const {
  */
 std::array<double,3> LevelSetCachedObject::getGradient(long i) const {
 
-    auto itr = m_ls.find(i);
-    if ( itr == m_ls.end() ){
+    const LevelSetInfo *info = m_ls.find(i);
+    if ( !info ){
         return levelSetDefaults::GRADIENT;
     }
 
-    return itr->gradient;
+    return info->gradient;
 
 }
 
@@ -131,8 +329,14 @@ void LevelSetCachedObject::_clearAfterMeshAdaption( const std::vector<adaption::
                 map.type == adaption::Type::TYPE_COARSENING  ){
 
                 for ( auto & parent : map.previous){
-                    if( m_ls.exists(parent) ) 
-                        m_ls.erase(parent,true) ;
+                    m_ls.erase(parent) ;
+                }
+            }
+
+            // Slots of the new cells in dense storage may contain stale data
+            if( m_ls.isDense() && map.type != adaption::Type::TYPE_RENUMBERING ){
+                for ( long child : map.current){
+                    m_ls.erase(child) ;
                 }
             }
         }
@@ -214,8 +418,9 @@ void LevelSetCachedObject::propagateSign() {
         int &cellPropagationStatus = propagationStatus.rawAt(cellRawId);
 
         int cellSign;
-        if (m_ls.find(cellId) != m_ls.end()) {
-            cellSign = getSign(cellId);
+        const LevelSetInfo *cellInfo = findLevelSetInfo(cellId, cellRawId);
+        if (cellInfo) {
+            cellSign = static_cast<int>(sign(cellInfo->value));
         } else {
             cellSign = PROPAGATION_SIGN_UNDEFINED;
         }
@@ -232,8 +437,16 @@ void LevelSetCachedObject::propagateSign() {
         externalSign = PROPAGATION_SIGN_DUMMY;
     }
 
+    // Identify the regions of connected cells waiting for the propagation
+    //
+    // The sign is constant within each region, hence it can be propagated
+    // assigning the sign of the seeds to their adjacent regions.
+    std::vector<std::size_t> waitingRawIds;
+    PiercedStorage<long, long> propagationRegions(2, &cells);
+    labelSignRegions(propagationStatus, &waitingRawIds, &propagationRegions);
+
     // Use the seeds to propagate the sign
-    propagateSeedSign(seeds, &propagationStatus, &nWaiting, &externalSign);
+    propagateSeedSign(seeds, &propagationStatus, &waitingRawIds, &propagationRegions, &nWaiting, &externalSign);
 
 #if BITPIT_ENABLE_MPI
     // If there are cells with an unknown sign, data communication among
@@ -316,7 +529,7 @@ void LevelSetCachedObject::propagateSign() {
                     int &cellPropagationStatus = propagationStatus.rawAt(cellRawId);
                     if (cellPropagationStatus == PROPAGATION_STATUS_WAITING) {
                         // Set the sign
-                        setSign(cellId, sign);
+                        setSign(cellId, cellRawId, sign);
 
                         // Initialize sign propagation
                         initializeCellSignPropagation(cellId, sign, boxMin, boxMax,
@@ -331,7 +544,7 @@ void LevelSetCachedObject::propagateSign() {
             }
 
             if (seeds.size() > 0) {
-                propagateSeedSign(seeds, &propagationStatus, &nWaiting, &externalSign);
+                propagateSeedSign(seeds, &propagationStatus, &waitingRawIds, &propagationRegions, &nWaiting, &externalSign);
             }
 
             // Wait to the sends to finish
@@ -389,11 +602,14 @@ void LevelSetCachedObject::propagateSign() {
         }
 
         long cellId = itr.getId();
-        setSign(cellId, externalSign);
+        setSign(cellId, cellRawId, externalSign);
         --nExternal;
     }
 
     assert(nExternal == 0);
+
+    // Choose the storage of the cached information
+    updateCacheStorage();
 }
 
 /*!
@@ -474,10 +690,180 @@ void LevelSetCachedObject::initializeCellSignPropagation(long cellId, int cellSi
     }
 }
 
+/*!
+ * Identifies the regions of connected cells that are waiting for the
+ * propagation of the sign.
+ *
+ * Regions are identified with a concurrent union-find over the adjacencies
+ * of the waiting cells: each waiting cell starts as a separate region, then
+ * the regions of adjacent waiting cells are merged. Merges only link a root
+ * to a root with a lower index, therefore they can be performed by multiple
+ * threads using atomic compare-and-swap operations. Regions are represented
+ * by the raw index of one of their cells (the root of the region).
+ *
+ * \param statuses contains the flags that defines the propagation status of
+ * the cells
+ * \param[out] waitingRawIds on output will contain the raw indexes of the
+ * cells waiting for the propagation
+ * \param[out] regions on output will contain, for each waiting cell, the
+ * raw index of the root of its region (PROPAGATION_REGION_FIELD_ROOT field)
+ * and an undefined sign (PROPAGATION_REGION_FIELD_SIGN field). Only the sign
+ * stored for the roots is meaningful and it represents the sign of the whole
+ * region
+ */
+void LevelSetCachedObject::labelSignRegions(const PiercedStorage<int, long> &statuses,
+                                            std::vector<std::size_t> *waitingRawIds,
+                                            PiercedStorage<long, long> *regions) {
+
+    VolumeKernel const &mesh = *(m_kernelPtr->getMesh()) ;
+    const PiercedVector<Cell> &cells = mesh.getCells();
+
+    VolumeKernel::CellConstIterator cellBegin = mesh.cellConstBegin();
+    VolumeKernel::CellConstIterator cellEnd   = mesh.cellConstEnd();
+
+    // List the waiting cells
+    //
+    // While the regions are being identified, the root field contains the
+    // position of the cell in the list of waiting cells.
+    waitingRawIds->clear();
+    for (auto itr = cellBegin; itr != cellEnd; ++itr) {
+        std::size_t cellRawId = itr.getRawIndex();
+        if (statuses.rawAt(cellRawId) != PROPAGATION_STATUS_WAITING) {
+            continue;
+        }
+
+        regions->rawAt(cellRawId, PROPAGATION_REGION_FIELD_ROOT) = waitingRawIds->size();
+        waitingRawIds->push_back(cellRawId);
+    }
+
+    long nWaitingCells = waitingRawIds->size();
+    if (nWaitingCells == 0) {
+        return;
+    }
+
+    // Merge the regions of adjacent waiting cells
+    //
+    // Adjacencies are symmetric, each pair of cells is considered only from
+    // the cell with the lower position.
+    std::unique_ptr<std::atomic<long>[]> parents(new std::atomic<long>[nWaitingCells]);
+
+#if BITPIT_ENABLE_OPENMP==1
+    #pragma omp parallel for schedule(static)
+#endif
+    for (long n = 0; n < nWaitingCells; ++n) {
+        parents[n].store(n, std::memory_order_relaxed);
+    }
+
+#if BITPIT_ENABLE_OPENMP==1
+    #pragma omp parallel for schedule(dynamic, PROPAGATION_CHUNK_SIZE)
+#endif
+    for (long n = 0; n < nWaitingCells; ++n) {
+        const Cell &cell = cells.rawAt((*waitingRawIds)[n]);
+        const long *cellNeighs = cell.getAdjacencies() ;
+        int nCellNeighs = cell.getAdjacencyCount() ;
+        for (int k = 0; k < nCellNeighs; ++k) {
+            long neighId = cellNeighs[k];
+            if (neighId == Element::NULL_ID) {
+                continue;
+            }
+
+            std::size_t neighRawId = cells.getRawIndex(neighId);
+            if (statuses.rawAt(neighRawId) != PROPAGATION_STATUS_WAITING) {
+                continue;
+            }
+
+            long neighPosition = regions->rawAt(neighRawId, PROPAGATION_REGION_FIELD_ROOT);
+            if (neighPosition <= n) {
+                continue;
+            }
+
+            mergeSignRegions(parents.get(), n, neighPosition);
+        }
+    }
+
+    // Store the roots of the regions
+#if BITPIT_ENABLE_OPENMP==1
+    #pragma omp parallel for schedule(static)
+#endif
+    for (long n = 0; n < nWaitingCells; ++n) {
+        std::size_t cellRawId = (*waitingRawIds)[n];
+        long rootPosition = findSignRegionRoot(parents.get(), n);
+
+        regions->rawAt(cellRawId, PROPAGATION_REGION_FIELD_ROOT) = (*waitingRawIds)[rootPosition];
+        regions->rawAt(cellRawId, PROPAGATION_REGION_FIELD_SIGN) = PROPAGATION_SIGN_UNDEFINED;
+    }
+}
+
+/*!
+ * Finds the root of the region that contains the specified element of a
+ * concurrent union-find.
+ *
+ * The path from the element to the root is halved while it is traversed,
+ * since parents can only be moved toward the root, the update is safe even
+ * if other threads are modifying the same path.
+ *
+ * \param parents are the parents of the elements of the union-find
+ * \param n is the element
+ * \result The root of the region that contains the element.
+ */
+long LevelSetCachedObject::findSignRegionRoot(std::atomic<long> *parents, long n) {
+
+    while (true) {
+        long parent = parents[n].load(std::memory_order_relaxed);
+        if (parent == n) {
+            return n;
+        }
+
+        long grandParent = parents[parent].load(std::memory_order_relaxed);
+        if (grandParent != parent) {
+            parents[n].compare_exchange_weak(parent, grandParent, std::memory_order_relaxed);
+        }
+
+        n = grandParent;
+    }
+}
+
+/*!
+ * Merges the regions that contain the specified elements of a concurrent
+ * union-find.
+ *
+ * The root with the higher index is linked to the root with the lower index,
+ * the link is created only if the root is still a root, otherwise the roots
+ * are searched again.
+ *
+ * \param parents are the parents of the elements of the union-find
+ * \param n is the first element
+ * \param m is the second element
+ */
+void LevelSetCachedObject::mergeSignRegions(std::atomic<long> *parents, long n, long m) {
+
+    while (true) {
+        n = findSignRegionRoot(parents, n);
+        m = findSignRegionRoot(parents, m);
+        if (n == m) {
+            return;
+        } else if (n < m) {
+            std::swap(n, m);
+        }
+
+        long expected = n;
+        if (parents[n].compare_exchange_strong(expected, m)) {
+            return;
+        }
+    }
+}
+
 /*!
  * Propagates the sign of the signed distance function from the specified
  * seeds to all reachable cells whose sign has not yet been assigned.
  *
+ * Each seed assigns its sign to the regions of waiting cells it is adjacent
+ * to, seeds are processed in reverse order and a region takes the sign of
+ * the first seed that reaches it. The sign of the regions is then assigned
+ * to their cells: the sign of the cells is evaluated concurrently, whereas
+ * it is stored serially, because the cached information can't be updated
+ * concurrently.
+ *
  * The sign will NOT be propagated into cells flagged with the "EXTERNAL"
  * status (i.e., cells outside the bounding box of all the objects). When
  * the propagation reaches the external region it can be stopped, the sign
@@ -488,6 +874,12 @@ void LevelSetCachedObject::initializeCellSignPropagation(long cellId, int cellSi
  * \param[in,out] statuses contains the flags that defines the propagation
  * status of the cells. On output, this flag will be updated with the new
  * propagation statuses
+ * \param[in,out] waitingRawIds contains the raw indexes of the cells that
+ * may be waiting for the propagation. On output, cells reached by the
+ * propagation will be removed from the list
+ * \param[in,out] regions contains the regions of the waiting cells (see
+ * labelSignRegions()). On output, the regions reached by the propagation
+ * will be updated with their sign
  * \param[in,out] nWaiting is the number of cells that are waiting for the
  * propagation to reach them. On output, this number will be updated so it's
  * possible to keep track of the cells whose sign is not yet assigned
@@ -497,79 +889,412 @@ void LevelSetCachedObject::initializeCellSignPropagation(long cellId, int cellSi
  */
 void LevelSetCachedObject::propagateSeedSign(const std::vector<long> &seeds,
                                              PiercedStorage<int, long> *statuses,
+                                             std::vector<std::size_t> *waitingRawIds,
+                                             PiercedStorage<long, long> *regions,
                                              long *nWaiting, int *externalSign) {
 
     VolumeKernel const &mesh = *(m_kernelPtr->getMesh()) ;
+    const PiercedVector<Cell> &cells = mesh.getCells();
 
-    std::vector<long> processList;
+    // Assign the sign of the seeds to the adjacent regions
+    //
+    // When a seed is adjacent to an external cell, the sign of the seed
+    // will be the sign of the external region.
+    long nReachedRegions = 0;
 
     std::size_t seedCursor = seeds.size();
     while (seedCursor != 0) {
-        // Get a seed
         --seedCursor;
         long seedId = seeds[seedCursor];
-
-        // Get the sign of the seed
         int seedSign = getSign(seedId);
 
-        // Initialize the process list with the seed
-        processList.resize(1);
-        processList[0] = seedId;
-
-        // Propagate the sign
-        while (!processList.empty()) {
-            long cellId = processList.back();
-            processList.resize(processList.size() - 1);
-
-            // Process non-seed cells
-            bool isSeed = (cellId == seedId);
-            if (!isSeed) {
-                // Consider only cells waiting for the propagation to reach them
-                //
-                // The process list is not unique, it can contain duplicate, so
-                // we need to make sure not to process a cell multiple times.
-                int &cellStatus = statuses->at(cellId);
-                if (cellStatus != PROPAGATION_STATUS_WAITING) {
-                    continue;
+        const Cell &seed = cells.at(seedId);
+        const long *seedNeighs = seed.getAdjacencies() ;
+        int nSeedNeighs = seed.getAdjacencyCount() ;
+        for (int k = 0; k < nSeedNeighs; ++k) {
+            long neighId = seedNeighs[k];
+            if (neighId == Element::NULL_ID) {
+                continue;
+            }
+
+            std::size_t neighRawId = cells.getRawIndex(neighId);
+            int neighStatus = statuses->rawAt(neighRawId);
+            if (neighStatus == PROPAGATION_STATUS_WAITING) {
+                std::size_t rootRawId = regions->rawAt(neighRawId, PROPAGATION_REGION_FIELD_ROOT);
+                long &regionSign = regions->rawAt(rootRawId, PROPAGATION_REGION_FIELD_SIGN);
+                if (regionSign == PROPAGATION_SIGN_UNDEFINED) {
+                    regionSign = seedSign;
+                    ++nReachedRegions;
+                }
+            } else if (neighStatus == PROPAGATION_STATUS_EXTERNAL) {
+                // If the sign of the external region is unknown it can
+                // be assigned, otherwise check if the current sign is
+                // consistent with the previously evaluated sign.
+                if (*externalSign == PROPAGATION_SIGN_UNDEFINED) {
+                    *externalSign = seedSign;
+                } else if (*externalSign != seedSign) {
+                    throw std::runtime_error("Mismatch in sign of external region!");
+                }
+            }
+        }
+    }
+
+    if (nReachedRegions == 0) {
+        return;
+    }
+
+    // Evaluate the sign of the waiting cells
+    //
+    // Cells of the reached regions that are adjacent to an external cell
+    // define the sign of the external region.
+    long nWaitingCells = waitingRawIds->size();
+    std::vector<int> cellSigns(nWaitingCells);
+
+    bool positiveExternal = false;
+    bool negativeExternal = false;
+
+#if BITPIT_ENABLE_OPENMP==1
+    #pragma omp parallel for schedule(dynamic, PROPAGATION_CHUNK_SIZE) reduction(||:positiveExternal,negativeExternal)
+#endif
+    for (long n = 0; n < nWaitingCells; ++n) {
+        std::size_t cellRawId = (*waitingRawIds)[n];
+        if (statuses->rawAt(cellRawId) != PROPAGATION_STATUS_WAITING) {
+            cellSigns[n] = PROPAGATION_SIGN_UNDEFINED;
+            continue;
+        }
+
+        std::size_t rootRawId = regions->rawAt(cellRawId, PROPAGATION_REGION_FIELD_ROOT);
+        int cellSign = regions->rawAt(rootRawId, PROPAGATION_REGION_FIELD_SIGN);
+        cellSigns[n] = cellSign;
+        if (cellSign == PROPAGATION_SIGN_UNDEFINED) {
+            continue;
+        }
+
+        const Cell &cell = cells.rawAt(cellRawId);
+        const long *cellNeighs = cell.getAdjacencies() ;
+        int nCellNeighs = cell.getAdjacencyCount() ;
+        for (int k = 0; k < nCellNeighs; ++k) {
+            long neighId = cellNeighs[k];
+            if (neighId == Element::NULL_ID) {
+                continue;
+            }
+
+            std::size_t neighRawId = cells.getRawIndex(neighId);
+            if (statuses->rawAt(neighRawId) == PROPAGATION_STATUS_EXTERNAL) {
+                if (cellSign > 0) {
+                    positiveExternal = true;
+                } else {
+                    negativeExternal = true;
                 }
+            }
+        }
+    }
+
+    // Set the sign of the reached cells
+    for (long n = 0; n < nWaitingCells; ++n) {
+        int cellSign = cellSigns[n];
+        if (cellSign == PROPAGATION_SIGN_UNDEFINED) {
+            continue;
+        }
+
+        std::size_t cellRawId = (*waitingRawIds)[n];
+        setSign(cells.rawAt(cellRawId).getId(), cellRawId, cellSign);
+        statuses->rawAt(cellRawId) = PROPAGATION_STATUS_REACHED;
+        --(*nWaiting);
+    }
+
+    // Remove the reached cells from the list of waiting cells
+    auto waitingEnd = std::remove_if(waitingRawIds->begin(), waitingRawIds->end(),
+                                     [statuses](std::size_t cellRawId) {
+                                         return (statuses->rawAt(cellRawId) != PROPAGATION_STATUS_WAITING);
+                                     });
+    waitingRawIds->erase(waitingEnd, waitingRawIds->end());
+
+    // Update the sign of the external region
+    //
+    // If the sign of the external region is unknown it can be assigned,
+    // otherwise check if the current sign is consistent with the previously
+    // evaluated sign.
+    if (*externalSign == PROPAGATION_SIGN_DUMMY || (!positiveExternal && !negativeExternal)) {
+        return;
+    }
+
+    int reachedExternalSign = (positiveExternal ? 1 : -1);
+    if (positiveExternal && negativeExternal) {
+        throw std::runtime_error("Mismatch in sign of external region!");
+    } else if (*externalSign == PROPAGATION_SIGN_UNDEFINED) {
+        *externalSign = reachedExternalSign;
+    } else if (*externalSign != reachedExternalSign) {
+        throw std::runtime_error("Mismatch in sign of external region!");
+    }
+}
+
+/*!
+ * Checks if the levelset of the specified cell has been evaluated exactly,
+ * i.e., if the cell belongs to the narrow band. Cells that only store the
+ * sign of the levelset are not considered exact.
+ *
+ * \param id is the id of the cell
+ * \result Returns true if the levelset of the cell has been evaluated
+ * exactly, false otherwise.
+ */
+bool LevelSetCachedObject::isDistanceExact(long id) const {
+
+    const LevelSetInfo *info = m_ls.find(id);
+    if (!info) {
+        return false;
+    }
+
+    return (std::abs(info->value) < levelSetDefaults::VALUE);
+}
 
-                // Set the sign of the cell
-                setSign(cellId, seedSign);
-                cellStatus = PROPAGATION_STATUS_REACHED;
-                --(*nWaiting);
+/*!
+ * Extends the distance from the narrow band to the entire domain.
+ *
+ * The distance of the cells outside the narrow band is evaluated with a
+ * fast marching method: cells are accepted in order of increasing distance
+ * using a min priority queue, each accepted cell passes to its neighbours
+ * the closest point on the surface it has been reached from (initially the
+ * projection point of the narrow band cells) and the neighbours evaluate
+ * their tentative distance as the distance between their centroid and that
+ * point. The sign of the levelset is propagated together with the closest
+ * point. The method works on any mesh that provides cell adjacencies and
+ * its cost is O(N log N). A tentative distance is updated only when it
+ * decreases, if this happens for an accepted cell the cell is evaluated
+ * again. Since the closest point is only passed among face neighbours, the
+ * distance is an upper bound of the exact one and its error is a fraction
+ * of the cell size.
+ *
+ * On partitioned meshes, the distances of the ghost cells are exchanged
+ * among the processes and the marching is restarted from the ghosts whose
+ * distance has decreased, until the distances of all the processes don't
+ * change anymore.
+ *
+ * The distance of the cells in the narrow band is not modified.
+ */
+void LevelSetCachedObject::extendDistance() {
 
-                // If there are no more waiting cells and we have detected the
-                // sign of the external region we can exit
-                if (*nWaiting == 0 && *externalSign != PROPAGATION_SIGN_UNDEFINED) {
-                    return;
+    VolumeKernel const &mesh = *(m_kernelPtr->getMesh()) ;
+    const PiercedVector<Cell> &cells = mesh.getCells();
+
+    VolumeKernel::CellConstIterator cellBegin = mesh.cellConstBegin();
+    VolumeKernel::CellConstIterator cellEnd   = mesh.cellConstEnd();
+
+    // Initialize the fast marching
+    //
+    // Cells in the narrow band are inserted in the heap and will be used
+    // to initialize the distance of their neighbours.
+    PiercedStorage<DistanceExtensionInfo, long> infos(1, &cells);
+
+    std::vector<std::array<int,2>> heapMap(cells.capacity());
+    MinPQueue<double, long> heap(mesh.getCellCount(), true, &heapMap);
+
+    for (auto itr = cellBegin; itr != cellEnd; ++itr) {
+        long cellId = itr.getId();
+        std::size_t cellRawId = itr.getRawIndex();
+
+        DistanceExtensionInfo &info = infos.rawAt(cellRawId);
+        if (isDistanceExact(cellId)) {
+            info.status   = DISTANCE_STATUS_EXACT;
+            info.sign     = getSign(cellId);
+            info.distance = std::abs(getLS(cellId));
+            info.root     = computeProjectionPoint(cellId);
+
+            pushDistanceTrial(cellRawId, &info, &heap, &heapMap);
+        } else {
+            info.status   = DISTANCE_STATUS_FAR;
+            info.sign     = levelSetDefaults::SIGN;
+            info.distance = std::numeric_limits<double>::max();
+            info.root     = levelSetDefaults::POINT;
+        }
+    }
+
+    // March the distance
+    marchDistance(&infos, &heap, &heapMap);
+
+#if BITPIT_ENABLE_MPI
+    // Exchange the distance of the ghosts
+    //
+    // If the distance received for a ghost is lower than the one evaluated
+    // locally, the ghost is used to restart the marching.
+    if (mesh.isPartitioned()) {
+        DataCommunicator dataCommunicator(m_kernelPtr->getCommunicator());
+
+        std::size_t dataSize = 4 * sizeof(double) + sizeof(int);
+
+        for (const auto &entry : mesh.getGhostExchangeTargets()) {
+            dataCommunicator.setRecv(entry.first, entry.second.size() * dataSize);
+        }
+
+        for (const auto &entry : mesh.getGhostExchangeSources()) {
+            dataCommunicator.setSend(entry.first, entry.second.size() * dataSize);
+        }
+
+        long nGlobalUpdates;
+        do {
+            for (const auto &entry : mesh.getGhostExchangeTargets()) {
+                dataCommunicator.startRecv(entry.first);
+            }
+
+            for (const auto &entry : mesh.getGhostExchangeSources()) {
+                const int rank = entry.first;
+                SendBuffer &buffer = dataCommunicator.getSendBuffer(rank);
+                for (long cellId : entry.second) {
+                    const DistanceExtensionInfo &info = infos.at(cellId);
+                    buffer << info.distance;
+                    buffer << info.root;
+                    buffer << info.sign;
                 }
+
+                dataCommunicator.startSend(rank);
             }
 
-            // Process cell neighbours
-            //
-            // If a neighbour is waiting for the propagation, add it to the
-            // process list. When the propagation reaches an external cell
-            // the sign of the seed frow which the propagation started will
-            // be the sign of the external region.
-            const Cell &cell = mesh.getCell(cellId);
-            const long *cellNeighs = cell.getAdjacencies() ;
-            int nCellNeighs = cell.getAdjacencyCount() ;
-            for(int n = 0; n < nCellNeighs; ++n){
-                long neighId = cellNeighs[n] ;
-                int neighStatus = statuses->at(neighId);
-                if (neighStatus == PROPAGATION_STATUS_WAITING) {
-                    processList.push_back(neighId);
-                } else if (neighStatus == PROPAGATION_STATUS_EXTERNAL) {
-                    // If the sign of the external region is unknown it can
-                    // be assigned, otherwise check if the current sign is
-                    // consistent with the previously evaluated sign.
-                    if (*externalSign == PROPAGATION_SIGN_UNDEFINED) {
-                        *externalSign = seedSign;
-                    } else if (*externalSign != seedSign) {
-                        throw std::runtime_error("Mismatch in sign of external region!");
+            long nUpdates = 0;
+            int nCompletedRecvs = 0;
+            while (nCompletedRecvs < dataCommunicator.getRecvCount()) {
+                int rank = dataCommunicator.waitAnyRecv();
+                RecvBuffer &buffer = dataCommunicator.getRecvBuffer(rank);
+                for (long cellId : mesh.getGhostExchangeTargets(rank)) {
+                    double distance;
+                    std::array<double,3> root;
+                    int sign;
+                    buffer >> distance;
+                    buffer >> root;
+                    buffer >> sign;
+
+                    std::size_t cellRawId = cells.getRawIndex(cellId);
+                    DistanceExtensionInfo &info = infos.rawAt(cellRawId);
+                    if (info.status == DISTANCE_STATUS_EXACT || distance >= info.distance) {
+                        continue;
                     }
+
+                    info.distance = distance;
+                    info.root     = root;
+                    info.sign     = sign;
+                    pushDistanceTrial(cellRawId, &info, &heap, &heapMap);
+                    ++nUpdates;
                 }
+
+                ++nCompletedRecvs;
+            }
+
+            dataCommunicator.waitAllSends();
+
+            marchDistance(&infos, &heap, &heapMap);
+
+            nGlobalUpdates = nUpdates;
+            MPI_Allreduce(MPI_IN_PLACE, &nGlobalUpdates, 1, MPI_LONG, MPI_SUM, m_kernelPtr->getCommunicator());
+        } while (nGlobalUpdates != 0);
+    }
+#endif
+
+    // Store the distance of the cells outside the narrow band
+    for (auto itr = cellBegin; itr != cellEnd; ++itr) {
+        const DistanceExtensionInfo &info = infos.rawAt(itr.getRawIndex());
+        if (info.status != DISTANCE_STATUS_ACCEPTED) {
+            continue;
+        }
+
+        long cellId = itr.getId();
+        const std::array<double,3> &centroid = m_kernelPtr->computeCellCentroid(cellId);
+
+        LevelSetInfo &lsInfo = m_ls.findOrEmplace(cellId);
+        lsInfo.value    = info.sign * info.distance;
+        lsInfo.gradient = (double) info.sign / info.distance * (centroid - info.root);
+    }
+
+#if BITPIT_ENABLE_MPI
+    // Make the ghosts consistent with their owners
+    if (mesh.isPartitioned()) {
+        exchangeGhosts();
+    }
+#endif
+
+    // Choose the storage of the cached information
+    updateCacheStorage();
+}
+
+/*!
+ * Inserts the specified cell in the heap of the fast marching, if the
+ * cell is already in the heap its key is updated.
+ *
+ * \param rawId is the raw index of the cell
+ * \param[in,out] info is the fast marching information of the cell, the
+ * distance should already be updated, on output the status will be updated
+ * \param[in,out] heap is the heap of the fast marching
+ * \param[in,out] heapMap is the map between the heap and the cells
+ */
+void LevelSetCachedObject::pushDistanceTrial(long rawId, DistanceExtensionInfo *info,
+                                             MinPQueue<double, long> *heap,
+                                             std::vector<std::array<int,2>> *heapMap) {
+
+    if (info->status == DISTANCE_STATUS_TRIAL) {
+        heap->modify((*heapMap)[rawId][1], info->distance, rawId);
+        return;
+    }
+
+    if (info->status != DISTANCE_STATUS_EXACT) {
+        info->status = DISTANCE_STATUS_TRIAL;
+    }
+
+    (*heapMap)[heap->heap_size][0] = rawId;
+    (*heapMap)[rawId][1] = heap->heap_size;
+    heap->insert(info->distance, rawId);
+}
+
+/*!
+ * Accepts the cells in the heap in order of increasing distance, updating
+ * the tentative distance of their neighbours, until the heap is empty.
+ *
+ * \param[in,out] infos is the fast marching information of the cells
+ * \param[in,out] heap is the heap of the fast marching
+ * \param[in,out] heapMap is the map between the heap and the cells
+ */
+void LevelSetCachedObject::marchDistance(PiercedStorage<DistanceExtensionInfo, long> *infos,
+                                         MinPQueue<double, long> *heap,
+                                         std::vector<std::array<int,2>> *heapMap) {
+
+    VolumeKernel const &mesh = *(m_kernelPtr->getMesh()) ;
+    const PiercedVector<Cell> &cells = mesh.getCells();
+
+    while (heap->heap_size > 0) {
+        // Accept the cell with the lowest distance
+        double distance;
+        long rawId = -1;
+        heap->extract(distance, rawId);
+
+        DistanceExtensionInfo &info = infos->rawAt(rawId);
+        if (info.status == DISTANCE_STATUS_TRIAL) {
+            info.status = DISTANCE_STATUS_ACCEPTED;
+        }
+
+        // Update the tentative distance of the neighbours
+        const Cell &cell = cells.rawAt(rawId);
+        const long *cellNeighs = cell.getAdjacencies() ;
+        int nCellNeighs = cell.getAdjacencyCount() ;
+        for (int n = 0; n < nCellNeighs; ++n) {
+            long neighId = cellNeighs[n];
+            if (neighId == Element::NULL_ID) {
+                continue;
+            }
+
+            std::size_t neighRawId = cells.getRawIndex(neighId);
+
+            DistanceExtensionInfo &neighInfo = infos->rawAt(neighRawId);
+            if (neighInfo.status == DISTANCE_STATUS_EXACT) {
+                continue;
             }
+
+            const std::array<double,3> &neighCentroid = m_kernelPtr->computeCellCentroid(neighId);
+            double neighDistance = norm2(neighCentroid - info.root);
+            if (neighDistance >= neighInfo.distance) {
+                continue;
+            }
+
+            neighInfo.distance = neighDistance;
+            neighInfo.root     = info.root;
+            neighInfo.sign     = info.sign;
+            pushDistanceTrial(neighRawId, &neighInfo, heap, heapMap);
         }
     }
 }
@@ -587,14 +1312,33 @@ void LevelSetCachedObject::setSign(long id, int sign) {
         return;
     }
 
-    // Get the info associated to the id
-    PiercedVector<LevelSetInfo>::iterator infoItr = m_ls.find(id);
-    if (infoItr == m_ls.end()){
-        infoItr = m_ls.emplace(id);
+    // Update the sign
+    m_ls.findOrEmplace(id).value = sign * levelSetDefaults::VALUE;
+}
+
+/*!
+ * Set the sign of the specified cell.
+ *
+ * In dense storage the sign is written in the slot associated to the raw
+ * index of the cell, in sparse storage it is set using the id of the cell.
+ *
+ * \param id is the id of the cell
+ * \param rawIndex is the raw index of the cell in the mesh
+ * \param sign is the sign that will be assiged to the cell
+ */
+void LevelSetCachedObject::setSign(long id, std::size_t rawIndex, int sign) {
+
+    // The sign has to be set only if it is different from the default sign
+    if (sign == levelSetDefaults::SIGN) {
+        return;
     }
 
     // Update the sign
-    (*infoItr).value = sign * levelSetDefaults::VALUE;
+    if (m_ls.isDense()) {
+        m_ls.rawFindOrEmplace(rawIndex).value = sign * levelSetDefaults::VALUE;
+    } else {
+        m_ls.findOrEmplace(id).value = sign * levelSetDefaults::VALUE;
+    }
 }
 
 /*!
@@ -604,13 +1348,11 @@ void LevelSetCachedObject::setSign(long id, int sign) {
 void LevelSetCachedObject::_dump( std::ostream &stream ){
 
     utils::binary::write(stream, (long) m_ls.size() ) ;
-    bitpit::PiercedVector<LevelSetInfo>::iterator   infoItr, infoEnd = m_ls.end() ;
-
-    for( infoItr=m_ls.begin(); infoItr!=infoEnd; ++infoItr){
-        utils::binary::write(stream, infoItr.getId()) ;
-        utils::binary::write(stream, infoItr->value) ;
-        utils::binary::write(stream, infoItr->gradient) ;
-    }
+    m_ls.forEach([&stream](long id, const LevelSetInfo &info){
+        utils::binary::write(stream, id) ;
+        utils::binary::write(stream, info.value) ;
+        utils::binary::write(stream, info.gradient) ;
+    });
 
     __dump(stream) ;
 }
@@ -639,7 +1381,7 @@ void LevelSetCachedObject::_restore( std::istream &stream ){
         utils::binary::read(stream, id) ;
         utils::binary::read(stream, cellInfo.value) ;
         utils::binary::read(stream, cellInfo.gradient) ;
-        m_ls.insert(id, cellInfo) ;
+        m_ls.findOrEmplace(id) = cellInfo ;
     }
 
     __restore(stream) ;
@@ -677,11 +1419,11 @@ void LevelSetCachedObject::_writeCommunicationBuffer( const std::vector<long> &s
 
     long index = 0;
     for( long id : sendList){
-        auto lsInfoItr = m_ls.find(id) ;
-        if( lsInfoItr != m_ls.end() ){
+        const LevelSetInfo *lsInfo = m_ls.find(id) ;
+        if( lsInfo ){
             dataBuffer << index ;
-            dataBuffer << lsInfoItr->value ;
-            dataBuffer << lsInfoItr->gradient ;
+            dataBuffer << lsInfo->value ;
+            dataBuffer << lsInfo->gradient ;
         }
         ++index ;
     }
@@ -716,13 +1458,9 @@ void LevelSetCachedObject::_readCommunicationBuffer( const std::vector<long> &re
         long id = recvList[index] ;
 
         // Assign the data of the element
-        PiercedVector<LevelSetInfo>::iterator infoItr = m_ls.find(id) ;
-        if( infoItr == m_ls.end() ){
-            infoItr = m_ls.emplace(id) ;
-        }
-
-        dataBuffer >> infoItr->value ;
-        dataBuffer >> infoItr->gradient ;
+        LevelSetInfo &info = m_ls.findOrEmplace(id) ;
+        dataBuffer >> info.value ;
+        dataBuffer >> info.gradient ;
     }
 
     __readCommunicationBuffer( recvList, dataBuffer ) ;
@@ -27,10 +27,12 @@
 
 // Standard Template Library
 # include <array>
+# include <atomic>
 # include <vector>
 # include <unordered_set>
 
 # include "bitpit_containers.hpp"
+# include "levelSetCachedStorage.hpp"
 
 namespace bitpit{
 
@@ -41,6 +43,9 @@ namespace adaption{
 class SendBuffer;
 class RecvBuffer;
 
+template <class T, class T1>
+class MinPQueue;
+
 class LevelSetKernel;
 class LevelSetObject;
 
@@ -54,7 +59,22 @@ class LevelSetCachedObject : public LevelSetObject{
     static const int                            PROPAGATION_SIGN_UNDEFINED;
     static const int                            PROPAGATION_SIGN_DUMMY;
 
+    static const std::size_t                    PROPAGATION_REGION_FIELD_ROOT;
+    static const std::size_t                    PROPAGATION_REGION_FIELD_SIGN;
+    static const long                           PROPAGATION_CHUNK_SIZE;
+
+    static const int                            DISTANCE_STATUS_FAR;
+    static const int                            DISTANCE_STATUS_TRIAL;
+    static const int                            DISTANCE_STATUS_ACCEPTED;
+    static const int                            DISTANCE_STATUS_EXACT;
+
+    static const double                         CACHE_DENSE_OCCUPANCY;
+    static const double                         CACHE_SPARSE_OCCUPANCY;
+
+    LevelSetCacheMode                           m_cacheMode;    /**< Mode used for choosing the storage of the cached information */
+
     void                                        setSign( long id, int sign ) ;
+    void                                        setSign( long id, std::size_t rawIndex, int sign ) ;
 
     void                                        initializeCellSignPropagation( long cellId, int cellSign,
                                                                                const std::array<double, 3> &boxMin,
@@ -63,14 +83,53 @@ class LevelSetCachedObject : public LevelSetObject{
                                                                                long *nWaiting, long *nExternal,
                                                                                int *externalSign ) ;
 
+    void                                        labelSignRegions( const PiercedStorage<int, long> &statuses,
+                                                                  std::vector<std::size_t> *waitingRawIds,
+                                                                  PiercedStorage<long, long> *regions ) ;
+
+    static long                                 findSignRegionRoot( std::atomic<long> *parents, long n ) ;
+    static void                                 mergeSignRegions( std::atomic<long> *parents, long n, long m ) ;
+
     void                                        propagateSeedSign( const std::vector<long> &seeds,
-                                                                   PiercedStorage<int, long> *status,
+                                                                   PiercedStorage<int, long> *statuses,
+                                                                   std::vector<std::size_t> *waitingRawIds,
+                                                                   PiercedStorage<long, long> *regions,
                                                                    long *nWaiting, int *externalSign ) ;
 
+    /*!
+     * Information used by the fast marching extension of the distance
+     */
+    struct DistanceExtensionInfo
+    {
+        int status;                                 /**< Fast marching status of the cell */
+        int sign;                                   /**< Sign of the levelset */
+        double distance;                            /**< Tentative distance from the surface */
+        std::array<double,3> root;                  /**< Closest point on the surface */
+    };
+
+    void                                        pushDistanceTrial( long rawId, DistanceExtensionInfo *info,
+                                                                   MinPQueue<double, long> *heap,
+                                                                   std::vector<std::array<int,2>> *heapMap ) ;
+
+    void                                        marchDistance( PiercedStorage<DistanceExtensionInfo, long> *infos,
+                                                               MinPQueue<double, long> *heap,
+                                                               std::vector<std::array<int,2>> *heapMap ) ;
+
     protected:
-    PiercedVector<LevelSetInfo>                 m_ls ;          /**< Levelset information for each cell */
+    LevelSetCachedStorage<LevelSetInfo>         m_ls ;          /**< Levelset information for each cell */
     virtual void                                getBoundingBox( std::array<double,3> &, std::array<double,3> & )const =0  ;
 
+    const LevelSetInfo *                        findLevelSetInfo( long id, std::size_t rawIndex ) const ;
+
+    void                                        setKernel(LevelSetKernel *) override ;
+
+    bool                                        isCacheDenseSupported() const ;
+    void                                        updateCacheStorage() ;
+    void                                        switchCacheStorage(bool) ;
+    virtual void                                __switchCacheStorage(bool) ;
+
+    virtual bool                                isDistanceExact(long ) const ;
+
     void                                        _clear( ) override ;
     virtual void                                __clear() ;
 
@@ -99,6 +158,11 @@ class LevelSetCachedObject : public LevelSetObject{
     std::array<double,3>                        getGradient(long ) const override ;
 
     void                                        propagateSign() override ;
+    void                                        extendDistance() override ;
+
+    void                                        setCacheMode(LevelSetCacheMode) ;
+    LevelSetCacheMode                           getCacheMode() const ;
+    bool                                        isCacheDense() const ;
 
 };
 
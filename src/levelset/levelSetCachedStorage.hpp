@@ -0,0 +1,89 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2019 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+# ifndef __BITPIT_LEVELSET_CACHED_STORAGE_HPP__
+# define __BITPIT_LEVELSET_CACHED_STORAGE_HPP__
+
+// Standard Template Library
+# include <cassert>
+# include <memory>
+
+# include "bitpit_containers.hpp"
+
+namespace bitpit{
+
+template<typename value_t>
+class LevelSetCachedStorage{
+
+    private:
+    /*!
+     * Slot of the dense storage
+     */
+    struct DenseSlot
+    {
+        value_t value;                                  /**< Value */
+        bool set;                                       /**< Tells if the value is set */
+
+        DenseSlot();
+    };
+
+    PiercedVector<value_t, long>                        m_sparse ;      /**< Sparse storage, contains only the cells that have a value */
+    std::unique_ptr<PiercedStorage<DenseSlot, long>>    m_dense ;       /**< Dense storage, contains a slot for each cell of the mesh */
+    PiercedKernel<long>                                 *m_denseKernel ; /**< Kernel the dense storage is synchronized with */
+
+    public:
+    LevelSetCachedStorage();
+    LevelSetCachedStorage(const LevelSetCachedStorage &other);
+    LevelSetCachedStorage(LevelSetCachedStorage &&other) = default;
+
+    bool                                                isDense() const ;
+    void                                                setDense(PiercedKernel<long> *kernel) ;
+    void                                                setSparse() ;
+
+    std::size_t                                         size() const ;
+    void                                                reserve(std::size_t n) ;
+    void                                                clear() ;
+    void                                                flush() ;
+
+    bool                                                exists(long id) const ;
+    const value_t *                                     find(long id) const ;
+    value_t *                                           find(long id) ;
+    value_t &                                           findOrEmplace(long id) ;
+    void                                                erase(long id) ;
+
+    bool                                                rawExists(std::size_t rawIndex) const ;
+    const value_t *                                     rawFind(std::size_t rawIndex) const ;
+    value_t &                                           rawFindOrEmplace(std::size_t rawIndex) ;
+
+    template<typename Function>
+    void                                                forEach(Function function) const ;
+
+};
+
+}
+
+// Template implementation
+#include "levelSetCachedStorage.tpp"
+
+#endif
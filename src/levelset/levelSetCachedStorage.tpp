@@ -0,0 +1,417 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2019 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+# ifndef __BITPIT_LEVELSET_CACHED_STORAGE_TPP__
+# define __BITPIT_LEVELSET_CACHED_STORAGE_TPP__
+
+namespace bitpit{
+
+/*!
+	@ingroup levelset
+	@class LevelSetCachedStorage
+	@brief Storage for the levelset information cached for the cells of the mesh.
+
+	The storage can work in two different modes:
+	 - sparse mode, values are stored in a PiercedVector that contains only
+	   the cells for which a value has been evaluated;
+	 - dense mode, values are stored in a PiercedStorage synchronized with
+	   the cells of the mesh, hence there is a slot for each cell and a
+	   lookup is a read of the slot associated to the raw index of the cell.
+
+	In dense mode, each slot has a flag that tells if its value is set,
+	therefore any value can be stored. Since the dense storage is registered
+	as a slave of the kernel of the cells, the mesh has to outlive the
+	storage. Slots of the cells created during a mesh update may contain
+	stale data: the values of those cells should be erased.
+
+	The raw accessors take the raw index of the cell in the kernel the
+	dense storage is synchronized with and can only be used in dense mode.
+	Accessors that take the id of the cell have to look up its raw index
+	in the kernel, therefore in dense mode they cost about as much as in
+	sparse mode: only callers that already know the raw index of the cells
+	(e.g., loops over the cells of the mesh) read the slots directly.
+
+	@tparam value_t is the type of the values
+*/
+
+/*!
+ * Constructor of the slots of the dense storage, the value of the slot is
+ * not set.
+ */
+template<typename value_t>
+LevelSetCachedStorage<value_t>::DenseSlot::DenseSlot()
+    : value(), set(false)
+{
+}
+
+/*!
+ * Constructor
+ */
+template<typename value_t>
+LevelSetCachedStorage<value_t>::LevelSetCachedStorage()
+    : m_denseKernel(nullptr)
+{
+}
+
+/*!
+ * Copy constructor
+ *
+ * The dense storage of the copy will be synchronized with the same kernel
+ * of the dense storage of the original.
+ * @param[in] other is the storage that will be copied
+ */
+template<typename value_t>
+LevelSetCachedStorage<value_t>::LevelSetCachedStorage(const LevelSetCachedStorage &other)
+    : m_sparse(other.m_sparse),
+      m_denseKernel(other.m_denseKernel)
+{
+    if (other.m_dense) {
+        m_dense = std::unique_ptr<PiercedStorage<DenseSlot, long>>(new PiercedStorage<DenseSlot, long>(*(other.m_dense), m_denseKernel, PiercedSyncMaster::SyncMode::SYNC_MODE_JOURNALED));
+    }
+}
+
+/*!
+ * Checks if the storage is in dense mode
+ * @return true if the storage is in dense mode, false otherwise
+ */
+template<typename value_t>
+bool LevelSetCachedStorage<value_t>::isDense() const{
+    return static_cast<bool>(m_dense);
+}
+
+/*!
+ * Switches the storage to dense mode.
+ *
+ * Values of the sparse storage are moved into the dense storage, values
+ * associated to ids that are not in the kernel are discarded.
+ * @param[in] kernel is the kernel the storage will be synchronized with
+ */
+template<typename value_t>
+void LevelSetCachedStorage<value_t>::setDense(PiercedKernel<long> *kernel){
+
+    if (m_dense) {
+        if (m_denseKernel == kernel) {
+            return;
+        }
+
+        setSparse();
+    }
+
+    m_denseKernel = kernel;
+    m_dense = std::unique_ptr<PiercedStorage<DenseSlot, long>>(new PiercedStorage<DenseSlot, long>(1, m_denseKernel, PiercedSyncMaster::SyncMode::SYNC_MODE_JOURNALED));
+
+    auto sparseEnd = m_sparse.end();
+    for (auto itr = m_sparse.begin(); itr != sparseEnd; ++itr) {
+        auto kernelItr = m_denseKernel->find(itr.getId());
+        if (kernelItr == m_denseKernel->cend()) {
+            continue;
+        }
+
+        DenseSlot &slot = m_dense->rawAt(kernelItr.getRawIndex());
+        slot.value = std::move(*itr);
+        slot.set   = true;
+    }
+
+    m_sparse.clear(true);
+}
+
+/*!
+ * Switches the storage to sparse mode.
+ *
+ * Only the values that are set are moved into the sparse storage.
+ */
+template<typename value_t>
+void LevelSetCachedStorage<value_t>::setSparse(){
+
+    if (!m_dense) {
+        return;
+    }
+
+    std::unique_ptr<PiercedStorage<DenseSlot, long>> dense = std::move(m_dense);
+
+    std::size_t nSetValues = 0;
+    auto kernelEnd = m_denseKernel->cend();
+    for (auto itr = m_denseKernel->cbegin(); itr != kernelEnd; ++itr) {
+        if (dense->rawAt(itr.getRawIndex()).set) {
+            ++nSetValues;
+        }
+    }
+
+    m_sparse.reserve(nSetValues);
+    for (auto itr = m_denseKernel->cbegin(); itr != kernelEnd; ++itr) {
+        DenseSlot &slot = dense->rawAt(itr.getRawIndex());
+        if (slot.set) {
+            m_sparse.insert(*itr, std::move(slot.value));
+        }
+    }
+
+    m_denseKernel = nullptr;
+}
+
+/*!
+ * Counts the values stored.
+ *
+ * In dense mode the count requires a loop over all the cells of the kernel.
+ * @return The number of values that are set.
+ */
+template<typename value_t>
+std::size_t LevelSetCachedStorage<value_t>::size() const{
+
+    if (!m_dense) {
+        return m_sparse.size();
+    }
+
+    std::size_t nSetValues = 0;
+    forEach([&nSetValues](long id, const value_t &value) {
+        BITPIT_UNUSED(id);
+        BITPIT_UNUSED(value);
+        ++nSetValues;
+    });
+
+    return nSetValues;
+}
+
+/*!
+ * Requests a change in the capacity of the storage such that it can
+ * contain at least n values. In dense mode the request is ignored.
+ * @param[in] n is the minimum capacity requested
+ */
+template<typename value_t>
+void LevelSetCachedStorage<value_t>::reserve(std::size_t n){
+
+    if (m_dense) {
+        return;
+    }
+
+    m_sparse.reserve(n);
+}
+
+/*!
+ * Removes all the values, the mode of the storage is not changed.
+ */
+template<typename value_t>
+void LevelSetCachedStorage<value_t>::clear(){
+
+    if (m_dense) {
+        m_dense->fill(DenseSlot());
+    } else {
+        m_sparse.clear();
+    }
+}
+
+/*!
+ * Flushes the holes left in the sparse storage by the erased values.
+ */
+template<typename value_t>
+void LevelSetCachedStorage<value_t>::flush(){
+
+    if (m_dense) {
+        return;
+    }
+
+    m_sparse.flush();
+}
+
+/*!
+ * Checks if a value is set for the specified id.
+ * @param[in] id is the id
+ * @return true if a value is set for the specified id, false otherwise
+ */
+template<typename value_t>
+bool LevelSetCachedStorage<value_t>::exists(long id) const{
+    return (find(id) != nullptr);
+}
+
+/*!
+ * Gets a constant pointer to the value associated to the specified id.
+ * @param[in] id is the id
+ * @return A constant pointer to the value associated to the specified id,
+ * if no value is set for the id a null pointer is returned.
+ */
+template<typename value_t>
+const value_t * LevelSetCachedStorage<value_t>::find(long id) const{
+
+    if (!m_dense) {
+        auto itr = m_sparse.find(id);
+        if (itr == m_sparse.cend()) {
+            return nullptr;
+        }
+
+        return &(*itr);
+    }
+
+    auto kernelItr = m_denseKernel->find(id);
+    if (kernelItr == m_denseKernel->cend()) {
+        return nullptr;
+    }
+
+    return rawFind(kernelItr.getRawIndex());
+}
+
+/*!
+ * Gets a pointer to the value associated to the specified id.
+ * @param[in] id is the id
+ * @return A pointer to the value associated to the specified id, if no
+ * value is set for the id a null pointer is returned.
+ */
+template<typename value_t>
+value_t * LevelSetCachedStorage<value_t>::find(long id){
+    return const_cast<value_t *>(static_cast<const LevelSetCachedStorage &>(*this).find(id));
+}
+
+/*!
+ * Gets a reference to the value associated to the specified id, if no
+ * value is set for the id a default constructed value is created.
+ *
+ * In dense mode the id has to be in the kernel.
+ * @param[in] id is the id
+ * @return A reference to the value associated to the specified id.
+ */
+template<typename value_t>
+value_t & LevelSetCachedStorage<value_t>::findOrEmplace(long id){
+
+    if (m_dense) {
+        return rawFindOrEmplace(m_denseKernel->getRawIndex(id));
+    }
+
+    auto itr = m_sparse.find(id);
+    if (itr == m_sparse.end()) {
+        itr = m_sparse.emplace(id);
+    }
+
+    return *itr;
+}
+
+/*!
+ * Erases the value associated to the specified id.
+ *
+ * In sparse mode the erase is delayed, the holes left in the storage will
+ * be removed by a flush.
+ * @param[in] id is the id
+ */
+template<typename value_t>
+void LevelSetCachedStorage<value_t>::erase(long id){
+
+    if (m_dense) {
+        auto kernelItr = m_denseKernel->find(id);
+        if (kernelItr != m_denseKernel->cend()) {
+            m_dense->rawAt(kernelItr.getRawIndex()) = DenseSlot();
+        }
+    } else if (m_sparse.exists(id)) {
+        m_sparse.erase(id, true);
+    }
+}
+
+/*!
+ * Checks if a value is set for the cell with the specified raw index.
+ *
+ * The storage has to be in dense mode.
+ * @param[in] rawIndex is the raw index of the cell in the kernel
+ * @return true if a value is set for the cell, false otherwise
+ */
+template<typename value_t>
+bool LevelSetCachedStorage<value_t>::rawExists(std::size_t rawIndex) const{
+
+    assert(m_dense);
+
+    return m_dense->rawAt(rawIndex).set;
+}
+
+/*!
+ * Gets a constant pointer to the value associated to the cell with the
+ * specified raw index.
+ *
+ * The storage has to be in dense mode.
+ * @param[in] rawIndex is the raw index of the cell in the kernel
+ * @return A constant pointer to the value associated to the cell, if no
+ * value is set for the cell a null pointer is returned.
+ */
+template<typename value_t>
+const value_t * LevelSetCachedStorage<value_t>::rawFind(std::size_t rawIndex) const{
+
+    assert(m_dense);
+
+    const DenseSlot &slot = m_dense->rawAt(rawIndex);
+    if (!slot.set) {
+        return nullptr;
+    }
+
+    return &(slot.value);
+}
+
+/*!
+ * Gets a reference to the value associated to the cell with the specified
+ * raw index, if no value is set for the cell a default constructed value
+ * is created.
+ *
+ * The storage has to be in dense mode.
+ * @param[in] rawIndex is the raw index of the cell in the kernel
+ * @return A reference to the value associated to the cell.
+ */
+template<typename value_t>
+value_t & LevelSetCachedStorage<value_t>::rawFindOrEmplace(std::size_t rawIndex){
+
+    assert(m_dense);
+
+    DenseSlot &slot = m_dense->rawAt(rawIndex);
+    if (!slot.set) {
+        slot.value = value_t();
+        slot.set   = true;
+    }
+
+    return slot.value;
+}
+
+/*!
+ * Applies the specified function to all the values that are set.
+ *
+ * Values are visited following the order of the storage.
+ * @param[in] function is the function that will be applied, it receives
+ * the id and a constant reference to the value
+ */
+template<typename value_t>
+template<typename Function>
+void LevelSetCachedStorage<value_t>::forEach(Function function) const{
+
+    if (!m_dense) {
+        auto sparseEnd = m_sparse.cend();
+        for (auto itr = m_sparse.cbegin(); itr != sparseEnd; ++itr) {
+            function(itr.getId(), *itr);
+        }
+
+        return;
+    }
+
+    auto kernelEnd = m_denseKernel->cend();
+    for (auto itr = m_denseKernel->cbegin(); itr != kernelEnd; ++itr) {
+        const DenseSlot &slot = m_dense->rawAt(itr.getRawIndex());
+        if (slot.set) {
+            function(*itr, slot.value);
+        }
+    }
+}
+
+}
+
+# endif
@@ -101,6 +101,17 @@ enum class LevelSetWriteField{
     DEFAULT=5                       /**< adds levelset value and gradient to VTK*/
 };
 
+/*!
+ * @ingroup levelsetEnums
+ * Enum class defining how cached objects store the levelset information
+ * of the cells. For details see LevelSetCachedObject::setCacheMode()
+ */
+enum class LevelSetCacheMode{
+    AUTOMATIC=0,                    /**< Storage is chosen according to the fraction of cells with cached information */
+    SPARSE=1,                       /**< Information is stored only for the cells it has been evaluated on */
+    DENSE=2                         /**< Information is stored in a slot for each cell of the mesh */
+};
+
 }
 
 #endif
@@ -148,6 +148,12 @@ short LevelSetObject::getSign(long i)const{
 void LevelSetObject::propagateSign(){
 }
 
+/*!
+ * Extends the distance from the narrow band to the levelset function throughout the grid
+ */
+void LevelSetObject::extendDistance(){
+}
+
 /*!
  * If cell centroid lies within the narrow band and hence levelset is computet exactly
  * @param[in] i cell index
@@ -56,7 +56,7 @@ class LevelSetObject : public VTKBaseStreamer{
     LevelSetObject(int);
     LevelSetObject(const LevelSetObject &other) = default;
 
-    void                                        setKernel(LevelSetKernel *);
+    virtual void                                setKernel(LevelSetKernel *);
     LevelSetKernel *                            getKernel();
 
     void                                        clear();
@@ -68,6 +68,7 @@ class LevelSetObject : public VTKBaseStreamer{
     void                                        clearAfterMeshAdaption(const std::vector<adaption::Info>&);
 
     virtual void                                propagateSign() ;
+    virtual void                                extendDistance() ;
 
     void                                        dump(std::ostream &);
     void                                        restore(std::istream &);
@@ -22,6 +22,7 @@
  *
 \*---------------------------------------------------------------------------*/
 
+# include <algorithm>
 # include <cassert>
 
 # include "bitpit_common.hpp"
@@ -29,6 +30,7 @@
 # include "bitpit_CG.hpp"
 # include "bitpit_surfunstructured.hpp"
 # include "bitpit_volcartesian.hpp"
+# include "bitpit_voloctree.hpp"
 
 # include "levelSetKernel.hpp"
 # include "levelSetCartesian.hpp"
@@ -418,9 +420,9 @@ int LevelSetSegmentation::getPart( long id ) const{
  */
 std::array<double,3> LevelSetSegmentation::getNormal( long id ) const{
 
-    auto itr = m_surfaceInfo.find(id) ;
-    if( itr != m_surfaceInfo.end() ){
-        return itr->normal;
+    const SurfaceInfo *info = m_surfaceInfo.find(id) ;
+    if( info ){
+        return info->normal;
     } else {
         return levelSetDefaults::GRADIENT ;
     }
@@ -435,15 +437,26 @@ std::array<double,3> LevelSetSegmentation::getNormal( long id ) const{
  */
 long LevelSetSegmentation::getSupport( long id ) const{
 
-    auto itr = m_surfaceInfo.find(id) ;
-    if( itr != m_surfaceInfo.end() ){
-        return itr->support;
+    const SurfaceInfo *info = m_surfaceInfo.find(id) ;
+    if( info ){
+        return info->support;
     } else {
         return levelSetDefaults::SUPPORT ;
     }
 
 }
 
+/*!
+ * Checks if the levelset of the specified cell has been evaluated exactly,
+ * i.e., if the cell has a support segment.
+ * @param[in] id index of cell
+ * @return true if the levelset of the cell has been evaluated exactly,
+ * false otherwise
+ */
+bool LevelSetSegmentation::isDistanceExact( long id ) const{
+    return m_surfaceInfo.exists(id);
+}
+
 /*!
  * Get size of support triangle
  * @param[in] i cell index
@@ -584,6 +597,20 @@ void LevelSetSegmentation::__clear( ){
     m_surfaceInfo.clear() ;
 }
 
+/*!
+ * Switches the storage of the segment's info.
+ * @param[in] dense if set to true, segment's info will be moved into dense
+ * storage, otherwise it will be moved into sparse storage
+ */
+void LevelSetSegmentation::__switchCacheStorage( bool dense ){
+
+    if( dense ){
+        m_surfaceInfo.setDense(&(m_kernelPtr->getMesh()->getCells()));
+    } else {
+        m_surfaceInfo.setSparse();
+    }
+}
+
 /*!
  * Computes the levelset function within the narrow band
  * @param[in] signd if signed- or unsigned- distance function should be calculated
@@ -599,6 +626,8 @@ void LevelSetSegmentation::computeLSInNarrowBand(bool signd){
         computeLSInNarrowBand( lsOctree, signd) ;
 
     }
+
+    updateCacheStorage() ;
 }
 
 /*!
@@ -614,14 +643,13 @@ void LevelSetSegmentation::updateLSInNarrowBand( const std::vector<adaption::Inf
         // Update is not implemented for Cartesian patches
         clear( ) ;
         computeLSInNarrowBand( lsCartesian, signd) ;
-        return;
-    }
 
-    if( LevelSetOctree* lsOctree = dynamic_cast<LevelSetOctree*>(m_kernelPtr) ){
+    } else if( LevelSetOctree* lsOctree = dynamic_cast<LevelSetOctree*>(m_kernelPtr) ){
         updateLSInNarrowBand( lsOctree, mapper, signd ) ;
-        return;
+
     }
 
+    updateCacheStorage() ;
 
 }
 
@@ -730,26 +758,20 @@ void LevelSetSegmentation::computeLSInNarrowBand( LevelSetCartesian *visitee, bo
                 // consider only cells within the search radius
                 if ( cellDistance <= searchRadius ) {
 
-                    PiercedVector<LevelSetInfo>::iterator lsInfoItr = m_ls.find(cellId) ;
-                    if( lsInfoItr == m_ls.end() ){
-                        lsInfoItr = m_ls.emplace(cellId) ;
-                    }
+                    LevelSetInfo &lsInfo = m_ls.findOrEmplace(cellId) ;
 
                     // check if the computed distance is the closest distance
-                    if( cellDistance < std::abs(lsInfoItr->value) ){
+                    if( cellDistance < std::abs(lsInfo.value) ){
 
                         // compute all necessary information and store them
                         m_segmentation->getSegmentInfo(cloud[k], segmentId, signd, distance, gradient, normal);
 
-                        lsInfoItr->value    = distance;
-                        lsInfoItr->gradient = gradient;
+                        lsInfo.value    = distance;
+                        lsInfo.gradient = gradient;
                 
-                        auto infoItr = m_surfaceInfo.find(cellId) ;
-                        if( infoItr == m_surfaceInfo.end() ){
-                            infoItr = m_surfaceInfo.emplace(cellId) ;
-                        }
-                        infoItr->support = segmentId;
-                        infoItr->normal = normal;
+                        SurfaceInfo &info = m_surfaceInfo.findOrEmplace(cellId) ;
+                        info.support = segmentId;
+                        info.normal = normal;
                     }
 
 
@@ -787,103 +809,171 @@ void LevelSetSegmentation::computeLSInNarrowBand( LevelSetCartesian *visitee, bo
  * In case the size of the narrow band has not been set,
  * the method will calculate the levelset within the cells
  * that intersect the surface and within their first neighbours,
+ * Cells are processed following the Morton order of their octants,
+ * when OpenMP is enabled contiguous chunks of cells are evaluated
+ * by different threads.
  * \param[in] visitee the octree LevelSetKernel
  * \param[in] signd whether signed distance should be calculated
  */
 void LevelSetSegmentation::computeLSInNarrowBand( LevelSetOctree *visitee, bool signd){
 
-    VolumeKernel &mesh = *(visitee->getMesh()) ;
+    VolOctree &mesh = *(visitee->getOctreeMesh()) ;
 
     bool adaptiveSearch(m_narrowBand<0);
-    double searchRadius = m_narrowBand;
     double factor = 0.5 *sqrt( (double) mesh.getDimension() );
 
-    long segmentId;
-    double distance;
-    std::array<double,3> gradient, normal;
-    std::array<double,3> centroid, root;
-
-    std::unordered_set<long> intersects;
-
-    for( const Cell &cell : mesh.getCells() ){
-
-        long cellId = cell.getId();
-
-        centroid = visitee->computeCellCentroid(cellId);
-
-        if(adaptiveSearch){
-            double cellSize = mesh.evalCellSize(cellId);
-            searchRadius = factor *cellSize;
-        }
-
-        m_segmentation->m_searchTreeUPtr->findPointClosestCell(centroid, searchRadius, &segmentId, &distance);
-
-        if(segmentId>=0){
-
-            m_segmentation->getSegmentInfo(centroid, segmentId, signd, distance, gradient, normal);
-
-            PiercedVector<LevelSetInfo>::iterator lsInfoItr = m_ls.find(cellId);
-            lsInfoItr = m_ls.emplace(cellId) ;
-            lsInfoItr->value    = distance;
-            lsInfoItr->gradient = gradient;
+    // Cells sorted according to the Morton order of their octants
+    const PabloNonUniform &tree = mesh.getTree();
+    uint32_t nInternalOctants = tree.getNumOctants();
+    uint32_t nGhostOctants = tree.getNumGhosts();
 
-            PiercedVector<SurfaceInfo>::iterator infoItr = m_surfaceInfo.emplace(cellId);
-            infoItr->support = segmentId;
-            infoItr->normal = normal;
+    std::vector<long> cellIds;
+    cellIds.reserve(nInternalOctants + nGhostOctants);
+    for (uint32_t n = 0; n < nInternalOctants; ++n) {
+        cellIds.push_back(mesh.getOctantId(VolOctree::OctantInfo(n, true)));
+    }
 
-            if(adaptiveSearch){
-                intersects.insert(cellId);
-            }
+    for (uint32_t n = 0; n < nGhostOctants; ++n) {
+        cellIds.push_back(mesh.getOctantId(VolOctree::OctantInfo(n, false)));
+    }
 
+    // Evaluate the levelset of the cells
+    long nCells = cellIds.size();
+    std::vector<double> searchRadii(nCells, m_narrowBand);
+    if(adaptiveSearch){
+        for (long n = 0; n < nCells; ++n) {
+            searchRadii[n] = factor *mesh.evalCellSize(cellIds[n]);
         }
-             
     }
 
+    std::vector<long> supportIds;
+    computeLSInCells(mesh, cellIds, searchRadii, signd, &supportIds);
+
     if(!adaptiveSearch){
         return;
     }
-    
-    for( long cellId : intersects){
 
+    // Evaluate the levelset of the neighbours of the intersected cells
+    //
+    // Each neighbour is evaluated only once, the search radius is evaluated
+    // using the projection point of the first intersected cell (in Morton
+    // order) the neighbour is adjacent to.
+    std::vector<long> neighIds;
+    std::vector<double> neighSearchRadii;
+    std::unordered_set<long> neighsAdded;
+    for (long n = 0; n < nCells; ++n) {
+        if (supportIds[n] < 0) {
+            continue;
+        }
+
+        long cellId = cellIds[n];
         Cell const &cell = mesh.getCell(cellId);
-        
-        centroid = visitee->computeCellCentroid(cellId);
-        root = computeProjectionPoint(cellId);
+
+        std::array<double,3> root = computeProjectionPoint(cellId);
 
         const long *neighbours = cell.getAdjacencies() ;
         int nNeighbours = cell.getAdjacencyCount() ;
-        for (int n = 0; n < nNeighbours; ++n) {
-            long neighId = neighbours[n];
+        for (int k = 0; k < nNeighbours; ++k) {
+            long neighId = neighbours[k];
 
             // skip if neigh cell has already been processed
             // either because it is intersected by surface or
             // because it is a neigh to a previous intersect
-            if( m_ls.count(neighId) != 0 ){
+            if( m_ls.exists(neighId) ){
                 continue;
             }
 
-            centroid = visitee->computeCellCentroid(neighId);
-            searchRadius =  1.05 *norm2(centroid-root);
-            m_segmentation->m_searchTreeUPtr->findPointClosestCell(centroid, searchRadius, &segmentId, &distance);
+            if( !neighsAdded.insert(neighId).second ){
+                continue;
+            }
 
-            if(segmentId>=0){
+            std::array<double,3> centroid = visitee->computeCellCentroid(neighId);
 
-                m_segmentation->getSegmentInfo(centroid, segmentId, signd, distance, gradient, normal);
+            neighIds.push_back(neighId);
+            neighSearchRadii.push_back(1.05 *norm2(centroid-root));
+        }
+    }
+
+    std::vector<long> neighSupportIds;
+    computeLSInCells(mesh, neighIds, neighSearchRadii, signd, &neighSupportIds);
+
+    assert(std::find(neighSupportIds.begin(), neighSupportIds.end(), Cell::NULL_ID) == neighSupportIds.end() && "Should not pass here");
+}
 
-                PiercedVector<LevelSetInfo>::iterator lsInfoItr = m_ls.emplace(neighId) ;
-                lsInfoItr->value    = distance;
-                lsInfoItr->gradient = gradient;
+/*!
+ * Computes the levelset of the specified cells.
+ * The closest segments of all the cells are searched with a single batch
+ * query on the search tree, then the segment information is evaluated,
+ * when OpenMP is enabled contiguous chunks of cells are evaluated by
+ * different threads. The results are stored in temporary per-cell storage
+ * and then inserted in the cached containers in a single bulk pass,
+ * following the order of the cells in the input list.
+ * Only cells whose distance from the surface is less than the search
+ * radius will be inserted in the cache.
+ * \param[in] mesh the mesh
+ * \param[in] cellIds the ids of the cells to evaluate
+ * \param[in] searchRadii the search radius of each cell
+ * \param[in] signd whether signed distance should be calculated
+ * \param[out] supportIds on output will contain the id of the support
+ * segment of each cell, cells farther than the search radius from the
+ * surface will have a null support
+ */
+void LevelSetSegmentation::computeLSInCells( const VolumeKernel &mesh, const std::vector<long> &cellIds, const std::vector<double> &searchRadii, bool signd, std::vector<long> *supportIds){
 
+    const SurfaceSkdTree &searchTree = *(m_segmentation->m_searchTreeUPtr);
 
-                PiercedVector<SurfaceInfo>::iterator infoItr = m_surfaceInfo.emplace(neighId);
-                infoItr->support = segmentId;
-                infoItr->normal = normal;
+    long nCells = cellIds.size();
+    supportIds->resize(nCells);
 
-            } else {
-                assert(false && "Should not pass here");
-            }
+    std::vector<double> distances(nCells);
+    std::vector<std::array<double,3>> gradients(nCells);
+    std::vector<std::array<double,3>> normals(nCells);
+
+    std::vector<std::array<double,3>> centroids(nCells);
 
+#if BITPIT_ENABLE_OPENMP==1
+    #pragma omp parallel for schedule(static)
+#endif
+    for (long n = 0; n < nCells; ++n) {
+        centroids[n] = mesh.evalCellCentroid(cellIds[n]);
+    }
+
+    searchTree.findPointClosestCells(nCells, centroids.data(), searchRadii.data(), supportIds->data(), distances.data());
+
+#if BITPIT_ENABLE_OPENMP==1
+    #pragma omp parallel for schedule(dynamic, NARROW_BAND_CHUNK_SIZE)
+#endif
+    for (long n = 0; n < nCells; ++n) {
+        long segmentId = (*supportIds)[n];
+        if (segmentId < 0) {
+            continue;
+        }
+
+        m_segmentation->getSegmentInfo(centroids[n], segmentId, signd, distances[n], gradients[n], normals[n]);
+    }
+
+    // Bulk insertion in the cached containers
+    std::size_t nSupported = nCells - std::count((*supportIds).begin(), (*supportIds).end(), Cell::NULL_ID);
+    if (!m_ls.isDense()) {
+        m_ls.reserve(m_ls.size() + nSupported);
+        m_surfaceInfo.reserve(m_surfaceInfo.size() + nSupported);
+    }
+
+    for (long n = 0; n < nCells; ++n) {
+        long segmentId = (*supportIds)[n];
+        if (segmentId < 0) {
+            continue;
         }
+
+        long cellId = cellIds[n];
+
+        LevelSetInfo &lsInfo = m_ls.findOrEmplace(cellId) ;
+        lsInfo.value    = distances[n];
+        lsInfo.gradient = gradients[n];
+
+        SurfaceInfo &info = m_surfaceInfo.findOrEmplace(cellId);
+        info.support = segmentId;
+        info.normal = normals[n];
     }
 }
 
@@ -936,13 +1026,13 @@ void LevelSetSegmentation::updateLSInNarrowBand( LevelSetOctree *visitee, const
 
                 m_segmentation->getSegmentInfo(centroid, segmentId, signd, distance, gradient, normal);
 
-                PiercedVector<LevelSetInfo>::iterator lsInfoItr = m_ls.emplace(cellId) ;
-                lsInfoItr->value    = distance;
-                lsInfoItr->gradient = gradient;
+                LevelSetInfo &lsInfo = m_ls.findOrEmplace(cellId) ;
+                lsInfo.value    = distance;
+                lsInfo.gradient = gradient;
 
-                PiercedVector<SurfaceInfo>::iterator infoItr = m_surfaceInfo.emplace(cellId) ;
-                infoItr->support = segmentId;
-                infoItr->normal = normal;
+                SurfaceInfo &info = m_surfaceInfo.findOrEmplace(cellId) ;
+                info.support = segmentId;
+                info.normal = normal;
 
             } else if(adaptiveSearch){
                 unprocessed.push_back(cellId);
@@ -981,14 +1071,14 @@ void LevelSetSegmentation::updateLSInNarrowBand( LevelSetOctree *visitee, const
 
                     m_segmentation->getSegmentInfo(centroid, segmentId, signd, distance, gradient, normal);
 
-                    PiercedVector<LevelSetInfo>::iterator lsInfoItr = m_ls.emplace(cellId) ;
-                    lsInfoItr->value    = distance;
-                    lsInfoItr->gradient = gradient;
+                    LevelSetInfo &lsInfo = m_ls.findOrEmplace(cellId) ;
+                    lsInfo.value    = distance;
+                    lsInfo.gradient = gradient;
 
 
-                    PiercedVector<SurfaceInfo>::iterator infoItr = m_surfaceInfo.emplace(cellId);
-                    infoItr->support = segmentId;
-                    infoItr->normal = normal;
+                    SurfaceInfo &info = m_surfaceInfo.findOrEmplace(cellId);
+                    info.support = segmentId;
+                    info.normal = normal;
 
                 } else {
                     assert(false && "Should not pass here");
@@ -1015,6 +1105,13 @@ void LevelSetSegmentation::__clearAfterMeshAdaption( const std::vector<adaption:
             continue;
         }
 
+        // Slots of the new cells in dense storage may contain stale data
+        if ( m_surfaceInfo.isDense() && info.type != adaption::Type::TYPE_RENUMBERING ) {
+            for ( long child : info.current ) {
+                m_surfaceInfo.erase( child ) ;
+            }
+        }
+
         // Delete only old data that belongs to the current processor
         if (info.type == adaption::Type::TYPE_PARTITION_RECV) {
             continue;
@@ -1022,9 +1119,7 @@ void LevelSetSegmentation::__clearAfterMeshAdaption( const std::vector<adaption:
 
         // Remove info of previous cells
         for ( long  parent : info.previous ) {
-            if ( m_surfaceInfo.find( parent ) != m_surfaceInfo.end() ) {
-                m_surfaceInfo.erase( parent, true ) ;
-            }
+            m_surfaceInfo.erase( parent ) ;
         }
     }
 
@@ -1039,12 +1134,11 @@ void LevelSetSegmentation::__dump( std::ostream &stream ){
 
     utils::binary::write( stream, m_surfaceInfo.size() ) ;
 
-    bitpit::PiercedVector<SurfaceInfo>::iterator infoItr, infoEnd = m_surfaceInfo.end() ;
-    for( infoItr = m_surfaceInfo.begin(); infoItr != infoEnd; ++infoItr){
-        utils::binary::write( stream, infoItr.getId() );
-        utils::binary::write( stream, infoItr->support );
-        utils::binary::write( stream, infoItr->normal );
-    }
+    m_surfaceInfo.forEach([&stream](long id, const SurfaceInfo &info){
+        utils::binary::write( stream, id );
+        utils::binary::write( stream, info.support );
+        utils::binary::write( stream, info.normal );
+    });
 }
 
 /*!
@@ -1068,7 +1162,7 @@ void LevelSetSegmentation::__restore( std::istream &stream ){
         utils::binary::read( stream, support );
         utils::binary::read( stream, normal );
 
-        m_surfaceInfo.insert(id, SurfaceInfo(support,normal));
+        m_surfaceInfo.findOrEmplace(id) = SurfaceInfo(support,normal);
     }
 }
 
@@ -1084,8 +1178,7 @@ void LevelSetSegmentation::__writeCommunicationBuffer( const std::vector<long> &
     // Evaluate the size of the buffer
     long nItems = 0;
     for( const auto &index : sendList){
-        auto infoItr = m_surfaceInfo.find(index) ;
-        if( infoItr != m_surfaceInfo.end() ){
+        if( m_surfaceInfo.exists(index) ){
             nItems++ ;
         }
     }
@@ -1097,11 +1190,11 @@ void LevelSetSegmentation::__writeCommunicationBuffer( const std::vector<long> &
 
     long index = 0 ;
     for( long id : sendList){
-        auto infoItr = m_surfaceInfo.find(id) ;
-        if( infoItr != m_surfaceInfo.end() ){
+        const SurfaceInfo *info = m_surfaceInfo.find(id) ;
+        if( info ){
             dataBuffer << index ;
-            dataBuffer << infoItr->support;
-            dataBuffer << infoItr->normal;
+            dataBuffer << info->support;
+            dataBuffer << info->normal;
         }
 
         ++index;
@@ -1125,12 +1218,9 @@ void LevelSetSegmentation::__readCommunicationBuffer( const std::vector<long> &r
         long id = recvList[index] ;
 
         // Assign the data of the element
-        auto infoItr = m_surfaceInfo.find(id) ;
-        if( infoItr == m_surfaceInfo.end() ){
-            infoItr = m_surfaceInfo.emplace(id) ;
-        }
-        dataBuffer >> infoItr->support;
-        dataBuffer >> infoItr->normal;
+        SurfaceInfo &info = m_surfaceInfo.findOrEmplace(id) ;
+        dataBuffer >> info.support;
+        dataBuffer >> info.normal;
     }
 }
 # endif
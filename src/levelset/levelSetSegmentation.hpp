@@ -40,6 +40,7 @@ namespace adaption{
 }
 class SurfUnstructured;
 class SurfaceSkdTree;
+class VolumeKernel;
 
 class SendBuffer;
 class RecvBuffer;
@@ -108,7 +109,9 @@ class LevelSetSegmentation : public LevelSetCachedObject {
     };
 
     std::shared_ptr<const SegmentationKernel> m_segmentation;
-    PiercedVector<SurfaceInfo>                         m_surfaceInfo;                      /**< cell support information  */
+    LevelSetCachedStorage<SurfaceInfo>                 m_surfaceInfo;                      /**< cell support information  */
+
+    static const long                           NARROW_BAND_CHUNK_SIZE = 256;  /**< Number of cells processed by a thread in a single chunk of the narrow band evaluation */
 
     double                                      getSegmentSize( long ) const;
 
@@ -119,6 +122,9 @@ class LevelSetSegmentation : public LevelSetCachedObject {
     void                                        __restore( std::istream &) override ;
 
     void                                        __clearAfterMeshAdaption(const std::vector<adaption::Info> &) override ;
+    void                                        __switchCacheStorage(bool) override ;
+
+    bool                                        isDistanceExact(long ) const override ;
 
 # if BITPIT_ENABLE_MPI
     void                                        __writeCommunicationBuffer(const std::vector<long> &, SendBuffer &) override ;
@@ -131,6 +137,7 @@ class LevelSetSegmentation : public LevelSetCachedObject {
     void                                        computeLSInNarrowBand( LevelSetCartesian *, bool);
     void                                        computeLSInNarrowBand( LevelSetOctree *, bool);
     void                                        updateLSInNarrowBand(LevelSetOctree *, const std::vector<adaption::Info> &, bool);
+    void                                        computeLSInCells( const VolumeKernel &, const std::vector<long> &, const std::vector<double> &, bool, std::vector<long> *);
 
     public:
     virtual ~LevelSetSegmentation();
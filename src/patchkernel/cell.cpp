@@ -44,9 +44,11 @@ bitpit::IBinaryStream& operator>>(bitpit::IBinaryStream &buffer, bitpit::Cell &c
 	buffer >> element;
 
 	// Write interface data ------------------------------------------------- //
+	cell.m_sharedInterfaces = nullptr;
 	buffer >> cell.m_interfaces;
 
 	// Write adjacencies data ----------------------------------------------- //
+	cell.m_sharedAdjacencies = nullptr;
 	buffer >> cell.m_adjacencies;
 
 	return buffer;
@@ -67,10 +69,22 @@ bitpit::OBinaryStream& operator<<(bitpit::OBinaryStream  &buffer, const bitpit::
 	buffer << element;
 
 	// Write interface data ------------------------------------------------- //
-	buffer << cell.m_interfaces;
+	if (cell.m_sharedInterfaces) {
+		bitpit::FlatVector2D<long> interfaces(false);
+		bitpit::Cell::importSharedNeighbourhood(cell.m_sharedInterfaces, &interfaces);
+		buffer << interfaces;
+	} else {
+		buffer << cell.m_interfaces;
+	}
 
 	// Write adjacencies data ----------------------------------------------- //
-	buffer << cell.m_adjacencies;
+	if (cell.m_sharedAdjacencies) {
+		bitpit::FlatVector2D<long> adjacencies(false);
+		bitpit::Cell::importSharedNeighbourhood(cell.m_sharedAdjacencies, &adjacencies);
+		buffer << adjacencies;
+	} else {
+		buffer << cell.m_adjacencies;
+	}
 
 	return buffer;
 }
@@ -84,6 +98,13 @@ namespace bitpit {
 	\brief The Cell class defines the cells.
 
 	Cell is class that defines the cells.
+
+	Connectivity, interfaces and adjacencies of the cell are usually stored
+	in storages owned by the cell. The patch can move them into a buffer
+	shared among all its cells (see PatchKernel::ELEMENT_STORAGE_ARENA), in
+	that case the cell only references its portion of the shared buffer.
+	Changes that alter the size of the data stored in a shared buffer will
+	move the data back into storages owned by the cell.
 */
 
 /*!
@@ -117,7 +138,9 @@ bitpit::FlatVector2D<long> Cell::createNeighbourhoodStorage(bool storeNeighbourh
 Cell::Cell()
 	: Element(), m_interior(true),
       m_interfaces(createNeighbourhoodStorage(false)),
-      m_adjacencies(createNeighbourhoodStorage(false))
+      m_adjacencies(createNeighbourhoodStorage(false)),
+      m_sharedInterfaces(nullptr),
+      m_sharedAdjacencies(nullptr)
 {
 
 }
@@ -134,7 +157,9 @@ Cell::Cell()
 Cell::Cell(long id, ElementType type, bool interior, bool storeNeighbourhood)
 	: Element(id, type),
       m_interfaces(createNeighbourhoodStorage(storeNeighbourhood)),
-      m_adjacencies(createNeighbourhoodStorage(storeNeighbourhood))
+      m_adjacencies(createNeighbourhoodStorage(storeNeighbourhood)),
+      m_sharedInterfaces(nullptr),
+      m_sharedAdjacencies(nullptr)
 {
 	_initialize(interior, false, false);
 }
@@ -153,7 +178,9 @@ Cell::Cell(long id, ElementType type, bool interior, bool storeNeighbourhood)
 Cell::Cell(long id, ElementType type, int connectSize, bool interior, bool storeNeighbourhood)
 	: Element(id, type, connectSize),
       m_interfaces(createNeighbourhoodStorage(storeNeighbourhood)),
-      m_adjacencies(createNeighbourhoodStorage(storeNeighbourhood))
+      m_adjacencies(createNeighbourhoodStorage(storeNeighbourhood)),
+      m_sharedInterfaces(nullptr),
+      m_sharedAdjacencies(nullptr)
 {
 	_initialize(interior, false, false);
 }
@@ -172,11 +199,50 @@ Cell::Cell(long id, ElementType type, int connectSize, bool interior, bool store
 Cell::Cell(long id, ElementType type, std::unique_ptr<long[]> &&connectStorage, bool interior, bool storeNeighbourhood)
 	: Element(id, type, std::move(connectStorage)),
       m_interfaces(createNeighbourhoodStorage(storeNeighbourhood)),
-      m_adjacencies(createNeighbourhoodStorage(storeNeighbourhood))
+      m_adjacencies(createNeighbourhoodStorage(storeNeighbourhood)),
+      m_sharedInterfaces(nullptr),
+      m_sharedAdjacencies(nullptr)
 {
 	_initialize(interior, false, false);
 }
 
+/*!
+	Copy constructor.
+
+	The copy will always store its data in storages owned by the cell, even
+	if the data of the original cell are stored in a shared buffer.
+
+	\param other is another cell whose content is copied in this cell
+*/
+Cell::Cell(const Cell &other)
+	: Element(other), m_interior(other.m_interior),
+      m_interfaces(other.m_interfaces),
+      m_adjacencies(other.m_adjacencies),
+      m_sharedInterfaces(nullptr),
+      m_sharedAdjacencies(nullptr)
+{
+	if (other.m_sharedInterfaces) {
+		importSharedNeighbourhood(other.m_sharedInterfaces, &m_interfaces);
+	}
+
+	if (other.m_sharedAdjacencies) {
+		importSharedNeighbourhood(other.m_sharedAdjacencies, &m_adjacencies);
+	}
+}
+
+/*!
+	Copy-assignament operator.
+
+	\param other is another cell whose content is copied in this cell
+*/
+Cell & Cell::operator=(const Cell &other)
+{
+	Cell tmp(other);
+	swap(tmp);
+
+	return *this;
+}
+
 /**
 * Exchanges the content of the cell by the content the specified other cell.
 *
@@ -190,6 +256,9 @@ void Cell::swap(Cell &other) noexcept
 
 	other.m_interfaces.swap(m_interfaces);
 	other.m_adjacencies.swap(m_adjacencies);
+
+	std::swap(other.m_sharedInterfaces, m_sharedInterfaces);
+	std::swap(other.m_sharedAdjacencies, m_sharedAdjacencies);
 }
 
 /*!
@@ -324,6 +393,7 @@ void Cell::deleteInterfaces()
 */
 void Cell::resetInterfaces(bool storeInterfaces)
 {
+	m_sharedInterfaces = nullptr;
 	m_interfaces = createNeighbourhoodStorage(storeInterfaces);
 }
 
@@ -338,6 +408,8 @@ void Cell::setInterfaces(std::vector<std::vector<long>> &interfaces)
 	    return;
 	}
 
+	unshareNeighbourhood(&m_sharedInterfaces, &m_interfaces);
+
 	assert(m_interfaces.size() == getFaceCount());
 	m_interfaces.initialize(interfaces);
 }
@@ -351,6 +423,11 @@ void Cell::setInterfaces(std::vector<std::vector<long>> &interfaces)
 */
 void Cell::setInterface(int face, int index, long interface)
 {
+	if (m_sharedInterfaces) {
+		m_sharedInterfaces[m_sharedInterfaces[face] + index] = interface;
+		return;
+	}
+
 	m_interfaces.setItem(face, index, interface);
 }
 
@@ -368,6 +445,7 @@ void Cell::pushInterface(int face, long interface)
 	}
 
 	// Add the interface
+	unshareNeighbourhood(&m_sharedInterfaces, &m_interfaces);
 	m_interfaces.pushBackItem(face, interface);
 }
 
@@ -380,6 +458,7 @@ void Cell::pushInterface(int face, long interface)
 */
 void Cell::deleteInterface(int face, int i)
 {
+	unshareNeighbourhood(&m_sharedInterfaces, &m_interfaces);
 	m_interfaces.eraseItem(face, i);
 }
 
@@ -393,6 +472,11 @@ void Cell::deleteInterface(int face, int i)
 */
 int Cell::getInterfaceCount() const
 {
+	if (m_sharedInterfaces) {
+		int nFaces = static_cast<int>(m_sharedInterfaces[0] - 1);
+		return static_cast<int>(m_sharedInterfaces[nFaces] - m_sharedInterfaces[0]);
+	}
+
 	return m_interfaces.getItemCount();
 }
 
@@ -407,6 +491,10 @@ int Cell::getInterfaceCount() const
 */
 int Cell::getInterfaceCount(int face) const
 {
+	if (m_sharedInterfaces) {
+		return static_cast<int>(m_sharedInterfaces[face + 1] - m_sharedInterfaces[face]);
+	}
+
 	return m_interfaces.getItemCount(face);
 }
 
@@ -419,6 +507,10 @@ int Cell::getInterfaceCount(int face) const
 */
 long Cell::getInterface(int face, int index) const
 {
+	if (m_sharedInterfaces) {
+		return m_sharedInterfaces[m_sharedInterfaces[face] + index];
+	}
+
 	return m_interfaces.getItem(face, index);
 }
 
@@ -429,7 +521,9 @@ long Cell::getInterface(int face, int index) const
 */
 const long * Cell::getInterfaces() const
 {
-	if (m_interfaces.empty()) {
+	if (m_sharedInterfaces) {
+		return m_sharedInterfaces + m_sharedInterfaces[0];
+	} else if (m_interfaces.empty()) {
 		return nullptr;
 	}
 
@@ -444,7 +538,9 @@ const long * Cell::getInterfaces() const
 */
 const long * Cell::getInterfaces(int face) const
 {
-	if (m_interfaces.empty()) {
+	if (m_sharedInterfaces) {
+		return m_sharedInterfaces + m_sharedInterfaces[face];
+	} else if (m_interfaces.empty()) {
 		return nullptr;
 	}
 
@@ -458,7 +554,9 @@ const long * Cell::getInterfaces(int face) const
 */
 long * Cell::getInterfaces()
 {
-	if (m_interfaces.empty()) {
+	if (m_sharedInterfaces) {
+		return m_sharedInterfaces + m_sharedInterfaces[0];
+	} else if (m_interfaces.empty()) {
 		return nullptr;
 	}
 
@@ -473,7 +571,9 @@ long * Cell::getInterfaces()
 */
 long * Cell::getInterfaces(int face)
 {
-	if (m_interfaces.empty()) {
+	if (m_sharedInterfaces) {
+		return m_sharedInterfaces + m_sharedInterfaces[face];
+	} else if (m_interfaces.empty()) {
 		return nullptr;
 	}
 
@@ -552,6 +652,7 @@ void Cell::deleteAdjacencies()
 */
 void Cell::resetAdjacencies(bool storeAdjacencies)
 {
+	m_sharedAdjacencies = nullptr;
 	m_adjacencies = createNeighbourhoodStorage(storeAdjacencies);
 }
 
@@ -566,7 +667,9 @@ void Cell::setAdjacencies(std::vector<std::vector<long>> &adjacencies)
 	    return;
 	}
 
-	assert(m_interfaces.size() == getFaceCount());
+	unshareNeighbourhood(&m_sharedAdjacencies, &m_adjacencies);
+
+	assert(m_adjacencies.size() == getFaceCount());
 	m_adjacencies.initialize(adjacencies);
 }
 
@@ -579,6 +682,11 @@ void Cell::setAdjacencies(std::vector<std::vector<long>> &adjacencies)
 */
 void Cell::setAdjacency(int face, int index, long adjacency)
 {
+	if (m_sharedAdjacencies) {
+		m_sharedAdjacencies[m_sharedAdjacencies[face] + index] = adjacency;
+		return;
+	}
+
 	m_adjacencies.setItem(face, index, adjacency);
 }
 
@@ -596,6 +704,7 @@ void Cell::pushAdjacency(int face, long adjacency)
 	}
 
 	// Add the adjacency
+	unshareNeighbourhood(&m_sharedAdjacencies, &m_adjacencies);
 	m_adjacencies.pushBackItem(face, adjacency);
 }
 
@@ -608,6 +717,7 @@ void Cell::pushAdjacency(int face, long adjacency)
 */
 void Cell::deleteAdjacency(int face, int i)
 {
+	unshareNeighbourhood(&m_sharedAdjacencies, &m_adjacencies);
 	m_adjacencies.eraseItem(face, i);
 }
 
@@ -621,6 +731,11 @@ void Cell::deleteAdjacency(int face, int i)
 */
 int Cell::getAdjacencyCount() const
 {
+	if (m_sharedAdjacencies) {
+		int nFaces = static_cast<int>(m_sharedAdjacencies[0] - 1);
+		return static_cast<int>(m_sharedAdjacencies[nFaces] - m_sharedAdjacencies[0]);
+	}
+
 	return m_adjacencies.getItemCount();
 }
 
@@ -635,6 +750,10 @@ int Cell::getAdjacencyCount() const
 */
 int Cell::getAdjacencyCount(int face) const
 {
+	if (m_sharedAdjacencies) {
+		return static_cast<int>(m_sharedAdjacencies[face + 1] - m_sharedAdjacencies[face]);
+	}
+
 	return m_adjacencies.getItemCount(face);
 }
 
@@ -647,6 +766,10 @@ int Cell::getAdjacencyCount(int face) const
 */
 long Cell::getAdjacency(int face, int index) const
 {
+	if (m_sharedAdjacencies) {
+		return m_sharedAdjacencies[m_sharedAdjacencies[face] + index];
+	}
+
 	return m_adjacencies.getItem(face, index);
 }
 
@@ -657,7 +780,9 @@ long Cell::getAdjacency(int face, int index) const
 */
 const long * Cell::getAdjacencies() const
 {
-	if (m_adjacencies.empty()) {
+	if (m_sharedAdjacencies) {
+		return m_sharedAdjacencies + m_sharedAdjacencies[0];
+	} else if (m_adjacencies.empty()) {
 		return nullptr;
 	}
 
@@ -672,7 +797,9 @@ const long * Cell::getAdjacencies() const
 */
 const long * Cell::getAdjacencies(int face) const
 {
-	if (m_adjacencies.empty()) {
+	if (m_sharedAdjacencies) {
+		return m_sharedAdjacencies + m_sharedAdjacencies[face];
+	} else if (m_adjacencies.empty()) {
 		return nullptr;
 	}
 
@@ -686,7 +813,9 @@ const long * Cell::getAdjacencies(int face) const
 */
 long * Cell::getAdjacencies()
 {
-	if (m_adjacencies.empty()) {
+	if (m_sharedAdjacencies) {
+		return m_sharedAdjacencies + m_sharedAdjacencies[0];
+	} else if (m_adjacencies.empty()) {
 		return nullptr;
 	}
 
@@ -701,7 +830,9 @@ long * Cell::getAdjacencies()
 */
 long * Cell::getAdjacencies(int face)
 {
-	if (m_adjacencies.empty()) {
+	if (m_sharedAdjacencies) {
+		return m_sharedAdjacencies + m_sharedAdjacencies[face];
+	} else if (m_adjacencies.empty()) {
 		return nullptr;
 	}
 
@@ -761,7 +892,7 @@ int Cell::findAdjacency(int adjacency)
 */
 bool Cell::isFaceBorder(int face) const
 {
-	return (m_adjacencies.getItemCount(face) == 0);
+	return (getAdjacencyCount(face) == 0);
 }
 
 /*!
@@ -816,7 +947,7 @@ void Cell::display(std::ostream &out, unsigned short int indent) const
 	else                                       out << cellVertexIds[nv-1] << " ]" << std::endl;
 
 	// neighbors infos ------------------------------------------------------ //
-        if (m_adjacencies.size() > 0) {
+        if (m_sharedAdjacencies || m_adjacencies.size() > 0) {
             out << t_s << "neighbors:    [ ";
             for (i = 0; i < nf; ++i) {
                 nn = getAdjacencyCount(i);
@@ -842,7 +973,7 @@ void Cell::display(std::ostream &out, unsigned short int indent) const
         }
 
         // interface infos ------------------------------------------------------ //
-        if (m_interfaces.size() > 0) {
+        if (m_sharedInterfaces || m_interfaces.size() > 0) {
             out << t_s << "interfaces:   [ ";
             for (i = 0; i < nf; ++i) {
                 nn = getInterfaceCount(i);
@@ -876,7 +1007,209 @@ void Cell::display(std::ostream &out, unsigned short int indent) const
 */
 unsigned int Cell::getBinarySize() const
 {
-    return (Element::getBinarySize() + m_interfaces.getBinarySize() + m_adjacencies.getBinarySize());
+    unsigned int binarySize = Element::getBinarySize();
+
+    if (m_sharedInterfaces) {
+        int nFaces = static_cast<int>(m_sharedInterfaces[0] - 1);
+        binarySize += (2 + nFaces + 1) * sizeof(std::size_t) + getInterfaceCount() * sizeof(long);
+    } else {
+        binarySize += m_interfaces.getBinarySize();
+    }
+
+    if (m_sharedAdjacencies) {
+        int nFaces = static_cast<int>(m_sharedAdjacencies[0] - 1);
+        binarySize += (2 + nFaces + 1) * sizeof(std::size_t) + getAdjacencyCount() * sizeof(long);
+    } else {
+        binarySize += m_adjacencies.getBinarySize();
+    }
+
+    return binarySize;
+}
+
+/*!
+	Checks if some data of the cell are stored in a buffer not owned by the
+	cell.
+
+	\result Returns true if some data of the cell are stored in a buffer not
+	owned by the cell, false otherwise.
+*/
+bool Cell::hasSharedStorage() const
+{
+	return (hasSharedConnect() || m_sharedInterfaces || m_sharedAdjacencies);
+}
+
+/*!
+	Evaluates the size of the portion of a shared buffer needed to store
+	connectivity, interfaces and adjacencies of the cell.
+
+	\result The size, expressed in number of items, of the portion of a
+	shared buffer needed to store the data of the cell.
+*/
+std::size_t Cell::evalSharedStorageSize() const
+{
+	std::size_t size = 0;
+	if (getConnect()) {
+		size += getConnectSize();
+	}
+
+	size += evalSharedNeighbourhoodSize(m_sharedInterfaces, m_interfaces);
+	size += evalSharedNeighbourhoodSize(m_sharedAdjacencies, m_adjacencies);
+
+	return size;
+}
+
+/*!
+	Moves connectivity, interfaces and adjacencies of the cell into the
+	specified buffer.
+
+	The buffer should be large enough to contain all the data of the cell
+	(see evalSharedStorageSize) and it has to be kept alive for as long as
+	the cell uses it. Storages previously owned by the cell are released.
+
+	\param buffer is the buffer where the data will be moved
+	\result A pointer to the first item of the buffer past the data of the
+	cell.
+*/
+long * Cell::shareStorage(long *buffer)
+{
+	// Connectivity
+	long *connect = getConnect();
+	if (connect) {
+		int connectSize = getConnectSize();
+		std::copy(connect, connect + connectSize, buffer);
+		setSharedConnect(buffer);
+		buffer += connectSize;
+	}
+
+	// Neighbourhood
+	buffer = shareNeighbourhood(buffer, &m_sharedInterfaces, &m_interfaces);
+	buffer = shareNeighbourhood(buffer, &m_sharedAdjacencies, &m_adjacencies);
+
+	return buffer;
+}
+
+/*!
+	Moves connectivity, interfaces and adjacencies of the cell into storages
+	owned by the cell.
+*/
+void Cell::unshareStorage()
+{
+	unshareConnect();
+
+	unshareNeighbourhood(&m_sharedInterfaces, &m_interfaces);
+	unshareNeighbourhood(&m_sharedAdjacencies, &m_adjacencies);
+}
+
+/*!
+	Evaluates the size of the portion of a shared buffer needed to store
+	the specified neighbourhood (i.e., interfaces or adjacencies).
+
+	\param sharedNeighbourhood is the neighbourhood stored in a shared buffer,
+	a null pointer means that the neighbourhood is not stored in a shared
+	buffer
+	\param neighbourhood is the neighbourhood stored in a storage owned by
+	the cell
+	\result The size, expressed in number of items, of the portion of a
+	shared buffer needed to store the neighbourhood.
+*/
+std::size_t Cell::evalSharedNeighbourhoodSize(const long *sharedNeighbourhood, const bitpit::FlatVector2D<long> &neighbourhood)
+{
+	if (sharedNeighbourhood) {
+		int nFaces = static_cast<int>(sharedNeighbourhood[0] - 1);
+		return static_cast<std::size_t>(sharedNeighbourhood[nFaces]);
+	} else if (neighbourhood.empty()) {
+		return 0;
+	}
+
+	return (neighbourhood.size() + 1 + neighbourhood.getItemCount());
+}
+
+/*!
+	Moves the specified neighbourhood (i.e., interfaces or adjacencies)
+	into a shared buffer.
+
+	In the shared buffer, the neighbourhood of a cell with n faces is stored
+	using n + 1 offsets followed by the items of all the faces. The offsets
+	are relative to the beginning of the neighbourhood, hence the items of
+	the i-th face are stored in the range [offsets[i], offsets[i + 1]). The
+	first offset is always equal to n + 1, therefore the number of faces
+	can be deduced from the offsets.
+
+	\param buffer is the buffer where the neighbourhood will be moved
+	\param[in,out] sharedNeighbourhood is the neighbourhood stored in a
+	shared buffer, on output it will point to the neighbourhood stored in
+	the specified buffer
+	\param[in,out] neighbourhood is the neighbourhood stored in a storage
+	owned by the cell, on output the storage will be destroyed
+	\result A pointer to the first item of the buffer past the neighbourhood.
+*/
+long * Cell::shareNeighbourhood(long *buffer, long **sharedNeighbourhood, bitpit::FlatVector2D<long> *neighbourhood)
+{
+	if (*sharedNeighbourhood) {
+		std::size_t size = evalSharedNeighbourhoodSize(*sharedNeighbourhood, *neighbourhood);
+		std::copy(*sharedNeighbourhood, *sharedNeighbourhood + size, buffer);
+		*sharedNeighbourhood = buffer;
+
+		return (buffer + size);
+	} else if (neighbourhood->empty()) {
+		return buffer;
+	}
+
+	int nFaces = neighbourhood->size();
+	const std::size_t *indices = neighbourhood->indices();
+	for (int i = 0; i <= nFaces; ++i) {
+		buffer[i] = static_cast<long>(nFaces + 1 + indices[i]);
+	}
+
+	int nItems = neighbourhood->getItemCount();
+	std::copy(neighbourhood->data(), neighbourhood->data() + nItems, buffer + nFaces + 1);
+
+	neighbourhood->destroy();
+	*sharedNeighbourhood = buffer;
+
+	return (buffer + nFaces + 1 + nItems);
+}
+
+/*!
+	Moves the specified neighbourhood (i.e., interfaces or adjacencies)
+	from a shared buffer into a storage owned by the cell.
+
+	\param[in,out] sharedNeighbourhood is the neighbourhood stored in a
+	shared buffer, on output it will be set to a null pointer
+	\param[in,out] neighbourhood is the storage owned by the cell where
+	the neighbourhood will be moved
+*/
+void Cell::unshareNeighbourhood(long **sharedNeighbourhood, bitpit::FlatVector2D<long> *neighbourhood)
+{
+	if (!(*sharedNeighbourhood)) {
+		return;
+	}
+
+	importSharedNeighbourhood(*sharedNeighbourhood, neighbourhood);
+	*sharedNeighbourhood = nullptr;
+}
+
+/*!
+	Copies the specified neighbourhood (i.e., interfaces or adjacencies)
+	stored in a shared buffer into the specified storage.
+
+	\param sharedNeighbourhood is the neighbourhood stored in a shared buffer
+	\param[out] neighbourhood is the storage where the neighbourhood will be
+	copied
+*/
+void Cell::importSharedNeighbourhood(const long *sharedNeighbourhood, bitpit::FlatVector2D<long> *neighbourhood)
+{
+	int nFaces = static_cast<int>(sharedNeighbourhood[0] - 1);
+
+	std::vector<int> sizes(nFaces);
+	for (int i = 0; i < nFaces; ++i) {
+		sizes[i] = static_cast<int>(sharedNeighbourhood[i + 1] - sharedNeighbourhood[i]);
+	}
+
+	neighbourhood->initialize(sizes);
+
+	const long *items = sharedNeighbourhood + sharedNeighbourhood[0];
+	std::copy(items, items + (sharedNeighbourhood[nFaces] - sharedNeighbourhood[0]), neighbourhood->data());
 }
 
 /*!
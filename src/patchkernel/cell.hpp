@@ -57,9 +57,9 @@ public:
 	Cell(long id, ElementType type, std::unique_ptr<long[]> &&connectStorage,
 	     bool interior = true, bool storeNeighbourhood = true);
 
-	Cell(const Cell &other) = default;
+	Cell(const Cell &other);
 	Cell(Cell&& other) = default;
-	Cell& operator = (const Cell &other) = default;
+	Cell& operator = (const Cell &other);
 	Cell& operator=(Cell&& other) = default;
 
 	void swap(Cell &other) noexcept;
@@ -117,8 +117,21 @@ private:
 	bitpit::FlatVector2D<long> m_interfaces;
 	bitpit::FlatVector2D<long> m_adjacencies;
 
+	long *m_sharedInterfaces;
+	long *m_sharedAdjacencies;
+
 	bitpit::FlatVector2D<long> createNeighbourhoodStorage(bool storeNeighbourhood);
 
+	bool hasSharedStorage() const;
+	std::size_t evalSharedStorageSize() const;
+	long * shareStorage(long *buffer);
+	void unshareStorage();
+
+	static std::size_t evalSharedNeighbourhoodSize(const long *sharedNeighbourhood, const bitpit::FlatVector2D<long> &neighbourhood);
+	static long * shareNeighbourhood(long *buffer, long **sharedNeighbourhood, bitpit::FlatVector2D<long> *neighbourhood);
+	static void unshareNeighbourhood(long **sharedNeighbourhood, bitpit::FlatVector2D<long> *neighbourhood);
+	static void importSharedNeighbourhood(const long *sharedNeighbourhood, bitpit::FlatVector2D<long> *neighbourhood);
+
 	void _initialize(bool interior, bool initializeNeighbourhood, bool storeNeighbourhood);
 
 };
@@ -457,15 +457,20 @@ void Element::_initialize(long id, ElementType type, int connectSize)
 		connectSize = ReferenceElementInfo::getInfo(type).nVertices;
 	}
 
-	std::unique_ptr<long[]> connectStorage;
-	if (connectSize != previousConnectSize) {
-		connectStorage = std::unique_ptr<long[]>(new long[connectSize]);
+	// Initialize element
+	//
+	// The current connectivity storage is re-used if it has the proper size.
+	// Shared storages are never re-used: the element may be a stale element
+	// (e.g., an element previously deleted from a container) whose shared
+	// storage is no longer valid.
+	if (connectSize != previousConnectSize || hasSharedConnect()) {
+		std::unique_ptr<long[]> connectStorage = std::unique_ptr<long[]>(new long[connectSize]);
+		_initialize(id, type, std::move(connectStorage));
 	} else {
-		connectStorage = std::move(m_connect);
+		setId(id);
+		setType(type);
+		setPID(0);
 	}
-
-	// Initialize element
-	_initialize(id, type, std::move(connectStorage));
 }
 
 /*!
@@ -579,7 +584,24 @@ int Element::getPID() const
 */
 void Element::setConnect(std::unique_ptr<long[]> &&connect)
 {
-	m_connect = std::move(connect);
+	m_connect = std::unique_ptr<long[], ConnectDeleter>(connect.release(), ConnectDeleter(true));
+}
+
+/*!
+	Sets the vertex connectivity of the element using a storage that is
+	not owned by the element.
+
+	The storage is typically a buffer shared among several elements (e.g.,
+	a storage arena owned by the patch) and it should already contain the
+	connectivity of the element. The element will not release the storage,
+	it's up to the owner of the buffer to keep it alive for as long as the
+	element uses it.
+
+	\param connect a pointer to the connectivity of the element
+*/
+void Element::setSharedConnect(long *connect)
+{
+	m_connect = std::unique_ptr<long[], ConnectDeleter>(connect, ConnectDeleter(false));
 }
 
 /*!
@@ -590,6 +612,39 @@ void Element::unsetConnect()
 	m_connect.reset(nullptr);
 }
 
+/*!
+	Checks if the vertex connectivity of the element is stored in a buffer
+	not owned by the element.
+
+	\result Returns true if the vertex connectivity of the element is stored
+	in a buffer not owned by the element, false otherwise.
+*/
+bool Element::hasSharedConnect() const
+{
+	return (m_connect && !m_connect.get_deleter().owned);
+}
+
+/*!
+	Moves the vertex connectivity of the element to a storage owned by the
+	element.
+
+	If the connectivity is stored in a buffer not owned by the element, the
+	connectivity is copied into a newly allocated storage owned by the
+	element, otherwise the function does nothing.
+*/
+void Element::unshareConnect()
+{
+	if (!hasSharedConnect()) {
+		return;
+	}
+
+	int connectSize = getConnectSize();
+	std::unique_ptr<long[]> connectStorage = std::unique_ptr<long[]>(new long[connectSize]);
+	std::copy(m_connect.get(), m_connect.get() + connectSize, connectStorage.get());
+
+	setConnect(std::move(connectStorage));
+}
+
 /*!
 	Gets the vertex connectivity of the element.
 
@@ -1911,7 +1966,7 @@ std::vector<ConstProxyVector<long>> Element::evalEdgeConnects(int nRequestedEdge
 unsigned int Element::getBinarySize() const
 {
 	unsigned int binarySize = sizeof(m_type) + sizeof(m_id) + getConnectSize() * sizeof(long) + sizeof(m_pid);
-	if (bitpit::ReferenceElementInfo::hasInfo(m_type)) {
+	if (!bitpit::ReferenceElementInfo::hasInfo(m_type)) {
 		binarySize += sizeof(int);
 	}
 
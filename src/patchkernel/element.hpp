@@ -115,7 +115,10 @@ public:
 	bool isThreeDimensional() const;
 	
 	void setConnect(std::unique_ptr<long[]> &&connect);
+	void setSharedConnect(long *connect);
 	void unsetConnect();
+	bool hasSharedConnect() const;
+	void unshareConnect();
 	int getConnectSize() const;
 	const long * getConnect() const;
 	long * getConnect();
@@ -198,7 +201,36 @@ private:
 
 	int m_pid;
 
-	std::unique_ptr<long[]> m_connect;
+	/*!
+		Deleter for the connectivity storage.
+
+		The connectivity may be stored in a buffer shared among several
+		elements (e.g., a storage arena owned by the patch). Such a storage
+		is not owned by the element and it will not be released when the
+		element is destroyed.
+	*/
+	struct ConnectDeleter {
+		bool owned;
+
+		ConnectDeleter()
+			: owned(true)
+		{
+		}
+
+		ConnectDeleter(bool isOwned)
+			: owned(isOwned)
+		{
+		}
+
+		void operator()(long *connect) const
+		{
+			if (owned) {
+				delete[] connect;
+			}
+		}
+	};
+
+	std::unique_ptr<long[], ConnectDeleter> m_connect;
 
 	void _initialize(long id, ElementType type = ElementType::UNDEFINED, int connectSize = 0);
 	void _initialize(long id, ElementType type, std::unique_ptr<long[]> &&connectStorage);
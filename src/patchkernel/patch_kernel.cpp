@@ -24,6 +24,7 @@
 
 #include <sstream>
 #include <typeinfo>
+#include <tuple>
 #include <unordered_map>
 #include <unordered_set>
 #if BITPIT_ENABLE_MPI==1
@@ -137,6 +138,7 @@ PatchKernel::PatchKernel(const PatchKernel &other)
       m_boxMaxCounter(other.m_boxMaxCounter),
       m_adjacenciesBuildStrategy(other.m_adjacenciesBuildStrategy),
       m_interfacesBuildStrategy(other.m_interfacesBuildStrategy),
+      m_elementStorageMode(other.m_elementStorageMode),
       m_spawnStatus(other.m_spawnStatus),
       m_adaptionStatus(other.m_adaptionStatus),
       m_expert(other.m_expert),
@@ -162,6 +164,16 @@ PatchKernel::PatchKernel(const PatchKernel &other)
 	// Register the patch
 	patch::manager().registerPatch(this);
 
+	// Pack cells and interfaces into the storage arenas
+	//
+	// Copied elements always store their data in storages owned by the
+	// elements, if needed, the data has to be moved into the arenas of
+	// this patch.
+	if (m_elementStorageMode == ELEMENT_STORAGE_ARENA) {
+		compactCellStorageArena();
+		compactInterfaceStorageArena();
+	}
+
 	// Update the VTK streamer
 	//
 	// The pointer to VTK streamers are copied, if there are pointer to the
@@ -242,6 +254,9 @@ void PatchKernel::initialize()
 	// Set interfaces build strategy
 	setInterfacesBuildStrategy(INTERFACES_NONE);
 
+	// Elements store their data individually
+	m_elementStorageMode = ELEMENT_STORAGE_INDIVIDUAL;
+
 	// Set the spawn as unneeded
 	//
 	// Specific implementation will set the appropriate status during their
@@ -589,6 +604,8 @@ void PatchKernel::endAlteration(bool squeezeStorage)
 	m_interfaces.flush();
 	m_vertices.flush();
 
+	_cellsAltered();
+
 	// Squeeze data structures
 	if (squeezeStorage) {
 		squeeze();
@@ -719,6 +736,8 @@ void PatchKernel::resetCells()
 {
 	m_cells.clear();
 	PiercedVector<Cell>().swap(m_cells);
+	_cellsAltered();
+	std::vector<long>().swap(m_cellStorageArena);
 	m_cellIdGenerator.reset();
 	m_nInternals = 0;
 #if BITPIT_ENABLE_MPI==1
@@ -752,6 +771,7 @@ void PatchKernel::resetInterfaces()
 	// Clear interfaces
 	m_interfaces.clear();
 	PiercedVector<Interface>().swap(m_interfaces);
+	std::vector<long>().swap(m_interfaceStorageArena);
 	m_interfaceIdGenerator.reset();
 
 	for (auto &cell : m_cells) {
@@ -1999,6 +2019,8 @@ PatchKernel::CellIterator PatchKernel::_addInternal(ElementType type, std::uniqu
 	}
 	m_nInternals++;
 
+	_cellsAltered();
+
 	// Update the id of the last internal cell
 	if (m_lastInternalId < 0) {
 		m_lastInternalId = id;
@@ -2142,6 +2164,7 @@ bool PatchKernel::deleteCells(const std::vector<long> &ids, bool updateNeighs, b
 
 	if (!delayed) {
 		m_cells.flush();
+		_cellsAltered();
 	}
 
 	return true;
@@ -2157,6 +2180,7 @@ void PatchKernel::_deleteInternal(long id, bool delayed)
 {
 	m_cells.erase(id, delayed);
 	m_nInternals--;
+	_cellsAltered();
 	if (id == m_lastInternalId) {
 		updateLastInternalId();
 	}
@@ -3535,6 +3559,7 @@ void PatchKernel::restoreCells(std::istream &stream)
 {
 	// Restore kernel
 	m_cells.restoreKernel(stream);
+	_cellsAltered();
 
 	// Enable advanced editing
 	bool originalExpertStatus = isExpert();
@@ -3589,8 +3614,8 @@ void PatchKernel::restoreCells(std::istream &stream)
 #endif
 
 	// Restore adjacencies
-	if (getAdjacenciesBuildStrategy() == ADJACENCIES_AUTOMATIC) {
-		buildAdjacencies();
+	if (getAdjacenciesBuildStrategy() != ADJACENCIES_NONE) {
+		buildAdjacencies(getAdjacenciesBuildStrategy());
 	}
 
 #if BITPIT_ENABLE_MPI==1
@@ -3869,6 +3894,8 @@ bool PatchKernel::sortCells()
 		return false;
 	}
 
+	_cellsAltered();
+
 	// Sort internal cells
 	if (m_nInternals > 0) {
 		m_cells.sortBefore(m_lastInternalId, true);
@@ -3945,6 +3972,11 @@ bool PatchKernel::squeezeCells()
 	}
 
 	m_cells.squeeze();
+	_cellsAltered();
+
+	if (m_elementStorageMode == ELEMENT_STORAGE_ARENA) {
+		compactCellStorageArena();
+	}
 
 	return true;
 }
@@ -3964,6 +3996,10 @@ bool PatchKernel::squeezeInterfaces()
 
 	m_interfaces.squeeze();
 
+	if (m_elementStorageMode == ELEMENT_STORAGE_ARENA) {
+		compactInterfaceStorageArena();
+	}
+
 	return true;
 }
 
@@ -3983,6 +4019,142 @@ bool PatchKernel::squeeze()
 	return status;
 }
 
+/*!
+	Gets the storage mode of the elements (i.e., cells and interfaces).
+
+	\result The storage mode of the elements.
+*/
+PatchKernel::ElementStorageMode PatchKernel::getElementStorageMode() const
+{
+	return m_elementStorageMode;
+}
+
+/*!
+	Sets the storage mode of the elements (i.e., cells and interfaces).
+
+	With the individual storage mode, every element owns the storages for
+	its connectivity and, for cells, for its interfaces and adjacencies.
+	This means several small heap allocations for each element.
+
+	With the arena storage mode, connectivity, interfaces and adjacencies
+	of all the elements are packed into large buffers owned by the patch
+	(one for the cells and one for the interfaces). Data of each element
+	is stored contiguously and elements are packed in the same order they
+	have in their container, this avoids memory fragmentation and improves
+	cache locality when iterating over the elements or their neighbours.
+
+	Elements created after the arenas have been packed, or elements whose
+	data changed size (e.g., when a new adjacency is added), store their
+	data individually until the arenas are compacted again. Compaction is
+	performed when the mode is set and every time the cells or interfaces
+	of the patch are squeezed.
+
+	\param mode is the storage mode of the elements
+*/
+void PatchKernel::setElementStorageMode(ElementStorageMode mode)
+{
+	if (mode == m_elementStorageMode) {
+		return;
+	}
+
+	m_elementStorageMode = mode;
+	if (m_elementStorageMode == ELEMENT_STORAGE_ARENA) {
+		compactCellStorageArena();
+		compactInterfaceStorageArena();
+	} else {
+		releaseCellStorageArena();
+		releaseInterfaceStorageArena();
+	}
+}
+
+/*!
+	Packs connectivity, interfaces and adjacencies of all the cells into
+	the cell storage arena.
+
+	Cell data is copied into a newly allocated arena following the order
+	of the cells in their storage, the previous arena is released only
+	after all the cells have been moved into the new arena. The storage
+	of deleted cells, as well as storages of cells whose data has been
+	moved out of the arena, are reclaimed.
+*/
+void PatchKernel::compactCellStorageArena()
+{
+	std::size_t arenaSize = 0;
+	for (const Cell &cell : m_cells) {
+		arenaSize += cell.evalSharedStorageSize();
+	}
+
+	std::vector<long> arena(arenaSize);
+	long *buffer = arena.data();
+	for (Cell &cell : m_cells) {
+		buffer = cell.shareStorage(buffer);
+	}
+	assert(buffer == arena.data() + arenaSize);
+
+	m_cellStorageArena.swap(arena);
+}
+
+/*!
+	Moves connectivity, interfaces and adjacencies of all the cells out of
+	the cell storage arena and releases the arena.
+*/
+void PatchKernel::releaseCellStorageArena()
+{
+	for (Cell &cell : m_cells) {
+		cell.unshareStorage();
+	}
+
+	std::vector<long>().swap(m_cellStorageArena);
+}
+
+/*!
+	Packs the connectivity of all the interfaces into the interface storage
+	arena.
+
+	Interface data is copied into a newly allocated arena following the
+	order of the interfaces in their storage, the previous arena is released
+	only after all the interfaces have been moved into the new arena.
+*/
+void PatchKernel::compactInterfaceStorageArena()
+{
+	std::size_t arenaSize = 0;
+	for (const Interface &interface : m_interfaces) {
+		if (interface.getConnect()) {
+			arenaSize += interface.getConnectSize();
+		}
+	}
+
+	std::vector<long> arena(arenaSize);
+	long *buffer = arena.data();
+	for (Interface &interface : m_interfaces) {
+		long *connect = interface.getConnect();
+		if (!connect) {
+			continue;
+		}
+
+		int connectSize = interface.getConnectSize();
+		std::copy(connect, connect + connectSize, buffer);
+		interface.setSharedConnect(buffer);
+		buffer += connectSize;
+	}
+	assert(buffer == arena.data() + arenaSize);
+
+	m_interfaceStorageArena.swap(arena);
+}
+
+/*!
+	Moves the connectivity of all the interfaces out of the interface
+	storage arena and releases the arena.
+*/
+void PatchKernel::releaseInterfaceStorageArena()
+{
+	for (Interface &interface : m_interfaces) {
+		interface.unshareConnect();
+	}
+
+	std::vector<long>().swap(m_interfaceStorageArena);
+}
+
 /*!
 	Evaluates the centroid of the specified cell.
 
@@ -4189,15 +4361,29 @@ void PatchKernel::setAdjacenciesBuildStrategy(AdjacenciesBuildStrategy status)
 
 /*!
 	Fill adjacencies info for each cell.
+
+	The build strategy will be used also for all the subsequent updates of
+	the adjacencies. With the automatic strategy, matching faces are found
+	using a hash table of the half-faces. With the sorted strategy, matching
+	faces are found sorting a flat list of face keys and sweeping through
+	the sorted list. The sorted strategy has a lower memory footprint and,
+	when multi-threading is enabled, sorts the keys concurrently.
+
+	\param strategy is the adjacencies build strategy that will be used
 */
-void PatchKernel::buildAdjacencies()
+void PatchKernel::buildAdjacencies(AdjacenciesBuildStrategy strategy)
 {
 	// Reset adjacencies
 	if (getAdjacenciesBuildStrategy() != ADJACENCIES_NONE) {
 		clearAdjacencies();
 	}
 
+	if (strategy == ADJACENCIES_NONE) {
+		return;
+	}
+
 	// Update the adjacencies
+	setAdjacenciesBuildStrategy(strategy);
 	updateAdjacencies(m_cells.getIds(false));
 }
 
@@ -4205,11 +4391,45 @@ void PatchKernel::buildAdjacencies()
 	Update the adjacencies of the specified list of cells and of their
 	neighbours.
 
+	Adjacencies are updated using the current build strategy. If no
+	adjacencies have been built yet, the automatic strategy is used.
+
 	This implementation can NOT handle hanging nodes.
 
 	\param[in] cellIds is the list of cell ids
 */
 void PatchKernel::updateAdjacencies(const std::vector<long> &cellIds)
+{
+	// Get the build strategy
+	AdjacenciesBuildStrategy strategy = getAdjacenciesBuildStrategy();
+	if (strategy == ADJACENCIES_NONE) {
+		strategy = ADJACENCIES_AUTOMATIC;
+	}
+
+	// Update the adjacencies
+	switch (strategy) {
+
+	case ADJACENCIES_SORTED:
+		updateAdjacenciesSorting(cellIds);
+		break;
+
+	default:
+		updateAdjacenciesHashing(cellIds);
+		break;
+
+	}
+
+	// Set adjacencies build strategy
+	setAdjacenciesBuildStrategy(strategy);
+}
+
+/*!
+	Update the adjacencies of the specified list of cells and of their
+	neighbours looking for matching half-faces in a hash table.
+
+	\param[in] cellIds is the list of cell ids
+*/
+void PatchKernel::updateAdjacenciesHashing(const std::vector<long> &cellIds)
 {
 	// The adjacencies are found looking for matching half-faces.
 	//
@@ -4324,9 +4544,197 @@ void PatchKernel::updateAdjacencies(const std::vector<long> &cellIds)
 			}
 		}
 	}
+}
 
-	// Set adjacencies build strategy
-	setAdjacenciesBuildStrategy(ADJACENCIES_AUTOMATIC);
+/*!
+	Update the adjacencies of the specified list of cells and of their
+	neighbours looking for matching half-faces in a sorted list.
+
+	Each half-face is identified by a key evaluated from its vertex ids.
+	Keys are stored in a flat array, sorted and then swept linearly: the
+	half-faces that share the same key are candidate neighbours. This
+	requires less memory than a hash table of half-faces and allows to
+	sort the keys concurrently.
+
+	\param[in] cellIds is the list of cell ids
+*/
+void PatchKernel::updateAdjacenciesSorting(const std::vector<long> &cellIds)
+{
+	// Matching rules are the same used when searching the half-faces in a
+	// hash table (see updateAdjacenciesHashing): on three-dimensional
+	// patches a face can only be shared by two half-faces with reverse
+	// winding, on lower dimension patches a face can be shared by any
+	// number of half-faces regardless of their winding.
+	//
+	// Half-faces of the non-updated cells are needed to find matches for
+	// the faces of the updated cells, however no adjacencies are created
+	// between two non-updated half-faces.
+	bool multipleMatchesAllowed = (getDimension() < 3);
+
+	// List the half-faces
+	struct HalfFaceInfo {
+		Cell *cell;
+		int face;
+		bool updated;
+	};
+
+	std::vector<HalfFaceInfo> halfFaces;
+	std::vector<std::size_t> faceVertexOffsets;
+
+	auto listCellHalfFaces = [&](Cell &cell, bool updated) {
+		int nCellFaces = cell.getFaceCount();
+		for (int face = 0; face < nCellFaces; ++face) {
+			if (!updated && !multipleMatchesAllowed && !cell.isFaceBorder(face)) {
+				continue;
+			}
+
+			halfFaces.push_back({&cell, face, updated});
+			faceVertexOffsets.push_back(faceVertexOffsets.back() + cell.getFaceVertexCount(face));
+		}
+	};
+
+	halfFaces.reserve(2 * cellIds.size());
+	faceVertexOffsets.reserve(2 * cellIds.size() + 1);
+	faceVertexOffsets.push_back(0);
+
+	if ((long) cellIds.size() != getCellCount()) {
+		std::unordered_set<long> updateCellSet(cellIds.begin(), cellIds.end());
+		for (Cell &cell : m_cells) {
+			if (updateCellSet.count(cell.getId()) == 0) {
+				listCellHalfFaces(cell, false);
+			}
+		}
+	}
+
+	for (long cellId : cellIds) {
+		listCellHalfFaces(m_cells[cellId], true);
+	}
+
+	std::size_t nHalfFaces = halfFaces.size();
+	if (nHalfFaces == 0) {
+		return;
+	}
+
+	// Evaluate the keys
+	//
+	// The vertices of the faces are stored in their natural order, the key
+	// used for sorting the half-faces is made of the smallest vertex id and
+	// of an hash of the vertices that does not depend on their order. Using
+	// the smallest vertex id as leading part of the key, the half-faces are
+	// sorted in an order that follows the vertex numbering and cells are
+	// accessed with better locality when the adjacencies are generated.
+	typedef std::tuple<long, std::size_t, std::size_t> HalfFaceKey;
+
+	std::vector<long> faceVertices(faceVertexOffsets.back());
+	std::vector<HalfFaceKey> keys(nHalfFaces);
+
+#if BITPIT_ENABLE_OPENMP==1
+	#pragma omp parallel for schedule(static)
+#endif
+	for (std::size_t i = 0; i < nHalfFaces; ++i) {
+		const HalfFaceInfo &halfFace = halfFaces[i];
+		const Cell &cell = *(halfFace.cell);
+
+		long *halfFaceVertices = faceVertices.data() + faceVertexOffsets[i];
+		std::size_t nHalfFaceVertices = faceVertexOffsets[i + 1] - faceVertexOffsets[i];
+		if (cell.hasInfo()) {
+			ConstProxyVector<long> cellVertexIds = cell.getVertexIds();
+			ConstProxyVector<int> faceLocalVertexIds = cell.getFaceLocalVertexIds(halfFace.face);
+			for (std::size_t k = 0; k < nHalfFaceVertices; ++k) {
+				halfFaceVertices[k] = cellVertexIds[faceLocalVertexIds[k]];
+			}
+		} else {
+			ConstProxyVector<long> faceVertexIds = cell.getFaceVertexIds(halfFace.face);
+			std::copy(faceVertexIds.cbegin(), faceVertexIds.cend(), halfFaceVertices);
+		}
+
+		long minVertex = halfFaceVertices[0];
+		std::size_t hash = nHalfFaceVertices;
+		for (std::size_t k = 0; k < nHalfFaceVertices; ++k) {
+			minVertex = std::min(halfFaceVertices[k], minVertex);
+
+			std::size_t vertexHash = static_cast<std::size_t>(halfFaceVertices[k]) * 0x9e3779b97f4a7c15ULL;
+			vertexHash ^= (vertexHash >> 29);
+			hash += vertexHash * 0xbf58476d1ce4e5b9ULL;
+		}
+
+		keys[i] = HalfFaceKey(minVertex, hash, i);
+	}
+
+	// Sort the half-faces
+	utils::parallelSort(keys.begin(), keys.end());
+
+	// Match the half-faces
+	//
+	// Candidate matches are the half-faces with the same key, candidates
+	// are matching if they have the same vertices (on three-dimensional
+	// patches vertices should also have reverse winding order).
+	auto areMatching = [&](std::size_t i, std::size_t j) -> bool {
+		std::size_t nVertices = faceVertexOffsets[i + 1] - faceVertexOffsets[i];
+		if (nVertices != faceVertexOffsets[j + 1] - faceVertexOffsets[j]) {
+			return false;
+		}
+
+		const long *vertices_i = faceVertices.data() + faceVertexOffsets[i];
+		const long *vertices_j = faceVertices.data() + faceVertexOffsets[j];
+		if (multipleMatchesAllowed) {
+			return std::is_permutation(vertices_i, vertices_i + nVertices, vertices_j);
+		}
+
+		const long *firstVertex_j = std::find(vertices_j, vertices_j + nVertices, vertices_i[0]);
+		if (firstVertex_j == vertices_j + nVertices) {
+			return false;
+		}
+
+		std::size_t offset = nVertices + static_cast<std::size_t>(firstVertex_j - vertices_j);
+		for (std::size_t k = 1; k < nVertices; ++k) {
+			if (vertices_i[k] != vertices_j[(offset - k) % nVertices]) {
+				return false;
+			}
+		}
+
+		return true;
+	};
+
+	std::size_t groupBegin = 0;
+	while (groupBegin < nHalfFaces) {
+		// Identify the half-faces with the same key
+		std::size_t groupEnd = groupBegin + 1;
+		while (groupEnd < nHalfFaces && std::get<0>(keys[groupEnd]) == std::get<0>(keys[groupBegin]) && std::get<1>(keys[groupEnd]) == std::get<1>(keys[groupBegin])) {
+			++groupEnd;
+		}
+
+		// Generate the adjacencies
+		for (std::size_t i = groupBegin; i < groupEnd; ++i) {
+			HalfFaceInfo &halfFace = halfFaces[std::get<2>(keys[i])];
+			if (!halfFace.cell) {
+				continue;
+			}
+
+			for (std::size_t j = i + 1; j < groupEnd; ++j) {
+				HalfFaceInfo &neighHalfFace = halfFaces[std::get<2>(keys[j])];
+				if (!neighHalfFace.cell) {
+					continue;
+				} else if (!halfFace.updated && !neighHalfFace.updated) {
+					continue;
+				} else if (!areMatching(std::get<2>(keys[i]), std::get<2>(keys[j]))) {
+					continue;
+				}
+
+				halfFace.cell->pushAdjacency(halfFace.face, neighHalfFace.cell->getId());
+				neighHalfFace.cell->pushAdjacency(neighHalfFace.face, halfFace.cell->getId());
+
+				// Each half-face can only be matched once on three-dimensional
+				// patches.
+				if (!multipleMatchesAllowed) {
+					neighHalfFace.cell = nullptr;
+					break;
+				}
+			}
+		}
+
+		groupBegin = groupEnd;
+	}
 }
 
 /*!
@@ -4378,8 +4786,15 @@ void PatchKernel::buildInterfaces()
 		clearInterfaces();
 	}
 
-	// Update interfaces
-	updateInterfaces(m_cells.getIds(false));
+	// Build interfaces
+	//
+	// If the patch contains no interfaces, the interfaces of all the cells
+	// can be built in bulk.
+	if (m_interfaces.empty()) {
+		buildAllCellInterfaces();
+	} else {
+		updateInterfaces(m_cells.getIds(false));
+	}
 }
 
 /*!
@@ -4455,6 +4870,370 @@ void PatchKernel::clearInterfaces()
 	resetInterfaces();
 }
 
+/*!
+	Build the interfaces of all the cells of a patch that contains no
+	interfaces.
+
+	The result is the same obtained calling updateInterfaces on all the
+	cells of the patch (same ids, same owners and neighbours, same order
+	of interfaces and adjacencies on the faces of the cells), however the
+	interfaces are built in bulk: interfaces are discovered from the
+	adjacencies concurrently, the ids are reserved up front and then all
+	the interfaces are inserted in the storage at once.
+
+	When updating the interfaces of all cells, the cells are processed in
+	the order they are stored. A cell builds the interfaces toward all its
+	neighbours that come after it in the storage (the interfaces toward
+	the neighbours that come before it have already been built by the
+	neighbours themselves). Adjacencies of a face are rearranged in order
+	to pair the i-th adjacency with the i-th interface: when an interface
+	is built, the paired adjacency is swapped into the position of the
+	newly added interface. The bulk build replicates this process.
+*/
+void PatchKernel::buildAllCellInterfaces()
+{
+	assert(m_interfaces.empty());
+
+	// Enable advanced editing
+	bool originalExpertStatus = isExpert();
+	setExpert(true);
+
+	std::size_t nRawCells = 0;
+	for (CellConstIterator itr = m_cells.cbegin(); itr != m_cells.cend(); ++itr) {
+		nRawCells = itr.getRawIndex() + 1;
+	}
+
+	// Slots
+	//
+	// Each face of a cell has a slot for every adjacency (and a slot for
+	// the border interface if the face has no adjacencies). Slots store
+	// the creation index of the interface paired with the adjacency.
+	std::vector<std::size_t> slotOffsets(nRawCells + 1, 0);
+	for (CellConstIterator itr = m_cells.cbegin(); itr != m_cells.cend(); ++itr) {
+		const Cell &cell = *itr;
+
+		std::size_t nCellSlots = 0;
+		const int nCellFaces = cell.getFaceCount();
+		for (int face = 0; face < nCellFaces; ++face) {
+			nCellSlots += std::max(cell.getAdjacencyCount(face), 1);
+		}
+
+		slotOffsets[itr.getRawIndex() + 1] = nCellSlots;
+	}
+
+	for (std::size_t i = 0; i < nRawCells; ++i) {
+		slotOffsets[i + 1] += slotOffsets[i];
+	}
+
+	auto getFaceSlots = [this, &slotOffsets](const Cell &cell, int face) -> std::size_t {
+		std::size_t slot = slotOffsets[m_cells.rawIndex(cell.getId())];
+		for (int i = 0; i < face; ++i) {
+			slot += std::max(cell.getAdjacencyCount(i), 1);
+		}
+
+		return slot;
+	};
+
+	// Sort the adjacencies of a face in the order the paired interfaces
+	// are created. The adjacencies whose interfaces are created by the
+	// neighbours come first, the function returns the number of these
+	// adjacencies.
+	auto sortFaceAdjacencies = [this](const Cell &cell, int face, std::vector<long> *adjacencies) -> int {
+		std::size_t rawIndex = m_cells.rawIndex(cell.getId());
+
+		int nFaceAdjacencies = cell.getAdjacencyCount(face);
+		const long *faceAdjacencies = cell.getAdjacencies(face);
+		adjacencies->assign(faceAdjacencies, faceAdjacencies + nFaceAdjacencies);
+
+		int nPrevious = 0;
+		while (true) {
+			int selected = -1;
+			std::size_t selectedRawIndex = rawIndex;
+			for (int k = nPrevious; k < nFaceAdjacencies; ++k) {
+				std::size_t neighRawIndex = m_cells.rawIndex((*adjacencies)[k]);
+				if (neighRawIndex < selectedRawIndex) {
+					selected = k;
+					selectedRawIndex = neighRawIndex;
+				}
+			}
+
+			if (selected < 0) {
+				break;
+			}
+
+			std::swap((*adjacencies)[nPrevious], (*adjacencies)[selected]);
+			++nPrevious;
+		}
+
+		return nPrevious;
+	};
+
+	// Count the interfaces created by each cell
+	std::vector<std::size_t> creationOffsets(nRawCells + 1, 0);
+
+#if BITPIT_ENABLE_OPENMP==1
+	#pragma omp parallel for schedule(dynamic, 1024)
+#endif
+	for (std::size_t i = 0; i < nRawCells; ++i) {
+		CellConstIterator itr = m_cells.rawFind(i);
+		if (itr.getId() < 0) {
+			continue;
+		}
+
+		const Cell &cell = *itr;
+
+		std::size_t nCreated = 0;
+		const int nCellFaces = cell.getFaceCount();
+		for (int face = 0; face < nCellFaces; ++face) {
+			int nFaceAdjacencies = cell.getAdjacencyCount(face);
+			if (nFaceAdjacencies == 0) {
+				if (cell.isInterior()) {
+					++nCreated;
+				}
+
+				continue;
+			}
+
+			const long *faceAdjacencies = cell.getAdjacencies(face);
+			for (int k = 0; k < nFaceAdjacencies; ++k) {
+				if (m_cells.rawIndex(faceAdjacencies[k]) > i) {
+					++nCreated;
+				}
+			}
+		}
+
+		creationOffsets[i + 1] = nCreated;
+	}
+
+	for (std::size_t i = 0; i < nRawCells; ++i) {
+		creationOffsets[i + 1] += creationOffsets[i];
+	}
+
+	// Reserve the ids of the interfaces
+	std::size_t nInterfaces = creationOffsets[nRawCells];
+
+	std::vector<long> interfaceIds(nInterfaces);
+	for (std::size_t n = 0; n < nInterfaces; ++n) {
+		interfaceIds[n] = m_interfaceIdGenerator.generate();
+	}
+
+	// Evaluate interface information
+	struct InterfaceInfo {
+		ElementType type;
+		std::unique_ptr<long[]> connect;
+		long ownerId;
+		int ownerFace;
+		long neighId;
+		int neighFace;
+	};
+
+	std::vector<InterfaceInfo> interfaceInfos(nInterfaces);
+	std::vector<std::size_t> slots(slotOffsets[nRawCells], std::numeric_limits<std::size_t>::max());
+
+#if BITPIT_ENABLE_OPENMP==1
+	#pragma omp parallel
+#endif
+	{
+		std::vector<long> sortedAdjacencies;
+
+#if BITPIT_ENABLE_OPENMP==1
+		#pragma omp for schedule(dynamic, 1024)
+#endif
+		for (std::size_t i = 0; i < nRawCells; ++i) {
+			CellIterator itr = m_cells.rawFind(i);
+			if (itr.getId() < 0) {
+				continue;
+			}
+
+			Cell &cell = *itr;
+			long cellId = cell.getId();
+
+			std::size_t creationIndex = creationOffsets[i];
+			const int nCellFaces = cell.getFaceCount();
+			for (int face = 0; face < nCellFaces; ++face) {
+				std::size_t faceSlots = getFaceSlots(cell, face);
+
+				// Find the neighbours that need an interface
+				int nFaceAdjacencies = cell.getAdjacencyCount(face);
+				int createBegin;
+				if (nFaceAdjacencies == 0) {
+					if (!cell.isInterior()) {
+						continue;
+					}
+
+					sortedAdjacencies.assign(1, Cell::NULL_ID);
+					createBegin = 0;
+				} else {
+					createBegin = sortFaceAdjacencies(cell, face, &sortedAdjacencies);
+				}
+
+				// Evaluate interface information
+				const long *faceAdjacencies = cell.getAdjacencies(face);
+				for (std::size_t k = createBegin; k < sortedAdjacencies.size(); ++k) {
+					long neighId = sortedAdjacencies[k];
+
+					Cell *neigh   = nullptr;
+					int neighFace = -1;
+					if (neighId >= 0) {
+						neigh     = &m_cells[neighId];
+						neighFace = findAdjoinNeighFace(cellId, neighId);
+					}
+
+					InterfaceInfo &info = interfaceInfos[creationIndex];
+					if (isInterfaceOwner(cell, face, neigh, neighFace)) {
+						info.ownerId   = cellId;
+						info.ownerFace = face;
+						info.neighId   = neighId;
+						info.neighFace = neighFace;
+					} else {
+						info.ownerId   = neighId;
+						info.ownerFace = neighFace;
+						info.neighId   = cellId;
+						info.neighFace = face;
+					}
+
+					const Cell &owner = (info.ownerId == cellId) ? cell : *neigh;
+					ConstProxyVector<long> faceConnect = owner.getFaceConnect(info.ownerFace);
+					info.type    = owner.getFaceType(info.ownerFace);
+					info.connect = std::unique_ptr<long[]>(new long[faceConnect.size()]);
+					std::copy(faceConnect.cbegin(), faceConnect.cend(), info.connect.get());
+
+					// Assign the interface to the slots of the cells
+					if (neighId >= 0) {
+						int adjacencyIndex = std::find(faceAdjacencies, faceAdjacencies + nFaceAdjacencies, neighId) - faceAdjacencies;
+						slots[faceSlots + adjacencyIndex] = creationIndex;
+
+						const long *neighFaceAdjacencies = neigh->getAdjacencies(neighFace);
+						int nNeighFaceAdjacencies = neigh->getAdjacencyCount(neighFace);
+						int neighAdjacencyIndex = std::find(neighFaceAdjacencies, neighFaceAdjacencies + nNeighFaceAdjacencies, cellId) - neighFaceAdjacencies;
+						slots[getFaceSlots(*neigh, neighFace) + neighAdjacencyIndex] = creationIndex;
+					} else {
+						slots[faceSlots] = creationIndex;
+					}
+
+					++creationIndex;
+				}
+			}
+		}
+	}
+
+	// Insert the interfaces
+	m_interfaces.reserve(nInterfaces);
+	for (std::size_t n = 0; n < nInterfaces; ++n) {
+		InterfaceInfo &info = interfaceInfos[n];
+
+		long interfaceId = interfaceIds[n];
+		Interface &interface = *(m_interfaces.emreclaim(interfaceId, interfaceId, info.type, std::move(info.connect)));
+		interface.setOwner(info.ownerId, info.ownerFace);
+		if (info.neighId >= 0) {
+			interface.setNeigh(info.neighId, info.neighFace);
+		}
+	}
+
+	std::vector<InterfaceInfo>().swap(interfaceInfos);
+
+	// Update cell data
+#if BITPIT_ENABLE_OPENMP==1
+	#pragma omp parallel
+#endif
+	{
+		std::vector<std::pair<std::size_t, long>> faceInterfaces;
+		std::vector<std::vector<long>> cellInterfaces;
+
+#if BITPIT_ENABLE_OPENMP==1
+		#pragma omp for schedule(dynamic, 1024)
+#endif
+		for (std::size_t i = 0; i < nRawCells; ++i) {
+			CellIterator itr = m_cells.rawFind(i);
+			if (itr.getId() < 0) {
+				continue;
+			}
+
+			Cell &cell = *itr;
+
+			std::size_t faceSlots = slotOffsets[i];
+			const int nCellFaces = cell.getFaceCount();
+			cellInterfaces.resize(nCellFaces);
+			for (int face = 0; face < nCellFaces; ++face) {
+				int nFaceAdjacencies = cell.getAdjacencyCount(face);
+				int nFaceSlots = std::max(nFaceAdjacencies, 1);
+
+				// Sort adjacencies and interfaces by creation order
+				const long *faceAdjacencies = cell.getAdjacencies(face);
+
+				faceInterfaces.clear();
+				for (int k = 0; k < nFaceSlots; ++k) {
+					std::size_t creationIndex = slots[faceSlots + k];
+					if (creationIndex >= nInterfaces) {
+						continue;
+					}
+
+					long adjacency = (k < nFaceAdjacencies) ? faceAdjacencies[k] : Cell::NULL_ID;
+					faceInterfaces.emplace_back(creationIndex, adjacency);
+				}
+
+				std::sort(faceInterfaces.begin(), faceInterfaces.end());
+
+				// Update cell data
+				std::vector<long> &cellFaceInterfaces = cellInterfaces[face];
+				cellFaceInterfaces.resize(faceInterfaces.size());
+				for (std::size_t k = 0; k < faceInterfaces.size(); ++k) {
+					cellFaceInterfaces[k] = interfaceIds[faceInterfaces[k].first];
+					if (faceInterfaces[k].second >= 0 && faceAdjacencies[k] != faceInterfaces[k].second) {
+						cell.setAdjacency(face, k, faceInterfaces[k].second);
+					}
+				}
+
+				faceSlots += nFaceSlots;
+			}
+
+			cell.setInterfaces(cellInterfaces);
+		}
+	}
+
+	// Set interfaces build strategy
+	setInterfacesBuildStrategy(INTERFACES_AUTOMATIC);
+
+	// Set original advanced editing status
+	setExpert(originalExpertStatus);
+}
+
+/*!
+	Checks if the first of the specified cells will be the owner of the
+	interface between the two cells.
+
+	The interface is owned by the cell that has only one adjacency, i.e.,
+	by the cell that owns the smallest of the two faces. If the faces
+	of both cells have the same size, the interface is owned by the cell
+	with the "lower fuzzy positioning". It is not necessary to have a
+	precise comparison, it's only necassary to define a repetible order
+	between the two cells. It is therefore possible to use the "fuzzy"
+	cell comparison.
+
+	\param cell_1 is the first cell
+	\param face_1 is the face of the first cell
+	\param cell_2 is the second cell, a null pointer means that the face
+	of the first cell is a border
+	\param face_2 is the face of the second cell
+	\result Returns true if the first cell will be the owner of the
+	interface, false otherwise.
+*/
+bool PatchKernel::isInterfaceOwner(const Cell &cell_1, int face_1, const Cell *cell_2, int face_2)
+{
+	if (!cell_2) {
+		return true;
+	}
+
+	if (cell_1.getAdjacencyCount(face_1) > 1) {
+		return false;
+	} else if (cell_2->getAdjacencyCount(face_2) == 1) {
+		assert(cell_1.getAdjacencyCount(face_1) == 1);
+		return CellFuzzyPositionLess(*this)(cell_1.getId(), cell_2->getId());
+	}
+
+	return true;
+}
+
 /*!
 	Given two cells, build the interface between them.
 
@@ -4491,23 +5270,7 @@ PatchKernel::InterfaceIterator PatchKernel::buildCellInterface(Cell *cell_1, int
 	}
 
 	// Owner and neighbour of the interface
-	//
-	// The interface is owned by the cell that has only one adjacency, i.e.,
-	// by the cell that owns the smallest of the two faces. If the faces
-	// of both cells have the same size, the interface is owned by the cell
-	// with the "lower fuzzy positioning". It is not necessary to have a
-	// precise comparison, it's only necassary to define a repetible order
-	// between the two cells. It is therefore possible to use the "fuzzy"
-	// cell comparison.
-	bool cellOwnsInterface = true;
-	if (cell_2) {
-		if (cell_1->getAdjacencyCount(face_1) > 1) {
-			cellOwnsInterface = false;
-		} else if (cell_2->getAdjacencyCount(face_2) == 1) {
-			assert(cell_1->getAdjacencyCount(face_1) == 1);
-			cellOwnsInterface = CellFuzzyPositionLess(*this)(id_1, id_2);
-		}
-	}
+	bool cellOwnsInterface = isInterfaceOwner(*cell_1, face_1, cell_2, face_2);
 
 	Cell *intrOwner;
 	Cell *intrNeigh;
@@ -4964,6 +5727,8 @@ void PatchKernel::translate(std::array<double, 3> translation)
 		vertex.translate(translation);
 	}
 
+	_cellsAltered();
+
 	// Update the bounding box
 	if (!isBoundingBoxFrozen() || isBoundingBoxDirty()) {
 		m_boxMinPoint += translation;
@@ -4997,6 +5762,8 @@ void PatchKernel::scale(std::array<double, 3> scaling)
 		vertex.scale(scaling, m_boxMinPoint);
 	}
 
+	_cellsAltered();
+
 	// Update the bounding box
 	if (!isBoundingBoxFrozen() || isBoundingBoxDirty()) {
 		for (int k = 0; k < 3; ++k) {
@@ -5053,6 +5820,19 @@ void PatchKernel::_setTol(double tolerance)
 	m_tolerance = tolerance;
 }
 
+/*!
+	Internal function called whenever the cells of the patch are altered.
+
+	The function is called after cells are added, deleted or moved inside
+	the storage and after the vertices are translated or scaled. Patches
+	that cache data derived from the cells can override it to discard the
+	cache. Direct changes to the coordinates of a vertex or to the
+	connectivity of a cell are not tracked.
+*/
+void PatchKernel::_cellsAltered()
+{
+}
+
 /*!
 	Gets the tolerance for the geometrical checks.
 
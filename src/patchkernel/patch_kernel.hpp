@@ -238,7 +238,8 @@ public:
 	*/
 	enum AdjacenciesBuildStrategy {
 		ADJACENCIES_NONE = -1,
-		ADJACENCIES_AUTOMATIC
+		ADJACENCIES_AUTOMATIC,
+		ADJACENCIES_SORTED
 	};
 
 	/*!
@@ -279,6 +280,14 @@ public:
 		PARTITIONING_ALTERED
 	};
 
+	/*!
+		Element storage mode
+	*/
+	enum ElementStorageMode {
+		ELEMENT_STORAGE_INDIVIDUAL,
+		ELEMENT_STORAGE_ARENA
+	};
+
 	virtual ~PatchKernel();
 
 	template<typename patch_t>
@@ -479,13 +488,16 @@ public:
 	bool squeezeCells();
 	bool squeezeInterfaces();
 
+	ElementStorageMode getElementStorageMode() const;
+	void setElementStorageMode(ElementStorageMode mode);
+
 	long locatePoint(double x, double y, double z);
 	virtual long locatePoint(const std::array<double, 3> &point) = 0;
 	bool isSameFace(long cellId_A, int face_A, long cellId_B, int face_B);
 
 	AdjacenciesBuildStrategy getAdjacenciesBuildStrategy() const;
 	void clearAdjacencies();
-	virtual void buildAdjacencies();
+	virtual void buildAdjacencies(AdjacenciesBuildStrategy strategy = ADJACENCIES_AUTOMATIC);
 	virtual void updateAdjacencies(const std::vector<long> &cellIds);
 
 	InterfacesBuildStrategy getInterfacesBuildStrategy() const;
@@ -637,6 +649,8 @@ protected:
 	virtual void _setTol(double tolerance);
 	virtual void _resetTol();
 
+	virtual void _cellsAltered();
+
 	virtual int _getDumpVersion() const = 0;
 	virtual void _dump(std::ostream &stream) const = 0;
 	virtual void _restore(std::istream &stream) = 0;
@@ -705,6 +719,10 @@ private:
 
 	InterfacesBuildStrategy m_interfacesBuildStrategy;
 
+	ElementStorageMode m_elementStorageMode;
+	std::vector<long> m_cellStorageArena;
+	std::vector<long> m_interfaceStorageArena;
+
 	SpawnStatus m_spawnStatus;
 
 	AdaptionStatus m_adaptionStatus;
@@ -752,10 +770,20 @@ private:
 	void beginAlteration();
 	void endAlteration(bool squeezeStorage = false);
 
+	void compactCellStorageArena();
+	void releaseCellStorageArena();
+	void compactInterfaceStorageArena();
+	void releaseInterfaceStorageArena();
+
+	void buildAllCellInterfaces();
+	bool isInterfaceOwner(const Cell &cell_1, int face_1, const Cell *cell_2, int face_2);
 	InterfaceIterator buildCellInterface(Cell *cell_1, int face_1, Cell *cell_2, int face_2, long interfaceId = Element::NULL_ID);
 
 	int findAdjoinNeighFace(long cellId, long neighId) const;
 
+	void updateAdjacenciesHashing(const std::vector<long> &cellIds);
+	void updateAdjacenciesSorting(const std::vector<long> &cellIds);
+
 	void setId(int id);
 
 	std::array<double, 3> evalElementCentroid(const Element &element) const;
@@ -215,6 +215,7 @@ PatchKernel::CellIterator PatchKernel::moveInternal2Ghost(long id, int ownerRank
 	// Swap the element with the last internal cell
 	if (id != m_lastInternalId) {
 		m_cells.swap(id, m_lastInternalId);
+		_cellsAltered();
 	}
 
 	// Get the iterator pointing to the updated position of the element
@@ -256,6 +257,7 @@ PatchKernel::CellIterator PatchKernel::moveGhost2Internal(long id)
 	// Swap the cell with the first ghost
 	if (id != m_firstGhostId) {
 		m_cells.swap(id, m_firstGhostId);
+		_cellsAltered();
 	}
 
 	// Get the iterator pointing to the updated position of the element
@@ -474,6 +476,8 @@ PatchKernel::CellIterator PatchKernel::_addGhost(ElementType type, std::unique_p
 	}
 	m_nGhosts++;
 
+	_cellsAltered();
+
 	// Update the id of the first ghost cell
 	if (m_firstGhostId < 0) {
 		m_firstGhostId = id;
@@ -558,6 +562,7 @@ void PatchKernel::_deleteGhost(long id, bool delayed)
 	// Delete cell
 	m_cells.erase(id, delayed);
 	m_nGhosts--;
+	_cellsAltered();
 	if (id == m_firstGhostId) {
 		updateFirstGhostId();
 	}
@@ -22,7 +22,9 @@
  *
 \*---------------------------------------------------------------------------*/
 
+#include <algorithm>
 #include <cmath>
+#include <numeric>
 #include <queue>
 
 #include "bitpit_CG.hpp"
@@ -408,6 +410,29 @@ double SkdNode::evalPointMinDistance(const std::array<double, 3> &point) const
     return distance;
 }
 
+/*!
+* Evaluates the minimum distance among the specified box and the
+* bounding box associated to the node.
+*
+* The distance is never greater than the minimum distance between the
+* node and any point contained in the specified box.
+*
+* \param boxMin is the minimum point of the box
+* \param boxMax is the maximum point of the box
+* \result The minimum distance among the specified box and the bounding
+* box associated to the node.
+*/
+double SkdNode::evalBoxMinDistance(const std::array<double, 3> &boxMin, const std::array<double, 3> &boxMax) const
+{
+    double distance = 0.;
+    for (int d = 0; d < 3; ++d) {
+        distance += std::pow(std::max({0., m_boxMin[d] - boxMax[d], boxMin[d] - m_boxMax[d]}), 2);
+    }
+    distance = std::sqrt(distance);
+
+    return distance;
+}
+
 /*!
 * Evaluates the maximum distance among the specified point and the
 * cells contained in the bounding box associated to the node.
@@ -513,6 +538,57 @@ void SkdNode::updatePointClosestCell(const std::array<double, 3> &point,
     }
 }
 
+/*!
+* Given the specified points find if, among the cells contained in the
+* bounding box associated to the node, there are cells closer to the
+* ones received in input.
+*
+* The result is the same that would be obtained calling the function
+* updatePointClosestCell for each point, however the vertex coordinates
+* of each cell are retrieved only once for all the points.
+*
+* \param nPoints is the number of points
+* \param points are the points
+* \param[in,out] ids are the ids of the current closest cells, on output
+* they will be updated if closer cells are found
+* \param[in,out] distances are the distances of the current closest cells,
+* on output they will be updated if closer cells are found
+*/
+void SkdNode::updatePointsClosestCell(std::size_t nPoints, const std::array<double, 3> *points,
+                                      long *ids, double *distances) const
+{
+    if (getCellCount() == 0) {
+        return;
+    }
+
+    const PatchKernel &patch = m_patchInfo->getPatch();
+    const PiercedVector<Cell> &cells = patch.getCells();
+    const std::vector<std::size_t> &cellRawIds = m_patchInfo->getCellRawIds();
+    std::vector<std::array<double, 3>> cellVertexCoordinates(ReferenceElementInfo::MAX_ELEM_VERTICES);
+
+    for (std::size_t n = m_cellRangeBegin; n < m_cellRangeEnd; n++) {
+        std::size_t cellRawId = cellRawIds[n];
+        const Cell &cell = cells.rawAt(cellRawId);
+
+        // Get the vertices ids
+        ConstProxyVector<long> elementVertexIds = cell.getVertexIds();
+        const int nElementVertices = elementVertexIds.size();
+
+        // Get vertex coordinates
+        cellVertexCoordinates.resize(nElementVertices);
+        for (int i = 0; i < nElementVertices; ++i) {
+            cellVertexCoordinates[i] = patch.getVertex(elementVertexIds[i]).getCoords();
+        }
+
+        // Update the closest cells
+        long cellId = cell.getId();
+        for (std::size_t k = 0; k < nPoints; ++k) {
+            double cellDistance = cell.evalPointDistance(points[k], cellVertexCoordinates.data());
+            updateClosestCellInfo(points[k], cellId, cellDistance, ids + k, distances + k);
+        }
+    }
+}
+
 /*!
 * Give the specified point, cell, and cell distance update the information
 * of the closest cell.
@@ -816,6 +892,11 @@ void PatchSkdTree::build(int leafCapacity)
         m_cellRawIds[k++] = itr.getRawIndex();
     }
 
+    // An empty tree has no nodes
+    if (nCells == 0) {
+        return;
+    }
+
     // Build patch cache
     m_patchInfo.buildCache(cellRange);
 
@@ -929,7 +1010,7 @@ SkdNode & PatchSkdTree::_getNode(std::size_t nodeId)
 */
 std::size_t PatchSkdTree::evalMaxDepth(std::size_t rootId) const
 {
-    if (rootId == SkdNode::NULL_ID) {
+    if (rootId == SkdNode::NULL_ID || m_nodes.empty()) {
         return 0;
     }
 
@@ -945,6 +1026,244 @@ std::size_t PatchSkdTree::evalMaxDepth(std::size_t rootId) const
     return depth;
 }
 
+/*!
+* Locates the cell that contains the specified point.
+*
+* The tree is traversed visiting only the nodes whose bounding box contains
+* the point, the cells of the leafs reached by the traversal are then checked
+* to find the one that contains the point. The check is performed with the
+* tolerance of the patch.
+*
+* \param point is the point
+* \result The id of the cell that contains the point. If the point is not
+* inside any of the cells contained in the tree, the function returns the
+* id of the null element.
+*/
+long PatchSkdTree::locatePoint(const std::array<double, 3> &point) const
+{
+    std::vector<std::size_t> nodeStack;
+    std::size_t leafId;
+
+    return findPointCell(point, &nodeStack, &leafId);
+}
+
+/*!
+* Locates the cells that contain the specified points.
+*
+* Points are processed following a space-filling curve, in this way points
+* processed one after the other are likely to be close to each other. The
+* traversal state of the last located point is then reused: before starting
+* a new traversal, the point is checked against the last cell found and
+* against the other cells of the leaf that contains that cell.
+*
+* If OpenMP is enabled, the points are processed concurrently.
+*
+* \param nPoints is the number of points
+* \param points are the points
+* \param[out] ids on output will contain the ids of the cells that contain
+* the points, if a point is not inside any of the cells contained in the
+* tree, the corresponding id is set to the id of the null element. The
+* pointer should point to a memory area large enough to hold the ids of
+* all the points.
+*/
+void PatchSkdTree::locatePoints(std::size_t nPoints, const std::array<double, 3> *points, long *ids) const
+{
+    if (nPoints == 0) {
+        return;
+    }
+
+    // Evaluate processing order
+    std::vector<std::size_t> processingOrder = evalPointProcessingOrder(nPoints, points);
+
+    // Locate the points
+#if BITPIT_ENABLE_OPENMP==1
+    #pragma omp parallel
+#endif
+    {
+        std::vector<std::size_t> nodeStack;
+
+        long lastCellId = Cell::NULL_ID;
+        std::size_t lastLeafId = SkdNode::NULL_ID;
+
+#if BITPIT_ENABLE_OPENMP==1
+        #pragma omp for schedule(static)
+#endif
+        for (std::size_t k = 0; k < nPoints; ++k) {
+            std::size_t n = processingOrder[k];
+            const std::array<double, 3> &point = points[n];
+
+            // Check the last cell found
+            if (lastCellId != Cell::NULL_ID && isPointInsideCell(lastCellId, point)) {
+                ids[n] = lastCellId;
+                continue;
+            }
+
+            // Check the cells of the last leaf
+            if (lastLeafId != SkdNode::NULL_ID) {
+                long cellId = findLeafPointCell(lastLeafId, point);
+                if (cellId != Cell::NULL_ID) {
+                    ids[n]     = cellId;
+                    lastCellId = cellId;
+                    continue;
+                }
+            }
+
+            // Traverse the tree
+            std::size_t leafId;
+            long cellId = findPointCell(point, &nodeStack, &leafId);
+            ids[n] = cellId;
+            if (cellId != Cell::NULL_ID) {
+                lastCellId = cellId;
+                lastLeafId = leafId;
+            }
+        }
+    }
+}
+
+/*!
+* Traverses the tree to find the cell that contains the specified point.
+*
+* \param point is the point
+* \param nodeStack is a storage that will be used to hold the nodes that
+* have to be visited, it is passed to the function to avoid reallocating
+* it every time the function is called
+* \param[out] leafId on output will contain the id of the leaf that contains
+* the cell, if the point is not inside any cell, the id will be set to the
+* null id
+* \result The id of the cell that contains the point. If the point is not
+* inside any of the cells contained in the tree, the function returns the
+* id of the null element.
+*/
+long PatchSkdTree::findPointCell(const std::array<double, 3> &point, std::vector<std::size_t> *nodeStack, std::size_t *leafId) const
+{
+    *leafId = SkdNode::NULL_ID;
+    if (m_nodes.empty()) {
+        return Cell::NULL_ID;
+    }
+
+    double tolerance = getPatch().getTol();
+
+    std::size_t rootId = 0;
+    nodeStack->assign(1, rootId);
+    while (!nodeStack->empty()) {
+        std::size_t nodeId = nodeStack->back();
+        const SkdNode &node = m_nodes[nodeId];
+        nodeStack->pop_back();
+
+        // Do not consider nodes whose bounding box doesn't contain the point
+        if (!node.boxContainsPoint(point, tolerance)) {
+            continue;
+        }
+
+        // If the node is a leaf look for the cell that contains the point,
+        // otherwise add its children to the stack.
+        bool isLeaf = true;
+        for (int i = SkdNode::CHILD_BEGIN; i != SkdNode::CHILD_END; ++i) {
+            SkdNode::ChildLocation childLocation = static_cast<SkdNode::ChildLocation>(i);
+            std::size_t childId = node.getChildId(childLocation);
+            if (childId != SkdNode::NULL_ID) {
+                isLeaf = false;
+                nodeStack->push_back(childId);
+            }
+        }
+
+        if (isLeaf) {
+            long cellId = findLeafPointCell(nodeId, point);
+            if (cellId != Cell::NULL_ID) {
+                *leafId = nodeId;
+                return cellId;
+            }
+        }
+    }
+
+    return Cell::NULL_ID;
+}
+
+/*!
+* Finds, among the cells contained in the specified leaf, the one that
+* contains the specified point.
+*
+* \param leafId is the id of the leaf
+* \param point is the point
+* \result The id of the cell that contains the point. If the point is not
+* inside any of the cells contained in the leaf, the function returns the
+* id of the null element.
+*/
+long PatchSkdTree::findLeafPointCell(std::size_t leafId, const std::array<double, 3> &point) const
+{
+    const SkdNode &leaf = m_nodes[leafId];
+
+    std::size_t nLeafCells = leaf.getCellCount();
+    for (std::size_t n = 0; n < nLeafCells; ++n) {
+        long cellId = leaf.getCell(n);
+        if (isPointInsideCell(cellId, point)) {
+            return cellId;
+        }
+    }
+
+    return Cell::NULL_ID;
+}
+
+/*!
+* Evaluates the order in which the specified points should be processed.
+*
+* Points are sorted along a Morton curve defined on the bounding box of
+* the root node, points outside the bounding box are clamped on the box.
+*
+* \param nPoints is the number of points
+* \param points are the points
+* \result The order in which the points should be processed.
+*/
+std::vector<std::size_t> PatchSkdTree::evalPointProcessingOrder(std::size_t nPoints, const std::array<double, 3> *points) const
+{
+    std::vector<std::size_t> processingOrder(nPoints);
+    std::iota(processingOrder.begin(), processingOrder.end(), 0);
+    if (m_nodes.empty()) {
+        return processingOrder;
+    }
+
+    // Evaluate Morton keys
+    //
+    // Each coordinate is quantized on 21 bits, the bits of the three
+    // coordinates are then interleaved.
+    const int N_KEY_BITS = 21;
+    const uint64_t MAX_KEY_COORDINATE = (uint64_t(1) << N_KEY_BITS) - 1;
+
+    const SkdNode &root = m_nodes[0];
+    const std::array<double, 3> &boxMin = root.getBoxMin();
+    const std::array<double, 3> &boxMax = root.getBoxMax();
+
+    std::array<double, 3> scale;
+    for (int d = 0; d < 3; ++d) {
+        double length = boxMax[d] - boxMin[d];
+        scale[d] = (length > 0.) ? MAX_KEY_COORDINATE / length : 0.;
+    }
+
+    std::vector<uint64_t> keys(nPoints);
+    for (std::size_t n = 0; n < nPoints; ++n) {
+        uint64_t key = 0;
+        for (int d = 0; d < 3; ++d) {
+            double scaledCoordinate = (points[n][d] - boxMin[d]) * scale[d];
+            scaledCoordinate = std::min(std::max(scaledCoordinate, 0.), double(MAX_KEY_COORDINATE));
+
+            uint64_t keyCoordinate = static_cast<uint64_t>(scaledCoordinate);
+            for (int b = 0; b < N_KEY_BITS; ++b) {
+                key |= ((keyCoordinate >> b) & uint64_t(1)) << (3 * b + d);
+            }
+        }
+
+        keys[n] = key;
+    }
+
+    // Sort the points
+    std::sort(processingOrder.begin(), processingOrder.end(),
+        [&keys](std::size_t i, std::size_t j) {
+            return (keys[i] < keys[j]);
+        });
+
+    return processingOrder;
+}
+
 /*!
 * Create the children of the specified node.
 *
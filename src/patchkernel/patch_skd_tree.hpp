@@ -97,11 +97,13 @@ public:
     bool boxIntersectsSphere(const std::array<double,3> &center, double radius) const;
 
     double evalPointMinDistance(const std::array<double, 3> &point) const;
+    double evalBoxMinDistance(const std::array<double, 3> &boxMin, const std::array<double, 3> &boxMax) const;
     double evalPointMaxDistance(const std::array<double, 3> &point) const;
     double evalPointDistance(const std::array<double, 3> &point) const;
 
     void findPointClosestCell(const std::array<double, 3> &point, long *id, double *distance) const;
     void updatePointClosestCell(const std::array<double, 3> &point, long *id, double *distance) const;
+    void updatePointsClosestCell(std::size_t nPoints, const std::array<double, 3> *points, long *ids, double *distances) const;
 
 protected:
     struct Allocator : std::allocator<SkdNode>
@@ -157,6 +159,9 @@ public:
 
     std::size_t evalMaxDepth(std::size_t rootId = 0) const;
 
+    long locatePoint(const std::array<double, 3> &point) const;
+    void locatePoints(std::size_t nPoints, const std::array<double, 3> *points, long *ids) const;
+
 protected:
     SkdPatchInfo m_patchInfo;
     std::vector<std::size_t> m_cellRawIds;
@@ -172,11 +177,18 @@ protected:
 
     SkdNode & _getNode(std::size_t nodeId);
 
+    virtual bool isPointInsideCell(long id, const std::array<double, 3> &point) const = 0;
+
 private:
     void setLeafCapacity(int capacity);
 
     void createChildren(std::size_t parentId);
 
+    long findPointCell(const std::array<double, 3> &point, std::vector<std::size_t> *nodeStack, std::size_t *leafId) const;
+    long findLeafPointCell(std::size_t leafId, const std::array<double, 3> &point) const;
+
+    std::vector<std::size_t> evalPointProcessingOrder(std::size_t nPoints, const std::array<double, 3> *points) const;
+
 };
 
 }
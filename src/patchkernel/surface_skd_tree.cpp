@@ -22,6 +22,13 @@
  *
 \*---------------------------------------------------------------------------*/
 
+#include <cassert>
+#include <limits>
+#include <numeric>
+#if BITPIT_ENABLE_OPENMP==1
+#include <omp.h>
+#endif
+
 #include "surface_skd_tree.hpp"
 
 namespace bitpit {
@@ -59,6 +66,32 @@ void SurfaceSkdTree::clear(bool release)
     PatchSkdTree::clear(release);
 }
 
+/*!
+* Checks if the specified point is inside a cell.
+*
+* A point is considered inside a cell if its distance from the cell is
+* less than the tolerance of the patch.
+*
+* \param id is the id of the cell
+* \param point is the point
+* \result Returns true if the point is inside the cell, false otherwise.
+*/
+bool SurfaceSkdTree::isPointInsideCell(long id, const std::array<double, 3> &point) const
+{
+    const PatchKernel &patch = getPatch();
+    const Cell &cell = patch.getCell(id);
+
+    ConstProxyVector<long> cellVertexIds = cell.getVertexIds();
+    const int nCellVertices = cellVertexIds.size();
+
+    std::vector<std::array<double, 3>> cellVertexCoordinates(nCellVertices);
+    for (int i = 0; i < nCellVertices; ++i) {
+        cellVertexCoordinates[i] = patch.getVertexCoords(cellVertexIds[i]);
+    }
+
+    return (cell.evalPointDistance(point, cellVertexCoordinates.data()) <= patch.getTol());
+}
+
 /*!
 * Computes the distance between the specified point and the closest
 * cell contained in the tree. Only cells with a distance less than
@@ -142,6 +175,12 @@ long SurfaceSkdTree::findPointClosestCell(const std::array<double, 3> &point, do
     // Initialize the cell id
     *id = Cell::NULL_ID;
 
+    // An empty tree contains no cells
+    if (m_nodes.empty()) {
+        *distance = std::numeric_limits<double>::max();
+        return 0;
+    }
+
     // Initialize the distance with an estimate
     //
     // The real distance will be lesser than or equal to the estimate.
@@ -152,9 +191,23 @@ long SurfaceSkdTree::findPointClosestCell(const std::array<double, 3> &point, do
     // Get a list of candidates nodes
     //
     // The list of candidates is a memeber of the class to avoid its
-    // reallocation every time the function is called.
-    m_candidateIds.clear();
-    m_candidateMinDistances.clear();
+    // reallocation every time the function is called. When the function
+    // is called from within a parallel region, the candidates are stored
+    // in local lists to allow concurrent searches.
+    std::vector<std::size_t> *candidateIds = &m_candidateIds;
+    std::vector<double> *candidateMinDistances = &m_candidateMinDistances;
+
+#if BITPIT_ENABLE_OPENMP==1
+    std::vector<std::size_t> threadCandidateIds;
+    std::vector<double> threadCandidateMinDistances;
+    if (omp_in_parallel()) {
+        candidateIds = &threadCandidateIds;
+        candidateMinDistances = &threadCandidateMinDistances;
+    }
+#endif
+
+    candidateIds->clear();
+    candidateMinDistances->clear();
 
     std::vector<std::size_t> nodeStack;
     nodeStack.push_back(rootId);
@@ -190,22 +243,22 @@ long SurfaceSkdTree::findPointClosestCell(const std::array<double, 3> &point, do
         }
 
         if (isLeaf) {
-            m_candidateIds.push_back(nodeId);
-            m_candidateMinDistances.push_back(nodeMinDistance);
+            candidateIds->push_back(nodeId);
+            candidateMinDistances->push_back(nodeMinDistance);
         }
     }
 
     // Process the candidates and find the closest cell
     long nDistanceEvaluations = 0;
-    for (std::size_t k = 0; k < m_candidateIds.size(); ++k) {
+    for (std::size_t k = 0; k < candidateIds->size(); ++k) {
         // Do not consider nodes with a minimum distance greater than
         // the distance estimate
-        if (m_candidateMinDistances[k] > *distance) {
+        if ((*candidateMinDistances)[k] > *distance) {
             continue;
         }
 
         // Evaluate the distance
-        std::size_t nodeId = m_candidateIds[k];
+        std::size_t nodeId = (*candidateIds)[k];
         const SkdNode &node = m_nodes[nodeId];
 
         node.updatePointClosestCell(point, id, distance);
@@ -221,4 +274,290 @@ long SurfaceSkdTree::findPointClosestCell(const std::array<double, 3> &point, do
     return nDistanceEvaluations;
 }
 
+/*!
+* Given the specified points find the closest cells contained in the
+* tree and evaluates the distances between those cells and the points.
+*
+* \param nPoints is the number of points
+* \param points are the points
+* \param[out] ids on output will contain the ids of the cells closest to
+* the points. The pointer should point to a memory area large enough to
+* hold the ids of all the points.
+* \param[out] distances on output will contain the distances between the
+* points and their closest cells. The pointer should point to a memory
+* area large enough to hold the distances of all the points.
+* \result The number of distance evaluations performed.
+*/
+long SurfaceSkdTree::findPointClosestCells(std::size_t nPoints, const std::array<double, 3> *points,
+                                           long *ids, double *distances) const
+{
+    return findPointClosestCells(nPoints, points, nullptr, ids, distances);
+}
+
+/*!
+* Given the specified points find the closest cells contained in the
+* tree and evaluates the distances between those cells and the points.
+*
+* Points are grouped in packets of consecutive points and the tree is
+* traversed once for each packet: a node is visited if it may contain the closest cell of at least
+* one point of the packet and, during the visit, each point of the packet
+* is checked only against the nodes that have not been pruned for that
+* point. The cells of a leaf are then compared with all the points of the
+* packet that need them, retrieving the vertex coordinates of the cells
+* only once. For each point, the result is the same that would be obtained
+* calling findPointClosestCell.
+*
+* Since the traversal is shared among the points of a packet, the search
+* is effective only if consecutive points are close to each other, i.e.,
+* the points should be sorted following a space-filling curve.
+*
+* If OpenMP is enabled, the packets are processed concurrently.
+*
+* \param nPoints is the number of points
+* \param points are the points
+* \param maxDistances are the maximum distances of the points, all cells
+* whose distance from a point is greater than the maximum distance of that
+* point will not be considered for the evaluation of its closest cell. If
+* a null pointer is passed, no maximum distance will be considered
+* \param[out] ids on output will contain the ids of the closest cells.
+* If all cells contained in the tree are farther than the maximum distance
+* of a point, the corresponding id will be set to the null id. The pointer
+* should point to a memory area large enough to hold the ids of all the
+* points.
+* \param[out] distances on output will contain the distances between the
+* points and their closest cells. If all cells contained in the tree are
+* farther than the maximum distance of a point, the corresponding distance
+* will be set to the maximum representable distance. The pointer should
+* point to a memory area large enough to hold the distances of all the
+* points.
+* \result The number of distance evaluations performed.
+*/
+long SurfaceSkdTree::findPointClosestCells(std::size_t nPoints, const std::array<double, 3> *points,
+                                           const double *maxDistances, long *ids, double *distances) const
+{
+    long nDistanceEvaluations = 0;
+
+    std::size_t nPackets = (nPoints + CLOSEST_CELL_PACKET_SIZE - 1) / CLOSEST_CELL_PACKET_SIZE;
+
+#if BITPIT_ENABLE_OPENMP==1
+    #pragma omp parallel reduction(+:nDistanceEvaluations)
+#endif
+    {
+        PacketSearchStorage storage;
+
+        std::array<double, CLOSEST_CELL_PACKET_SIZE> packetMaxDistances;
+        packetMaxDistances.fill(std::numeric_limits<double>::max());
+
+#if BITPIT_ENABLE_OPENMP==1
+        #pragma omp for schedule(dynamic)
+#endif
+        for (std::size_t p = 0; p < nPackets; ++p) {
+            std::size_t packetBegin = p * CLOSEST_CELL_PACKET_SIZE;
+            std::size_t packetEnd = std::min(packetBegin + CLOSEST_CELL_PACKET_SIZE, nPoints);
+            std::size_t nPacketPoints = packetEnd - packetBegin;
+
+            const double *pointMaxDistances = packetMaxDistances.data();
+            if (maxDistances) {
+                pointMaxDistances = maxDistances + packetBegin;
+            }
+
+            nDistanceEvaluations += findPacketClosestCells(nPacketPoints, points + packetBegin, pointMaxDistances,
+                                                           ids + packetBegin, distances + packetBegin, &storage);
+        }
+    }
+
+    return nDistanceEvaluations;
+}
+
+/*!
+* Given the specified packet of points find the closest cells contained
+* in the tree and evaluates the distances between those cells and the
+* points.
+*
+* The tree is traversed once for the whole packet. Nodes are first pruned
+* using the bounding box of the points that are still active in the node,
+* then the pruning bounds of each active point are checked.
+*
+* \param nPoints is the number of points, it should not be greater than
+* the packet size
+* \param points are the points
+* \param maxDistances are the maximum distances of the points
+* \param[out] ids on output will contain the ids of the closest cells
+* \param[out] distances on output will contain the distances between the
+* points and their closest cells
+* \param storage is the storage that will be used to hold the nodes that
+* have to be visited and the candidate leaves, it is passed to the function
+* to avoid reallocating it for every packet
+* \result The number of distance evaluations performed.
+*/
+long SurfaceSkdTree::findPacketClosestCells(std::size_t nPoints, const std::array<double, 3> *points,
+                                            const double *maxDistances, long *ids, double *distances,
+                                            PacketSearchStorage *storage) const
+{
+    assert(nPoints <= CLOSEST_CELL_PACKET_SIZE);
+
+    // Initialize the cell ids and the distance estimates
+    //
+    // The real distances will be lesser than or equal to the estimates.
+    //
+    // An empty tree contains no cells.
+    if (m_nodes.empty()) {
+        for (std::size_t k = 0; k < nPoints; ++k) {
+            ids[k]       = Cell::NULL_ID;
+            distances[k] = std::numeric_limits<double>::max();
+        }
+
+        return 0;
+    }
+
+    std::size_t rootId = 0;
+    const SkdNode &root = m_nodes[rootId];
+
+    for (std::size_t k = 0; k < nPoints; ++k) {
+        ids[k]       = Cell::NULL_ID;
+        distances[k] = std::min(root.evalPointMaxDistance(points[k]), maxDistances[k]);
+    }
+
+    // Get a list of candidates nodes
+    //
+    // Every visited node is associated with the list of the points that
+    // are still active in that node, i.e., the points for which the node
+    // may contain the closest cell. For each active point, the minimum
+    // distance between the point and the node is stored along with the
+    // point.
+    std::vector<PacketNode> &nodeStack = storage->nodeStack;
+    std::vector<PacketNode> &candidates = storage->candidates;
+    std::vector<std::size_t> &activePoints = storage->activePoints;
+    std::vector<double> &activeMinDistances = storage->activeMinDistances;
+
+    candidates.clear();
+
+    activePoints.resize(nPoints);
+    std::iota(activePoints.begin(), activePoints.end(), 0);
+    activeMinDistances.assign(nPoints, 0.);
+
+    nodeStack.clear();
+    nodeStack.push_back({rootId, 0, nPoints});
+    while (!nodeStack.empty()) {
+        PacketNode packetNode = nodeStack.back();
+        const SkdNode &node = m_nodes[packetNode.id];
+        nodeStack.pop_back();
+
+        // Do not consider nodes whose minimum distance from the bounding
+        // box of the active points is greater than the distance estimates
+        // of all the active points
+        //
+        // The distance between the boxes is a lower bound of the minimum
+        // distance between the node and each point, this check allows to
+        // prune the node for all the points at once.
+        double packetDistance = 0.;
+        std::array<double, 3> packetBoxMin = points[activePoints[packetNode.pointsBegin]];
+        std::array<double, 3> packetBoxMax = packetBoxMin;
+        for (std::size_t i = packetNode.pointsBegin; i < packetNode.pointsEnd; ++i) {
+            std::size_t k = activePoints[i];
+            packetDistance = std::max(distances[k], packetDistance);
+            for (int d = 0; d < 3; ++d) {
+                packetBoxMin[d] = std::min(points[k][d], packetBoxMin[d]);
+                packetBoxMax[d] = std::max(points[k][d], packetBoxMax[d]);
+            }
+        }
+
+        if (node.evalBoxMinDistance(packetBoxMin, packetBoxMax) > packetDistance) {
+            continue;
+        }
+
+        // Do not consider the node for the points whose minimum distance
+        // is greater than the distance estimate, for the other points
+        // update the distance estimate.
+        std::size_t nodePointsBegin = activePoints.size();
+        for (std::size_t i = packetNode.pointsBegin; i < packetNode.pointsEnd; ++i) {
+            std::size_t k = activePoints[i];
+
+            double nodeMinDistance = node.evalPointMinDistance(points[k]);
+            if (nodeMinDistance > distances[k]) {
+                continue;
+            }
+
+            double nodeMaxDistance = node.evalPointMaxDistance(points[k]);
+            distances[k] = std::min(nodeMaxDistance, distances[k]);
+
+            activePoints.push_back(k);
+            activeMinDistances.push_back(nodeMinDistance);
+        }
+
+        std::size_t nodePointsEnd = activePoints.size();
+        if (nodePointsBegin == nodePointsEnd) {
+            continue;
+        }
+
+        // If the node is a leaf add it to the candidates, otherwise
+        // add its children to the stack.
+        bool isLeaf = true;
+        for (int i = SkdNode::CHILD_BEGIN; i != SkdNode::CHILD_END; ++i) {
+            SkdNode::ChildLocation childLocation = static_cast<SkdNode::ChildLocation>(i);
+            std::size_t childId = node.getChildId(childLocation);
+            if (childId != SkdNode::NULL_ID) {
+                isLeaf = false;
+                nodeStack.push_back({childId, nodePointsBegin, nodePointsEnd});
+            }
+        }
+
+        if (isLeaf) {
+            candidates.push_back({packetNode.id, nodePointsBegin, nodePointsEnd});
+        }
+    }
+
+    // Process the candidates and find the closest cells
+    std::array<std::size_t, CLOSEST_CELL_PACKET_SIZE> leafPointIndexes;
+    std::array<std::array<double, 3>, CLOSEST_CELL_PACKET_SIZE> leafPoints;
+    std::array<long, CLOSEST_CELL_PACKET_SIZE> leafIds;
+    std::array<double, CLOSEST_CELL_PACKET_SIZE> leafDistances;
+
+    long nDistanceEvaluations = 0;
+    for (const PacketNode &candidate : candidates) {
+        // Get the points that need to process the candidate
+        //
+        // Do not consider points with a minimum distance greater than
+        // the distance estimate.
+        std::size_t nLeafPoints = 0;
+        for (std::size_t i = candidate.pointsBegin; i < candidate.pointsEnd; ++i) {
+            std::size_t k = activePoints[i];
+            if (activeMinDistances[i] > distances[k]) {
+                continue;
+            }
+
+            leafPointIndexes[nLeafPoints] = k;
+            leafPoints[nLeafPoints]       = points[k];
+            leafIds[nLeafPoints]          = ids[k];
+            leafDistances[nLeafPoints]    = distances[k];
+            ++nLeafPoints;
+        }
+
+        if (nLeafPoints == 0) {
+            continue;
+        }
+
+        // Evaluate the distances
+        const SkdNode &node = m_nodes[candidate.id];
+        node.updatePointsClosestCell(nLeafPoints, leafPoints.data(), leafIds.data(), leafDistances.data());
+        nDistanceEvaluations += nLeafPoints;
+
+        for (std::size_t i = 0; i < nLeafPoints; ++i) {
+            std::size_t k = leafPointIndexes[i];
+            ids[k]       = leafIds[i];
+            distances[k] = leafDistances[i];
+        }
+    }
+
+    // If no closest cell was found set the distance to the maximum
+    // representable distance.
+    for (std::size_t k = 0; k < nPoints; ++k) {
+        if (ids[k] == Cell::NULL_ID) {
+            distances[k] = std::numeric_limits<double>::max();
+        }
+    }
+
+    return nDistanceEvaluations;
+}
+
 }
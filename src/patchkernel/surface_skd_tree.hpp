@@ -43,10 +43,34 @@ public:
     long findPointClosestCell(const std::array<double,3> &point, long *id, double *distance) const;
     long findPointClosestCell(const std::array<double, 3> &point, double maxDistance, long *id, double *distance) const;
 
+    long findPointClosestCells(std::size_t nPoints, const std::array<double, 3> *points, long *ids, double *distances) const;
+    long findPointClosestCells(std::size_t nPoints, const std::array<double, 3> *points, const double *maxDistances, long *ids, double *distances) const;
+
+protected:
+    bool isPointInsideCell(long id, const std::array<double, 3> &point) const override;
+
 private:
+    static const std::size_t CLOSEST_CELL_PACKET_SIZE = 32;  /**< Number of points that are traversed together by the batch closest cell search */
+
+    struct PacketNode {
+        std::size_t id;
+        std::size_t pointsBegin;
+        std::size_t pointsEnd;
+    };
+
+    struct PacketSearchStorage {
+        std::vector<PacketNode> nodeStack;
+        std::vector<PacketNode> candidates;
+        std::vector<std::size_t> activePoints;
+        std::vector<double> activeMinDistances;
+    };
+
     mutable std::vector<std::size_t> m_candidateIds;
     mutable std::vector<double> m_candidateMinDistances;
 
+    long findPacketClosestCells(std::size_t nPoints, const std::array<double, 3> *points, const double *maxDistances,
+                                long *ids, double *distances, PacketSearchStorage *storage) const;
+
 };
 
 }
@@ -43,4 +43,20 @@ VolumeSkdTree::VolumeSkdTree(const VolumeKernel *patch)
 {
 }
 
+/*!
+* Checks if the specified point is inside a cell.
+*
+* \param id is the id of the cell
+* \param point is the point
+* \result Returns true if the point is inside the cell, false otherwise.
+*/
+bool VolumeSkdTree::isPointInsideCell(long id, const std::array<double, 3> &point) const
+{
+    // The check is delegated to the patch. The function is not declared
+    // constant in the patch, however it doesn't modify the patch.
+    VolumeKernel &patch = const_cast<VolumeKernel &>(static_cast<const VolumeKernel &>(getPatch()));
+
+    return patch.isPointInside(id, point);
+}
+
 }
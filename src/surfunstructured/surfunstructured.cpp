@@ -98,6 +98,19 @@ SurfUnstructured::SurfUnstructured(std::istream &stream)
 	restore(stream);
 }
 
+/*!
+	Creates a copy of the specified patch.
+
+	The skd-tree used for locating points is not copied, the copy will
+	build its own tree when needed.
+
+	\param other is the patch that will be copied
+*/
+SurfUnstructured::SurfUnstructured(const SurfUnstructured &other)
+	: SurfaceKernel(other)
+{
+}
+
 /*!
 	Creates a clone of the pach.
 
@@ -179,10 +192,15 @@ void SurfUnstructured::_restore(std::istream &stream)
 /*!
  * Locates the cell the contains the point.
  *
+ * A point is considered inside a cell if its distance from the cell is
+ * less than the tolerance of the patch.
+ *
  * If the point is not inside the patch, the function returns the id of the
  * null element.
  *
- * NOTE: this function is not implemented yet.
+ * The point is located using the skd-tree of the patch, the tree is built
+ * the first time a point is located and it is discarded when the cells of
+ * the patch are altered.
  *
  * \param[in] point is the point to be checked
  * \result Returns the linear id of the cell the contains the point. If the
@@ -191,11 +209,50 @@ void SurfUnstructured::_restore(std::istream &stream)
  */
 long SurfUnstructured::locatePoint(const std::array<double, 3> &point)
 {
-	BITPIT_UNUSED(point);
+	return getLocationTree().locatePoint(point);
+}
+
+/*!
+ * Locates the cells that contain the specified points.
+ *
+ * The points are located in batch using the skd-tree of the patch, see
+ * SurfaceSkdTree::locatePoints for further details.
+ *
+ * \param[in] nPoints is the number of points
+ * \param[in] points are the points to be located
+ * \param[out] ids on output will contain the ids of the cells that contain
+ * the points, if a point is not inside the patch, the corresponding id is
+ * set to the id of the null element
+ */
+void SurfUnstructured::locatePoints(std::size_t nPoints, const std::array<double, 3> *points, long *ids)
+{
+	getLocationTree().locatePoints(nPoints, points, ids);
+}
 
-	throw std::runtime_error ("The function 'locatePoint' is not implemented yet");
+/*!
+ * Gets the skd-tree used for locating points, building it if needed.
+ *
+ * \result The skd-tree used for locating points.
+ */
+const SurfaceSkdTree & SurfUnstructured::getLocationTree()
+{
+	const int LEAF_CAPACITY = 8;
 
-	return false;
+	if (!m_locationTree) {
+		m_locationTree = std::unique_ptr<SurfaceSkdTree>(new SurfaceSkdTree(this));
+		m_locationTree->build(LEAF_CAPACITY);
+	}
+
+	return *m_locationTree;
+}
+
+/*!
+ * Discards the skd-tree used for locating points, because it no longer
+ * matches the cells of the patch.
+ */
+void SurfUnstructured::_cellsAltered()
+{
+	m_locationTree.reset();
 }
 
 //TODO: Aggiungere un metodo in SurfUnstructured per aggiungere più vertici.
@@ -26,6 +26,7 @@
 #define __BITPIT_SURFUNSTRUCTURED_HPP__
 
 #include <array>
+#include <memory>
 #include <vector>
 
 #include "bitpit_IO.hpp"
@@ -52,6 +53,7 @@ public:
 
         // Search algorithms
         long locatePoint(const std::array<double, 3> &point) override;
+        void locatePoints(std::size_t nPoints, const std::array<double, 3> *points, long *ids);
 
         // Evaluations
         void extractEdgeNetwork(SurfUnstructured &);
@@ -65,12 +67,14 @@ public:
         unsigned short exportDGF(const std::string &);
 
 protected:
-	SurfUnstructured(const SurfUnstructured &other) = default;
+	SurfUnstructured(const SurfUnstructured &other);
 
 	int _getDumpVersion() const override;
 	void _dump(std::ostream &stream) const override;
 	void _restore(std::istream &stream) override;
 
+	void _cellsAltered() override;
+
 	static ElementType getSTLFacetType(int nFacetVertices);
 	static ElementType getDGFFacetType(int nFacetVertices);
 
@@ -80,6 +84,9 @@ protected:
 	unsigned short exportSTLMulti(const std::string &, bool exportInternalsOnly = true, std::unordered_map<int, std::string> *PIDNames = nullptr);
 
 private:
+	std::unique_ptr<SurfaceSkdTree> m_locationTree;
+
+	const SurfaceSkdTree & getLocationTree();
 
 };
 
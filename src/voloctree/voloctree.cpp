@@ -1836,7 +1836,7 @@ std::vector<long> VolOctree::importCells(const std::vector<OctantInfo> &octantIn
 	}
 
 	// Update adjacencies
-	if (getAdjacenciesBuildStrategy() == ADJACENCIES_AUTOMATIC) {
+	if (getAdjacenciesBuildStrategy() != ADJACENCIES_NONE) {
 		updateAdjacencies(createdCells);
 	}
 
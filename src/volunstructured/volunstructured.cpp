@@ -76,6 +76,19 @@ VolUnstructured::VolUnstructured(int id, int dimension)
 #endif
 }
 
+/*!
+	Creates a copy of the specified patch.
+
+	The skd-tree used for locating points is not copied, the copy will
+	build its own tree when needed.
+
+	\param other is the patch that will be copied
+*/
+VolUnstructured::VolUnstructured(const VolUnstructured &other)
+	: VolumeKernel(other)
+{
+}
+
 /*!
 	Destroys the patch.
 */
@@ -248,24 +261,115 @@ void VolUnstructured::_restore(std::istream &stream)
  */
 bool VolUnstructured::isPointInside(const std::array<double, 3> &point)
 {
-	BITPIT_UNUSED(point);
-
-	return false;
+	return (locatePoint(point) != Cell::NULL_ID);
 }
 
 /*!
 	Checks if the specified point is inside a cell.
 
+	Cells are assumed to be convex: the point is inside the cell if it lies
+	on the inner side of all the faces of the cell. In two dimensions the
+	point should also lie on the plane of the cell. All checks are performed
+	using the tolerance of the patch.
+
 	\param[in] id is the idof the cell
 	\param[in] point is the point to be checked
 	\result Returns true if the point is inside the cell, false otherwise.
  */
 bool VolUnstructured::isPointInside(long id, const std::array<double, 3> &point)
 {
-	BITPIT_UNUSED(id);
-	BITPIT_UNUSED(point);
+	const double tolerance = getTol();
+
+	const Cell &cell = m_cells[id];
+	ConstProxyVector<long> cellVertexIds = cell.getVertexIds();
+	const int nCellVertices = cellVertexIds.size();
+
+	// Check the bounding box of the cell
+	std::vector<std::array<double, 3>> cellVertexCoordinates(nCellVertices);
+	std::array<double, 3> cellCentroid = {{0., 0., 0.}};
+	std::array<double, 3> boxMin = getVertexCoords(cellVertexIds[0]);
+	std::array<double, 3> boxMax = boxMin;
+	for (int i = 0; i < nCellVertices; ++i) {
+		const std::array<double, 3> &vertexCoords = getVertexCoords(cellVertexIds[i]);
+		cellVertexCoordinates[i] = vertexCoords;
+		cellCentroid += vertexCoords;
+		for (int d = 0; d < 3; ++d) {
+			boxMin[d] = std::min(vertexCoords[d], boxMin[d]);
+			boxMax[d] = std::max(vertexCoords[d], boxMax[d]);
+		}
+	}
+	cellCentroid /= double(nCellVertices);
 
-	return false;
+	for (int d = 0; d < 3; ++d) {
+		if (point[d] < boxMin[d] - tolerance || point[d] > boxMax[d] + tolerance) {
+			return false;
+		}
+	}
+
+	// In two dimensions the point should lie on the plane of the cell
+	int dimension = getDimension();
+
+	std::array<double, 3> cellNormal;
+	if (dimension == 2) {
+		cellNormal = cell.evalNormal(cellVertexCoordinates.data());
+		if (std::abs(dotProduct(point - cellCentroid, cellNormal)) > tolerance) {
+			return false;
+		}
+	}
+
+	// The point should lie on the inner side of all the faces
+	const int nCellFaces = cell.getFaceCount();
+	for (int face = 0; face < nCellFaces; ++face) {
+		ConstProxyVector<long> faceVertexIds = cell.getFaceVertexIds(face);
+		const int nFaceVertices = faceVertexIds.size();
+
+		std::array<double, 3> faceCentroid = {{0., 0., 0.}};
+		for (int i = 0; i < nFaceVertices; ++i) {
+			faceCentroid += getVertexCoords(faceVertexIds[i]);
+		}
+		faceCentroid /= double(nFaceVertices);
+
+		// Evaluate the normal of the face
+		//
+		// In three dimensions the normal is evaluated using Newell's method,
+		// the vertices of pixels are not ordered cyclically and need to be
+		// reordered.
+		std::array<double, 3> faceNormal;
+		if (dimension == 2) {
+			faceNormal = crossProduct(getVertexCoords(faceVertexIds[1]) - getVertexCoords(faceVertexIds[0]), cellNormal);
+		} else {
+			static const std::array<int, 4> PIXEL_CYCLIC_ORDER = {{0, 1, 3, 2}};
+			bool isPixel = (cell.getFaceType(face) == ElementType::PIXEL);
+
+			faceNormal = {{0., 0., 0.}};
+			for (int k = 0; k < nFaceVertices; ++k) {
+				int i = k;
+				int j = (k + 1) % nFaceVertices;
+				if (isPixel) {
+					i = PIXEL_CYCLIC_ORDER[i];
+					j = PIXEL_CYCLIC_ORDER[j];
+				}
+
+				const std::array<double, 3> &coords_i = getVertexCoords(faceVertexIds[i]);
+				const std::array<double, 3> &coords_j = getVertexCoords(faceVertexIds[j]);
+				faceNormal += crossProduct(coords_i - faceCentroid, coords_j - faceCentroid);
+			}
+		}
+
+		double faceNormalNorm = norm2(faceNormal);
+		if (faceNormalNorm <= 0.) {
+			continue;
+		}
+		faceNormal /= faceNormalNorm;
+
+		// The normal is oriented using the centroid of the cell
+		double orientation = (dotProduct(faceCentroid - cellCentroid, faceNormal) > 0.) ? 1. : -1.;
+		if (orientation * dotProduct(point - faceCentroid, faceNormal) > tolerance) {
+			return false;
+		}
+	}
+
+	return true;
 }
 
 /*!
@@ -274,6 +378,10 @@ bool VolUnstructured::isPointInside(long id, const std::array<double, 3> &point)
  * If the point is not inside the patch, the function returns the id of the
  * null element.
  *
+ * The point is located using the skd-tree of the patch, the tree is built
+ * the first time a point is located and it is discarded when the cells of
+ * the patch are altered.
+ *
  * \param[in] point is the point to be checked
  * \result Returns the linear id of the cell the contains the point. If the
  * point is not inside the patch, the function returns the id of the null
@@ -281,9 +389,50 @@ bool VolUnstructured::isPointInside(long id, const std::array<double, 3> &point)
  */
 long VolUnstructured::locatePoint(const std::array<double, 3> &point)
 {
-	BITPIT_UNUSED(point);
+	return getLocationTree().locatePoint(point);
+}
+
+/*!
+ * Locates the cells that contain the specified points.
+ *
+ * The points are located in batch using the skd-tree of the patch, see
+ * VolumeSkdTree::locatePoints for further details.
+ *
+ * \param[in] nPoints is the number of points
+ * \param[in] points are the points to be located
+ * \param[out] ids on output will contain the ids of the cells that contain
+ * the points, if a point is not inside the patch, the corresponding id is
+ * set to the id of the null element
+ */
+void VolUnstructured::locatePoints(std::size_t nPoints, const std::array<double, 3> *points, long *ids)
+{
+	getLocationTree().locatePoints(nPoints, points, ids);
+}
 
-	return false;
+/*!
+ * Gets the skd-tree used for locating points, building it if needed.
+ *
+ * \result The skd-tree used for locating points.
+ */
+const VolumeSkdTree & VolUnstructured::getLocationTree()
+{
+	const int LEAF_CAPACITY = 8;
+
+	if (!m_locationTree) {
+		m_locationTree = std::unique_ptr<VolumeSkdTree>(new VolumeSkdTree(this));
+		m_locationTree->build(LEAF_CAPACITY);
+	}
+
+	return *m_locationTree;
+}
+
+/*!
+ * Discards the skd-tree used for locating points, because it no longer
+ * matches the cells of the patch.
+ */
+void VolUnstructured::_cellsAltered()
+{
+	m_locationTree.reset();
 }
 
 }
@@ -26,6 +26,7 @@
 #define __BITPIT_VOLUNSTRUCTURED_HPP__
 
 #include <array>
+#include <memory>
 #include <vector>
 
 #include "bitpit_patchkernel.hpp"
@@ -57,15 +58,21 @@ public:
 	bool isPointInside(const std::array<double, 3> &point) override;
 	bool isPointInside(long id, const std::array<double, 3> &point) override;
 	long locatePoint(const std::array<double, 3> &point) override;
+	void locatePoints(std::size_t nPoints, const std::array<double, 3> *points, long *ids);
 
 protected:
-	VolUnstructured(const VolUnstructured &other) = default;
+	VolUnstructured(const VolUnstructured &other);
 
 	int _getDumpVersion() const override;
 	void _dump(std::ostream &stream) const override;
 	void _restore(std::istream &stream) override;
 
+	void _cellsAltered() override;
+
 private:
+	std::unique_ptr<VolumeSkdTree> m_locationTree;
+
+	const VolumeSkdTree & getLocationTree();
 
 };
 
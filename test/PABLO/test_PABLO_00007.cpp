@@ -0,0 +1,231 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2019 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <array>
+#include <vector>
+
+#if BITPIT_ENABLE_MPI==1
+#   include <mpi.h>
+#endif
+
+#include "bitpit_common.hpp"
+#include "bitpit_PABLO.hpp"
+#include "bitpit_IO.hpp"
+
+using namespace std;
+using namespace bitpit;
+
+/*!
+* Refine the octants whose center is inside a sphere.
+*
+* \param tree is the tree
+* \param nRefinements is the number of refinements
+*/
+void refineSphere(ParaTree *tree, int nRefinements)
+{
+    const array<double, 3> SPHERE_CENTER = {{0.5, 0.5, 0.5}};
+    const double SPHERE_RADIUS = 0.25;
+
+    for (int n = 0; n < nRefinements; ++n) {
+        uint32_t nOctants = tree->getNumOctants();
+        for (uint32_t idx = 0; idx < nOctants; ++idx) {
+            array<double, 3> center = tree->getCenter(idx);
+            if (tree->getDim() == 2) {
+                center[2] = SPHERE_CENTER[2];
+            }
+
+            if (norm2(center - SPHERE_CENTER) < SPHERE_RADIUS) {
+                tree->setMarker(idx, 1);
+            }
+        }
+
+        tree->adapt();
+    }
+}
+
+/*!
+* Check the connectivity of the specified tree.
+*
+* The connectivity computed in flat mode should match the standard one and
+* the nodes referenced by the connectivity should match the nodes of the
+* octants.
+*
+* \param tree is the tree
+*/
+void checkConnectivity(ParaTree *tree)
+{
+    uint32_t nOctants = tree->getNumOctants();
+    uint8_t nNodes = tree->getNnodes();
+
+    // Standard connectivity
+    tree->computeConnectivity();
+    if (tree->isConnectivityFlat()) {
+        throw std::runtime_error("Connectivity should not be flat");
+    }
+
+    u32vector2D connectivity = tree->getConnectivity();
+    u32arr3vector nodes = tree->getNodes();
+
+    for (uint32_t idx = 0; idx < nOctants; ++idx) {
+        for (uint8_t i = 0; i < nNodes; ++i) {
+            if (tree->getNodeCoordinates(connectivity[idx][i]) != tree->getNode(idx, i)) {
+                throw std::runtime_error("Connectivity doesn't match the nodes of the octants");
+            }
+        }
+    }
+
+    for (std::size_t k = 1; k < nodes.size(); ++k) {
+        if (nodes[k] == nodes[k - 1]) {
+            throw std::runtime_error("Nodes are duplicated");
+        }
+    }
+
+    // Flat connectivity
+    tree->clearConnectivity();
+    tree->computeConnectivity(true);
+    if (!tree->isConnectivityFlat()) {
+        throw std::runtime_error("Connectivity should be flat");
+    }
+
+    if (tree->getNodes() != nodes) {
+        throw std::runtime_error("Flat nodes don't match the standard nodes");
+    }
+
+    if (!tree->getConnectivity().empty()) {
+        throw std::runtime_error("Standard connectivity should be empty in flat mode");
+    }
+
+    const u32vector &flatConnectivity = tree->getFlatConnectivity();
+    if (flatConnectivity.size() != nOctants * nNodes) {
+        throw std::runtime_error("Flat connectivity has the wrong size");
+    }
+
+    for (uint32_t idx = 0; idx < nOctants; ++idx) {
+        ConstProxyVector<uint32_t> octantConnect = tree->getConnectivityView(idx);
+        for (uint8_t i = 0; i < nNodes; ++i) {
+            if (flatConnectivity[idx * nNodes + i] != connectivity[idx][i] || octantConnect[i] != connectivity[idx][i]) {
+                throw std::runtime_error("Flat connectivity doesn't match the standard connectivity");
+            }
+        }
+    }
+
+    // Update keeps the mode
+    tree->updateConnectivity();
+    if (!tree->isConnectivityFlat() || tree->getFlatConnectivity() != flatConnectivity) {
+        throw std::runtime_error("Update of flat connectivity failed");
+    }
+
+    tree->clearConnectivity();
+
+    log::cout() << "    Octants: " << nOctants << ", nodes: " << nodes.size() << std::endl;
+}
+
+/*!
+* Subtest 001
+*
+* Testing connectivity of a 2D octree.
+*/
+int subtest_001()
+{
+    log::cout() << "\n\n:: Connectivity of a 2D octree ::\n";
+
+    ParaTree tree(2);
+    tree.adaptGlobalRefine();
+    tree.adaptGlobalRefine();
+    refineSphere(&tree, 3);
+
+    checkConnectivity(&tree);
+
+    return 0;
+}
+
+/*!
+* Subtest 002
+*
+* Testing connectivity of a 3D octree.
+*/
+int subtest_002()
+{
+    log::cout() << "\n\n:: Connectivity of a 3D octree ::\n";
+
+    ParaTree tree(3);
+    tree.adaptGlobalRefine();
+    tree.adaptGlobalRefine();
+    refineSphere(&tree, 2);
+
+    checkConnectivity(&tree);
+
+    return 0;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+#if BITPIT_ENABLE_MPI==1
+    MPI_Init(&argc,&argv);
+#else
+    BITPIT_UNUSED(argc);
+    BITPIT_UNUSED(argv);
+#endif
+
+    int nProcs;
+    int rank;
+#if BITPIT_ENABLE_MPI==1
+    MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+#else
+    nProcs = 1;
+    rank   = 0;
+#endif
+
+    // Initialize the logger
+    log::manager().initialize(log::SEPARATE, false, nProcs, rank);
+    log::cout() << fileVerbosity(log::NORMAL);
+    log::cout() << consoleVerbosity(log::QUIET);
+
+    // Run the subtests
+    log::cout() << "Testing octree connectivity" << std::endl;
+
+    int status;
+    try {
+        status = subtest_001();
+        if (status != 0) {
+            return status;
+        }
+
+        status = subtest_002();
+        if (status != 0) {
+            return status;
+        }
+    } catch (const std::exception &exception) {
+        log::cout() << exception.what();
+        exit(1);
+    }
+
+#if BITPIT_ENABLE_MPI==1
+    MPI_Finalize();
+#endif
+}
@@ -0,0 +1,265 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2019 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <array>
+#include <vector>
+
+#if BITPIT_ENABLE_MPI==1
+#   include <mpi.h>
+#endif
+
+#include "bitpit_common.hpp"
+#include "bitpit_PABLO.hpp"
+#include "bitpit_IO.hpp"
+
+using namespace std;
+using namespace bitpit;
+
+/*!
+* Refine the octants whose center is inside a sphere.
+*
+* \param tree is the tree
+* \param nRefinements is the number of refinements
+*/
+void refineSphere(ParaTree *tree, int nRefinements)
+{
+    const array<double, 3> SPHERE_CENTER = {{0.5, 0.5, 0.5}};
+    const double SPHERE_RADIUS = 0.25;
+
+    for (int n = 0; n < nRefinements; ++n) {
+        uint32_t nOctants = tree->getNumOctants();
+        for (uint32_t idx = 0; idx < nOctants; ++idx) {
+            array<double, 3> center = tree->getCenter(idx);
+            if (tree->getDim() == 2) {
+                center[2] = SPHERE_CENTER[2];
+            }
+
+            if (norm2(center - SPHERE_CENTER) < SPHERE_RADIUS) {
+                tree->setMarker(idx, 1);
+            }
+        }
+
+        tree->adapt();
+    }
+}
+
+/*!
+* Check that the index based getters of the specified tree return the
+* same values that can be read from the octants.
+*
+* \param tree is the tree
+*/
+void checkGetters(ParaTree *tree)
+{
+    uint32_t nOctants = tree->getNumOctants();
+    for (uint32_t idx = 0; idx < nOctants; ++idx) {
+        const Octant *octant = tree->getOctant(idx);
+
+        if (tree->getCoordinates(idx) != tree->getCoordinates(octant)) {
+            throw std::runtime_error("Coordinates don't match");
+        }
+
+        if (tree->getX(idx) != tree->getX(octant) || tree->getY(idx) != tree->getY(octant) || tree->getZ(idx) != tree->getZ(octant)) {
+            throw std::runtime_error("Coordinates don't match");
+        }
+
+        if (tree->getCenter(idx) != tree->getCenter(octant)) {
+            throw std::runtime_error("Centers don't match");
+        }
+
+        if (tree->getSize(idx) != tree->getSize(octant) || tree->getArea(idx) != tree->getArea(octant) || tree->getVolume(idx) != tree->getVolume(octant)) {
+            throw std::runtime_error("Sizes don't match");
+        }
+
+        if (tree->getLevel(idx) != tree->getLevel(octant) || tree->getMarker(idx) != tree->getMarker(octant)) {
+            throw std::runtime_error("Levels or markers don't match");
+        }
+
+        if (tree->getBalance(idx) != tree->getBalance(octant)) {
+            throw std::runtime_error("Balance flags don't match");
+        }
+
+        if (tree->getIsNewR(idx) != tree->getIsNewR(octant) || tree->getIsNewC(idx) != tree->getIsNewC(octant)) {
+            throw std::runtime_error("Adaption flags don't match");
+        }
+    }
+}
+
+/*!
+* Check the structure-of-arrays layout on a tree of the specified dimension.
+*
+* The same adaption is performed on two trees, one using the default layout
+* and the other using the structure-of-arrays layout: the getters of the two
+* trees should return the same values during the whole process.
+*
+* \param dimension is the dimension of the trees
+*/
+void checkLayout(int dimension)
+{
+    ParaTree aosTree(dimension);
+    if (aosTree.getOctantLayout() != ParaTree::OCTANT_LAYOUT_AOS) {
+        throw std::runtime_error("Default layout should be AoS");
+    }
+
+    ParaTree soaTree(dimension);
+    soaTree.setOctantLayout(ParaTree::OCTANT_LAYOUT_SOA);
+    if (soaTree.getOctantLayout() != ParaTree::OCTANT_LAYOUT_SOA) {
+        throw std::runtime_error("Unable to set the SoA layout");
+    }
+
+    // Uniform refinement
+    for (ParaTree *tree : {&aosTree, &soaTree}) {
+        tree->adaptGlobalRefine();
+        tree->adaptGlobalRefine();
+        refineSphere(tree, 2);
+        checkGetters(tree);
+    }
+
+    // Markers and balance flags set by the user, updated with 2:1 balance
+    for (ParaTree *tree : {&aosTree, &soaTree}) {
+        uint32_t nOctants = tree->getNumOctants();
+        for (uint32_t idx = 0; idx < nOctants; ++idx) {
+            if (idx % 7 == 0) {
+                tree->setMarker(idx, 1);
+            } else if (idx % 5 == 0) {
+                tree->setMarker(tree->getOctant(idx), -1);
+            }
+
+            if (idx % 11 == 0) {
+                tree->setBalance(idx, false);
+            }
+        }
+        checkGetters(tree);
+
+        tree->preadapt();
+        checkGetters(tree);
+
+        tree->adapt(true);
+        checkGetters(tree);
+
+        tree->adaptGlobalCoarse();
+        checkGetters(tree);
+    }
+
+    // Compare the two trees
+    uint32_t nOctants = aosTree.getNumOctants();
+    if (soaTree.getNumOctants() != nOctants) {
+        throw std::runtime_error("Trees have different number of octants");
+    }
+
+    for (uint32_t idx = 0; idx < nOctants; ++idx) {
+        if (aosTree.getCenter(idx) != soaTree.getCenter(idx) || aosTree.getLevel(idx) != soaTree.getLevel(idx)) {
+            throw std::runtime_error("Trees don't match");
+        }
+
+        if (aosTree.getMarker(idx) != soaTree.getMarker(idx) || aosTree.getIsNewC(idx) != soaTree.getIsNewC(idx)) {
+            throw std::runtime_error("Trees don't match");
+        }
+    }
+
+    // Switch back to the default layout
+    soaTree.setOctantLayout(ParaTree::OCTANT_LAYOUT_AOS);
+    checkGetters(&soaTree);
+
+    log::cout() << "    Octants: " << nOctants << std::endl;
+}
+
+/*!
+* Subtest 001
+*
+* Testing structure-of-arrays layout of a 2D octree.
+*/
+int subtest_001()
+{
+    log::cout() << "\n\n:: Structure-of-arrays layout of a 2D octree ::\n";
+
+    checkLayout(2);
+
+    return 0;
+}
+
+/*!
+* Subtest 002
+*
+* Testing structure-of-arrays layout of a 3D octree.
+*/
+int subtest_002()
+{
+    log::cout() << "\n\n:: Structure-of-arrays layout of a 3D octree ::\n";
+
+    checkLayout(3);
+
+    return 0;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+#if BITPIT_ENABLE_MPI==1
+    MPI_Init(&argc,&argv);
+#else
+    BITPIT_UNUSED(argc);
+    BITPIT_UNUSED(argv);
+#endif
+
+    int nProcs;
+    int rank;
+#if BITPIT_ENABLE_MPI==1
+    MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+#else
+    nProcs = 1;
+    rank   = 0;
+#endif
+
+    // Initialize the logger
+    log::manager().initialize(log::SEPARATE, false, nProcs, rank);
+    log::cout() << fileVerbosity(log::NORMAL);
+    log::cout() << consoleVerbosity(log::QUIET);
+
+    // Run the subtests
+    log::cout() << "Testing octree layouts" << std::endl;
+
+    int status;
+    try {
+        status = subtest_001();
+        if (status != 0) {
+            return status;
+        }
+
+        status = subtest_002();
+        if (status != 0) {
+            return status;
+        }
+    } catch (const std::exception &exception) {
+        log::cout() << exception.what();
+        exit(1);
+    }
+
+#if BITPIT_ENABLE_MPI==1
+    MPI_Finalize();
+#endif
+}
@@ -0,0 +1,212 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2019 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <array>
+#include <random>
+#include <vector>
+
+#if BITPIT_ENABLE_MPI==1
+#   include <mpi.h>
+#endif
+
+#include "bitpit_common.hpp"
+#include "bitpit_PABLO.hpp"
+#include "bitpit_IO.hpp"
+
+using namespace std;
+using namespace bitpit;
+
+/*!
+* Refine the octants whose center is inside a sphere.
+*
+* \param tree is the tree
+* \param nRefinements is the number of refinements
+*/
+void refineSphere(ParaTree *tree, int nRefinements)
+{
+    const array<double, 3> SPHERE_CENTER = {{0.5, 0.5, 0.5}};
+    const double SPHERE_RADIUS = 0.25;
+
+    for (int n = 0; n < nRefinements; ++n) {
+        uint32_t nOctants = tree->getNumOctants();
+        for (uint32_t idx = 0; idx < nOctants; ++idx) {
+            array<double, 3> center = tree->getCenter(idx);
+            if (tree->getDim() == 2) {
+                center[2] = SPHERE_CENTER[2];
+            }
+
+            if (norm2(center - SPHERE_CENTER) < SPHERE_RADIUS) {
+                tree->setMarker(idx, 1);
+            }
+        }
+
+        tree->adapt();
+    }
+}
+
+/*!
+* Check the batched point location of the specified tree.
+*
+* The owners found by the batched query should match the ones found
+* locating the points one by one.
+*
+* \param tree is the tree
+*/
+void checkPointOwners(ParaTree *tree)
+{
+    const std::size_t N_POINTS = 5000;
+
+    std::mt19937 generator(1);
+    std::uniform_real_distribution<double> distribution(-0.1, 1.1);
+
+    std::vector<darray3> points(N_POINTS);
+    for (darray3 &point : points) {
+        point[0] = distribution(generator);
+        point[1] = distribution(generator);
+        point[2] = (tree->getDim() == 3) ? distribution(generator) : 0.;
+    }
+
+    // Add the corners of the domain
+    points.push_back({{0., 0., 0.}});
+    points.push_back({{1., 1., (tree->getDim() == 3) ? 1. : 0.}});
+
+    u32vector ownerIdx;
+    ivector ownerRank;
+    tree->getPointsOwnerIdx(points.size(), points.data(), ownerIdx, ownerRank);
+    if (ownerIdx.size() != points.size() || ownerRank.size() != points.size()) {
+        throw std::runtime_error("Wrong number of owners");
+    }
+
+    std::size_t nInside = 0;
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        uint32_t expectedIdx = tree->getPointOwnerIdx(points[i]);
+        if (ownerIdx[i] != expectedIdx) {
+            throw std::runtime_error("Batched owner doesn't match the owner of the point");
+        }
+
+        if (expectedIdx == std::numeric_limits<uint32_t>::max()) {
+            if (ownerRank[i] >= 0) {
+                throw std::runtime_error("Points outside the domain should have no owner rank");
+            }
+            continue;
+        }
+
+        if (ownerRank[i] != tree->getRank()) {
+            throw std::runtime_error("Wrong owner rank");
+        }
+
+        ++nInside;
+    }
+
+    log::cout() << "    Points: " << points.size() << ", inside the domain: " << nInside << std::endl;
+}
+
+/*!
+* Subtest 001
+*
+* Testing batched point location on a 2D octree.
+*/
+int subtest_001()
+{
+    log::cout() << "\n\n:: Batched point location on a 2D octree ::\n";
+
+    ParaTree tree(2);
+    tree.adaptGlobalRefine();
+    tree.adaptGlobalRefine();
+    refineSphere(&tree, 4);
+
+    checkPointOwners(&tree);
+
+    return 0;
+}
+
+/*!
+* Subtest 002
+*
+* Testing batched point location on a 3D octree.
+*/
+int subtest_002()
+{
+    log::cout() << "\n\n:: Batched point location on a 3D octree ::\n";
+
+    ParaTree tree(3);
+    tree.adaptGlobalRefine();
+    tree.adaptGlobalRefine();
+    refineSphere(&tree, 3);
+
+    checkPointOwners(&tree);
+
+    return 0;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+#if BITPIT_ENABLE_MPI==1
+    MPI_Init(&argc,&argv);
+#else
+    BITPIT_UNUSED(argc);
+    BITPIT_UNUSED(argv);
+#endif
+
+    int nProcs;
+    int rank;
+#if BITPIT_ENABLE_MPI==1
+    MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+#else
+    nProcs = 1;
+    rank   = 0;
+#endif
+
+    // Initialize the logger
+    log::manager().initialize(log::SEPARATE, false, nProcs, rank);
+    log::cout() << fileVerbosity(log::NORMAL);
+    log::cout() << consoleVerbosity(log::QUIET);
+
+    // Run the subtests
+    log::cout() << "Testing batched point location" << std::endl;
+
+    int status;
+    try {
+        status = subtest_001();
+        if (status != 0) {
+            return status;
+        }
+
+        status = subtest_002();
+        if (status != 0) {
+            return status;
+        }
+    } catch (const std::exception &exception) {
+        log::cout() << exception.what();
+        exit(1);
+    }
+
+#if BITPIT_ENABLE_MPI==1
+    MPI_Finalize();
+#endif
+}
@@ -0,0 +1,183 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2019 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <random>
+#include <vector>
+
+#if BITPIT_ENABLE_MPI==1
+#   include <mpi.h>
+#endif
+
+#include "bitpit_common.hpp"
+#include "bitpit_PABLO.hpp"
+
+using namespace std;
+using namespace bitpit;
+
+/*!
+* Check the batch Morton functions using the specified kernel.
+*
+* The Morton numbers and the coordinates evaluated by the batch functions
+* should match the ones evaluated by the scalar functions. The number of
+* items is chosen so that the remainder loops of the kernels are tested.
+*
+* \param kernel is the kernel
+*/
+void checkKernel(PABLO::MortonKernel kernel)
+{
+    const std::size_t N_ITEMS = 1003;
+
+    PABLO::setMortonKernel(kernel);
+
+    std::mt19937 generator(1);
+    std::uniform_int_distribution<uint32_t> distribution3D(0, (1 << 21) - 1);
+    std::uniform_int_distribution<uint32_t> distribution2D;
+
+    // 3D Morton numbers
+    std::vector<uint32_t> x(N_ITEMS);
+    std::vector<uint32_t> y(N_ITEMS);
+    std::vector<uint32_t> z(N_ITEMS);
+    for (std::size_t i = 0; i < N_ITEMS; ++i) {
+        x[i] = distribution3D(generator);
+        y[i] = distribution3D(generator);
+        z[i] = distribution3D(generator);
+    }
+
+    std::vector<uint64_t> mortons(N_ITEMS);
+    PABLO::computeMortons(N_ITEMS, x.data(), y.data(), z.data(), mortons.data());
+    for (std::size_t i = 0; i < N_ITEMS; ++i) {
+        if (mortons[i] != PABLO::computeMorton(x[i], y[i], z[i])) {
+            throw std::runtime_error("Batch 3D Morton number doesn't match the scalar one");
+        }
+    }
+
+    std::vector<uint32_t> xDecoded(N_ITEMS);
+    std::vector<uint32_t> yDecoded(N_ITEMS);
+    std::vector<uint32_t> zDecoded(N_ITEMS);
+    PABLO::decodeMortons(N_ITEMS, mortons.data(), xDecoded.data(), yDecoded.data(), zDecoded.data());
+    if (xDecoded != x || yDecoded != y || zDecoded != z) {
+        throw std::runtime_error("Batch 3D Morton decode doesn't give the original coordinates");
+    }
+
+    // 2D Morton numbers
+    for (std::size_t i = 0; i < N_ITEMS; ++i) {
+        x[i] = distribution2D(generator);
+        y[i] = distribution2D(generator);
+    }
+
+    PABLO::computeMortons(N_ITEMS, x.data(), y.data(), mortons.data());
+    for (std::size_t i = 0; i < N_ITEMS; ++i) {
+        if (mortons[i] != PABLO::computeMorton(x[i], y[i])) {
+            throw std::runtime_error("Batch 2D Morton number doesn't match the scalar one");
+        }
+    }
+
+    PABLO::decodeMortons(N_ITEMS, mortons.data(), xDecoded.data(), yDecoded.data());
+    if (xDecoded != x || yDecoded != y) {
+        throw std::runtime_error("Batch 2D Morton decode doesn't give the original coordinates");
+    }
+
+    // Morton numbers cached by the tree
+    ParaTree tree(3);
+    tree.adaptGlobalRefine();
+    tree.adaptGlobalRefine();
+    tree.setMarker(uint32_t(0), 1);
+    tree.adapt();
+
+    for (uint32_t idx = 0; idx < tree.getNumOctants(); ++idx) {
+        if (tree.getMorton(idx) != tree.getMorton(tree.getOctant(idx))) {
+            throw std::runtime_error("Morton number cached by the tree doesn't match the one of the octant");
+        }
+    }
+}
+
+/*!
+* Subtest 001
+*
+* Testing batch Morton functions.
+*/
+int subtest_001()
+{
+    log::cout() << "\n\n:: Batch Morton functions ::\n";
+
+    PABLO::MortonKernel defaultKernel = PABLO::getMortonKernel();
+    for (PABLO::MortonKernel kernel : {PABLO::MORTON_KERNEL_SCALAR, PABLO::MORTON_KERNEL_AVX2, PABLO::MORTON_KERNEL_BMI2}) {
+        if (!PABLO::isMortonKernelSupported(kernel)) {
+            log::cout() << "    Kernel " << kernel << ": not supported" << std::endl;
+            continue;
+        }
+
+        checkKernel(kernel);
+        log::cout() << "    Kernel " << kernel << ": ok" << std::endl;
+    }
+    PABLO::setMortonKernel(defaultKernel);
+
+    return 0;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+#if BITPIT_ENABLE_MPI==1
+    MPI_Init(&argc,&argv);
+#else
+    BITPIT_UNUSED(argc);
+    BITPIT_UNUSED(argv);
+#endif
+
+    int nProcs;
+    int rank;
+#if BITPIT_ENABLE_MPI==1
+    MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+#else
+    nProcs = 1;
+    rank   = 0;
+#endif
+
+    // Initialize the logger
+    log::manager().initialize(log::SEPARATE, false, nProcs, rank);
+    log::cout() << fileVerbosity(log::NORMAL);
+    log::cout() << consoleVerbosity(log::QUIET);
+
+    // Run the subtests
+    log::cout() << "Testing batch Morton functions" << std::endl;
+
+    int status;
+    try {
+        status = subtest_001();
+        if (status != 0) {
+            return status;
+        }
+    } catch (const std::exception &exception) {
+        log::cout() << exception.what();
+        exit(1);
+    }
+
+#if BITPIT_ENABLE_MPI==1
+    MPI_Finalize();
+#endif
+}
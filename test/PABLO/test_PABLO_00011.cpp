@@ -0,0 +1,227 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2019 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <array>
+#include <vector>
+
+#if BITPIT_ENABLE_MPI==1
+#   include <mpi.h>
+#endif
+#if BITPIT_ENABLE_OPENMP==1
+#   include <omp.h>
+#endif
+
+#include "bitpit_common.hpp"
+#include "bitpit_PABLO.hpp"
+
+using namespace std;
+using namespace bitpit;
+
+/*!
+* Set the number of threads used by the adaption.
+*
+* When OpenMP is not enabled the adaption is always serial and the function
+* does nothing.
+*
+* \param nThreads is the number of threads
+*/
+void setThreads(int nThreads)
+{
+#if BITPIT_ENABLE_OPENMP==1
+    omp_set_num_threads(nThreads);
+#else
+    BITPIT_UNUSED(nThreads);
+#endif
+}
+
+/*!
+* Mark the octants of the tree for the adaption.
+*
+* The octants inside a spherical shell are marked for refinement, the
+* octants far from the shell are marked for coarsening.
+*
+* \param tree is the tree
+* \param radius is the radius of the shell
+*/
+void setMarkers(ParaTree *tree, double radius)
+{
+    const array<double, 3> SPHERE_CENTER = {{0.5, 0.5, 0.5}};
+
+    uint32_t nOctants = tree->getNumOctants();
+    for (uint32_t idx = 0; idx < nOctants; ++idx) {
+        array<double, 3> center = tree->getCenter(idx);
+        if (tree->getDim() == 2) {
+            center[2] = SPHERE_CENTER[2];
+        }
+
+        double distance = std::abs(norm2(center - SPHERE_CENTER) - radius);
+        if (distance < 0.5 * tree->getSize(idx)) {
+            tree->setMarker(idx, 2);
+        } else if (distance < 2. * tree->getSize(idx)) {
+            tree->setMarker(idx, 1);
+        } else if (distance > 0.2) {
+            tree->setMarker(idx, -1);
+        }
+    }
+}
+
+/*!
+* Check that the threaded adaption gives the same results of the serial
+* adaption.
+*
+* \param dim is the dimension of the trees
+* \param nGlobalRefinements is the number of global refinements applied
+* to the trees before the adaption
+*/
+void checkAdaption(uint8_t dim, int nGlobalRefinements)
+{
+    ParaTree serialTree(dim);
+    ParaTree threadedTree(dim);
+    for (int n = 0; n < nGlobalRefinements; ++n) {
+        serialTree.adaptGlobalRefine();
+        threadedTree.adaptGlobalRefine();
+    }
+
+    for (int iter = 0; iter < 3; ++iter) {
+        double radius = 0.2 + 0.05 * iter;
+
+        setThreads(1);
+        setMarkers(&serialTree, radius);
+        serialTree.adapt(true);
+
+        setThreads(4);
+        setMarkers(&threadedTree, radius);
+        threadedTree.adapt(true);
+
+        uint32_t nOctants = serialTree.getNumOctants();
+        if (threadedTree.getNumOctants() != nOctants) {
+            throw std::runtime_error("Threaded adaption gives a different number of octants");
+        }
+
+        u32vector serialMapper;
+        u32vector threadedMapper;
+        bvector serialIsGhost;
+        bvector threadedIsGhost;
+        for (uint32_t idx = 0; idx < nOctants; ++idx) {
+            if (threadedTree.getMorton(idx) != serialTree.getMorton(idx) ||
+                    threadedTree.getLevel(idx) != serialTree.getLevel(idx) ||
+                    threadedTree.getMarker(idx) != serialTree.getMarker(idx) ||
+                    threadedTree.getIsNewR(idx) != serialTree.getIsNewR(idx) ||
+                    threadedTree.getIsNewC(idx) != serialTree.getIsNewC(idx) ||
+                    threadedTree.getBalance(idx) != serialTree.getBalance(idx)) {
+                throw std::runtime_error("Threaded adaption gives different octants");
+            }
+
+            uint32_t mapIdx = idx;
+            serialTree.getMapping(mapIdx, serialMapper, serialIsGhost);
+            threadedTree.getMapping(mapIdx, threadedMapper, threadedIsGhost);
+            if (threadedMapper != serialMapper || threadedIsGhost != serialIsGhost) {
+                throw std::runtime_error("Threaded adaption gives a different mapping");
+            }
+        }
+
+        log::cout() << "    Adaption " << iter << ": " << nOctants << " octants" << std::endl;
+    }
+
+    setThreads(1);
+}
+
+/*!
+* Subtest 001
+*
+* Testing threaded adaption of a 2D octree.
+*/
+int subtest_001()
+{
+    log::cout() << "\n\n:: Threaded adaption of a 2D octree ::\n";
+
+    checkAdaption(2, 7);
+
+    return 0;
+}
+
+/*!
+* Subtest 002
+*
+* Testing threaded adaption of a 3D octree.
+*/
+int subtest_002()
+{
+    log::cout() << "\n\n:: Threaded adaption of a 3D octree ::\n";
+
+    checkAdaption(3, 4);
+
+    return 0;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+#if BITPIT_ENABLE_MPI==1
+    MPI_Init(&argc,&argv);
+#else
+    BITPIT_UNUSED(argc);
+    BITPIT_UNUSED(argv);
+#endif
+
+    int nProcs;
+    int rank;
+#if BITPIT_ENABLE_MPI==1
+    MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+#else
+    nProcs = 1;
+    rank   = 0;
+#endif
+
+    // Initialize the logger
+    log::manager().initialize(log::SEPARATE, false, nProcs, rank);
+    log::cout() << fileVerbosity(log::NORMAL);
+    log::cout() << consoleVerbosity(log::QUIET);
+
+    // Run the subtests
+    log::cout() << "Testing threaded adaption" << std::endl;
+
+    int status;
+    try {
+        status = subtest_001();
+        if (status != 0) {
+            return status;
+        }
+
+        status = subtest_002();
+        if (status != 0) {
+            return status;
+        }
+    } catch (const std::exception &exception) {
+        log::cout() << exception.what();
+        exit(1);
+    }
+
+#if BITPIT_ENABLE_MPI==1
+    MPI_Finalize();
+#endif
+}
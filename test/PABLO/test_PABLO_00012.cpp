@@ -0,0 +1,253 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2019 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <array>
+#include <vector>
+
+#if BITPIT_ENABLE_MPI==1
+#   include <mpi.h>
+#endif
+
+#include "bitpit_common.hpp"
+#include "bitpit_PABLO.hpp"
+
+using namespace std;
+using namespace bitpit;
+
+
+/*!
+* Mark for refinement the octants whose center is near a circle.
+*
+* \param tree is the tree
+* \param radius is the radius of the circle
+*/
+void setMarkers(ParaTree *tree, double radius)
+{
+    const array<double, 3> CIRCLE_CENTER = {{0.4, 0.6, 0.5}};
+
+    uint32_t nOctants = tree->getNumOctants();
+    for (uint32_t idx = 0; idx < nOctants; ++idx) {
+        array<double, 3> center = tree->getCenter(idx);
+        center[2] = CIRCLE_CENTER[2];
+
+        double distance = std::abs(norm2(center - CIRCLE_CENTER) - radius);
+        if (distance < tree->getSize(idx)) {
+            tree->setMarker(idx, 1);
+        }
+    }
+}
+
+/*!
+* Check that the cached neighbours of a tree match the ones found searching
+* the tree.
+*
+* \param tree is the tree with the neighbour cache enabled
+*/
+void checkNeighbours(const ParaTree &tree)
+{
+    if (!tree.isNeighbourCacheValid()) {
+        throw std::runtime_error("Neighbour cache is not valid");
+    }
+
+    uint8_t dim = tree.getDim();
+    uint8_t maxCodim = tree.getNeighbourCacheCodimension();
+    uint32_t nOctants = tree.getNumOctants();
+    for (uint32_t idx = 0; idx < nOctants; ++idx) {
+        const Octant *octant = tree.getOctant(idx);
+        for (uint8_t codim = 1; codim <= maxCodim; ++codim) {
+            uint8_t nEntities;
+            if (codim == 1) {
+                nEntities = tree.getNfaces();
+            } else if (codim == dim) {
+                nEntities = tree.getNnodes();
+            } else {
+                nEntities = tree.getNedges();
+            }
+
+            for (uint8_t i = 0; i < nEntities; ++i) {
+                // Neighbours found searching the tree
+                u32vector expectedNeighbours;
+                bvector expectedIsGhost;
+                tree.findNeighbours(octant, i, codim, expectedNeighbours, expectedIsGhost);
+
+                // Neighbours read from the cache
+                ConstProxyVector<uint8_t> cachedIsGhost;
+                ConstProxyVector<uint32_t> cachedNeighbours = tree.getNeighboursView(idx, i, codim, &cachedIsGhost);
+                if (cachedNeighbours.size() != expectedNeighbours.size() || cachedIsGhost.size() != expectedIsGhost.size()) {
+                    throw std::runtime_error("Neighbour cache has a wrong number of neighbours");
+                }
+
+                for (std::size_t n = 0; n < expectedNeighbours.size(); ++n) {
+                    if (cachedNeighbours[n] != expectedNeighbours[n] || (cachedIsGhost[n] != 0) != expectedIsGhost[n]) {
+                        throw std::runtime_error("Neighbour cache has wrong neighbours");
+                    }
+                }
+
+                u32vector neighbours;
+                bvector isGhost;
+                tree.findNeighbours(idx, i, codim, neighbours, isGhost);
+                if (neighbours != expectedNeighbours || isGhost != expectedIsGhost) {
+                    throw std::runtime_error("Neighbour search using the cache gives wrong neighbours");
+                }
+            }
+        }
+    }
+}
+
+/*!
+* Check the neighbour cache of a tree while it is modified.
+*
+* \param dim is the dimension of the tree
+*/
+void checkNeighbourCache(uint8_t dim)
+{
+    ParaTree tree(dim);
+    tree.enableNeighbourCache(dim);
+    checkNeighbours(tree);
+
+    // Global refinement
+    tree.adaptGlobalRefine();
+    tree.adaptGlobalRefine();
+    checkNeighbours(tree);
+
+    // Periodic boundaries
+    tree.setPeriodic(0);
+    checkNeighbours(tree);
+
+    // Adaption
+    for (int iter = 0; iter < 3; ++iter) {
+        setMarkers(&tree, 0.2 + 0.05 * iter);
+        tree.adapt();
+        checkNeighbours(tree);
+
+        log::cout() << "    Adaption " << iter << ": " << tree.getNumOctants() << " octants" << std::endl;
+    }
+
+    // Global coarsening
+    tree.adaptGlobalCoarse();
+    checkNeighbours(tree);
+
+#if BITPIT_ENABLE_MPI==1
+    // Load balance
+    tree.loadBalance();
+    checkNeighbours(tree);
+#endif
+
+    // Copy
+    ParaTree copy(tree);
+    checkNeighbours(copy);
+
+    // Disabled cache
+    tree.disableNeighbourCache();
+    if (tree.isNeighbourCacheValid()) {
+        throw std::runtime_error("Disabled neighbour cache is valid");
+    }
+
+    u32vector neighbours;
+    bvector isGhost;
+    tree.findNeighbours(uint32_t(0), 0, 1, neighbours, isGhost);
+    ConstProxyVector<uint32_t> viewNeighbours = tree.getNeighboursView(0, 0, 1);
+    if (u32vector(viewNeighbours.cbegin(), viewNeighbours.cend()) != neighbours) {
+        throw std::runtime_error("Neighbour view without the cache gives wrong neighbours");
+    }
+}
+
+/*!
+* Subtest 001
+*
+* Testing the neighbour cache of a 2D octree.
+*/
+int subtest_001()
+{
+    log::cout() << "\n\n:: Neighbour cache of a 2D octree ::\n";
+
+    checkNeighbourCache(2);
+
+    return 0;
+}
+
+/*!
+* Subtest 002
+*
+* Testing the neighbour cache of a 3D octree.
+*/
+int subtest_002()
+{
+    log::cout() << "\n\n:: Neighbour cache of a 3D octree ::\n";
+
+    checkNeighbourCache(3);
+
+    return 0;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+#if BITPIT_ENABLE_MPI==1
+    MPI_Init(&argc,&argv);
+#else
+    BITPIT_UNUSED(argc);
+    BITPIT_UNUSED(argv);
+#endif
+
+    int nProcs;
+    int rank;
+#if BITPIT_ENABLE_MPI==1
+    MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+#else
+    nProcs = 1;
+    rank   = 0;
+#endif
+
+    // Initialize the logger
+    log::manager().initialize(log::SEPARATE, false, nProcs, rank);
+    log::cout() << fileVerbosity(log::NORMAL);
+    log::cout() << consoleVerbosity(log::QUIET);
+
+    // Run the subtests
+    log::cout() << "Testing neighbour cache" << std::endl;
+
+    int status;
+    try {
+        status = subtest_001();
+        if (status != 0) {
+            return status;
+        }
+
+        status = subtest_002();
+        if (status != 0) {
+            return status;
+        }
+    } catch (const std::exception &exception) {
+        log::cout() << exception.what();
+        exit(1);
+    }
+
+#if BITPIT_ENABLE_MPI==1
+    MPI_Finalize();
+#endif
+}
@@ -0,0 +1,177 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2019 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <cmath>
+#include <vector>
+
+#include <mpi.h>
+
+#include "bitpit_common.hpp"
+#include "bitpit_PABLO.hpp"
+#include "bitpit_IO.hpp"
+
+using namespace bitpit;
+
+/*!
+* Evaluate the weights of the local octants.
+*
+* The octants in the left half of the domain are four times heavier than
+* the others.
+*
+* \param tree is the tree
+* \result The weights of the local octants.
+*/
+dvector evalWeights(const ParaTree &tree)
+{
+    uint32_t nOctants = tree.getNumOctants();
+
+    dvector weights(nOctants);
+    for (uint32_t idx = 0; idx < nOctants; ++idx) {
+        if (tree.getCenter(idx)[0] < 0.5) {
+            weights[idx] = 4.;
+        } else {
+            weights[idx] = 1.;
+        }
+    }
+
+    return weights;
+}
+
+/*!
+* Check the weights of the partition.
+*
+* Every process should receive a share of the global weight that differs
+* from the average by less than the maximum weight of an octant.
+*
+* \param tree is the tree
+*/
+void checkPartition(const ParaTree &tree)
+{
+    const double MAX_WEIGHT = 4.;
+
+    dvector weights = evalWeights(tree);
+
+    double localWeight = 0.;
+    for (double weight : weights) {
+        localWeight += weight;
+    }
+
+    double globalWeight;
+    MPI_Allreduce(&localWeight, &globalWeight, 1, MPI_DOUBLE, MPI_SUM, tree.getComm());
+
+    double averageWeight = globalWeight / tree.getNproc();
+    log::cout() << "    Weight on rank " << tree.getRank() << " = " << localWeight << " (average " << averageWeight << ")" << std::endl;
+    if (std::abs(localWeight - averageWeight) > MAX_WEIGHT) {
+        throw std::runtime_error("Partition is not balanced");
+    }
+
+    uint64_t nGlobalOctants = tree.getNumOctants();
+    MPI_Allreduce(MPI_IN_PLACE, &nGlobalOctants, 1, MPI_UINT64_T, MPI_SUM, tree.getComm());
+    if (nGlobalOctants != tree.getGlobalNumOctants()) {
+        throw std::runtime_error("Octants are lost during the partitioning");
+    }
+}
+
+/*!
+* Subtest 001
+*
+* Testing weighted partitioning of a distributed 2D octree.
+*
+* \param rank is the rank of the process
+*/
+int subtest_001(int rank)
+{
+    BITPIT_UNUSED(rank);
+
+    // Instantation of a 2D para_tree object
+    ParaTree pablo(2);
+
+    // Refine globally and distribute the tree
+    for (int iter = 0; iter < 5; iter++) {
+        pablo.adaptGlobalRefine();
+    }
+
+    pablo.loadBalance();
+
+    // Refine the bottom half of the domain, the tree is now unbalanced
+    uint32_t nOctants = pablo.getNumOctants();
+    for (uint32_t idx = 0; idx < nOctants; ++idx) {
+        if (pablo.getCenter(idx)[1] < 0.5) {
+            pablo.setMarker(idx, 1);
+        }
+    }
+    pablo.adapt();
+
+    // Weighted partitioning of the distributed tree
+    dvector weights = evalWeights(pablo);
+    pablo.loadBalance(&weights);
+
+    checkPartition(pablo);
+
+    // Uniform weights should give the uniform partitioning
+    weights.assign(pablo.getNumOctants(), 1.);
+    pablo.loadBalance(&weights);
+    uint32_t nWeightedOctants = pablo.getNumOctants();
+
+    pablo.loadBalance();
+    if (pablo.getNumOctants() != nWeightedOctants) {
+        throw std::runtime_error("Uniform weights don't give the uniform partition");
+    }
+
+    // Done
+    return 0;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+    MPI_Init(&argc,&argv);
+
+    // Initialize the logger
+    int nProcs;
+    int rank;
+    MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    log::manager().initialize(log::COMBINED, true, nProcs, rank);
+    log::cout().setVisibility(log::GLOBAL);
+
+    // Run the subtests
+    log::cout() << "Testing weighted partitioning of a parallel octree." << std::endl;
+
+    int status;
+    try {
+        status = subtest_001(rank);
+        if (status != 0) {
+            return status;
+        }
+    } catch (const std::exception &exception) {
+        log::cout() << exception.what();
+        exit(1);
+    }
+
+    MPI_Finalize();
+}
@@ -0,0 +1,162 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2019 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <mpi.h>
+
+#include "bitpit_common.hpp"
+#include "bitpit_PABLO.hpp"
+#include "bitpit_IO.hpp"
+
+using namespace bitpit;
+
+/*!
+* Subtest 001
+*
+* Testing batched point location on a distributed 3D octree.
+*
+* \param rank is the rank of the process
+*/
+int subtest_001(int rank)
+{
+    BITPIT_UNUSED(rank);
+
+    const std::size_t N_POINTS = 2000;
+
+    // Instantation of a 3D para_tree object
+    ParaTree pablo(3);
+
+    // Refine globally and distribute the tree
+    for (int iter = 0; iter < 4; iter++) {
+        pablo.adaptGlobalRefine();
+    }
+
+    pablo.loadBalance();
+
+    // All the processes query the same points
+    std::mt19937 generator(1);
+    std::uniform_real_distribution<double> distribution(-0.1, 1.1);
+
+    std::vector<darray3> points(N_POINTS);
+    for (darray3 &point : points) {
+        point[0] = distribution(generator);
+        point[1] = distribution(generator);
+        point[2] = distribution(generator);
+    }
+
+    u32vector ownerIdx;
+    ivector ownerRank;
+    pablo.getPointsOwnerIdx(points.size(), points.data(), ownerIdx, ownerRank, true);
+
+    // The owner of each point evaluates the expected global index
+    std::vector<uint64_t> expectedGlobalIdx(N_POINTS, 0);
+    for (std::size_t i = 0; i < N_POINTS; ++i) {
+        if (ownerRank[i] != pablo.getRank()) {
+            continue;
+        }
+
+        uint32_t idx = pablo.getPointOwnerIdx(points[i]);
+        if (idx == std::numeric_limits<uint32_t>::max()) {
+            throw std::runtime_error("Unable to locate a local point");
+        }
+
+        expectedGlobalIdx[i] = pablo.getGlobalIdx(idx);
+    }
+
+    MPI_Allreduce(MPI_IN_PLACE, expectedGlobalIdx.data(), N_POINTS, MPI_UINT64_T, MPI_MAX, pablo.getComm());
+
+    // Check the owners
+    const std::vector<uint64_t> &partitionRanges = pablo.getPartitionRangeGlobalIdx();
+
+    std::size_t nRemote = 0;
+    for (std::size_t i = 0; i < N_POINTS; ++i) {
+        if (ownerRank[i] < 0) {
+            if (ownerIdx[i] != std::numeric_limits<uint32_t>::max()) {
+                throw std::runtime_error("Points outside the domain should have no owner");
+            }
+            continue;
+        } else if (ownerRank[i] != pablo.getRank()) {
+            ++nRemote;
+        }
+
+        uint64_t offset = (ownerRank[i] > 0) ? partitionRanges[ownerRank[i] - 1] + 1 : 0;
+        if (offset + ownerIdx[i] != expectedGlobalIdx[i]) {
+            throw std::runtime_error("Owner doesn't match the expected one");
+        }
+    }
+
+    log::cout() << "    Points: " << N_POINTS << ", owned by other processes: " << nRemote << std::endl;
+
+    // Without the exchange only the local points are located
+    u32vector localOwnerIdx;
+    pablo.getPointsOwnerIdx(points.size(), points.data(), localOwnerIdx);
+    for (std::size_t i = 0; i < N_POINTS; ++i) {
+        if (ownerRank[i] == pablo.getRank()) {
+            if (localOwnerIdx[i] != ownerIdx[i]) {
+                throw std::runtime_error("Local owner doesn't match the expected one");
+            }
+        } else if (localOwnerIdx[i] != std::numeric_limits<uint32_t>::max()) {
+            throw std::runtime_error("Points owned by other processes should have no local owner");
+        }
+    }
+
+    // Done
+    return 0;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+    MPI_Init(&argc,&argv);
+
+    // Initialize the logger
+    int nProcs;
+    int rank;
+    MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    log::manager().initialize(log::COMBINED, true, nProcs, rank);
+    log::cout().setVisibility(log::GLOBAL);
+
+    // Run the subtests
+    log::cout() << "Testing batched point location on a parallel octree." << std::endl;
+
+    int status;
+    try {
+        status = subtest_001(rank);
+        if (status != 0) {
+            return status;
+        }
+    } catch (const std::exception &exception) {
+        log::cout() << exception.what();
+        exit(1);
+    }
+
+    MPI_Finalize();
+}
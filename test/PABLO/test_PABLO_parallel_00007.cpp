@@ -0,0 +1,182 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2019 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+
+#include <array>
+#include <cmath>
+#include <vector>
+
+#include <mpi.h>
+
+#include "bitpit_common.hpp"
+#include "bitpit_PABLO.hpp"
+
+using namespace bitpit;
+
+/*!
+* Mark the octants for the adaption.
+*
+* The octants close to the given point are marked for a deep refinement,
+* the octants far from it are marked for coarsening. The balance has to
+* propagate the refinement across several layers of octants and across
+* the partitions.
+*
+* \param tree is the tree
+* \param point is the point driving the refinement
+*/
+void setMarkers(ParaTree &tree, const std::array<double, 3> &point)
+{
+    uint32_t nOctants = tree.getNumOctants();
+    for (uint32_t idx = 0; idx < nOctants; ++idx) {
+        std::array<double, 3> center = tree.getCenter(idx);
+        double distance = std::sqrt(std::pow(center[0] - point[0], 2) + std::pow(center[1] - point[1], 2));
+        if (distance < tree.getSize(idx)) {
+            tree.setMarker(idx, 3);
+        } else if (distance > 0.4) {
+            tree.setMarker(idx, -1);
+        }
+    }
+}
+
+/*!
+* Check that two trees are equal.
+*
+* \param tree is the tree
+* \param reference is the reference tree
+*/
+void checkTrees(const ParaTree &tree, const ParaTree &reference)
+{
+    if (tree.getGlobalNumOctants() != reference.getGlobalNumOctants()) {
+        throw std::runtime_error("Balance strategies give trees with a different number of octants");
+    }
+
+    uint32_t nOctants = tree.getNumOctants();
+    if (nOctants != reference.getNumOctants()) {
+        throw std::runtime_error("Balance strategies give different partitions");
+    }
+
+    for (uint32_t idx = 0; idx < nOctants; ++idx) {
+        if (tree.getMorton(idx) != reference.getMorton(idx) || tree.getLevel(idx) != reference.getLevel(idx)) {
+            throw std::runtime_error("Balance strategies give different octants");
+        }
+    }
+}
+
+/*!
+* Subtest 001
+*
+* Testing the frontier strategy of the 2:1 balance of a distributed 2D octree.
+*
+* \param rank is the rank of the process
+*/
+int subtest_001(int rank)
+{
+    BITPIT_UNUSED(rank);
+
+    // Instantation of two 2D para_tree objects, one for each balance strategy
+    ParaTree sweepTree(2);
+    sweepTree.setBalanceStrategy(ParaTree::BALANCE_STRATEGY_SWEEP);
+    sweepTree.setBalanceCodimension(2);
+
+    ParaTree frontierTree(2);
+    frontierTree.setBalanceStrategy(ParaTree::BALANCE_STRATEGY_FRONTIER);
+    frontierTree.setBalanceCodimension(2);
+
+    // Refine globally and distribute the trees
+    for (int iter = 0; iter < 4; iter++) {
+        sweepTree.adaptGlobalRefine();
+        frontierTree.adaptGlobalRefine();
+    }
+
+    sweepTree.loadBalance();
+    frontierTree.loadBalance();
+
+    // Adapt the trees around a moving point
+    for (int iter = 0; iter < 4; iter++) {
+        std::array<double, 3> point = {{0.3 + 0.1 * iter, 0.45 + 0.05 * iter, 0.}};
+
+        setMarkers(sweepTree, point);
+        sweepTree.adapt();
+
+        setMarkers(frontierTree, point);
+        frontierTree.adapt();
+
+        checkTrees(frontierTree, sweepTree);
+
+        u32vector sweepVisits = sweepTree.getBalanceVisits();
+        u32vector frontierVisits = frontierTree.getBalanceVisits();
+        log::cout() << "    Adaption " << iter << ": " << frontierTree.getGlobalNumOctants() << " octants" << std::endl;
+        for (std::size_t k = 0; k < sweepVisits.size(); ++k) {
+            log::cout() << "      Sweep iteration " << k << " visited " << sweepVisits[k] << " octants" << std::endl;
+        }
+        for (std::size_t k = 0; k < frontierVisits.size(); ++k) {
+            log::cout() << "      Frontier iteration " << k << " visited " << frontierVisits[k] << " octants" << std::endl;
+        }
+
+        if (frontierVisits.empty()) {
+            throw std::runtime_error("Balance visits are not tracked");
+        }
+
+        sweepTree.loadBalance();
+        frontierTree.loadBalance();
+
+        checkTrees(frontierTree, sweepTree);
+    }
+
+    // Done
+    return 0;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+    MPI_Init(&argc,&argv);
+
+    // Initialize the logger
+    int nProcs;
+    int rank;
+    MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    log::manager().initialize(log::COMBINED, true, nProcs, rank);
+    log::cout().setVisibility(log::GLOBAL);
+
+    // Run the subtests
+    log::cout() << "Testing frontier-based 2:1 balance of a parallel octree." << std::endl;
+
+    int status;
+    try {
+        status = subtest_001(rank);
+        if (status != 0) {
+            return status;
+        }
+    } catch (const std::exception &exception) {
+        log::cout() << exception.what();
+        exit(1);
+    }
+
+    MPI_Finalize();
+}
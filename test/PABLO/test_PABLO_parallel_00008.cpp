@@ -0,0 +1,292 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2019 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+#include <array>
+#include <cmath>
+#include <string>
+
+#include <mpi.h>
+
+#include "bitpit_common.hpp"
+#include "bitpit_PABLO.hpp"
+
+using namespace bitpit;
+
+/*!
+* Refine the octants whose center is inside a circle.
+*
+* \param tree is the tree
+* \param nRefinements is the number of refinements
+*/
+void refineCircle(ParaTree &tree, int nRefinements)
+{
+    for (int n = 0; n < nRefinements; ++n) {
+        uint32_t nOctants = tree.getNumOctants();
+        for (uint32_t idx = 0; idx < nOctants; ++idx) {
+            std::array<double, 3> center = tree.getCenter(idx);
+            double distance = std::sqrt(std::pow(center[0] - 0.4, 2) + std::pow(center[1] - 0.6, 2));
+            if (distance < 0.2) {
+                tree.setMarker(idx, 1);
+            }
+        }
+
+        tree.adapt();
+    }
+}
+
+/*!
+* Check that the octants of a tree match the ones of a serial reference
+* tree with the same global indexes.
+*
+* \param tree is the tree
+* \param reference is the serial reference tree
+*/
+void checkOctants(const ParaTree &tree, const ParaTree &reference)
+{
+    if (tree.getGlobalNumOctants() != reference.getGlobalNumOctants()) {
+        throw std::runtime_error("Restored tree has a different number of octants");
+    }
+
+    uint32_t nOctants = tree.getNumOctants();
+    for (uint32_t idx = 0; idx < nOctants; ++idx) {
+        uint32_t referenceIdx = static_cast<uint32_t>(tree.getGlobalIdx(idx));
+        if (tree.getMorton(idx) != reference.getMorton(referenceIdx) || tree.getLevel(idx) != reference.getLevel(referenceIdx)) {
+            throw std::runtime_error("Restored tree has different octants");
+        }
+    }
+}
+
+/*!
+* Subtest 001
+*
+* Testing the restore of a checkpoint of a distributed 2D octree on a
+* different number of processes.
+*
+* \param rank is the rank of the process
+*/
+int subtest_001(int rank)
+{
+    const std::string FILENAME = "test_PABLO_parallel_00008_distributed.dat";
+
+    int nProcs;
+    MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+
+    // Create and distribute the tree
+    ParaTree tree(2);
+    for (int iter = 0; iter < 3; iter++) {
+        tree.adaptGlobalRefine();
+    }
+
+    tree.loadBalance();
+    refineCircle(tree, 3);
+    tree.loadBalance();
+
+    tree.dumpCheckpoint(FILENAME);
+
+    // Restore the checkpoint on a single process
+    ParaTree serialTree(2, "PABLO", MPI_COMM_SELF);
+    serialTree.restoreCheckpoint(FILENAME);
+
+    checkOctants(tree, serialTree);
+    log::cout() << "    Restored " << serialTree.getGlobalNumOctants() << " octants on 1 process" << std::endl;
+
+    // Restore the checkpoint on subsets of the processes
+    for (int nRestoreProcs = 2; nRestoreProcs <= nProcs; ++nRestoreProcs) {
+        MPI_Comm restoreComm;
+        MPI_Comm_split(MPI_COMM_WORLD, (rank < nRestoreProcs) ? 0 : MPI_UNDEFINED, rank, &restoreComm);
+        if (restoreComm == MPI_COMM_NULL) {
+            continue;
+        }
+
+        ParaTree restoredTree(2, "PABLO", restoreComm);
+        restoredTree.restoreCheckpoint(FILENAME);
+
+        if (restoredTree.getSerial()) {
+            throw std::runtime_error("Restored tree should be distributed");
+        }
+
+        if (restoredTree.getNumOctants() == 0 || restoredTree.getNumGhosts() == 0) {
+            throw std::runtime_error("Restored tree is not partitioned");
+        }
+
+        checkOctants(restoredTree, serialTree);
+
+        // The restored tree should be usable
+        restoredTree.adaptGlobalRefine();
+        if (restoredTree.getGlobalNumOctants() != 4 * serialTree.getGlobalNumOctants()) {
+            throw std::runtime_error("Restored tree cannot be adapted");
+        }
+
+        log::cout() << "    Restored " << serialTree.getGlobalNumOctants() << " octants on " << nRestoreProcs << " processes" << std::endl;
+
+        MPI_Comm_free(&restoreComm);
+    }
+
+    // Done
+    return 0;
+}
+
+/*!
+* Subtest 002
+*
+* Testing the restore of a checkpoint of a serial 2D octree on a different
+* number of processes.
+*
+* \param rank is the rank of the process
+*/
+int subtest_002(int rank)
+{
+    const std::string FILENAME = "test_PABLO_parallel_00008_serial.dat";
+
+    // Create the tree
+    ParaTree tree(2);
+    for (int iter = 0; iter < 3; iter++) {
+        tree.adaptGlobalRefine();
+    }
+
+    refineCircle(tree, 2);
+
+    tree.dumpCheckpoint(FILENAME);
+
+    // Restore the checkpoint on two processes
+    MPI_Comm restoreComm;
+    MPI_Comm_split(MPI_COMM_WORLD, (rank < 2) ? 0 : MPI_UNDEFINED, rank, &restoreComm);
+    if (restoreComm == MPI_COMM_NULL) {
+        return 0;
+    }
+
+    ParaTree restoredTree(2, "PABLO", restoreComm);
+    restoredTree.restoreCheckpoint(FILENAME);
+
+    if (!restoredTree.getSerial()) {
+        throw std::runtime_error("Restored tree should be serial");
+    }
+
+    uint32_t nOctants = tree.getNumOctants();
+    if (restoredTree.getNumOctants() != nOctants) {
+        throw std::runtime_error("Restored tree has a different number of octants");
+    }
+
+    for (uint32_t idx = 0; idx < nOctants; ++idx) {
+        if (restoredTree.getMorton(idx) != tree.getMorton(idx) || restoredTree.getLevel(idx) != tree.getLevel(idx)) {
+            throw std::runtime_error("Restored tree has different octants");
+        }
+    }
+
+    log::cout() << "    Restored " << restoredTree.getGlobalNumOctants() << " octants on every process" << std::endl;
+
+    MPI_Comm_free(&restoreComm);
+
+    // Done
+    return 0;
+}
+
+/*!
+* Subtest 003
+*
+* Testing that the properties of a 2D octree balanced across vertices
+* survive a checkpoint round trip.
+*
+* \param rank is the rank of the process
+*/
+int subtest_003(int rank)
+{
+    BITPIT_UNUSED(rank);
+
+    const std::string FILENAME = "test_PABLO_parallel_00008_codimension.dat";
+
+    // Create and distribute the tree
+    ParaTree tree(2);
+    tree.setBalanceCodimension(2);
+    for (int iter = 0; iter < 3; iter++) {
+        tree.adaptGlobalRefine();
+    }
+
+    tree.loadBalance();
+    refineCircle(tree, 2);
+
+    tree.dumpCheckpoint(FILENAME);
+
+    // Restore the checkpoint on all the processes and on a single process
+    ParaTree restoredTree(2);
+    restoredTree.restoreCheckpoint(FILENAME);
+
+    ParaTree serialTree(2, "PABLO", MPI_COMM_SELF);
+    serialTree.restoreCheckpoint(FILENAME);
+
+    for (const ParaTree *checkedTree : {&restoredTree, &serialTree}) {
+        if (checkedTree->getBalanceCodimension() != 2) {
+            throw std::runtime_error("Restored tree has a different balance codimension");
+        }
+    }
+
+    checkOctants(restoredTree, serialTree);
+
+    log::cout() << "    Restored balance codimension " << static_cast<int>(restoredTree.getBalanceCodimension()) << std::endl;
+
+    // Done
+    return 0;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+    MPI_Init(&argc,&argv);
+
+    // Initialize the logger
+    int nProcs;
+    int rank;
+    MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    log::manager().initialize(log::COMBINED, true, nProcs, rank);
+    log::cout().setVisibility(log::GLOBAL);
+
+    // Run the subtests
+    log::cout() << "Testing single-file checkpoints of a parallel octree." << std::endl;
+
+    int status;
+    try {
+        status = subtest_001(rank);
+        if (status != 0) {
+            return status;
+        }
+
+        status = subtest_002(rank);
+        if (status != 0) {
+            return status;
+        }
+
+        status = subtest_003(rank);
+        if (status != 0) {
+            return status;
+        }
+    } catch (const std::exception &exception) {
+        log::cout() << exception.what();
+        exit(1);
+    }
+
+    MPI_Finalize();
+}
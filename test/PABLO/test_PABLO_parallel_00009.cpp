@@ -0,0 +1,221 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2019 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <array>
+#include <vector>
+
+#include <mpi.h>
+
+#include "bitpit_common.hpp"
+#include "bitpit_PABLO.hpp"
+
+using namespace bitpit;
+
+/*!
+* Communication interface that exchanges one value per octant.
+*/
+class ValueComm : public DataCommInterface<ValueComm> {
+
+public:
+    ValueComm(std::vector<double> &data, std::vector<double> &ghostData)
+        : m_data(data), m_ghostData(ghostData)
+    {
+    }
+
+    size_t fixedSize() const
+    {
+        return sizeof(double);
+    }
+
+    size_t size(const uint32_t e) const
+    {
+        BITPIT_UNUSED(e);
+
+        return sizeof(double);
+    }
+
+    template<class Buffer>
+    void gather(Buffer &buffer, const uint32_t e)
+    {
+        buffer << m_data[e];
+    }
+
+    template<class Buffer>
+    void scatter(Buffer &buffer, const uint32_t e)
+    {
+        buffer >> m_ghostData[e];
+    }
+
+private:
+    std::vector<double> &m_data;
+    std::vector<double> &m_ghostData;
+
+};
+
+/*!
+* Check the data received by the ghost octants.
+*
+* \param tree is the tree
+* \param ghostData is the data of the ghost octants
+*/
+void checkGhostData(const ParaTree &tree, const std::vector<double> &ghostData)
+{
+    uint32_t nGhosts = tree.getNumGhosts();
+    for (uint32_t idx = 0; idx < nGhosts; ++idx) {
+        if (ghostData[idx] != static_cast<double>(tree.getGhostGlobalIdx(idx))) {
+            throw std::runtime_error("Ghost octants received wrong data");
+        }
+    }
+}
+
+/*!
+* Check the split-phase communication of user data.
+*
+* \param dim is the dimension of the tree
+* \param nGhostLayers is the number of ghost layers
+*/
+void checkCommunication(uint8_t dim, std::size_t nGhostLayers)
+{
+    ParaTree tree(dim);
+    tree.setNofGhostLayers(nGhostLayers);
+    for (int n = 0; n < 6 - dim; ++n) {
+        tree.adaptGlobalRefine();
+    }
+
+    // Refine the octants of the lower-left corner to get an unbalanced
+    // number of ghosts among the processes
+    uint32_t nOctants = tree.getNumOctants();
+    for (uint32_t idx = 0; idx < nOctants; ++idx) {
+        std::array<double, 3> center = tree.getCenter(idx);
+        if (center[0] < 0.3 && center[1] < 0.3) {
+            tree.setMarker(idx, 1);
+        }
+    }
+    tree.adapt();
+    tree.loadBalance();
+
+    nOctants = tree.getNumOctants();
+    uint32_t nGhosts = tree.getNumGhosts();
+
+    std::vector<double> data(nOctants);
+    for (uint32_t idx = 0; idx < nOctants; ++idx) {
+        data[idx] = static_cast<double>(tree.getGlobalIdx(idx));
+    }
+
+    // Blocking communication
+    std::vector<double> ghostData(nGhosts, -1.);
+    ValueComm comm(data, ghostData);
+    tree.communicate(comm);
+    checkGhostData(tree, ghostData);
+
+    // Split-phase communication
+    std::fill(ghostData.begin(), ghostData.end(), -1.);
+    tree.startCommunication(comm);
+    if (!tree.isCommunicationActive()) {
+        throw std::runtime_error("Communication is not active after being started");
+    }
+
+    // The data to be sent has already been gathered, hence the data of the
+    // internal octants can be modified
+    for (octantIterator itr = tree.getInternalOctantsBegin(); itr != tree.getInternalOctantsEnd(); ++itr) {
+        data[tree.getIdx(*itr)] = -2.;
+    }
+
+    tree.finishCommunication(comm);
+    if (tree.isCommunicationActive()) {
+        throw std::runtime_error("Communication is active after being finished");
+    }
+
+    checkGhostData(tree, ghostData);
+
+    log::cout() << "    Ghost layers " << nGhostLayers << ": " << nGhosts << " ghosts" << std::endl;
+}
+
+/*!
+* Subtest 001
+*
+* Testing split-phase communication of user data on a 2D octree.
+*/
+int subtest_001()
+{
+    log::cout() << "\n\n:: Split-phase communication of user data on a 2D octree ::\n";
+
+    checkCommunication(2, 1);
+    checkCommunication(2, 2);
+
+    return 0;
+}
+
+/*!
+* Subtest 002
+*
+* Testing split-phase communication of user data on a 3D octree.
+*/
+int subtest_002()
+{
+    log::cout() << "\n\n:: Split-phase communication of user data on a 3D octree ::\n";
+
+    checkCommunication(3, 1);
+    checkCommunication(3, 2);
+
+    return 0;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+    MPI_Init(&argc,&argv);
+
+    // Initialize the logger
+    int nProcs;
+    int rank;
+    MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    log::manager().initialize(log::COMBINED, true, nProcs, rank);
+    log::cout().setVisibility(log::GLOBAL);
+
+    // Run the subtests
+    log::cout() << "Testing split-phase communication of user data." << std::endl;
+
+    int status;
+    try {
+        status = subtest_001();
+        if (status != 0) {
+            return status;
+        }
+
+        status = subtest_002();
+        if (status != 0) {
+            return status;
+        }
+    } catch (const std::exception &exception) {
+        log::cout() << exception.what();
+        exit(1);
+    }
+
+    MPI_Finalize();
+}
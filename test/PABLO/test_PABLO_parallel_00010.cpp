@@ -0,0 +1,304 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2019 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <array>
+#include <vector>
+
+#include <mpi.h>
+
+#include "bitpit_common.hpp"
+#include "bitpit_PABLO.hpp"
+
+using namespace bitpit;
+
+typedef std::vector<std::vector<double>> OctantData;
+
+/*!
+* Load balance interface that migrates a variable number of values per octant.
+*/
+class ValuesLB : public DataLBInterface<ValuesLB> {
+
+public:
+    ValuesLB(OctantData &data, OctantData &ghostData)
+        : m_data(data), m_ghostData(ghostData)
+    {
+    }
+
+    size_t fixedSize() const
+    {
+        return 0;
+    }
+
+    size_t size(const uint32_t e) const
+    {
+        return sizeof(std::size_t) + m_data[e].size() * sizeof(double);
+    }
+
+    void move(const uint32_t from, const uint32_t to)
+    {
+        m_data[to] = m_data[from];
+    }
+
+    template<class Buffer>
+    void gather(Buffer &buffer, const uint32_t e)
+    {
+        buffer << m_data[e].size();
+        for (double value : m_data[e]) {
+            buffer << value;
+        }
+    }
+
+    template<class Buffer>
+    void scatter(Buffer &buffer, const uint32_t e)
+    {
+        std::size_t nValues;
+        buffer >> nValues;
+        m_data[e].resize(nValues);
+        for (double &value : m_data[e]) {
+            buffer >> value;
+        }
+    }
+
+    void assign(uint32_t stride, uint32_t length)
+    {
+        OctantData(m_data.begin() + stride, m_data.begin() + stride + length).swap(m_data);
+    }
+
+    void resize(uint32_t newSize)
+    {
+        m_data.resize(newSize);
+    }
+
+    void resizeGhost(uint32_t newSize)
+    {
+        m_ghostData.resize(newSize);
+    }
+
+    void shrink()
+    {
+        m_data.shrink_to_fit();
+    }
+
+private:
+    OctantData &m_data;
+    OctantData &m_ghostData;
+
+};
+
+/*!
+* Create the data of the octants.
+*
+* Every octant stores its Morton number, repeated a number of times that
+* depends on its level.
+*
+* \param tree is the tree
+* \param[out] data is the data of the octants
+*/
+void createData(const ParaTree &tree, OctantData *data)
+{
+    uint32_t nOctants = tree.getNumOctants();
+    data->resize(nOctants);
+    for (uint32_t idx = 0; idx < nOctants; ++idx) {
+        (*data)[idx].assign(1 + tree.getLevel(idx) % 3, static_cast<double>(tree.getMorton(idx)));
+    }
+}
+
+/*!
+* Check that a tree balanced with the streaming migration matches the
+* reference tree and that the user data followed its octants.
+*
+* \param tree is the tree balanced with the streaming migration
+* \param data is the data of the octants of the tree
+* \param reference is the reference tree
+*/
+void checkTree(const ParaTree &tree, const OctantData &data, const ParaTree &reference)
+{
+    uint32_t nOctants = tree.getNumOctants();
+    if (reference.getNumOctants() != nOctants || reference.getNumGhosts() != tree.getNumGhosts()) {
+        throw std::runtime_error("Streaming load balance gives a different partition");
+    }
+
+    for (uint32_t idx = 0; idx < nOctants; ++idx) {
+        uint64_t morton = tree.getMorton(idx);
+        if (reference.getMorton(idx) != morton || reference.getLevel(idx) != tree.getLevel(idx)) {
+            throw std::runtime_error("Streaming load balance gives different octants");
+        }
+
+        if (data.empty()) {
+            continue;
+        }
+
+        const std::vector<double> &octantData = data[idx];
+        if (octantData.size() != std::size_t(1 + tree.getLevel(idx) % 3)) {
+            throw std::runtime_error("Streaming load balance gives wrong user data");
+        }
+
+        for (double value : octantData) {
+            if (value != static_cast<double>(morton)) {
+                throw std::runtime_error("Streaming load balance gives wrong user data");
+            }
+        }
+    }
+}
+
+/*!
+* Evaluate the weights that move the partitions towards one corner of the
+* domain.
+*
+* \param tree is the tree
+* \param corner is the index of the corner (0 lower-left, 1 upper-right)
+* \param[out] weights are the weights of the octants
+*/
+void evalWeights(const ParaTree &tree, int corner, dvector *weights)
+{
+    uint32_t nOctants = tree.getNumOctants();
+    weights->resize(nOctants);
+    for (uint32_t idx = 0; idx < nOctants; ++idx) {
+        std::array<double, 3> center = tree.getCenter(idx);
+        if (corner == 1) {
+            center[0] = 1. - center[0];
+            center[1] = 1. - center[1];
+        }
+
+        (*weights)[idx] = (center[0] < 0.5 && center[1] < 0.5) ? 4. : 1.;
+    }
+}
+
+/*!
+* Check the streaming load balance.
+*
+* \param dim is the dimension of the trees
+* \param withData controls if the octants have user data
+*/
+void checkStreamingLoadBalance(uint8_t dim, bool withData)
+{
+    ParaTree reference(dim);
+    ParaTree tree(dim);
+    tree.setLoadBalanceMemoryBudget(1024);
+
+    for (int n = 0; n < 6 - dim; ++n) {
+        reference.adaptGlobalRefine();
+        tree.adaptGlobalRefine();
+    }
+
+    reference.loadBalance();
+    tree.loadBalance();
+
+    OctantData referenceData;
+    OctantData referenceGhostData;
+    OctantData data;
+    OctantData ghostData;
+    for (int corner = 0; corner < 2; ++corner) {
+        dvector referenceWeights;
+        evalWeights(reference, corner, &referenceWeights);
+
+        dvector weights;
+        evalWeights(tree, corner, &weights);
+
+        if (withData) {
+            createData(reference, &referenceData);
+            ValuesLB referenceLB(referenceData, referenceGhostData);
+            reference.loadBalance(referenceLB, &referenceWeights);
+
+            createData(tree, &data);
+            ValuesLB treeLB(data, ghostData);
+            tree.loadBalance(treeLB, &weights);
+        } else {
+            reference.loadBalance(&referenceWeights);
+            tree.loadBalance(&weights);
+        }
+
+        checkTree(tree, data, reference);
+
+        log::cout() << "    Corner " << corner << ": " << tree.getNumOctants() << " octants" << std::endl;
+    }
+}
+
+/*!
+* Subtest 001
+*
+* Testing streaming load balance of a 2D octree.
+*/
+int subtest_001()
+{
+    log::cout() << "\n\n:: Streaming load balance of a 2D octree ::\n";
+
+    checkStreamingLoadBalance(2, false);
+    checkStreamingLoadBalance(2, true);
+
+    return 0;
+}
+
+/*!
+* Subtest 002
+*
+* Testing streaming load balance of a 3D octree.
+*/
+int subtest_002()
+{
+    log::cout() << "\n\n:: Streaming load balance of a 3D octree ::\n";
+
+    checkStreamingLoadBalance(3, false);
+    checkStreamingLoadBalance(3, true);
+
+    return 0;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+    MPI_Init(&argc,&argv);
+
+    // Initialize the logger
+    int nProcs;
+    int rank;
+    MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    log::manager().initialize(log::COMBINED, true, nProcs, rank);
+    log::cout().setVisibility(log::GLOBAL);
+
+    // Run the subtests
+    log::cout() << "Testing streaming load balance." << std::endl;
+
+    int status;
+    try {
+        status = subtest_001();
+        if (status != 0) {
+            return status;
+        }
+
+        status = subtest_002();
+        if (status != 0) {
+            return status;
+        }
+    } catch (const std::exception &exception) {
+        log::cout() << exception.what();
+        exit(1);
+    }
+
+    MPI_Finalize();
+}
@@ -0,0 +1,219 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2019 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+#include <array>
+#include <cmath>
+#include <sstream>
+#include <string>
+
+#include <mpi.h>
+
+#include "bitpit_common.hpp"
+#include "bitpit_PABLO.hpp"
+
+using namespace bitpit;
+
+/*!
+* Check that the Morton numbers cached by the tree match the ones computed
+* from the coordinates of the octants, for both internal and ghost octants.
+*
+* \param tree is the tree
+* \param stage is the name of the stage being checked
+*/
+void checkMortons(const ParaTree &tree, const std::string &stage)
+{
+    uint32_t nOctants = tree.getNumOctants();
+    for (uint32_t idx = 0; idx < nOctants; ++idx) {
+        if (tree.getMorton(idx) != tree.getMorton(tree.getOctant(idx))) {
+            std::stringstream message;
+            message << "Wrong cached Morton number for octant " << idx << " after " << stage;
+            throw std::runtime_error(message.str());
+        }
+    }
+
+    uint32_t nGhosts = tree.getNumGhosts();
+    for (uint32_t idx = 0; idx < nGhosts; ++idx) {
+        const Octant *ghost = tree.getGhostOctant(idx);
+        if (tree.getGhostMorton(idx) != tree.getMorton(ghost)) {
+            std::stringstream message;
+            message << "Wrong cached Morton number for ghost " << idx << " after " << stage;
+            throw std::runtime_error(message.str());
+        }
+
+        if (tree.getIdx(ghost) != idx) {
+            std::stringstream message;
+            message << "Ghost " << idx << " cannot be found by Morton number after " << stage;
+            throw std::runtime_error(message.str());
+        }
+    }
+
+    log::cout() << "    Checked " << nOctants << " octants and " << nGhosts << " ghosts after " << stage << std::endl;
+}
+
+/*!
+* Set the markers of the octants whose center is inside a sphere.
+*
+* \param tree is the tree
+* \param radius is the radius of the sphere
+* \param marker is the marker to set
+*/
+void markSphere(ParaTree &tree, double radius, int8_t marker)
+{
+    uint32_t nOctants = tree.getNumOctants();
+    for (uint32_t idx = 0; idx < nOctants; ++idx) {
+        std::array<double, 3> center = tree.getCenter(idx);
+        double distance = std::pow(center[0] - 0.4, 2) + std::pow(center[1] - 0.6, 2);
+        if (tree.getDim() == 3) {
+            distance += std::pow(center[2] - 0.5, 2);
+        }
+
+        if (std::sqrt(distance) < radius) {
+            tree.setMarker(idx, marker);
+        }
+    }
+}
+
+/*!
+* Run adaption, coarsening and load balance on a tree, checking the cached
+* Morton numbers after each step.
+*
+* \param dimension is the dimension of the tree
+*/
+void checkTree(int dimension)
+{
+    ParaTree tree(dimension);
+
+    // Initial refinement and partitioning
+    for (int iter = 0; iter < 3; iter++) {
+        tree.adaptGlobalRefine();
+    }
+    checkMortons(tree, "global refinement");
+
+    tree.loadBalance();
+    checkMortons(tree, "first load balance");
+
+    // Refinement, with and without mapping
+    markSphere(tree, 0.3, 1);
+    tree.adapt();
+    checkMortons(tree, "refinement");
+
+    markSphere(tree, 0.2, 1);
+    tree.adapt(true);
+    checkMortons(tree, "mapped refinement");
+
+    // Coarsening, with and without mapping
+    markSphere(tree, 0.25, -1);
+    tree.adapt();
+    checkMortons(tree, "coarsening");
+
+    markSphere(tree, 0.35, -1);
+    tree.adapt(true);
+    checkMortons(tree, "mapped coarsening");
+
+    // Load balance of the adapted tree
+    tree.loadBalance();
+    checkMortons(tree, "load balance");
+
+    // Global coarsening
+    tree.adaptGlobalCoarse();
+    checkMortons(tree, "global coarsening");
+
+    tree.loadBalance();
+    checkMortons(tree, "final load balance");
+}
+
+/*!
+* Subtest 001
+*
+* Testing the cached Morton numbers of a 2D octree.
+*
+* \param rank is the rank of the process
+*/
+int subtest_001(int rank)
+{
+    BITPIT_UNUSED(rank);
+
+    log::cout() << "  >> 2D octree" << std::endl;
+
+    checkTree(2);
+
+    // Done
+    return 0;
+}
+
+/*!
+* Subtest 002
+*
+* Testing the cached Morton numbers of a 3D octree.
+*
+* \param rank is the rank of the process
+*/
+int subtest_002(int rank)
+{
+    BITPIT_UNUSED(rank);
+
+    log::cout() << "  >> 3D octree" << std::endl;
+
+    checkTree(3);
+
+    // Done
+    return 0;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+    MPI_Init(&argc,&argv);
+
+    // Initialize the logger
+    int nProcs;
+    int rank;
+    MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    log::manager().initialize(log::COMBINED, true, nProcs, rank);
+    log::cout().setVisibility(log::GLOBAL);
+
+    // Run the subtests
+    log::cout() << "Testing the cached Morton numbers of a parallel octree." << std::endl;
+
+    int status;
+    try {
+        status = subtest_001(rank);
+        if (status != 0) {
+            return status;
+        }
+
+        status = subtest_002(rank);
+        if (status != 0) {
+            return status;
+        }
+    } catch (const std::exception &exception) {
+        log::cout() << exception.what();
+        exit(1);
+    }
+
+    MPI_Finalize();
+}
@@ -0,0 +1,274 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2019 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <array>
+#include <cmath>
+#include <vector>
+#if BITPIT_ENABLE_MPI==1
+#include <mpi.h>
+#endif
+
+#include "bitpit_IO.hpp"
+#include "bitpit_RBF.hpp"
+
+using namespace bitpit;
+
+/*!
+* Subtest 001
+*
+* Testing sparse solution of the interpolation system with a compactly
+* supported basis function against the dense solution.
+*/
+int subtest_001()
+{
+    // Nodes on a structured lattice
+    std::vector<std::array<double,3>> nodes;
+    std::vector<double> values;
+    int nNodesPerDirection = 8;
+    for (int i = 0; i < nNodesPerDirection; ++i) {
+        for (int j = 0; j < nNodesPerDirection; ++j) {
+            for (int k = 0; k < nNodesPerDirection; ++k) {
+                std::array<double,3> node = {{i / double(nNodesPerDirection - 1), j / double(nNodesPerDirection - 1), k / double(nNodesPerDirection - 1)}};
+                nodes.push_back(node);
+                values.push_back(std::sin(node[0]) + node[1] * node[2]);
+            }
+        }
+    }
+
+    // Dense solution
+    RBF denseRBF(RBFBasisFunction::WENDLANDC2);
+    denseRBF.setSupportRadius(0.45);
+    denseRBF.addNode(nodes);
+    denseRBF.addData(values);
+    if (denseRBF.solve() != 0) {
+        log::cout() << "Dense solution of the RBF system failed" << std::endl;
+        return 1;
+    }
+
+    // Sparse solution
+    RBF sparseRBF(RBFBasisFunction::WENDLANDC2);
+    sparseRBF.setSupportRadius(0.45);
+    sparseRBF.setSolverMode(RBFSolverMode::SPARSE);
+    sparseRBF.addNode(nodes);
+    sparseRBF.addData(values);
+    if (sparseRBF.solve() != 0) {
+        log::cout() << "Sparse solution of the RBF system failed" << std::endl;
+        return 1;
+    }
+
+    // Compare the solutions
+    double maxDifference = 0.;
+    for (int n = 0; n < (int) nodes.size(); n += 7) {
+        std::array<double,3> point = nodes[n] + std::array<double,3>{{0.01, 0.02, -0.01}};
+
+        double denseValue  = denseRBF.evalRBF(point)[0];
+        double sparseValue = sparseRBF.evalRBF(point)[0];
+        maxDifference = std::max(maxDifference, std::abs(denseValue - sparseValue));
+    }
+
+    log::cout() << "Maximum difference between dense and sparse solutions " << maxDifference << std::endl;
+    if (maxDifference > 1.e-8) {
+        return 1;
+    }
+
+    // Sparse interpolation should reproduce the values on the nodes
+    double maxError = 0.;
+    for (int n = 0; n < (int) nodes.size(); ++n) {
+        maxError = std::max(maxError, std::abs(sparseRBF.evalRBF(n)[0] - values[n]));
+    }
+
+    log::cout() << "Maximum interpolation error on the nodes " << maxError << std::endl;
+    if (maxError > 1.e-8) {
+        return 1;
+    }
+
+    return 0;
+}
+
+/*!
+* Subtest 002
+*
+* Testing batched evaluation of the RBF against point-wise evaluation.
+*/
+int subtest_002()
+{
+    // Nodes and weights
+    std::vector<std::array<double,3>> nodes;
+    std::vector<double> weights0;
+    std::vector<double> weights1;
+    for (int n = 0; n < 500; ++n) {
+        double t = n / 500.;
+        nodes.push_back({{std::cos(17. * t), std::sin(11. * t), t}});
+        weights0.push_back(std::sin(5. * t));
+        weights1.push_back(t * t);
+    }
+
+    // Evaluation points
+    std::vector<std::array<double,3>> points;
+    for (int n = 0; n < 2000; ++n) {
+        double t = n / 2000.;
+        points.push_back({{0.9 * std::cos(31. * t), 0.9 * std::sin(23. * t), t}});
+    }
+
+    // Compare batched and point-wise evaluation
+    std::vector<RBFBasisFunction> functions = {RBFBasisFunction::WENDLANDC2, RBFBasisFunction::GAUSS90};
+    for (RBFBasisFunction function : functions) {
+        RBF paramRBF(function);
+        paramRBF.setMode(RBFMode::PARAM);
+        paramRBF.setSupportRadius(0.3);
+        paramRBF.addNode(nodes);
+        paramRBF.addData(weights0);
+        paramRBF.addData(weights1);
+        for (int n = 0; n < (int) nodes.size(); n += 10) {
+            paramRBF.deactivateNode(n);
+        }
+
+        std::vector<double> batchValues;
+        paramRBF.evalRBF(points, &batchValues);
+        if (batchValues.size() != 2 * points.size()) {
+            return 1;
+        }
+
+        double maxDifference = 0.;
+        for (std::size_t n = 0; n < points.size(); ++n) {
+            std::vector<double> values = paramRBF.evalRBF(points[n]);
+            for (int j = 0; j < 2; ++j) {
+                maxDifference = std::max(maxDifference, std::abs(values[j] - batchValues[2 * n + j]));
+            }
+        }
+
+        log::cout() << "Maximum difference between batched and point-wise evaluation " << maxDifference << std::endl;
+        if (maxDifference > 1.e-12) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/*!
+* Subtest 003
+*
+* Testing incremental greedy selection of the nodes against the standard one.
+*/
+int subtest_003()
+{
+    // Nodes
+    std::vector<std::array<double,3>> nodes;
+    std::vector<double> values;
+    for (int n = 0; n < 400; ++n) {
+        double t = n / 400.;
+        std::array<double,3> node = {{std::cos(13. * t), std::sin(7. * t), 2. * t}};
+        nodes.push_back(node);
+        values.push_back(0.1 * std::sin(3. * node[0]) + 0.05 * node[1] * node[2]);
+    }
+
+    // Standard and incremental greedy
+    std::vector<RBF> greedyRBFs(2);
+    for (int k = 0; k < 2; ++k) {
+        RBF &greedyRBF = greedyRBFs[k];
+        greedyRBF.setFunction(RBFBasisFunction::WENDLANDC2);
+        greedyRBF.setSupportRadius(0.8);
+        greedyRBF.addNode(nodes);
+        greedyRBF.addData(values);
+        if (greedyRBF.greedy(1.e-4, (k == 1)) != 0) {
+            log::cout() << "Greedy selection failed" << std::endl;
+            return 1;
+        }
+    }
+
+    // Compare the selections
+    log::cout() << "Active nodes with standard greedy " << greedyRBFs[0].getActiveCount() << std::endl;
+    log::cout() << "Active nodes with incremental greedy " << greedyRBFs[1].getActiveCount() << std::endl;
+    if (greedyRBFs[0].getActiveSet() != greedyRBFs[1].getActiveSet()) {
+        return 1;
+    }
+
+    double maxDifference = 0.;
+    for (int n = 0; n < (int) nodes.size(); ++n) {
+        maxDifference = std::max(maxDifference, std::abs(greedyRBFs[0].evalRBF(n)[0] - greedyRBFs[1].evalRBF(n)[0]));
+    }
+
+    log::cout() << "Maximum difference between standard and incremental greedy " << maxDifference << std::endl;
+    if (maxDifference > 1.e-8) {
+        return 1;
+    }
+
+    return 0;
+}
+
+// ========================================================================== //
+// MAIN                                                                       //
+// ========================================================================== //
+int main(int argc, char *argv[])
+{
+    // ====================================================================== //
+    // INITIALIZE MPI                                                         //
+    // ====================================================================== //
+#if BITPIT_ENABLE_MPI==1
+    MPI_Init(&argc,&argv);
+#else
+    BITPIT_UNUSED(argc);
+    BITPIT_UNUSED(argv);
+#endif
+
+    // ====================================================================== //
+    // VARIABLES DECLARATION                                                  //
+    // ====================================================================== //
+
+    // Local variabels
+    int                             status = 0;
+
+    // ====================================================================== //
+    // RUN SUB-TESTS                                                          //
+    // ====================================================================== //
+    try {
+        status = subtest_001();
+        if (status != 0) {
+            return (10 + status);
+        }
+
+        status = subtest_002();
+        if (status != 0) {
+            return (20 + status);
+        }
+
+        status = subtest_003();
+        if (status != 0) {
+            return (30 + status);
+        }
+    } catch (const std::exception &exception) {
+        log::cout() << exception.what();
+        exit(1);
+    }
+
+    // ====================================================================== //
+    // FINALIZE MPI                                                           //
+    // ====================================================================== //
+#if BITPIT_ENABLE_MPI==1
+    MPI_Finalize();
+#endif
+
+    return status;
+}
@@ -0,0 +1,244 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2019 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <array>
+#include <unordered_map>
+#if BITPIT_ENABLE_MPI==1
+# include <mpi.h>
+#endif
+
+#include "bitpit_containers.hpp"
+
+using namespace bitpit;
+
+/*!
+* Get the name of the specified position map type.
+*
+* \param type is the type of the position map
+* \result The name of the specified position map type.
+*/
+std::string getMapTypeName(PiercedPositionMap<long>::MapType type)
+{
+	switch (type) {
+
+	case PiercedPositionMap<long>::MAP_TYPE_FLAT:
+		return "flat";
+
+	case PiercedPositionMap<long>::MAP_TYPE_DENSE:
+		return "dense";
+
+	default:
+		return "hash";
+
+	}
+}
+
+/*!
+* Subtest 001
+*
+* Testing the position map against a reference map.
+*/
+int subtest_001()
+{
+	std::array<PiercedPositionMap<long>::MapType, 3> mapTypes = {{
+		PiercedPositionMap<long>::MAP_TYPE_HASH,
+		PiercedPositionMap<long>::MAP_TYPE_FLAT,
+		PiercedPositionMap<long>::MAP_TYPE_DENSE
+	}};
+
+	const long MAX_ID = 5000;
+	const int N_OPERATIONS = 100000;
+
+	for (PiercedPositionMap<long>::MapType type : mapTypes) {
+		std::cout << std::endl << "::: Testing " << getMapTypeName(type) << " position map :::" << std::endl;
+
+		std::srand(1);
+
+		PiercedPositionMap<long> map(type);
+		std::unordered_map<long, std::size_t> reference;
+
+		// Random insertions and deletions
+		for (int n = 0; n < N_OPERATIONS; ++n) {
+			long id = std::rand() % MAX_ID;
+			if (std::rand() % 3 == 0) {
+				map.erase(id);
+				reference.erase(id);
+			} else {
+				std::size_t pos = std::rand();
+				map.set(id, pos);
+				reference[id] = pos;
+			}
+		}
+
+		// Change the type of the map back and forth
+		for (PiercedPositionMap<long>::MapType otherType : mapTypes) {
+			map.setType(otherType);
+		}
+		map.setType(type);
+
+		// Compare the maps
+		if (map.size() != reference.size()) {
+			std::cout << "  Map size is " << map.size() << ", expected size is " << reference.size() << std::endl;
+			return 1;
+		}
+
+		for (long id = -1; id < MAX_ID + 1; ++id) {
+			auto referenceItr = reference.find(id);
+			std::size_t pos = map.find(id);
+			if (referenceItr == reference.end()) {
+				if (pos != PiercedPositionMap<long>::NOT_FOUND) {
+					std::cout << "  Id " << id << " should not be in the map" << std::endl;
+					return 1;
+				}
+			} else if (pos != referenceItr->second) {
+				std::cout << "  Id " << id << " has position " << pos << ", expected position is " << referenceItr->second << std::endl;
+				return 1;
+			}
+		}
+
+		std::size_t nVisited = 0;
+		map.forEach([&nVisited](long id, std::size_t pos) {
+			BITPIT_UNUSED(id);
+			BITPIT_UNUSED(pos);
+			++nVisited;
+		});
+
+		if (nVisited != reference.size()) {
+			std::cout << "  Number of visited entries is " << nVisited << ", expected number is " << reference.size() << std::endl;
+			return 1;
+		}
+
+		std::cout << "  Position map matches the reference map (" << map.size() << " entries)" << std::endl;
+	}
+
+	return 0;
+}
+
+/*!
+* Subtest 002
+*
+* Testing PiercedVector with different position maps.
+*/
+int subtest_002()
+{
+	std::array<PiercedPositionMap<long>::MapType, 3> mapTypes = {{
+		PiercedPositionMap<long>::MAP_TYPE_HASH,
+		PiercedPositionMap<long>::MAP_TYPE_FLAT,
+		PiercedPositionMap<long>::MAP_TYPE_DENSE
+	}};
+
+	const long N_ELEMENTS = 2000;
+
+	for (PiercedPositionMap<long>::MapType type : mapTypes) {
+		std::cout << std::endl << "::: Testing PiercedVector with " << getMapTypeName(type) << " position map :::" << std::endl;
+
+		PiercedVector<double> container;
+		container.setPositionMapType(type);
+
+		// Fill the container
+		for (long id = 0; id < N_ELEMENTS; ++id) {
+			container.emplaceBack(id, (double) id);
+		}
+
+		// Erase some elements
+		for (long id = 0; id < N_ELEMENTS; id += 3) {
+			container.erase(id);
+		}
+
+		// Insert new elements in the holes
+		for (long id = N_ELEMENTS; id < N_ELEMENTS + N_ELEMENTS / 4; ++id) {
+			container.emplace(id, (double) id);
+		}
+
+		// Swap some elements
+		container.swap(1, N_ELEMENTS - 1);
+		container.swap(4, 5);
+
+		container.checkIntegrity();
+
+		// Squeeze and sort the container
+		container.squeeze();
+		container.checkIntegrity();
+
+		container.sort();
+		container.checkIntegrity();
+
+		// Check the contents
+		for (auto itr = container.cbegin(); itr != container.cend(); ++itr) {
+			if (*itr != (double) itr.getId()) {
+				std::cout << "  Element " << itr.getId() << " has value " << *itr << std::endl;
+				return 1;
+			}
+		}
+
+		long previousId = -1;
+		for (auto itr = container.cbegin(); itr != container.cend(); ++itr) {
+			if (itr.getId() <= previousId) {
+				std::cout << "  Elements are not sorted" << std::endl;
+				return 1;
+			}
+			previousId = itr.getId();
+		}
+
+		std::cout << "  Container is consistent (" << container.size() << " elements)" << std::endl;
+	}
+
+	return 0;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+#if BITPIT_ENABLE_MPI==1
+	MPI_Init(&argc,&argv);
+#else
+	BITPIT_UNUSED(argc);
+	BITPIT_UNUSED(argv);
+#endif
+
+	// Run the subtests
+	std::cout << "Testing pierced position maps" << std::endl;
+
+	int status;
+	try {
+		status = subtest_001();
+		if (status != 0) {
+			return status;
+		}
+
+		status = subtest_002();
+		if (status != 0) {
+			return status;
+		}
+	} catch (const std::exception &exception) {
+		std::cout << exception.what();
+		return 1;
+	}
+
+#if BITPIT_ENABLE_MPI==1
+	MPI_Finalize();
+#endif
+}
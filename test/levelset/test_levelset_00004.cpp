@@ -0,0 +1,299 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2019 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+//Standard Template Library
+# include <cmath>
+# include <vector>
+
+#if BITPIT_ENABLE_MPI==1
+# include <mpi.h>
+#endif
+
+#if BITPIT_ENABLE_OPENMP==1
+# include <omp.h>
+#endif
+
+// bitpit
+# include "bitpit_CG.hpp"
+# include "bitpit_surfunstructured.hpp"
+# include "bitpit_voloctree.hpp"
+# include "bitpit_levelset.hpp"
+
+/*!
+* Evaluate the levelset of the specified surface on the given octree.
+*
+* \param[in] mesh is the mesh
+* \param[in] surface is the surface
+* \param[in] narrowBand is the size of the narrow band, a negative value
+* means that the narrow band size will be evaluated automatically
+* \param[in] nThreads is the number of threads that will be used
+* \param[out] values on output will contain the levelset of the cells
+* \param[out] supports on output will contain the support of the cells
+*/
+void evalLevelSet(bitpit::VolOctree &mesh, bitpit::SurfUnstructured *surface, double narrowBand,
+                  int nThreads, std::vector<double> *values, std::vector<long> *supports)
+{
+#if BITPIT_ENABLE_OPENMP==1
+    omp_set_num_threads(nThreads);
+#else
+    BITPIT_UNUSED(nThreads);
+#endif
+
+    bitpit::LevelSet levelset;
+    levelset.setMesh(&mesh);
+    int objectId = levelset.addObject(surface, BITPIT_PI / 3.);
+    if (narrowBand > 0.) {
+        levelset.setSizeNarrowBand(narrowBand);
+    }
+
+    levelset.compute();
+
+    const bitpit::LevelSetSegmentation &object = dynamic_cast<const bitpit::LevelSetSegmentation &>(levelset.getObject(objectId));
+
+    values->clear();
+    supports->clear();
+    for (const bitpit::Cell &cell : mesh.getCells()) {
+        long cellId = cell.getId();
+        values->push_back(object.getLS(cellId));
+        supports->push_back(object.getSupport(cellId));
+    }
+}
+
+/*!
+* Check the levelset evaluated on the given octree.
+*
+* Cells that have a support should have a levelset equal to the distance
+* between their centroid and the surface, cells whose distance from the
+* surface is less than the specified threshold should have a support.
+*
+* \param[in] mesh is the mesh
+* \param[in] surface is the surface
+* \param[in] narrowBand is the size of the narrow band, a negative value
+* means that the narrow band size has been evaluated automatically
+* \param[in] values is the levelset of the cells
+* \param[in] supports is the support of the cells
+* \result The number of errors found.
+*/
+int checkLevelSet(const bitpit::VolOctree &mesh, const bitpit::SurfUnstructured *surface, double narrowBand,
+                  const std::vector<double> &values, const std::vector<long> &supports)
+{
+    bitpit::SurfaceSkdTree searchTree(surface);
+    searchTree.build();
+
+    int nErrors = 0;
+    int nSupported = 0;
+    std::size_t n = 0;
+    for (const bitpit::Cell &cell : mesh.getCells()) {
+        long cellId = cell.getId();
+
+        std::array<double, 3> centroid = mesh.evalCellCentroid(cellId);
+        double distance = searchTree.evalPointDistance(centroid);
+
+        double threshold = narrowBand;
+        if (threshold < 0.) {
+            threshold = 0.5 * std::sqrt(3.) * mesh.evalCellSize(cellId);
+        }
+
+        if (supports[n] != bitpit::levelSetDefaults::SUPPORT) {
+            ++nSupported;
+            if (std::abs(std::abs(values[n]) - distance) > 1.e-12) {
+                bitpit::log::cout() << "  Wrong levelset for cell " << cellId << ": " << values[n] << " (expected " << distance << ")" << std::endl;
+                ++nErrors;
+            }
+        } else if (distance < threshold) {
+            bitpit::log::cout() << "  Cell " << cellId << " is missing from the narrow band" << std::endl;
+            ++nErrors;
+        }
+
+        ++n;
+    }
+
+    bitpit::log::cout() << "  Cells with a support: " << nSupported << std::endl;
+
+    return nErrors;
+}
+
+/*!
+* Run the levelset evaluation and checks on the given octree.
+*
+* When OpenMP is enabled, the results obtained using a single thread and
+* multiple threads are compared.
+*
+* \param[in] mesh is the mesh
+* \param[in] surface is the surface
+* \param[in] narrowBand is the size of the narrow band, a negative value
+* means that the narrow band size will be evaluated automatically
+* \result Returns zero on success, a non-zero value otherwise.
+*/
+int run(bitpit::VolOctree &mesh, bitpit::SurfUnstructured *surface, double narrowBand)
+{
+    std::vector<double> values;
+    std::vector<long> supports;
+    evalLevelSet(mesh, surface, narrowBand, 1, &values, &supports);
+
+    if (checkLevelSet(mesh, surface, narrowBand, values, supports) != 0) {
+        bitpit::log::cout() << "  Levelset evaluated using one thread is wrong" << std::endl;
+        return 1;
+    }
+
+#if BITPIT_ENABLE_OPENMP==1
+    std::vector<double> threadedValues;
+    std::vector<long> threadedSupports;
+    evalLevelSet(mesh, surface, narrowBand, 4, &threadedValues, &threadedSupports);
+
+    if (threadedValues != values || threadedSupports != supports) {
+        bitpit::log::cout() << "  Levelset evaluated using multiple threads differs from the one evaluated using one thread" << std::endl;
+        return 1;
+    }
+#endif
+
+    return 0;
+}
+
+/*!
+* Create an octree around the specified surface.
+*
+* Cells close to the surface are refined.
+*
+* \param[in] surface is the surface
+* \result The octree.
+*/
+std::unique_ptr<bitpit::VolOctree> createMesh(const bitpit::SurfUnstructured *surface)
+{
+    std::array<double,3> meshMin, meshMax, delta;
+    surface->getBoundingBox(meshMin, meshMax);
+
+    delta = meshMax - meshMin;
+    meshMin -= 0.1 * delta;
+    meshMax += 0.1 * delta;
+
+    double h = 0.;
+    for (int i = 0; i < 3; ++i) {
+        h = std::max(h, meshMax[i] - meshMin[i]);
+    }
+
+    std::unique_ptr<bitpit::VolOctree> mesh(new bitpit::VolOctree(3, meshMin, h, h / 16.));
+    mesh->buildAdjacencies();
+    mesh->update();
+
+    bitpit::SurfaceSkdTree searchTree(surface);
+    searchTree.build();
+
+    for (int i = 0; i < 2; ++i) {
+        for (const bitpit::Cell &cell : mesh->getCells()) {
+            long cellId = cell.getId();
+            double distance = searchTree.evalPointDistance(mesh->evalCellCentroid(cellId));
+            if (distance < mesh->evalCellSize(cellId)) {
+                mesh->markCellForRefinement(cellId);
+            }
+        }
+
+        mesh->update();
+    }
+
+    return mesh;
+}
+
+/*!
+* Subtest 001
+*
+* Testing threaded narrow band evaluation on an octree with automatic
+* narrow band size.
+*/
+int subtest_001()
+{
+    std::unique_ptr<bitpit::SurfUnstructured> STL(new bitpit::SurfUnstructured(2, 3));
+    STL->importSTL("./data/cube.stl", true);
+    STL->deleteCoincidentVertices();
+    STL->buildAdjacencies();
+
+    std::unique_ptr<bitpit::VolOctree> mesh = createMesh(STL.get());
+
+    bitpit::log::cout() << " - Evaluating levelset with automatic narrow band on " << mesh->getCellCount() << " cells" << std::endl;
+
+    return run(*mesh, STL.get(), -1.);
+}
+
+/*!
+* Subtest 002
+*
+* Testing threaded narrow band evaluation on an octree with user-defined
+* narrow band size.
+*/
+int subtest_002()
+{
+    std::unique_ptr<bitpit::SurfUnstructured> STL(new bitpit::SurfUnstructured(2, 3));
+    STL->importSTL("./data/cube.stl", true);
+    STL->deleteCoincidentVertices();
+    STL->buildAdjacencies();
+
+    std::unique_ptr<bitpit::VolOctree> mesh = createMesh(STL.get());
+
+    std::array<double,3> surfaceMin, surfaceMax;
+    STL->getBoundingBox(surfaceMin, surfaceMax);
+    double narrowBand = 0.1 * norm2(surfaceMax - surfaceMin);
+
+    bitpit::log::cout() << " - Evaluating levelset with narrow band size " << narrowBand << " on " << mesh->getCellCount() << " cells" << std::endl;
+
+    return run(*mesh, STL.get(), narrowBand);
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+#if BITPIT_ENABLE_MPI==1
+	MPI_Init(&argc,&argv);
+#else
+	BITPIT_UNUSED(argc);
+	BITPIT_UNUSED(argv);
+#endif
+
+	// Initialize the logger
+	bitpit::log::manager().initialize(bitpit::log::COMBINED);
+
+	// Run the subtests
+	bitpit::log::cout() << "Testing threaded narrow band evaluation on octrees" << std::endl;
+
+	int status;
+	try {
+		status = subtest_001();
+		if (status != 0) {
+			return status;
+		}
+
+		status = subtest_002();
+		if (status != 0) {
+			return status;
+		}
+	} catch (const std::exception &exception) {
+		bitpit::log::cout() << exception.what();
+		exit(1);
+	}
+
+#if BITPIT_ENABLE_MPI==1
+	MPI_Finalize();
+#endif
+}
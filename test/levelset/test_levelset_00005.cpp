@@ -0,0 +1,399 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2019 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+//Standard Template Library
+# include <cmath>
+# include <sstream>
+# include <vector>
+
+#if BITPIT_ENABLE_MPI==1
+# include <mpi.h>
+#endif
+
+// bitpit
+# include "bitpit_CG.hpp"
+# include "bitpit_surfunstructured.hpp"
+# include "bitpit_voloctree.hpp"
+# include "bitpit_levelset.hpp"
+
+/*!
+* Compare the information cached by two segmentation objects.
+*
+* \param[in] mesh is the mesh
+* \param[in] object is the object
+* \param[in] reference is the reference object
+* \result The number of cells whose information differs.
+*/
+int compareObjects(const bitpit::VolOctree &mesh, const bitpit::LevelSetSegmentation &object,
+                   const bitpit::LevelSetSegmentation &reference)
+{
+    int nErrors = 0;
+    for (const bitpit::Cell &cell : mesh.getCells()) {
+        long cellId = cell.getId();
+
+        bool isSame = (object.getSign(cellId) == reference.getSign(cellId));
+        isSame &= (object.getLS(cellId) == reference.getLS(cellId));
+        isSame &= (object.getGradient(cellId) == reference.getGradient(cellId));
+        isSame &= (object.getSupport(cellId) == reference.getSupport(cellId));
+        isSame &= (object.getNormal(cellId) == reference.getNormal(cellId));
+        if (!isSame) {
+            bitpit::log::cout() << "  Cached information of cell " << cellId << " differs from the reference" << std::endl;
+            ++nErrors;
+        }
+    }
+
+    return nErrors;
+}
+
+/*!
+* Count the cells that have cached information.
+*
+* The count is read from the dump of a levelset that contains a single
+* cached object.
+*
+* \param[in] levelset is the levelset
+* \result The number of cells that have cached information.
+*/
+long countCachedCells(bitpit::LevelSet &levelset)
+{
+    std::stringstream stream;
+    levelset.dump(stream);
+
+    std::vector<int> order;
+    bool useNarrowBand, signedDF, propagateSign, extendDistance;
+    bitpit::utils::binary::read(stream, order);
+    bitpit::utils::binary::read(stream, useNarrowBand);
+    bitpit::utils::binary::read(stream, signedDF);
+    bitpit::utils::binary::read(stream, propagateSign);
+    bitpit::utils::binary::read(stream, extendDistance);
+
+    int id;
+    double narrowBand;
+    long nCachedCells;
+    bitpit::utils::binary::read(stream, id);
+    bitpit::utils::binary::read(stream, narrowBand);
+    bitpit::utils::binary::read(stream, nCachedCells);
+
+    return nCachedCells;
+}
+
+/*!
+* Create an octree around the specified surface.
+*
+* \param[in] surface is the surface
+* \result The octree.
+*/
+std::unique_ptr<bitpit::VolOctree> createMesh(const bitpit::SurfUnstructured *surface)
+{
+    std::array<double,3> meshMin, meshMax, delta;
+    surface->getBoundingBox(meshMin, meshMax);
+
+    delta = meshMax - meshMin;
+    meshMin -= 0.1 * delta;
+    meshMax += 0.1 * delta;
+
+    double h = 0.;
+    for (int i = 0; i < 3; ++i) {
+        h = std::max(h, meshMax[i] - meshMin[i]);
+    }
+
+    std::unique_ptr<bitpit::VolOctree> mesh(new bitpit::VolOctree(3, meshMin, h, h / 16.));
+    mesh->buildAdjacencies();
+    mesh->update();
+
+    return mesh;
+}
+
+/*!
+* Subtest 001
+*
+* Testing sparse and dense storage of the cached information.
+*
+* The narrow band contains all the cells of the mesh, hence the automatic
+* cache mode should select dense storage.
+*/
+int subtest_001()
+{
+    std::unique_ptr<bitpit::SurfUnstructured> STL(new bitpit::SurfUnstructured(2, 3));
+    STL->importSTL("./data/cube.stl", true);
+    STL->deleteCoincidentVertices();
+    STL->buildAdjacencies();
+
+    std::unique_ptr<bitpit::VolOctree> mesh = createMesh(STL.get());
+
+    // Create the levelset
+    bitpit::LevelSet levelset;
+    levelset.setMesh(mesh.get());
+    levelset.setPropagateSign(true);
+
+    int sparseId    = levelset.addObject(STL.get(), BITPIT_PI / 3.);
+    int denseId     = levelset.addObject(STL.get(), BITPIT_PI / 3.);
+    int automaticId = levelset.addObject(STL.get(), BITPIT_PI / 3.);
+
+    std::array<double,3> meshMin, meshMax;
+    mesh->getBoundingBox(meshMin, meshMax);
+    levelset.setSizeNarrowBand(norm2(meshMax - meshMin));
+
+    bitpit::LevelSetSegmentation &sparseObject    = levelset.getObject<bitpit::LevelSetSegmentation>(sparseId);
+    bitpit::LevelSetSegmentation &denseObject     = levelset.getObject<bitpit::LevelSetSegmentation>(denseId);
+    bitpit::LevelSetSegmentation &automaticObject = levelset.getObject<bitpit::LevelSetSegmentation>(automaticId);
+
+    sparseObject.setCacheMode(bitpit::LevelSetCacheMode::SPARSE);
+    denseObject.setCacheMode(bitpit::LevelSetCacheMode::DENSE);
+
+    // Compute the levelset
+    bitpit::log::cout() << " - Evaluating levelset on " << mesh->getCellCount() << " cells" << std::endl;
+
+    levelset.compute();
+
+    if (sparseObject.isCacheDense() || !denseObject.isCacheDense()) {
+        bitpit::log::cout() << "  Storage doesn't match the requested cache mode" << std::endl;
+        return 1;
+    }
+
+    if (!automaticObject.isCacheDense()) {
+        bitpit::log::cout() << "  Automatic cache mode should select dense storage" << std::endl;
+        return 1;
+    }
+
+    if (compareObjects(*mesh, denseObject, sparseObject) != 0 || compareObjects(*mesh, automaticObject, sparseObject) != 0) {
+        return 1;
+    }
+
+    // Refine the cells intersected by the surface and update the levelset
+    //
+    // Ids of the refined cells are recycled for the new cells, hence the
+    // slots of the dense storage associated to new cells may contain the
+    // information of deleted cells.
+    for (int i = 0; i < 2; ++i) {
+        bitpit::log::cout() << " - Updating levelset after refinement" << std::endl;
+
+        for (const bitpit::Cell &cell : mesh->getCells()) {
+            long cellId = cell.getId();
+            if (std::abs(sparseObject.getLS(cellId)) < 0.5 * std::sqrt(3.) * mesh->evalCellSize(cellId)) {
+                mesh->markCellForRefinement(cellId);
+            }
+        }
+
+        std::vector<bitpit::adaption::Info> adaptionData = mesh->update(true);
+        levelset.update(adaptionData);
+
+        if (compareObjects(*mesh, denseObject, sparseObject) != 0 || compareObjects(*mesh, automaticObject, sparseObject) != 0) {
+            return 1;
+        }
+    }
+
+    // Switch storage
+    bitpit::log::cout() << " - Switching storage" << std::endl;
+
+    denseObject.setCacheMode(bitpit::LevelSetCacheMode::SPARSE);
+    sparseObject.setCacheMode(bitpit::LevelSetCacheMode::DENSE);
+    if (denseObject.isCacheDense() || !sparseObject.isCacheDense()) {
+        bitpit::log::cout() << "  Storage doesn't match the requested cache mode" << std::endl;
+        return 1;
+    }
+
+    if (compareObjects(*mesh, denseObject, sparseObject) != 0 || compareObjects(*mesh, automaticObject, sparseObject) != 0) {
+        return 1;
+    }
+
+    return 0;
+}
+
+/*!
+* Create a levelset that contains a single segmentation object, the id of
+* the object will be zero.
+*
+* \param[in] mesh is the mesh
+* \param[in] surface is the surface
+* \param[in] cacheMode is the cache mode of the object
+* \param[in] narrowBand is the size of the narrow band
+* \result The levelset.
+*/
+std::unique_ptr<bitpit::LevelSet> createLevelSet(bitpit::VolOctree *mesh, bitpit::SurfUnstructured *surface,
+                                                 bitpit::LevelSetCacheMode cacheMode, double narrowBand)
+{
+    std::unique_ptr<bitpit::LevelSet> levelset(new bitpit::LevelSet());
+    levelset->setMesh(mesh);
+    levelset->setPropagateSign(true);
+    levelset->setSizeNarrowBand(narrowBand);
+
+    levelset->addObject(surface, BITPIT_PI / 3., 0);
+    levelset->getObject<bitpit::LevelSetSegmentation>(0).setCacheMode(cacheMode);
+
+    return levelset;
+}
+
+/*!
+* Subtest 002
+*
+* Testing sparse and dense storage of the cached information when the sign
+* is propagated outside a small narrow band.
+*
+* Cells outside the narrow band only store the sign of the levelset. All the
+* storage modes should contain the same cells, restoring a dump should give
+* the same information whatever the storage modes of the dumped and of the
+* restored objects are, and automatic mode should keep its storage when the
+* levelset is updated without changes in the mesh.
+*/
+int subtest_002()
+{
+    std::unique_ptr<bitpit::SurfUnstructured> STL(new bitpit::SurfUnstructured(2, 3));
+    STL->importSTL("./data/cube.stl", true);
+    STL->deleteCoincidentVertices();
+    STL->buildAdjacencies();
+
+    std::unique_ptr<bitpit::VolOctree> mesh = createMesh(STL.get());
+
+    std::array<double,3> meshMin, meshMax;
+    mesh->getBoundingBox(meshMin, meshMax);
+    double narrowBand = 0.05 * norm2(meshMax - meshMin);
+
+    // Create the levelsets
+    std::vector<bitpit::LevelSetCacheMode> cacheModes = {{bitpit::LevelSetCacheMode::SPARSE,
+                                                          bitpit::LevelSetCacheMode::DENSE,
+                                                          bitpit::LevelSetCacheMode::AUTOMATIC}};
+
+    std::vector<std::unique_ptr<bitpit::LevelSet>> levelsets;
+    std::vector<bitpit::LevelSetSegmentation *> objects;
+    for (bitpit::LevelSetCacheMode cacheMode : cacheModes) {
+        levelsets.push_back(createLevelSet(mesh.get(), STL.get(), cacheMode, narrowBand));
+        objects.push_back(&(levelsets.back()->getObject<bitpit::LevelSetSegmentation>(0)));
+    }
+
+    const bitpit::LevelSetSegmentation &sparseObject    = *(objects[0]);
+    const bitpit::LevelSetSegmentation &automaticObject = *(objects[2]);
+
+    // Compute the levelset
+    bitpit::log::cout() << " - Evaluating levelset on " << mesh->getCellCount() << " cells" << std::endl;
+
+    for (std::unique_ptr<bitpit::LevelSet> &levelset : levelsets) {
+        levelset->compute();
+    }
+
+    long nCachedCells = countCachedCells(*(levelsets[0]));
+    bitpit::log::cout() << "  Cells with cached information: " << nCachedCells << std::endl;
+
+    for (std::size_t i = 0; i < levelsets.size(); ++i) {
+        if (compareObjects(*mesh, *(objects[i]), sparseObject) != 0) {
+            return 1;
+        }
+
+        if (countCachedCells(*(levelsets[i])) != nCachedCells) {
+            bitpit::log::cout() << "  Number of cells with cached information differs from the reference" << std::endl;
+            return 1;
+        }
+    }
+
+    // Dump and restore the levelsets
+    bitpit::log::cout() << " - Dumping and restoring the levelset" << std::endl;
+
+    for (std::unique_ptr<bitpit::LevelSet> &levelset : levelsets) {
+        for (bitpit::LevelSetCacheMode cacheMode : cacheModes) {
+            std::stringstream stream;
+            levelset->dump(stream);
+
+            std::unique_ptr<bitpit::LevelSet> restoredLevelset = createLevelSet(mesh.get(), STL.get(), cacheMode, narrowBand);
+            restoredLevelset->restore(stream);
+
+            const bitpit::LevelSetSegmentation &restoredObject = restoredLevelset->getObject<bitpit::LevelSetSegmentation>(0);
+            if (compareObjects(*mesh, restoredObject, sparseObject) != 0) {
+                return 1;
+            }
+
+            if (countCachedCells(*restoredLevelset) != nCachedCells) {
+                bitpit::log::cout() << "  Number of cells with cached information differs after restore" << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    // Update the levelset without changing the mesh
+    bool automaticDense = automaticObject.isCacheDense();
+    for (int n = 0; n < 2; ++n) {
+        bitpit::log::cout() << " - Updating levelset" << std::endl;
+
+        std::vector<bitpit::adaption::Info> adaptionData = mesh->update(true);
+        for (std::unique_ptr<bitpit::LevelSet> &levelset : levelsets) {
+            levelset->update(adaptionData);
+        }
+
+        if (automaticObject.isCacheDense() != automaticDense) {
+            bitpit::log::cout() << "  Automatic cache mode changed storage during the update" << std::endl;
+            return 1;
+        }
+
+        for (std::size_t i = 0; i < levelsets.size(); ++i) {
+            if (compareObjects(*mesh, *(objects[i]), sparseObject) != 0) {
+                return 1;
+            }
+
+            if (countCachedCells(*(levelsets[i])) != nCachedCells) {
+                bitpit::log::cout() << "  Number of cells with cached information differs from the reference" << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+#if BITPIT_ENABLE_MPI==1
+	MPI_Init(&argc,&argv);
+#else
+	BITPIT_UNUSED(argc);
+	BITPIT_UNUSED(argv);
+#endif
+
+	// Initialize the logger
+	bitpit::log::manager().initialize(bitpit::log::COMBINED);
+
+	// Run the subtests
+	bitpit::log::cout() << "Testing storage modes of cached levelset objects" << std::endl;
+
+	int status;
+	try {
+		status = subtest_001();
+		if (status != 0) {
+			return status;
+		}
+
+		status = subtest_002();
+		if (status != 0) {
+			return status;
+		}
+	} catch (const std::exception &exception) {
+		bitpit::log::cout() << exception.what();
+		exit(1);
+	}
+
+#if BITPIT_ENABLE_MPI==1
+	MPI_Finalize();
+#endif
+}
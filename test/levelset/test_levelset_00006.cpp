@@ -0,0 +1,231 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2019 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+//Standard Template Library
+# include <cmath>
+# include <vector>
+
+#if BITPIT_ENABLE_MPI==1
+# include <mpi.h>
+#endif
+
+// bitpit
+# include "bitpit_CG.hpp"
+# include "bitpit_surfunstructured.hpp"
+# include "bitpit_volcartesian.hpp"
+# include "bitpit_voloctree.hpp"
+# include "bitpit_levelset.hpp"
+
+/*!
+* Check the distance extended outside the narrow band.
+*
+* The extended levelset is compared with the levelset evaluated only in the
+* narrow band and with the exact distance from the surface: inside the narrow
+* band the values should be the same, outside the narrow band the sign should
+* match the propagated one and the distance should be close to the exact one.
+*
+* \param[in] mesh is the mesh
+* \param[in] surface is the surface
+* \param[in] tolerance is the tolerance on the distance, relative to the
+* cell size
+* \result The number of errors found.
+*/
+int checkExtension(bitpit::VolumeKernel &mesh, bitpit::SurfUnstructured *surface, double tolerance)
+{
+    bitpit::LevelSet levelset;
+    levelset.setMesh(&mesh);
+    levelset.setPropagateSign(true);
+
+    int referenceId = levelset.addObject(surface, BITPIT_PI / 3.);
+    levelset.compute();
+
+    const bitpit::LevelSetSegmentation &reference = levelset.getObject<bitpit::LevelSetSegmentation>(referenceId);
+
+    bitpit::LevelSet extendedLevelset;
+    extendedLevelset.setMesh(&mesh);
+    extendedLevelset.setPropagateSign(true);
+    extendedLevelset.setExtendDistance(true);
+
+    int extendedId = extendedLevelset.addObject(surface, BITPIT_PI / 3.);
+    extendedLevelset.compute();
+
+    const bitpit::LevelSetSegmentation &extended = extendedLevelset.getObject<bitpit::LevelSetSegmentation>(extendedId);
+
+    bitpit::SurfaceSkdTree searchTree(surface);
+    searchTree.build();
+
+    int nErrors = 0;
+    double maxError = 0.;
+    for (const bitpit::Cell &cell : mesh.getCells()) {
+        long cellId = cell.getId();
+
+        double referenceValue = reference.getLS(cellId);
+        double extendedValue  = extended.getLS(cellId);
+        if (reference.getSupport(cellId) != bitpit::levelSetDefaults::SUPPORT) {
+            if (extendedValue != referenceValue) {
+                bitpit::log::cout() << "  Levelset of narrow band cell " << cellId << " has been modified" << std::endl;
+                ++nErrors;
+            }
+            continue;
+        }
+
+        if (extended.getSign(cellId) != reference.getSign(cellId)) {
+            bitpit::log::cout() << "  Wrong sign for cell " << cellId << std::endl;
+            ++nErrors;
+        }
+
+        std::array<double,3> centroid = mesh.evalCellCentroid(cellId);
+        double distance = searchTree.evalPointDistance(centroid);
+        double error = std::abs(std::abs(extendedValue) - distance) / mesh.evalCellSize(cellId);
+        maxError = std::max(error, maxError);
+        if (error > tolerance) {
+            bitpit::log::cout() << "  Wrong distance for cell " << cellId << ": " << extendedValue << " (expected " << distance << ")" << std::endl;
+            ++nErrors;
+        }
+    }
+
+    bitpit::log::cout() << "  Maximum error relative to the cell size: " << maxError << std::endl;
+
+    return nErrors;
+}
+
+/*!
+* Evaluate the bounding box of the mesh that will be created around the
+* specified surface.
+*
+* \param[in] surface is the surface
+* \param[out] meshMin is the lower corner of the box
+* \param[out] meshMax is the upper corner of the box
+*/
+void evalMeshBox(const bitpit::SurfUnstructured *surface, std::array<double,3> *meshMin, std::array<double,3> *meshMax)
+{
+    surface->getBoundingBox(*meshMin, *meshMax);
+
+    std::array<double,3> delta = *meshMax - *meshMin;
+    *meshMin -= 0.5 * delta;
+    *meshMax += 0.5 * delta;
+}
+
+/*!
+* Subtest 001
+*
+* Testing distance extension on a Cartesian mesh.
+*/
+int subtest_001(bitpit::SurfUnstructured *surface)
+{
+    std::array<double,3> meshMin, meshMax;
+    evalMeshBox(surface, &meshMin, &meshMax);
+
+    std::array<int,3> nCells = {{32, 32, 32}};
+    bitpit::VolCartesian mesh(3, meshMin, meshMax - meshMin, nCells);
+    mesh.update();
+    mesh.buildInterfaces();
+
+    bitpit::log::cout() << " - Extending distance on a Cartesian mesh with " << mesh.getCellCount() << " cells" << std::endl;
+
+    return checkExtension(mesh, surface, 0.5);
+}
+
+/*!
+* Subtest 002
+*
+* Testing distance extension on an octree mesh.
+*/
+int subtest_002(bitpit::SurfUnstructured *surface)
+{
+    std::array<double,3> meshMin, meshMax;
+    evalMeshBox(surface, &meshMin, &meshMax);
+
+    double h = 0.;
+    for (int i = 0; i < 3; ++i) {
+        h = std::max(h, meshMax[i] - meshMin[i]);
+    }
+
+    bitpit::VolOctree mesh(3, meshMin, h, h / 16.);
+    mesh.buildAdjacencies();
+    mesh.update();
+
+    bitpit::SurfaceSkdTree searchTree(surface);
+    searchTree.build();
+
+    for (int i = 0; i < 2; ++i) {
+        for (const bitpit::Cell &cell : mesh.getCells()) {
+            long cellId = cell.getId();
+            double distance = searchTree.evalPointDistance(mesh.evalCellCentroid(cellId));
+            if (distance < mesh.evalCellSize(cellId)) {
+                mesh.markCellForRefinement(cellId);
+            }
+        }
+
+        mesh.update();
+    }
+
+    bitpit::log::cout() << " - Extending distance on an octree mesh with " << mesh.getCellCount() << " cells" << std::endl;
+
+    return checkExtension(mesh, surface, 0.5);
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+#if BITPIT_ENABLE_MPI==1
+	MPI_Init(&argc,&argv);
+#else
+	BITPIT_UNUSED(argc);
+	BITPIT_UNUSED(argv);
+#endif
+
+	// Initialize the logger
+	bitpit::log::manager().initialize(bitpit::log::COMBINED);
+
+	// Run the subtests
+	bitpit::log::cout() << "Testing distance extension outside the narrow band" << std::endl;
+
+	std::unique_ptr<bitpit::SurfUnstructured> STL(new bitpit::SurfUnstructured(2, 3));
+	STL->importSTL("./data/cube.stl", true);
+	STL->deleteCoincidentVertices();
+	STL->buildAdjacencies();
+
+	int status;
+	try {
+		status = subtest_001(STL.get());
+		if (status != 0) {
+			return status;
+		}
+
+		status = subtest_002(STL.get());
+		if (status != 0) {
+			return status;
+		}
+	} catch (const std::exception &exception) {
+		bitpit::log::cout() << exception.what();
+		exit(1);
+	}
+
+#if BITPIT_ENABLE_MPI==1
+	MPI_Finalize();
+#endif
+}
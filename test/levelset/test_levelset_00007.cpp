@@ -0,0 +1,285 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2019 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+
+//Standard Template Library
+# include <cmath>
+# include <vector>
+
+#if BITPIT_ENABLE_MPI==1
+# include <mpi.h>
+#endif
+
+#if BITPIT_ENABLE_OPENMP==1
+# include <omp.h>
+#endif
+
+// bitpit
+# include "bitpit_CG.hpp"
+# include "bitpit_surfunstructured.hpp"
+# include "bitpit_volcartesian.hpp"
+# include "bitpit_voloctree.hpp"
+# include "bitpit_levelset.hpp"
+
+/*!
+* Evaluate the exact sign of the specified point with respect to a convex
+* surface.
+*
+* A point is inside a convex surface if it lies on the inner side of the
+* planes of all the facets. The inner side of a facet is the one that contains
+* the centroid of the surface. The levelset is positive on the side the facet
+* normals point to, hence the sign of the inner side is the sign of the
+* projection of the centroid on the facet normals.
+*
+* \param[in] surface is the convex surface
+* \param[in] surfaceCentroid is the centroid of the surface
+* \param[in] point is the point
+* \result The exact sign of the point.
+*/
+short evalConvexSign(const bitpit::SurfUnstructured &surface, const std::array<double,3> &surfaceCentroid,
+                     const std::array<double,3> &point)
+{
+    short insideSign = 0;
+    for (const bitpit::Cell &facet : surface.getCells()) {
+        long facetId = facet.getId();
+        std::array<double,3> facetCentroid = surface.evalCellCentroid(facetId);
+        std::array<double,3> facetNormal   = surface.evalFacetNormal(facetId);
+
+        short facetInsideSign = (dotProduct(surfaceCentroid - facetCentroid, facetNormal) > 0.) ? 1 : -1;
+        if (dotProduct(point - facetCentroid, facetNormal) * facetInsideSign < 0.) {
+            return -facetInsideSign;
+        }
+
+        insideSign = facetInsideSign;
+    }
+
+    return insideSign;
+}
+
+/*!
+* Evaluate the centroid of the specified surface.
+*
+* \param[in] surface is the surface
+* \result The centroid of the surface.
+*/
+std::array<double,3> evalSurfaceCentroid(const bitpit::SurfUnstructured &surface)
+{
+    std::array<double,3> centroid = {{0., 0., 0.}};
+    for (const bitpit::Vertex &vertex : surface.getVertices()) {
+        centroid += vertex.getCoords();
+    }
+    centroid /= (double) surface.getVertexCount();
+
+    return centroid;
+}
+
+/*!
+* Check the propagated sign of the levelset.
+*
+* The signs of all the cells are compared with the exact sign evaluated from
+* the convexity of the surface. Cells outside the narrow band should be
+* found both inside and outside the surface, otherwise the propagation
+* would not be tested. When OpenMP is enabled, the propagation is
+* run both with one thread and with multiple threads.
+*
+* \param[in] mesh is the mesh
+* \param[in] surface is the convex surface
+* \result The number of errors found.
+*/
+int checkSign(bitpit::VolumeKernel &mesh, bitpit::SurfUnstructured *surface)
+{
+    std::array<double,3> surfaceCentroid = evalSurfaceCentroid(*surface);
+
+#if BITPIT_ENABLE_OPENMP==1
+    std::vector<int> threadCounts = {1, 4};
+#else
+    std::vector<int> threadCounts = {1};
+#endif
+
+    int nErrors = 0;
+    for (int nThreads : threadCounts) {
+#if BITPIT_ENABLE_OPENMP==1
+        omp_set_num_threads(nThreads);
+#endif
+
+        bitpit::LevelSet levelset;
+        levelset.setMesh(&mesh);
+        levelset.setPropagateSign(true);
+
+        int objectId = levelset.addObject(surface, BITPIT_PI / 3.);
+        levelset.compute();
+
+        const bitpit::LevelSetSegmentation &object = levelset.getObject<bitpit::LevelSetSegmentation>(objectId);
+
+        long nPropagatedInside  = 0;
+        long nPropagatedOutside = 0;
+        for (const bitpit::Cell &cell : mesh.getCells()) {
+            long cellId = cell.getId();
+            short expectedSign = evalConvexSign(*surface, surfaceCentroid, mesh.evalCellCentroid(cellId));
+            if (object.getSign(cellId) != expectedSign) {
+                bitpit::log::cout() << "  Wrong sign for cell " << cellId << " using " << nThreads << " threads" << std::endl;
+                ++nErrors;
+            }
+
+            if (object.getSupport(cellId) != bitpit::levelSetDefaults::SUPPORT) {
+                continue;
+            }
+
+            if (expectedSign < 0) {
+                ++nPropagatedInside;
+            } else {
+                ++nPropagatedOutside;
+            }
+        }
+
+        bitpit::log::cout() << "  Propagated sign using " << nThreads << " threads: " << nPropagatedInside << " negative cells, " << nPropagatedOutside << " positive cells" << std::endl;
+
+        if (nPropagatedInside == 0 || nPropagatedOutside == 0) {
+            bitpit::log::cout() << "  The sign should have been propagated both inside and outside the surface" << std::endl;
+            ++nErrors;
+        }
+    }
+
+    return nErrors;
+}
+
+/*!
+* Evaluate the bounding box of the mesh that will be created around the
+* specified surface.
+*
+* \param[in] surface is the surface
+* \param[out] meshMin is the lower corner of the box
+* \param[out] meshMax is the upper corner of the box
+*/
+void evalMeshBox(const bitpit::SurfUnstructured *surface, std::array<double,3> *meshMin, std::array<double,3> *meshMax)
+{
+    surface->getBoundingBox(*meshMin, *meshMax);
+
+    std::array<double,3> delta = *meshMax - *meshMin;
+    *meshMin -= 0.5 * delta;
+    *meshMax += 0.5 * delta;
+}
+
+/*!
+* Subtest 001
+*
+* Testing sign propagation on a Cartesian mesh.
+*/
+int subtest_001(bitpit::SurfUnstructured *surface)
+{
+    std::array<double,3> meshMin, meshMax;
+    evalMeshBox(surface, &meshMin, &meshMax);
+
+    std::array<int,3> nCells = {{32, 32, 32}};
+    bitpit::VolCartesian mesh(3, meshMin, meshMax - meshMin, nCells);
+    mesh.update();
+    mesh.buildInterfaces();
+
+    bitpit::log::cout() << " - Propagating sign on a Cartesian mesh with " << mesh.getCellCount() << " cells" << std::endl;
+
+    return checkSign(mesh, surface);
+}
+
+/*!
+* Subtest 002
+*
+* Testing sign propagation on an octree mesh.
+*/
+int subtest_002(bitpit::SurfUnstructured *surface)
+{
+    std::array<double,3> meshMin, meshMax;
+    evalMeshBox(surface, &meshMin, &meshMax);
+
+    double h = 0.;
+    for (int i = 0; i < 3; ++i) {
+        h = std::max(h, meshMax[i] - meshMin[i]);
+    }
+
+    bitpit::VolOctree mesh(3, meshMin, h, h / 16.);
+    mesh.buildAdjacencies();
+    mesh.update();
+
+    bitpit::SurfaceSkdTree searchTree(surface);
+    searchTree.build();
+
+    for (int i = 0; i < 2; ++i) {
+        for (const bitpit::Cell &cell : mesh.getCells()) {
+            long cellId = cell.getId();
+            double distance = searchTree.evalPointDistance(mesh.evalCellCentroid(cellId));
+            if (distance < mesh.evalCellSize(cellId)) {
+                mesh.markCellForRefinement(cellId);
+            }
+        }
+
+        mesh.update();
+    }
+
+    bitpit::log::cout() << " - Propagating sign on an octree mesh with " << mesh.getCellCount() << " cells" << std::endl;
+
+    return checkSign(mesh, surface);
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+#if BITPIT_ENABLE_MPI==1
+	MPI_Init(&argc,&argv);
+#else
+	BITPIT_UNUSED(argc);
+	BITPIT_UNUSED(argv);
+#endif
+
+	// Initialize the logger
+	bitpit::log::manager().initialize(bitpit::log::COMBINED);
+
+	// Run the subtests
+	bitpit::log::cout() << "Testing sign propagation" << std::endl;
+
+	std::unique_ptr<bitpit::SurfUnstructured> STL(new bitpit::SurfUnstructured(2, 3));
+	STL->importSTL("./data/cube.stl", true);
+	STL->deleteCoincidentVertices();
+	STL->buildAdjacencies();
+
+	int status;
+	try {
+		status = subtest_001(STL.get());
+		if (status != 0) {
+			return status;
+		}
+
+		status = subtest_002(STL.get());
+		if (status != 0) {
+			return status;
+		}
+	} catch (const std::exception &exception) {
+		bitpit::log::cout() << exception.what();
+		exit(1);
+	}
+
+#if BITPIT_ENABLE_MPI==1
+	MPI_Finalize();
+#endif
+}
@@ -0,0 +1,246 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2019 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+//Standard Template Library
+# include <array>
+# include <cmath>
+# include <map>
+
+# include <mpi.h>
+
+// bitpit
+# include "bitpit_communications.hpp"
+# include "bitpit_surfunstructured.hpp"
+# include "bitpit_voloctree.hpp"
+# include "bitpit_levelset.hpp"
+
+/*!
+* Evaluate the extended levelset of the specified surface.
+*
+* \param[in] mesh is the mesh
+* \param[in] surface is the surface
+* \param[out] values on output will contain the levelset of the cells,
+* indexed by the centroid of the cells
+*/
+void evalExtendedLevelSet(bitpit::VolOctree &mesh, bitpit::SurfUnstructured *surface,
+                          std::map<std::array<double,3>, double> *values)
+{
+    bitpit::LevelSet levelset;
+    levelset.setMesh(&mesh);
+    levelset.setPropagateSign(true);
+    levelset.setExtendDistance(true);
+
+    int objectId = levelset.addObject(surface, BITPIT_PI / 3.);
+    levelset.compute();
+
+    const bitpit::LevelSetObject &object = levelset.getObject(objectId);
+
+    values->clear();
+    for (const bitpit::Cell &cell : mesh.getCells()) {
+        long cellId = cell.getId();
+        (*values)[mesh.evalCellCentroid(cellId)] = object.getLS(cellId);
+    }
+}
+
+/*!
+* Subtest 001
+*
+* Testing distance extension on a partitioned octree mesh.
+*
+* \param rank is the rank of the process
+*/
+int subtest_001(int rank)
+{
+    BITPIT_UNUSED(rank);
+
+    // Input geometry
+    bitpit::log::cout() << " - Loading stl geometry" << std::endl;
+
+    std::unique_ptr<bitpit::SurfUnstructured> STL(new bitpit::SurfUnstructured(2, 3));
+    STL->importSTL("./data/cube.stl", true);
+    STL->deleteCoincidentVertices();
+    STL->buildAdjacencies();
+
+    // Create the mesh
+    bitpit::log::cout() << " - Setting mesh" << std::endl;
+
+    std::array<double,3> meshMin, meshMax;
+    STL->getBoundingBox(meshMin, meshMax);
+
+    std::array<double,3> delta = meshMax - meshMin;
+    meshMin -= 0.5 * delta;
+    meshMax += 0.5 * delta;
+
+    double h = 0.;
+    for (int i = 0; i < 3; ++i) {
+        h = std::max(h, meshMax[i] - meshMin[i]);
+    }
+
+    bitpit::VolOctree mesh(3, meshMin, h, h / 16.);
+    mesh.buildAdjacencies();
+    mesh.update();
+
+    bitpit::SurfaceSkdTree searchTree(STL.get());
+    searchTree.build();
+
+    for (int i = 0; i < 2; ++i) {
+        for (const bitpit::Cell &cell : mesh.getCells()) {
+            long cellId = cell.getId();
+            double distance = searchTree.evalPointDistance(mesh.evalCellCentroid(cellId));
+            if (distance < mesh.evalCellSize(cellId)) {
+                mesh.markCellForRefinement(cellId);
+            }
+        }
+
+        mesh.update();
+    }
+
+    // Serial extension
+    bitpit::log::cout() << " - Extending distance on the serial mesh" << std::endl;
+
+    std::map<std::array<double,3>, double> serialValues;
+    evalExtendedLevelSet(mesh, STL.get(), &serialValues);
+
+    // Parallel extension
+    bitpit::log::cout() << " - Extending distance on the partitioned mesh" << std::endl;
+
+    mesh.partition(MPI_COMM_WORLD, false);
+
+    bitpit::LevelSet levelset;
+    levelset.setMesh(&mesh);
+    levelset.setPropagateSign(true);
+    levelset.setExtendDistance(true);
+
+    int objectId = levelset.addObject(STL.get(), BITPIT_PI / 3.);
+    levelset.compute();
+
+    const bitpit::LevelSetObject &object = levelset.getObject(objectId);
+
+    // Compare the partitioned values with the serial ones
+    //
+    // The marching restarts from the ghosts whose distance has decreased,
+    // therefore the order in which the cells are accepted may be different
+    // from the serial one. Both distances are upper bounds of the exact
+    // distance whose error is a fraction of the cell size.
+    const double TOLERANCE = 0.5;
+
+    int nErrors = 0;
+    double maxDifference = 0.;
+    for (const bitpit::Cell &cell : mesh.getCells()) {
+        long cellId = cell.getId();
+
+        double value = object.getLS(cellId);
+        double serialValue = serialValues.at(mesh.evalCellCentroid(cellId));
+        if ((value > 0.) != (serialValue > 0.)) {
+            bitpit::log::cout() << "  Wrong sign for cell " << cellId << std::endl;
+            ++nErrors;
+        }
+
+        double difference = std::abs(value - serialValue) / mesh.evalCellSize(cellId);
+        maxDifference = std::max(difference, maxDifference);
+        if (difference > TOLERANCE) {
+            bitpit::log::cout() << "  Wrong distance for cell " << cellId << ": " << value << " (serial " << serialValue << ")" << std::endl;
+            ++nErrors;
+        }
+    }
+
+    MPI_Allreduce(MPI_IN_PLACE, &maxDifference, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+    bitpit::log::cout() << "  Maximum difference from the serial distance relative to the cell size: " << maxDifference << std::endl;
+
+    // Check that the ghosts agree with their owners
+    bitpit::DataCommunicator dataCommunicator(MPI_COMM_WORLD);
+
+    for (const auto &entry : mesh.getGhostExchangeSources()) {
+        int rank = entry.first;
+        const std::vector<long> &sendIds = entry.second;
+
+        dataCommunicator.setSend(rank, sendIds.size() * sizeof(double));
+        bitpit::SendBuffer &buffer = dataCommunicator.getSendBuffer(rank);
+        for (long cellId : sendIds) {
+            buffer << object.getLS(cellId);
+        }
+    }
+
+    for (const auto &entry : mesh.getGhostExchangeTargets()) {
+        dataCommunicator.setRecv(entry.first, entry.second.size() * sizeof(double));
+    }
+
+    dataCommunicator.startAllRecvs();
+    dataCommunicator.startAllSends();
+
+    int nCompletedRecvs = 0;
+    while (nCompletedRecvs < dataCommunicator.getRecvCount()) {
+        int rank = dataCommunicator.waitAnyRecv();
+        bitpit::RecvBuffer &buffer = dataCommunicator.getRecvBuffer(rank);
+        for (long cellId : mesh.getGhostExchangeTargets(rank)) {
+            double ownerValue;
+            buffer >> ownerValue;
+            if (object.getLS(cellId) != ownerValue) {
+                bitpit::log::cout() << "  Ghost " << cellId << " doesn't agree with its owner" << std::endl;
+                ++nErrors;
+            }
+        }
+
+        ++nCompletedRecvs;
+    }
+
+    dataCommunicator.waitAllSends();
+
+    MPI_Allreduce(MPI_IN_PLACE, &nErrors, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+
+    return nErrors;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+    MPI_Init(&argc,&argv);
+
+    // Initialize the logger
+    int nProcs;
+    int    rank;
+    MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    bitpit::log::manager().initialize(bitpit::log::COMBINED, true, nProcs, rank);
+    bitpit::log::cout().setVisibility(bitpit::log::GLOBAL);
+
+    // Run the subtests
+    bitpit::log::cout() << "Testing parallel distance extension outside the narrow band" << std::endl;
+
+    int status;
+    try {
+        status = subtest_001(rank);
+        if (status != 0) {
+            return status;
+        }
+    } catch (const std::exception &exception) {
+        bitpit::log::cout() << exception.what();
+        exit(1);
+    }
+
+    MPI_Finalize();
+}
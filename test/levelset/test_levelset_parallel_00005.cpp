@@ -0,0 +1,282 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2019 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+
+//Standard Template Library
+# include <array>
+# include <cmath>
+# include <vector>
+
+# include <mpi.h>
+
+#if BITPIT_ENABLE_OPENMP==1
+# include <omp.h>
+#endif
+
+// bitpit
+# include "bitpit_CG.hpp"
+# include "bitpit_communications.hpp"
+# include "bitpit_surfunstructured.hpp"
+# include "bitpit_voloctree.hpp"
+# include "bitpit_levelset.hpp"
+
+/*!
+* Evaluate the exact sign of the specified point with respect to a convex
+* surface.
+*
+* A point is inside a convex surface if it lies on the inner side of the
+* planes of all the facets. The inner side of a facet is the one that contains
+* the centroid of the surface. The levelset is positive on the side the facet
+* normals point to, hence the sign of the inner side is the sign of the
+* projection of the centroid on the facet normals.
+*
+* \param[in] surface is the convex surface
+* \param[in] surfaceCentroid is the centroid of the surface
+* \param[in] point is the point
+* \result The exact sign of the point.
+*/
+short evalConvexSign(const bitpit::SurfUnstructured &surface, const std::array<double,3> &surfaceCentroid,
+                     const std::array<double,3> &point)
+{
+    short insideSign = 0;
+    for (const bitpit::Cell &facet : surface.getCells()) {
+        long facetId = facet.getId();
+        std::array<double,3> facetCentroid = surface.evalCellCentroid(facetId);
+        std::array<double,3> facetNormal   = surface.evalFacetNormal(facetId);
+
+        short facetInsideSign = (dotProduct(surfaceCentroid - facetCentroid, facetNormal) > 0.) ? 1 : -1;
+        if (dotProduct(point - facetCentroid, facetNormal) * facetInsideSign < 0.) {
+            return -facetInsideSign;
+        }
+
+        insideSign = facetInsideSign;
+    }
+
+    return insideSign;
+}
+
+/*!
+* Subtest 001
+*
+* Testing sign propagation on a partitioned octree mesh.
+*
+* The surface is placed in a corner of the domain, therefore, once the mesh
+* is partitioned, some processes have no cells in the narrow band and their
+* sign can only be propagated from the seeds received through the ghosts.
+*
+* \param rank is the rank of the process
+*/
+int subtest_001(int rank)
+{
+    BITPIT_UNUSED(rank);
+
+    // Input geometry
+    bitpit::log::cout() << " - Loading stl geometry" << std::endl;
+
+    std::unique_ptr<bitpit::SurfUnstructured> STL(new bitpit::SurfUnstructured(2, 3));
+    STL->importSTL("./data/cube.stl", true);
+    STL->deleteCoincidentVertices();
+    STL->buildAdjacencies();
+
+    std::array<double,3> surfaceCentroid = {{0., 0., 0.}};
+    for (const bitpit::Vertex &vertex : STL->getVertices()) {
+        surfaceCentroid += vertex.getCoords();
+    }
+    surfaceCentroid /= (double) STL->getVertexCount();
+
+    // Create the mesh
+    bitpit::log::cout() << " - Setting mesh" << std::endl;
+
+    std::array<double,3> surfaceMin, surfaceMax;
+    STL->getBoundingBox(surfaceMin, surfaceMax);
+
+    std::array<double,3> delta = surfaceMax - surfaceMin;
+    std::array<double,3> meshMin = surfaceMin - 0.5 * delta;
+
+    double h = 0.;
+    for (int i = 0; i < 3; ++i) {
+        h = std::max(h, 8. * delta[i]);
+    }
+
+    bitpit::VolOctree mesh(3, meshMin, h, h / 32.);
+    mesh.buildAdjacencies();
+    mesh.update();
+
+    bitpit::SurfaceSkdTree searchTree(STL.get());
+    searchTree.build();
+
+    for (int i = 0; i < 2; ++i) {
+        for (const bitpit::Cell &cell : mesh.getCells()) {
+            long cellId = cell.getId();
+            double distance = searchTree.evalPointDistance(mesh.evalCellCentroid(cellId));
+            if (distance < mesh.evalCellSize(cellId)) {
+                mesh.markCellForRefinement(cellId);
+            }
+        }
+
+        mesh.update();
+    }
+
+    mesh.partition(MPI_COMM_WORLD, false);
+
+    // Propagate the sign
+#if BITPIT_ENABLE_OPENMP==1
+    std::vector<int> threadCounts = {1, 4};
+#else
+    std::vector<int> threadCounts = {1};
+#endif
+
+    int nErrors = 0;
+    for (int nThreads : threadCounts) {
+#if BITPIT_ENABLE_OPENMP==1
+        omp_set_num_threads(nThreads);
+#endif
+
+        bitpit::log::cout() << " - Propagating sign using " << nThreads << " threads" << std::endl;
+
+        bitpit::LevelSet levelset;
+        levelset.setMesh(&mesh);
+        levelset.setPropagateSign(true);
+
+        int objectId = levelset.addObject(STL.get(), BITPIT_PI / 3.);
+        levelset.compute();
+
+        const bitpit::LevelSetSegmentation &object = levelset.getObject<bitpit::LevelSetSegmentation>(objectId);
+
+        // Compare the signs with the exact ones
+        long nPropagatedInside  = 0;
+        long nPropagatedOutside = 0;
+        long nLocalSupports     = 0;
+        for (const bitpit::Cell &cell : mesh.getCells()) {
+            long cellId = cell.getId();
+
+            short expectedSign = evalConvexSign(*STL, surfaceCentroid, mesh.evalCellCentroid(cellId));
+            if (object.getSign(cellId) != expectedSign) {
+                bitpit::log::cout() << "  Wrong sign for cell " << cellId << std::endl;
+                ++nErrors;
+            }
+
+            if (object.getSupport(cellId) != bitpit::levelSetDefaults::SUPPORT) {
+                if (cell.isInterior()) {
+                    ++nLocalSupports;
+                }
+                continue;
+            }
+
+            if (expectedSign < 0) {
+                ++nPropagatedInside;
+            } else {
+                ++nPropagatedOutside;
+            }
+        }
+
+        bitpit::log::cout() << "  Interior cells in the narrow band: " << nLocalSupports << std::endl;
+        bitpit::log::cout() << "  Propagated sign: " << nPropagatedInside << " negative cells, " << nPropagatedOutside << " positive cells" << std::endl;
+
+        // At least one process should have received its sign only from the
+        // ghosts, otherwise the propagation through the ghosts is not tested.
+        int hasLocalSeeds = (nLocalSupports > 0) ? 1 : 0;
+        MPI_Allreduce(MPI_IN_PLACE, &hasLocalSeeds, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+        if (hasLocalSeeds != 0) {
+            bitpit::log::cout() << "  All the processes have cells in the narrow band" << std::endl;
+            ++nErrors;
+        }
+
+        // Check that the ghosts agree with their owners
+        bitpit::DataCommunicator dataCommunicator(MPI_COMM_WORLD);
+
+        for (const auto &entry : mesh.getGhostExchangeSources()) {
+            int rank = entry.first;
+            const std::vector<long> &sendIds = entry.second;
+
+            dataCommunicator.setSend(rank, sendIds.size() * sizeof(short));
+            bitpit::SendBuffer &buffer = dataCommunicator.getSendBuffer(rank);
+            for (long cellId : sendIds) {
+                buffer << object.getSign(cellId);
+            }
+        }
+
+        for (const auto &entry : mesh.getGhostExchangeTargets()) {
+            dataCommunicator.setRecv(entry.first, entry.second.size() * sizeof(short));
+        }
+
+        dataCommunicator.startAllRecvs();
+        dataCommunicator.startAllSends();
+
+        int nCompletedRecvs = 0;
+        while (nCompletedRecvs < dataCommunicator.getRecvCount()) {
+            int rank = dataCommunicator.waitAnyRecv();
+            bitpit::RecvBuffer &buffer = dataCommunicator.getRecvBuffer(rank);
+            for (long cellId : mesh.getGhostExchangeTargets(rank)) {
+                short ownerSign;
+                buffer >> ownerSign;
+                if (object.getSign(cellId) != ownerSign) {
+                    bitpit::log::cout() << "  Sign of ghost " << cellId << " doesn't agree with its owner" << std::endl;
+                    ++nErrors;
+                }
+            }
+
+            ++nCompletedRecvs;
+        }
+
+        dataCommunicator.waitAllSends();
+    }
+
+    MPI_Allreduce(MPI_IN_PLACE, &nErrors, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+
+    return nErrors;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+    MPI_Init(&argc,&argv);
+
+    // Initialize the logger
+    int nProcs;
+    int    rank;
+    MPI_Comm_size(MPI_COMM_WORLD, &nProcs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    bitpit::log::manager().initialize(bitpit::log::COMBINED, true, nProcs, rank);
+    bitpit::log::cout().setVisibility(bitpit::log::GLOBAL);
+
+    // Run the subtests
+    bitpit::log::cout() << "Testing parallel sign propagation" << std::endl;
+
+    int status;
+    try {
+        status = subtest_001(rank);
+        if (status != 0) {
+            return status;
+        }
+    } catch (const std::exception &exception) {
+        bitpit::log::cout() << exception.what();
+        exit(1);
+    }
+
+    MPI_Finalize();
+}
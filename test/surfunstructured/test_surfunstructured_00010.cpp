@@ -0,0 +1,178 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2019 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+// ========================================================================== //
+//           ** BitPit mesh ** Test 010 for class SurfUnstructured **         //
+//                                                                            //
+// Test point location                                                        //
+// ========================================================================== //
+
+// ========================================================================== //
+// INCLUDES                                                                   //
+// ========================================================================== //
+
+// Standard Template Library
+# include <array>
+# include <vector>
+# include <iostream>
+#if BITPIT_ENABLE_MPI==1
+# include <mpi.h>
+#endif
+
+// BitPit
+# include "bitpit_common.hpp"
+# include "bitpit_operators.hpp"
+# include "bitpit_surfunstructured.hpp"
+
+// ========================================================================== //
+// NAMESPACES                                                                 //
+// ========================================================================== //
+using namespace std;
+using namespace bitpit;
+
+// ========================================================================== //
+// SUBTEST #001 Test point location                                           //
+// ========================================================================== //
+int subtest_001(
+    void
+) {
+
+    // Create the mesh
+    //
+    // The mesh is a triangulation of the unit square on the xy plane, each
+    // square is split along its diagonal.
+    const int N_CELLS = 16;
+    const int N_VERTICES = N_CELLS + 1;
+    const double h = 1. / N_CELLS;
+
+    SurfUnstructured *mesh = new SurfUnstructured(2, 3);
+
+    for (int j = 0; j < N_VERTICES; ++j) {
+        for (int i = 0; i < N_VERTICES; ++i) {
+            mesh->addVertex({{i * h, j * h, 0.}}, i + N_VERTICES * j);
+        }
+    }
+
+    for (int j = 0; j < N_CELLS; ++j) {
+        for (int i = 0; i < N_CELLS; ++i) {
+            long v0 = i + N_VERTICES * j;
+            long v1 = v0 + 1;
+            long v2 = v1 + N_VERTICES;
+            long v3 = v0 + N_VERTICES;
+
+            mesh->addCell(ElementType::TRIANGLE, std::vector<long>({{v0, v1, v2}}), 2 * (i + N_CELLS * j));
+            mesh->addCell(ElementType::TRIANGLE, std::vector<long>({{v0, v2, v3}}), 2 * (i + N_CELLS * j) + 1);
+        }
+    }
+
+    // Generate the points
+    //
+    // Points are placed on the surface, away from the edges of the triangles,
+    // and above the surface.
+    std::vector<array<double, 3>> points;
+    std::vector<long> expectedIds;
+    for (int j = 0; j < N_CELLS; ++j) {
+        for (int i = 0; i < N_CELLS; ++i) {
+            points.push_back({{(i + 0.75) * h, (j + 0.25) * h, 0.}});
+            expectedIds.push_back(2 * (i + N_CELLS * j));
+
+            points.push_back({{(i + 0.25) * h, (j + 0.75) * h, 0.}});
+            expectedIds.push_back(2 * (i + N_CELLS * j) + 1);
+
+            points.push_back({{(i + 0.25) * h, (j + 0.75) * h, 0.1 * h}});
+            expectedIds.push_back(Cell::NULL_ID);
+        }
+    }
+
+    std::size_t nPoints = points.size();
+
+    // Locate the points
+    std::vector<long> batchIds(nPoints);
+    mesh->locatePoints(nPoints, points.data(), batchIds.data());
+
+    SurfaceSkdTree tree(mesh);
+    tree.build(4);
+
+    for (std::size_t n = 0; n < nPoints; ++n) {
+        long patchId = mesh->locatePoint(points[n]);
+        long treeId  = tree.locatePoint(points[n]);
+        if (patchId != expectedIds[n] || treeId != expectedIds[n] || batchIds[n] != expectedIds[n]) {
+            log::cout() << "  Wrong location of point " << points[n] << ": expected cell " << expectedIds[n]
+                        << ", found cells " << patchId << " (patch), " << treeId << " (tree), " << batchIds[n] << " (batch)" << std::endl;
+
+            return 1;
+        }
+    }
+
+    log::cout() << "  Located " << nPoints << " points" << std::endl;
+
+    delete mesh;
+
+    return 0;
+}
+
+// ========================================================================== //
+// MAIN                                                                       //
+// ========================================================================== //
+int main(int argc, char *argv[])
+{
+    // ====================================================================== //
+    // INITIALIZE MPI                                                         //
+    // ====================================================================== //
+#if BITPIT_ENABLE_MPI==1
+	MPI_Init(&argc,&argv);
+#else
+	BITPIT_UNUSED(argc);
+	BITPIT_UNUSED(argv);
+#endif
+
+    // ====================================================================== //
+    // VARIABLES DECLARATION                                                  //
+    // ====================================================================== //
+
+    // Local variabels
+    int                             status = 0;
+
+    // ====================================================================== //
+    // RUN SUB-TESTS                                                          //
+    // ====================================================================== //
+    try {
+        status = subtest_001();
+        if (status != 0) {
+            return (10 + status);
+        }
+    } catch (const std::exception &exception) {
+        log::cout() << exception.what();
+        exit(1);
+    }
+
+    // ====================================================================== //
+    // FINALIZE MPI                                                           //
+    // ====================================================================== //
+#if BITPIT_ENABLE_MPI==1
+    MPI_Finalize();
+#endif
+
+    return status;
+}
@@ -0,0 +1,205 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2019 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+// ========================================================================== //
+//           ** BitPit mesh ** Test 011 for class SurfUnstructured **         //
+//                                                                            //
+// Test batch closest cell search                                             //
+// ========================================================================== //
+
+// ========================================================================== //
+// INCLUDES                                                                   //
+// ========================================================================== //
+
+// Standard Template Library
+# include <array>
+# include <cmath>
+# include <limits>
+# include <vector>
+# include <iostream>
+#if BITPIT_ENABLE_MPI==1
+# include <mpi.h>
+#endif
+
+// BitPit
+# include "bitpit_common.hpp"
+# include "bitpit_operators.hpp"
+# include "bitpit_surfunstructured.hpp"
+
+// ========================================================================== //
+// NAMESPACES                                                                 //
+// ========================================================================== //
+using namespace std;
+using namespace bitpit;
+
+// ========================================================================== //
+// SUBTEST #001 Test batch closest cell search                                //
+// ========================================================================== //
+int subtest_001(
+    void
+) {
+
+    // Create the mesh
+    //
+    // The mesh is a triangulation of a wavy surface defined over the unit
+    // square on the xy plane, each square is split along its diagonal.
+    const int N_CELLS = 32;
+    const int N_VERTICES = N_CELLS + 1;
+    const double h = 1. / N_CELLS;
+
+    SurfUnstructured *mesh = new SurfUnstructured(2, 3);
+
+    for (int j = 0; j < N_VERTICES; ++j) {
+        for (int i = 0; i < N_VERTICES; ++i) {
+            double x = i * h;
+            double y = j * h;
+            double z = 0.1 * std::sin(2. * BITPIT_PI * x) * std::cos(2. * BITPIT_PI * y);
+            mesh->addVertex({{x, y, z}}, i + N_VERTICES * j);
+        }
+    }
+
+    for (int j = 0; j < N_CELLS; ++j) {
+        for (int i = 0; i < N_CELLS; ++i) {
+            long v0 = i + N_VERTICES * j;
+            long v1 = v0 + 1;
+            long v2 = v1 + N_VERTICES;
+            long v3 = v0 + N_VERTICES;
+
+            mesh->addCell(ElementType::TRIANGLE, std::vector<long>({{v0, v1, v2}}), 2 * (i + N_CELLS * j));
+            mesh->addCell(ElementType::TRIANGLE, std::vector<long>({{v0, v2, v3}}), 2 * (i + N_CELLS * j) + 1);
+        }
+    }
+
+    SurfaceSkdTree tree(mesh);
+    tree.build(4);
+
+    // Generate the points
+    //
+    // Points are placed on a regular grid that contains the surface, the
+    // maximum distance of each point varies along the grid.
+    const int N_POINTS = 24;
+    const double dp = 1.5 / (N_POINTS - 1);
+
+    std::vector<array<double, 3>> points;
+    std::vector<double> maxDistances;
+    for (int k = 0; k < N_POINTS; ++k) {
+        for (int j = 0; j < N_POINTS; ++j) {
+            for (int i = 0; i < N_POINTS; ++i) {
+                points.push_back({{- 0.25 + i * dp, - 0.25 + j * dp, - 0.75 + k * dp}});
+                maxDistances.push_back(0.05 + 0.01 * ((i + j + k) % 30));
+            }
+        }
+    }
+
+    std::size_t nPoints = points.size();
+
+    // Find the closest cells
+    for (int pass = 0; pass < 2; ++pass) {
+        const double *passMaxDistances = nullptr;
+        if (pass == 1) {
+            passMaxDistances = maxDistances.data();
+        }
+
+        std::vector<long> batchIds(nPoints);
+        std::vector<double> batchDistances(nPoints);
+        tree.findPointClosestCells(nPoints, points.data(), passMaxDistances, batchIds.data(), batchDistances.data());
+
+        std::size_t nFound = 0;
+        for (std::size_t n = 0; n < nPoints; ++n) {
+            double maxDistance = std::numeric_limits<double>::max();
+            if (passMaxDistances) {
+                maxDistance = passMaxDistances[n];
+            }
+
+            long id;
+            double distance;
+            tree.findPointClosestCell(points[n], maxDistance, &id, &distance);
+            if (batchIds[n] != id || batchDistances[n] != distance) {
+                log::cout() << "  Wrong closest cell of point " << points[n] << ": expected cell " << id << " at distance " << distance
+                            << ", found cell " << batchIds[n] << " at distance " << batchDistances[n] << std::endl;
+
+                return 1;
+            }
+
+            if (id != Cell::NULL_ID) {
+                ++nFound;
+            }
+        }
+
+        if (passMaxDistances) {
+            log::cout() << "  Found closest cells of " << nFound << " out of " << nPoints << " points using maximum distances" << std::endl;
+        } else {
+            log::cout() << "  Found closest cells of " << nFound << " out of " << nPoints << " points" << std::endl;
+        }
+    }
+
+    delete mesh;
+
+    return 0;
+}
+
+// ========================================================================== //
+// MAIN                                                                       //
+// ========================================================================== //
+int main(int argc, char *argv[])
+{
+    // ====================================================================== //
+    // INITIALIZE MPI                                                         //
+    // ====================================================================== //
+#if BITPIT_ENABLE_MPI==1
+	MPI_Init(&argc,&argv);
+#else
+	BITPIT_UNUSED(argc);
+	BITPIT_UNUSED(argv);
+#endif
+
+    // ====================================================================== //
+    // VARIABLES DECLARATION                                                  //
+    // ====================================================================== //
+
+    // Local variabels
+    int                             status = 0;
+
+    // ====================================================================== //
+    // RUN SUB-TESTS                                                          //
+    // ====================================================================== //
+    try {
+        status = subtest_001();
+        if (status != 0) {
+            return (10 + status);
+        }
+    } catch (const std::exception &exception) {
+        log::cout() << exception.what();
+        exit(1);
+    }
+
+    // ====================================================================== //
+    // FINALIZE MPI                                                           //
+    // ====================================================================== //
+#if BITPIT_ENABLE_MPI==1
+    MPI_Finalize();
+#endif
+
+    return status;
+}
@@ -0,0 +1,236 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2019 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <array>
+#include <map>
+#include <tuple>
+#if BITPIT_ENABLE_MPI==1
+#include <mpi.h>
+#endif
+
+#include "bitpit_common.hpp"
+#include "bitpit_IO.hpp"
+#include "bitpit_voloctree.hpp"
+
+using namespace bitpit;
+
+typedef std::tuple<long, int, long, int, std::vector<long>> InterfaceSnapshot;
+typedef std::map<long, std::vector<std::vector<long>>> CellSnapshot;
+
+/*!
+* Take a snapshot of the interfaces of the specified patch.
+*
+* \param patch is the patch
+* \result The snapshot of the interfaces of the patch.
+*/
+std::map<long, InterfaceSnapshot> takeInterfaceSnapshot(const PatchKernel &patch)
+{
+	std::map<long, InterfaceSnapshot> snapshot;
+	for (const Interface &interface : patch.getInterfaces()) {
+		const long *connect = interface.getConnect();
+		std::vector<long> interfaceConnect(connect, connect + interface.getConnectSize());
+
+		snapshot[interface.getId()] = InterfaceSnapshot(interface.getOwner(), interface.getOwnerFace(),
+		                                                interface.getNeigh(), interface.getNeighFace(),
+		                                                interfaceConnect);
+	}
+
+	return snapshot;
+}
+
+/*!
+* Take a snapshot of the adjacencies and the interfaces of the cells of the
+* specified patch.
+*
+* Adjacencies and interfaces are stored in the order they have on the faces
+* of the cells.
+*
+* \param patch is the patch
+* \result The snapshot of the cells of the patch.
+*/
+CellSnapshot takeCellSnapshot(const PatchKernel &patch)
+{
+	CellSnapshot snapshot;
+	for (const Cell &cell : patch.getCells()) {
+		std::vector<std::vector<long>> &cellSnapshot = snapshot[cell.getId()];
+
+		int nFaces = cell.getFaceCount();
+		for (int face = 0; face < nFaces; ++face) {
+			const long *adjacencies = cell.getAdjacencies(face);
+			cellSnapshot.emplace_back(adjacencies, adjacencies + cell.getAdjacencyCount(face));
+
+			const long *interfaces = cell.getInterfaces(face);
+			cellSnapshot.emplace_back(interfaces, interfaces + cell.getInterfaceCount(face));
+		}
+	}
+
+	return snapshot;
+}
+
+/*!
+* Check if the interfaces built in bulk match the interfaces built updating
+* the interfaces of the cells one by one.
+*
+* \param patch is the patch
+*/
+void checkInterfaces(VolOctree *patch)
+{
+	// Update the interfaces of all the cells
+	patch->clearInterfaces();
+	patch->updateInterfaces(patch->getCells().getIds(false));
+
+	std::map<long, InterfaceSnapshot> updatedInterfaces = takeInterfaceSnapshot(*patch);
+	CellSnapshot updatedCells = takeCellSnapshot(*patch);
+
+	// Build the interfaces in bulk
+	patch->clearInterfaces();
+	patch->buildInterfaces();
+
+	std::map<long, InterfaceSnapshot> builtInterfaces = takeInterfaceSnapshot(*patch);
+	CellSnapshot builtCells = takeCellSnapshot(*patch);
+
+	log::cout() << "    Number of interfaces: " << patch->getInterfaceCount() << std::endl;
+
+	if (builtInterfaces != updatedInterfaces) {
+		throw std::runtime_error("Interfaces built in bulk don't match the updated interfaces");
+	}
+
+	if (builtCells != updatedCells) {
+		throw std::runtime_error("Cell data built in bulk doesn't match the updated cell data");
+	}
+}
+
+/*!
+* Refine the cells of the specified patch that are inside the given sphere.
+*
+* \param patch is the patch
+* \param center is the center of the sphere
+* \param radius is the radius of the sphere
+*/
+void refineSphere(VolOctree *patch, const std::array<double, 3> &center, double radius)
+{
+	for (const Cell &cell : patch->getCells()) {
+		std::array<double, 3> centroid = patch->evalCellCentroid(cell.getId());
+		if (norm2(centroid - center) < radius) {
+			patch->markCellForRefinement(cell.getId());
+		}
+	}
+
+	patch->update();
+}
+
+/*!
+* Subtest 001
+*
+* Testing bulk build of the interfaces of a 2D patch.
+*/
+int subtest_001()
+{
+	std::array<double, 3> origin = {{0., 0., 0.}};
+	double length = 1;
+	double dh = 0.125;
+
+	log::cout() << "  >> 2D octree patch" << "\n";
+
+	VolOctree *patch_2D = new VolOctree(2, origin, length, dh);
+	patch_2D->buildAdjacencies();
+	patch_2D->buildInterfaces();
+	patch_2D->update();
+
+	refineSphere(patch_2D, {{0.5, 0.5, 0.}}, 0.3);
+	refineSphere(patch_2D, {{0.3, 0.4, 0.}}, 0.1);
+
+	checkInterfaces(patch_2D);
+
+	delete patch_2D;
+
+	return 0;
+}
+
+/*!
+* Subtest 002
+*
+* Testing bulk build of the interfaces of a 3D patch.
+*/
+int subtest_002()
+{
+	std::array<double, 3> origin = {{0., 0., 0.}};
+	double length = 1;
+	double dh = 0.125;
+
+	log::cout() << "  >> 3D octree patch" << "\n";
+
+	VolOctree *patch_3D = new VolOctree(3, origin, length, dh);
+	patch_3D->buildAdjacencies();
+	patch_3D->buildInterfaces();
+	patch_3D->update();
+
+	refineSphere(patch_3D, {{0.5, 0.5, 0.5}}, 0.3);
+	refineSphere(patch_3D, {{0.3, 0.4, 0.5}}, 0.1);
+
+	checkInterfaces(patch_3D);
+
+	delete patch_3D;
+
+	return 0;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+#if BITPIT_ENABLE_MPI==1
+	MPI_Init(&argc,&argv);
+#else
+	BITPIT_UNUSED(argc);
+	BITPIT_UNUSED(argv);
+#endif
+
+	// Initialize the logger
+	log::manager().initialize(log::COMBINED);
+
+	// Run the subtests
+	log::cout() << "Testing bulk build of the interfaces of octree patches" << std::endl;
+
+	int status;
+	try {
+		status = subtest_001();
+		if (status != 0) {
+			return status;
+		}
+
+		status = subtest_002();
+		if (status != 0) {
+			return status;
+		}
+	} catch (const std::exception &exception) {
+		log::cout() << exception.what();
+		exit(1);
+	}
+
+#if BITPIT_ENABLE_MPI==1
+	MPI_Finalize();
+#endif
+}
@@ -0,0 +1,281 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2019 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <array>
+#include <map>
+
+#include "bitpit_common.hpp"
+#include "bitpit_IO.hpp"
+#include "bitpit_volunstructured.hpp"
+
+using namespace bitpit;
+
+typedef std::map<long, std::vector<std::vector<long>>> ElementSnapshot;
+
+/*!
+* Take a snapshot of connectivity, adjacencies and interfaces of the cells
+* of the specified patch.
+*
+* \param patch is the patch
+* \result The snapshot of the cells of the patch.
+*/
+ElementSnapshot takeCellSnapshot(const PatchKernel &patch)
+{
+    ElementSnapshot snapshot;
+    for (const Cell &cell : patch.getCells()) {
+        std::vector<std::vector<long>> &cellSnapshot = snapshot[cell.getId()];
+
+        const long *connect = cell.getConnect();
+        cellSnapshot.emplace_back(connect, connect + cell.getConnectSize());
+
+        int nFaces = cell.getFaceCount();
+        for (int face = 0; face < nFaces; ++face) {
+            const long *adjacencies = cell.getAdjacencies(face);
+            cellSnapshot.emplace_back(adjacencies, adjacencies + cell.getAdjacencyCount(face));
+
+            const long *interfaces = cell.getInterfaces(face);
+            cellSnapshot.emplace_back(interfaces, interfaces + cell.getInterfaceCount(face));
+        }
+    }
+
+    return snapshot;
+}
+
+/*!
+* Take a snapshot of the connectivity of the interfaces of the specified
+* patch.
+*
+* \param patch is the patch
+* \result The snapshot of the interfaces of the patch.
+*/
+ElementSnapshot takeInterfaceSnapshot(const PatchKernel &patch)
+{
+    ElementSnapshot snapshot;
+    for (const Interface &interface : patch.getInterfaces()) {
+        const long *connect = interface.getConnect();
+        snapshot[interface.getId()].emplace_back(connect, connect + interface.getConnectSize());
+    }
+
+    return snapshot;
+}
+
+/*!
+* Check if the elements of the specified patch match the given snapshots.
+*
+* \param patch is the patch
+* \param cellSnapshot is the snapshot of the cells
+* \param interfaceSnapshot is the snapshot of the interfaces
+*/
+void checkSnapshot(const PatchKernel &patch, const ElementSnapshot &cellSnapshot, const ElementSnapshot &interfaceSnapshot)
+{
+    if (takeCellSnapshot(patch) != cellSnapshot) {
+        throw std::runtime_error("Cell data doesn't match the expected data");
+    }
+
+    if (takeInterfaceSnapshot(patch) != interfaceSnapshot) {
+        throw std::runtime_error("Interface data doesn't match the expected data");
+    }
+
+    for (const Cell &cell : patch.getCells()) {
+        OBinaryStream cellBuffer(cell.getBinarySize());
+        cellBuffer << cell;
+        if ((size_t) cellBuffer.tellg() != cell.getBinarySize()) {
+            throw std::runtime_error("Binary size of the cell doesn't match the expected size");
+        }
+
+        IBinaryStream restoredBuffer(cellBuffer.data(), cellBuffer.getSize());
+        Cell restoredCell;
+        restoredBuffer >> restoredCell;
+        if (restoredCell.getAdjacencyCount() != cell.getAdjacencyCount() || restoredCell.getInterfaceCount() != cell.getInterfaceCount()) {
+            throw std::runtime_error("Streamed cell data doesn't match the expected data");
+        }
+    }
+}
+
+/*!
+* Subtest 001
+*
+* Testing arena storage of connectivity, adjacencies and interfaces.
+*/
+int subtest_001()
+{
+    log::cout() << "\n\n:: Arena storage of elements ::\n";
+
+    VolUnstructured *patch = new VolUnstructured(0, 2);
+    patch->setExpert(true);
+
+    patch->addVertex({{0.00000000, 0.00000000, 0.00000000}},  1);
+    patch->addVertex({{0.00000000, 1.00000000, 0.00000000}},  2);
+    patch->addVertex({{1.00000000, 1.00000000, 0.00000000}},  3);
+    patch->addVertex({{1.00000000, 0.00000000, 0.00000000}},  4);
+    patch->addVertex({{1.00000000, 0.50000000, 0.00000000}},  5);
+    patch->addVertex({{0.25992107, 1.00000000, 0.00000000}},  6);
+    patch->addVertex({{0.58740113, 1.00000000, 0.00000000}},  7);
+    patch->addVertex({{0.00000000, 0.75000000, 0.00000000}},  8);
+    patch->addVertex({{0.00000000, 0.50000000, 0.00000000}},  9);
+    patch->addVertex({{0.00000000, 0.25000000, 0.00000000}}, 10);
+    patch->addVertex({{0.25992107, 0.00000000, 0.00000000}}, 11);
+    patch->addVertex({{0.58740113, 0.00000000, 0.00000000}}, 12);
+    patch->addVertex({{0.42807699, 0.41426491, 0.00000000}}, 13);
+    patch->addVertex({{0.30507278, 0.69963441, 0.00000000}}, 14);
+    patch->addVertex({{0.64032722, 0.68239464, 0.00000000}}, 15);
+    patch->addVertex({{0.24229808, 0.24179558, 0.00000000}}, 16);
+    patch->addVertex({{0.67991107, 0.28835559, 0.00000000}}, 17);
+    patch->addVertex({{0.22034760, 0.48841527, 0.00000000}}, 18);
+    patch->addVertex({{0.43952167, 0.18888322, 0.00000000}}, 19);
+
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{ 3,  7, 15}}));
+    patch->addCell(ElementType::QUAD,     std::vector<long>({{ 1, 11, 16, 10}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{ 8,  9, 18}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{ 8, 18, 14}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{ 3, 15,  5}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{ 9, 10, 18}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{10, 16, 18}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{ 4, 17, 12}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{ 4,  5, 17}}));
+    patch->addCell(ElementType::QUAD,     std::vector<long>({{13, 17, 15, 14}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{11, 12, 19}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{13, 19, 17}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{12, 17, 19}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{13, 14, 18}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{ 5, 15, 17}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{11, 19, 16}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{13, 16, 19}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{13, 18, 16}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{14, 15,  7}}));
+    patch->addCell(ElementType::POLYGON,  std::vector<long>({{ 5,  2,  8, 14, 7, 6}}));
+
+    patch->buildAdjacencies();
+    patch->buildInterfaces();
+
+    ElementSnapshot cellSnapshot = takeCellSnapshot(*patch);
+    ElementSnapshot interfaceSnapshot = takeInterfaceSnapshot(*patch);
+
+    // Pack the elements into the arenas
+    log::cout() << " - Packing elements into the arenas" << std::endl;
+
+    patch->setElementStorageMode(PatchKernel::ELEMENT_STORAGE_ARENA);
+    for (const Cell &cell : patch->getCells()) {
+        if (!cell.hasSharedConnect()) {
+            throw std::runtime_error("Cell connectivity has not been moved into the arena");
+        }
+    }
+
+    checkSnapshot(*patch, cellSnapshot, interfaceSnapshot);
+
+    // Modify a cell stored in the arena
+    log::cout() << " - Modifying the neighbourhood of a cell stored in the arena" << std::endl;
+
+    Cell &modifiedCell = patch->getCell(0);
+    modifiedCell.pushAdjacency(0, 100);
+    modifiedCell.deleteAdjacency(0, modifiedCell.findAdjacency(0, 100));
+    modifiedCell.setInterface(0, 0, modifiedCell.getInterface(0, 0));
+
+    checkSnapshot(*patch, cellSnapshot, interfaceSnapshot);
+
+    // Copy the patch
+    log::cout() << " - Copying the patch" << std::endl;
+
+    std::unique_ptr<PatchKernel> clonedPatch = patch->clone();
+    if (clonedPatch->getElementStorageMode() != PatchKernel::ELEMENT_STORAGE_ARENA) {
+        throw std::runtime_error("Element storage mode has not been copied");
+    }
+
+    checkSnapshot(*clonedPatch, cellSnapshot, interfaceSnapshot);
+
+    // Delete some cells and squeeze the patch
+    log::cout() << " - Deleting cells and squeezing the patch" << std::endl;
+
+    std::vector<long> deletedCells = {{2, 7, 19}};
+    for (long cellId : deletedCells) {
+        patch->deleteCell(cellId);
+    }
+
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{ 8,  9, 18}}), 2);
+    patch->updateAdjacencies(std::vector<long>({{2}}));
+    patch->updateInterfaces(std::vector<long>({{2}}));
+
+    cellSnapshot = takeCellSnapshot(*patch);
+    interfaceSnapshot = takeInterfaceSnapshot(*patch);
+
+    patch->squeeze();
+
+    checkSnapshot(*patch, cellSnapshot, interfaceSnapshot);
+
+    for (const Cell &cell : patch->getCells()) {
+        if (!cell.hasSharedConnect()) {
+            throw std::runtime_error("Cell connectivity has not been moved into the arena");
+        }
+    }
+
+    // Switch back to individual storage
+    log::cout() << " - Moving elements out of the arenas" << std::endl;
+
+    patch->setElementStorageMode(PatchKernel::ELEMENT_STORAGE_INDIVIDUAL);
+    for (const Cell &cell : patch->getCells()) {
+        if (cell.hasSharedConnect()) {
+            throw std::runtime_error("Cell connectivity has not been moved out of the arena");
+        }
+    }
+
+    checkSnapshot(*patch, cellSnapshot, interfaceSnapshot);
+
+    delete patch;
+
+    return 0;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+#if BITPIT_ENABLE_MPI==1
+    MPI_Init(&argc,&argv);
+#else
+    BITPIT_UNUSED(argc);
+    BITPIT_UNUSED(argv);
+#endif
+
+    // Initialize the logger
+    log::manager().initialize(log::COMBINED);
+
+    // Run the subtests
+    log::cout() << "Testing element storage of volunstructured patches" << std::endl;
+
+    int status;
+    try {
+        status = subtest_001();
+        if (status != 0) {
+            return status;
+        }
+    } catch (const std::exception &exception) {
+        log::cout() << exception.what();
+        return 1;
+    }
+
+#if BITPIT_ENABLE_MPI==1
+    MPI_Finalize();
+#endif
+}
@@ -0,0 +1,258 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2019 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <array>
+#include <map>
+#include <set>
+
+#include "bitpit_common.hpp"
+#include "bitpit_IO.hpp"
+#include "bitpit_volunstructured.hpp"
+
+using namespace bitpit;
+
+typedef std::map<long, std::vector<std::set<long>>> AdjacencySnapshot;
+
+/*!
+* Take a snapshot of the adjacencies of the cells of the specified patch.
+*
+* \param patch is the patch
+* \result The snapshot of the adjacencies of the patch.
+*/
+AdjacencySnapshot takeAdjacencySnapshot(const PatchKernel &patch)
+{
+    AdjacencySnapshot snapshot;
+    for (const Cell &cell : patch.getCells()) {
+        std::vector<std::set<long>> &cellSnapshot = snapshot[cell.getId()];
+
+        int nFaces = cell.getFaceCount();
+        for (int face = 0; face < nFaces; ++face) {
+            const long *adjacencies = cell.getAdjacencies(face);
+            cellSnapshot.emplace_back(adjacencies, adjacencies + cell.getAdjacencyCount(face));
+        }
+    }
+
+    return snapshot;
+}
+
+/*!
+* Check if the adjacencies built with the hash-based strategy match the
+* adjacencies built with the sort-based strategy.
+*
+* Adjacencies are compared after a complete build and after a partial
+* update involving only some cells of the patch.
+*
+* \param patch is the patch
+* \param updatedCells are the cells that will be deleted and re-inserted
+* to test partial updates
+*/
+void checkAdjacencies(VolUnstructured *patch, const std::vector<long> &updatedCells)
+{
+    // Complete build
+    patch->buildAdjacencies(PatchKernel::ADJACENCIES_AUTOMATIC);
+    AdjacencySnapshot hashedSnapshot = takeAdjacencySnapshot(*patch);
+
+    patch->buildAdjacencies(PatchKernel::ADJACENCIES_SORTED);
+    if (patch->getAdjacenciesBuildStrategy() != PatchKernel::ADJACENCIES_SORTED) {
+        throw std::runtime_error("Adjacencies build strategy has not been set");
+    }
+
+    AdjacencySnapshot sortedSnapshot = takeAdjacencySnapshot(*patch);
+    if (sortedSnapshot != hashedSnapshot) {
+        throw std::runtime_error("Sorted adjacencies don't match the hashed adjacencies");
+    }
+
+    log::cout() << "    Complete build: adjacencies match" << std::endl;
+
+    // Partial update
+    std::vector<std::pair<ElementType, std::vector<long>>> updatedCellInfo;
+    for (long cellId : updatedCells) {
+        const Cell &cell = patch->getCell(cellId);
+        const long *cellConnect = cell.getConnect();
+        updatedCellInfo.emplace_back(cell.getType(), std::vector<long>(cellConnect, cellConnect + cell.getConnectSize()));
+    }
+
+    for (long cellId : updatedCells) {
+        patch->deleteCell(cellId);
+    }
+
+    for (std::size_t n = 0; n < updatedCells.size(); ++n) {
+        patch->addCell(updatedCellInfo[n].first, updatedCellInfo[n].second, updatedCells[n]);
+    }
+
+    patch->updateAdjacencies(updatedCells);
+
+    sortedSnapshot = takeAdjacencySnapshot(*patch);
+    if (sortedSnapshot != hashedSnapshot) {
+        throw std::runtime_error("Partially updated adjacencies don't match the hashed adjacencies");
+    }
+
+    log::cout() << "    Partial update: adjacencies match" << std::endl;
+}
+
+/*!
+* Subtest 001
+*
+* Testing sort-based build of the adjacencies of a two-dimensional patch.
+*/
+int subtest_001()
+{
+    log::cout() << "\n\n:: Sorted adjacencies of a 2D patch ::\n";
+
+    VolUnstructured *patch = new VolUnstructured(0, 2);
+
+    patch->addVertex({{0.00000000, 0.00000000, 0.00000000}},  1);
+    patch->addVertex({{0.00000000, 1.00000000, 0.00000000}},  2);
+    patch->addVertex({{1.00000000, 1.00000000, 0.00000000}},  3);
+    patch->addVertex({{1.00000000, 0.00000000, 0.00000000}},  4);
+    patch->addVertex({{1.00000000, 0.50000000, 0.00000000}},  5);
+    patch->addVertex({{0.25992107, 1.00000000, 0.00000000}},  6);
+    patch->addVertex({{0.58740113, 1.00000000, 0.00000000}},  7);
+    patch->addVertex({{0.00000000, 0.75000000, 0.00000000}},  8);
+    patch->addVertex({{0.00000000, 0.50000000, 0.00000000}},  9);
+    patch->addVertex({{0.00000000, 0.25000000, 0.00000000}}, 10);
+    patch->addVertex({{0.25992107, 0.00000000, 0.00000000}}, 11);
+    patch->addVertex({{0.58740113, 0.00000000, 0.00000000}}, 12);
+    patch->addVertex({{0.42807699, 0.41426491, 0.00000000}}, 13);
+    patch->addVertex({{0.30507278, 0.69963441, 0.00000000}}, 14);
+    patch->addVertex({{0.64032722, 0.68239464, 0.00000000}}, 15);
+    patch->addVertex({{0.24229808, 0.24179558, 0.00000000}}, 16);
+    patch->addVertex({{0.67991107, 0.28835559, 0.00000000}}, 17);
+    patch->addVertex({{0.22034760, 0.48841527, 0.00000000}}, 18);
+    patch->addVertex({{0.43952167, 0.18888322, 0.00000000}}, 19);
+
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{ 3,  7, 15}}));
+    patch->addCell(ElementType::QUAD,     std::vector<long>({{ 1, 11, 16, 10}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{ 8,  9, 18}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{ 8, 18, 14}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{ 3, 15,  5}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{ 9, 10, 18}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{10, 16, 18}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{ 4, 17, 12}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{ 4,  5, 17}}));
+    patch->addCell(ElementType::QUAD,     std::vector<long>({{13, 17, 15, 14}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{11, 12, 19}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{13, 19, 17}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{12, 17, 19}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{13, 14, 18}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{ 5, 15, 17}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{11, 19, 16}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{13, 16, 19}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{13, 18, 16}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{14, 15,  7}}));
+    patch->addCell(ElementType::POLYGON,  std::vector<long>({{ 5,  2,  8, 14, 7, 6}}));
+
+    checkAdjacencies(patch, std::vector<long>({{2, 9, 19}}));
+
+    delete patch;
+
+    return 0;
+}
+
+/*!
+* Subtest 002
+*
+* Testing sort-based build of the adjacencies of a three-dimensional patch.
+*/
+int subtest_002()
+{
+    log::cout() << "\n\n:: Sorted adjacencies of a 3D patch ::\n";
+
+    const int N_CELLS = 6;
+    const int N_VERTICES = N_CELLS + 1;
+
+    VolUnstructured *patch = new VolUnstructured(0, 3);
+
+    auto getVertexId = [N_VERTICES](int i, int j, int k) -> long {
+        return (i + N_VERTICES * (j + N_VERTICES * k));
+    };
+
+    for (int k = 0; k < N_VERTICES; ++k) {
+        for (int j = 0; j < N_VERTICES; ++j) {
+            for (int i = 0; i < N_VERTICES; ++i) {
+                patch->addVertex({{(double) i, (double) j, (double) k}}, getVertexId(i, j, k));
+            }
+        }
+    }
+
+    for (int k = 0; k < N_CELLS; ++k) {
+        for (int j = 0; j < N_CELLS; ++j) {
+            for (int i = 0; i < N_CELLS; ++i) {
+                std::vector<long> connect = {{
+                    getVertexId(i,     j,     k    ), getVertexId(i + 1, j,     k    ),
+                    getVertexId(i + 1, j + 1, k    ), getVertexId(i,     j + 1, k    ),
+                    getVertexId(i,     j,     k + 1), getVertexId(i + 1, j,     k + 1),
+                    getVertexId(i + 1, j + 1, k + 1), getVertexId(i,     j + 1, k + 1)
+                }};
+
+                patch->addCell(ElementType::HEXAHEDRON, connect);
+            }
+        }
+    }
+
+    checkAdjacencies(patch, std::vector<long>({{0, 43, 44, 107, 215}}));
+
+    delete patch;
+
+    return 0;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+#if BITPIT_ENABLE_MPI==1
+    MPI_Init(&argc,&argv);
+#else
+    BITPIT_UNUSED(argc);
+    BITPIT_UNUSED(argv);
+#endif
+
+    // Initialize the logger
+    log::manager().initialize(log::COMBINED);
+
+    // Run the subtests
+    log::cout() << "Testing adjacencies build strategies of volunstructured patches" << std::endl;
+
+    int status;
+    try {
+        status = subtest_001();
+        if (status != 0) {
+            return status;
+        }
+
+        status = subtest_002();
+        if (status != 0) {
+            return status;
+        }
+    } catch (const std::exception &exception) {
+        log::cout() << exception.what();
+        return 1;
+    }
+
+#if BITPIT_ENABLE_MPI==1
+    MPI_Finalize();
+#endif
+}
@@ -0,0 +1,343 @@
+/*---------------------------------------------------------------------------*\
+ *
+ *  bitpit
+ *
+ *  Copyright (C) 2015-2019 OPTIMAD engineering Srl
+ *
+ *  -------------------------------------------------------------------------
+ *  License
+ *  This file is part of bitpit.
+ *
+ *  bitpit is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Lesser General Public License v3 (LGPL)
+ *  as published by the Free Software Foundation.
+ *
+ *  bitpit is distributed in the hope that it will be useful, but WITHOUT
+ *  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ *  FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with bitpit. If not, see <http://www.gnu.org/licenses/>.
+ *
+\*---------------------------------------------------------------------------*/
+
+#include <array>
+#include <cmath>
+#include <sstream>
+#include <vector>
+
+#include "bitpit_common.hpp"
+#include "bitpit_operators.hpp"
+#include "bitpit_volunstructured.hpp"
+
+using namespace bitpit;
+
+/*!
+* Check the location of the specified points.
+*
+* Points are located one by one using the patch, one by one using a skd-tree
+* and in batch using the patch. All the location methods should return the
+* expected cells.
+*
+* \param patch is the patch
+* \param points are the points
+* \param expectedIds are the ids of the cells expected to contain the points
+*/
+void checkLocation(VolUnstructured *patch, const std::vector<std::array<double, 3>> &points,
+                   const std::vector<long> &expectedIds)
+{
+    std::size_t nPoints = points.size();
+
+    VolumeSkdTree tree(patch);
+    tree.build(4);
+
+    std::vector<long> batchIds(nPoints);
+    patch->locatePoints(nPoints, points.data(), batchIds.data());
+
+    for (std::size_t n = 0; n < nPoints; ++n) {
+        const std::array<double, 3> &point = points[n];
+
+        long patchId = patch->locatePoint(point);
+        if (patchId != expectedIds[n]) {
+            std::stringstream message;
+            message << "Patch located point " << point << " in cell " << patchId << " instead of " << expectedIds[n];
+            throw std::runtime_error(message.str());
+        }
+
+        long treeId = tree.locatePoint(point);
+        if (treeId != expectedIds[n]) {
+            std::stringstream message;
+            message << "Tree located point " << point << " in cell " << treeId << " instead of " << expectedIds[n];
+            throw std::runtime_error(message.str());
+        }
+
+        if (batchIds[n] != expectedIds[n]) {
+            std::stringstream message;
+            message << "Batch located point " << point << " in cell " << batchIds[n] << " instead of " << expectedIds[n];
+            throw std::runtime_error(message.str());
+        }
+
+        if (patch->isPointInside(point) != (expectedIds[n] != Cell::NULL_ID)) {
+            std::stringstream message;
+            message << "Wrong inside check for point " << point;
+            throw std::runtime_error(message.str());
+        }
+    }
+
+    log::cout() << "    Located " << nPoints << " points" << std::endl;
+}
+
+/*!
+* Subtest 001
+*
+* Testing point location on a two-dimensional patch.
+*/
+int subtest_001()
+{
+    log::cout() << "\n\n:: Point location on a 2D patch ::\n";
+
+    VolUnstructured *patch = new VolUnstructured(0, 2);
+
+    patch->addVertex({{0.00000000, 0.00000000, 0.00000000}},  1);
+    patch->addVertex({{0.00000000, 1.00000000, 0.00000000}},  2);
+    patch->addVertex({{1.00000000, 1.00000000, 0.00000000}},  3);
+    patch->addVertex({{1.00000000, 0.00000000, 0.00000000}},  4);
+    patch->addVertex({{1.00000000, 0.50000000, 0.00000000}},  5);
+    patch->addVertex({{0.25992107, 1.00000000, 0.00000000}},  6);
+    patch->addVertex({{0.58740113, 1.00000000, 0.00000000}},  7);
+    patch->addVertex({{0.00000000, 0.75000000, 0.00000000}},  8);
+    patch->addVertex({{0.00000000, 0.50000000, 0.00000000}},  9);
+    patch->addVertex({{0.00000000, 0.25000000, 0.00000000}}, 10);
+    patch->addVertex({{0.25992107, 0.00000000, 0.00000000}}, 11);
+    patch->addVertex({{0.58740113, 0.00000000, 0.00000000}}, 12);
+    patch->addVertex({{0.42807699, 0.41426491, 0.00000000}}, 13);
+    patch->addVertex({{0.30507278, 0.69963441, 0.00000000}}, 14);
+    patch->addVertex({{0.64032722, 0.68239464, 0.00000000}}, 15);
+    patch->addVertex({{0.24229808, 0.24179558, 0.00000000}}, 16);
+    patch->addVertex({{0.67991107, 0.28835559, 0.00000000}}, 17);
+    patch->addVertex({{0.22034760, 0.48841527, 0.00000000}}, 18);
+    patch->addVertex({{0.43952167, 0.18888322, 0.00000000}}, 19);
+
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{ 3,  7, 15}}));
+    patch->addCell(ElementType::QUAD,     std::vector<long>({{ 1, 11, 16, 10}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{ 8,  9, 18}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{ 8, 18, 14}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{ 3, 15,  5}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{ 9, 10, 18}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{10, 16, 18}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{ 4, 17, 12}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{ 4,  5, 17}}));
+    patch->addCell(ElementType::QUAD,     std::vector<long>({{13, 17, 15, 14}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{11, 12, 19}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{13, 19, 17}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{12, 17, 19}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{13, 14, 18}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{ 5, 15, 17}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{11, 19, 16}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{13, 16, 19}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{13, 18, 16}}));
+    patch->addCell(ElementType::TRIANGLE, std::vector<long>({{14, 15,  7}}));
+
+    // The centroid of a cell should be located inside the cell itself,
+    // points outside the patch or outside the plane of the patch should
+    // not be located.
+    std::vector<std::array<double, 3>> points;
+    std::vector<long> expectedIds;
+    for (const Cell &cell : patch->getCells()) {
+        points.push_back(patch->evalCellCentroid(cell.getId()));
+        expectedIds.push_back(cell.getId());
+    }
+
+    points.push_back({{1.5, 0.5, 0.0}});
+    expectedIds.push_back(Cell::NULL_ID);
+
+    points.push_back({{0.5, 0.5, 0.5}});
+    expectedIds.push_back(Cell::NULL_ID);
+
+    checkLocation(patch, points, expectedIds);
+
+    delete patch;
+
+    return 0;
+}
+
+/*!
+* Subtest 002
+*
+* Testing point location on a three-dimensional patch.
+*/
+int subtest_002()
+{
+    log::cout() << "\n\n:: Point location on a 3D patch ::\n";
+
+    const int N_CELLS = 8;
+    const int N_VERTICES = N_CELLS + 1;
+
+    VolUnstructured *patch = new VolUnstructured(0, 3);
+
+    auto getVertexId = [N_VERTICES](int i, int j, int k) -> long {
+        return (i + N_VERTICES * (j + N_VERTICES * k));
+    };
+
+    auto getCellId = [N_CELLS](int i, int j, int k) -> long {
+        return (i + N_CELLS * (j + N_CELLS * k));
+    };
+
+    for (int k = 0; k < N_VERTICES; ++k) {
+        for (int j = 0; j < N_VERTICES; ++j) {
+            for (int i = 0; i < N_VERTICES; ++i) {
+                patch->addVertex({{(double) i, (double) j, (double) k}}, getVertexId(i, j, k));
+            }
+        }
+    }
+
+    for (int k = 0; k < N_CELLS; ++k) {
+        for (int j = 0; j < N_CELLS; ++j) {
+            for (int i = 0; i < N_CELLS; ++i) {
+                std::vector<long> connect = {{
+                    getVertexId(i,     j,     k    ), getVertexId(i + 1, j,     k    ),
+                    getVertexId(i + 1, j + 1, k    ), getVertexId(i,     j + 1, k    ),
+                    getVertexId(i,     j,     k + 1), getVertexId(i + 1, j,     k + 1),
+                    getVertexId(i + 1, j + 1, k + 1), getVertexId(i,     j + 1, k + 1)
+                }};
+
+                patch->addCell(ElementType::HEXAHEDRON, connect, getCellId(i, j, k));
+            }
+        }
+    }
+
+    // Points are generated with a linear congruential generator, the cell
+    // that contains a point is identified by the integer part of its
+    // coordinates. Points are moved away from the faces of the cells to
+    // avoid ambiguities.
+    const std::size_t N_POINTS = 10000;
+
+    std::vector<std::array<double, 3>> points(N_POINTS);
+    std::vector<long> expectedIds(N_POINTS);
+
+    unsigned long seed = 1;
+    auto generateCoordinate = [&seed](double maxValue) -> double {
+        seed = (1103515245 * seed + 12345) % 2147483648;
+        return maxValue * seed / 2147483648.;
+    };
+
+    for (std::size_t n = 0; n < N_POINTS; ++n) {
+        std::array<int, 3> ijk;
+        for (int d = 0; d < 3; ++d) {
+            double coordinate = generateCoordinate(N_CELLS + 2.) - 1.;
+            ijk[d] = static_cast<int>(std::floor(coordinate));
+            points[n][d] = ijk[d] + 0.05 + 0.9 * (coordinate - ijk[d]);
+        }
+
+        bool isInside = true;
+        for (int d = 0; d < 3; ++d) {
+            isInside &= (ijk[d] >= 0 && ijk[d] < N_CELLS);
+        }
+
+        if (isInside) {
+            expectedIds[n] = getCellId(ijk[0], ijk[1], ijk[2]);
+        } else {
+            expectedIds[n] = Cell::NULL_ID;
+        }
+    }
+
+    checkLocation(patch, points, expectedIds);
+
+    delete patch;
+
+    return 0;
+}
+
+/*!
+* Subtest 003
+*
+* Testing that point location follows the alterations of the patch.
+*/
+int subtest_003()
+{
+    log::cout() << "\n\n:: Point location on an altered patch ::\n";
+
+    VolUnstructured *patch = new VolUnstructured(0, 2);
+
+    patch->addVertex({{0.0, 0.0, 0.0}}, 0);
+    patch->addVertex({{1.0, 0.0, 0.0}}, 1);
+    patch->addVertex({{2.0, 0.0, 0.0}}, 2);
+    patch->addVertex({{0.0, 1.0, 0.0}}, 3);
+    patch->addVertex({{1.0, 1.0, 0.0}}, 4);
+    patch->addVertex({{2.0, 1.0, 0.0}}, 5);
+
+    patch->addCell(ElementType::QUAD, std::vector<long>({{0, 1, 4, 3}}), (long) 0);
+    patch->addCell(ElementType::QUAD, std::vector<long>({{1, 2, 5, 4}}), (long) 1);
+
+    std::vector<std::array<double, 3>> points = {{{{0.5, 0.5, 0.0}}, {{1.5, 0.5, 0.0}}, {{2.5, 0.5, 0.0}}}};
+
+    // Locate the points on the original patch, this builds the skd-tree
+    checkLocation(patch, points, {{0, 1, Cell::NULL_ID}});
+
+    // Delete a cell
+    patch->deleteCell(1);
+    checkLocation(patch, points, {{0, Cell::NULL_ID, Cell::NULL_ID}});
+
+    // Add a cell
+    patch->addVertex({{3.0, 0.0, 0.0}}, 6);
+    patch->addVertex({{3.0, 1.0, 0.0}}, 7);
+    patch->addCell(ElementType::QUAD, std::vector<long>({{2, 6, 7, 5}}), (long) 2);
+    checkLocation(patch, points, {{0, Cell::NULL_ID, 2}});
+
+    // Translate the patch
+    patch->translate({{1.0, 0.0, 0.0}});
+    checkLocation(patch, points, {{Cell::NULL_ID, 0, Cell::NULL_ID}});
+
+    // Reset the cells
+    patch->resetCells();
+    checkLocation(patch, points, {{Cell::NULL_ID, Cell::NULL_ID, Cell::NULL_ID}});
+
+    delete patch;
+
+    return 0;
+}
+
+/*!
+* Main program.
+*/
+int main(int argc, char *argv[])
+{
+#if BITPIT_ENABLE_MPI==1
+    MPI_Init(&argc,&argv);
+#else
+    BITPIT_UNUSED(argc);
+    BITPIT_UNUSED(argv);
+#endif
+
+    // Initialize the logger
+    log::manager().initialize(log::COMBINED);
+
+    // Run the subtests
+    log::cout() << "Testing point location on volunstructured patches" << std::endl;
+
+    int status;
+    try {
+        status = subtest_001();
+        if (status != 0) {
+            return status;
+        }
+
+        status = subtest_002();
+        if (status != 0) {
+            return status;
+        }
+
+        status = subtest_003();
+        if (status != 0) {
+            return status;
+        }
+    } catch (const std::exception &exception) {
+        log::cout() << exception.what();
+        return 1;
+    }
+
+#if BITPIT_ENABLE_MPI==1
+    MPI_Finalize();
+#endif
+}